@@ -0,0 +1,264 @@
+/*----------------------------------------------------------------------------
+
+Name		anomalymodel.cpp
+
+Purpose		Table model over the anomalies of a NodeTimeline.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "anomalymodel.h"
+#include <QPair>
+#include <algorithm>
+
+// Columns of the view
+enum AnomalyColumn
+{
+    ANOM_TIME,
+    ANOM_IFACE,
+    ANOM_NODE,
+    ANOM_KIND,
+    ANOM_LENGTH,
+    ANOM_DETAIL,
+    ANOM_COLUMNS
+};
+
+/*----------------------------------------------------------------------------
+
+Name		AnomalyModel
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+AnomalyModel::AnomalyModel( QObject* parent )
+    : QAbstractTableModel( parent )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setTimeline
+
+Purpose		Replaces the rows with the anomalies of every lane, merged into
+            time order
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void AnomalyModel::setTimeline( const NodeTimeline& timeline, const QStringList& ifaces )
+{
+    beginResetModel();
+    mTimeline = timeline;
+    mIfaces = ifaces;
+    mRows.clear();
+
+    QVector< QPair<qint64, int> > order;
+    for ( int l = 0; l < mTimeline.size(); ++l )
+    {
+        const QVector<NodeEvent>& events = mTimeline.at( l ).events;
+        for ( int e = 0; e < events.size(); ++e )
+        {
+            if ( !NodeTimeline::isAnomaly( events.at( e ).kind ) )
+                continue;
+
+            Row row;
+            row.lane = l;
+            row.event = e;
+            order.append( qMakePair( events.at( e ).begin, mRows.size() ) );
+            mRows.append( row );
+        }
+    }
+
+    std::sort( order.begin(), order.end() );
+    QVector<Row> rows;
+    for ( int i = 0; i < order.size(); ++i )
+        rows.append( mRows.at( order.at(i).second ) );
+    mRows = rows;
+    endResetModel();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		eventAt
+
+Purpose		Returns the event shown in a row
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+const NodeEvent& AnomalyModel::eventAt( int row ) const
+{
+    const Row& r = mRows.at( row );
+    return mTimeline.at( r.lane ).events.at( r.event );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		rowCount
+
+Purpose		Returns the number of anomalies
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int AnomalyModel::rowCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() )
+        return 0;
+
+    return mRows.size();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		columnCount
+
+Purpose		Returns the number of columns
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int AnomalyModel::columnCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() )
+        return 0;
+
+    return ANOM_COLUMNS;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		data
+
+Purpose		Returns the text of a cell, its value for sorting, or its
+            alignment (numbers are right aligned)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant AnomalyModel::data( const QModelIndex& index, int role ) const
+{
+    if ( !index.isValid() || index.row() >= rowCount() )
+        return QVariant();
+
+    const int column = index.column();
+    switch ( role )
+    {
+    case Qt::DisplayRole:
+        return text( index.row(), column );
+    case Qt::UserRole:
+        return value( index.row(), column );
+    case Qt::TextAlignmentRole:
+        if ( column == ANOM_TIME || column == ANOM_NODE || column == ANOM_LENGTH )
+            return int( Qt::AlignRight | Qt::AlignVCenter );
+        return int( Qt::AlignLeft | Qt::AlignVCenter );
+    default:
+        return QVariant();
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		headerData
+
+Purpose		Returns the column titles
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant AnomalyModel::headerData( int section, Qt::Orientation orientation, int role ) const
+{
+    if ( orientation != Qt::Horizontal || role != Qt::DisplayRole )
+        return QVariant();
+
+    const bool timed = mTimeline.isTimed();
+    switch ( section )
+    {
+    case ANOM_TIME:     return timed ? tr( "Time (s)" ) : tr( "Frame" );
+    case ANOM_IFACE:    return tr( "Interface" );
+    case ANOM_NODE:     return tr( "Node" );
+    case ANOM_KIND:     return tr( "Anomaly" );
+    case ANOM_LENGTH:   return timed ? tr( "Lasted (ms)" ) : tr( "Frames" );
+    case ANOM_DETAIL:   return tr( "Detail" );
+    }
+    return QVariant();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		value
+
+Purpose		Returns the value a cell sorts by
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant AnomalyModel::value( int row, int column ) const
+{
+    const NodeLane& lane = mTimeline.at( mRows.at( row ).lane );
+    const NodeEvent& e = eventAt( row );
+    switch ( column )
+    {
+    case ANOM_TIME:     return e.begin;
+    case ANOM_IFACE:    return mIfaces.value( lane.iface );
+    case ANOM_NODE:     return lane.node;
+    case ANOM_KIND:     return e.kind;
+    case ANOM_LENGTH:   return e.end - e.begin;
+    case ANOM_DETAIL:   return e.value;
+    }
+    return QVariant();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		text
+
+Purpose		Returns the text of a cell
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QString AnomalyModel::text( int row, int column ) const
+{
+    const NodeLane& lane = mTimeline.at( mRows.at( row ).lane );
+    const NodeEvent& e = eventAt( row );
+    const bool timed = mTimeline.isTimed();
+    switch ( column )
+    {
+    case ANOM_TIME:
+        return timed ? QString::number( e.begin / 1e6, 'f', 6 ) : QString::number( e.begin );
+    case ANOM_IFACE:
+        return mIfaces.value( lane.iface );
+    case ANOM_NODE:
+        return QString( "%1" ).arg( lane.node, 2, 16, QChar( '0' ) ).toUpper();
+    case ANOM_LENGTH:
+        return timed ? QString::number( ( e.end - e.begin ) / 1e3, 'f', 1 )
+                     : QString::number( e.end - e.begin );
+    case ANOM_KIND:
+        switch ( e.kind )
+        {
+        case EVENT_HEARTBEAT_TIMEOUT:   return tr( "Heartbeat timeout" );
+        case EVENT_GUARD_TIMEOUT:       return tr( "Guard timeout" );
+        case EVENT_GUARD_TOGGLE:        return tr( "Guard toggle error" );
+        case EVENT_EMCY_BURST:          return tr( "EMCY burst" );
+        case EVENT_FLAPPING:            return tr( "State flapping" );
+        case EVENT_UNEXPECTED_BOOT:     return tr( "Unexpected boot-up" );
+        }
+        break;
+    case ANOM_DETAIL:
+        switch ( e.kind )
+        {
+        case EVENT_HEARTBEAT_TIMEOUT:
+            return ( e.end == mTimeline.end() )
+                   ? tr( "Not heard again (period %1 ms)" ).arg( e.value / 1000.0 )
+                   : tr( "Silent until heard again (period %1 ms)" ).arg( e.value / 1000.0 );
+        case EVENT_GUARD_TIMEOUT:
+            return tr( "Request unanswered until the next" );
+        case EVENT_GUARD_TOGGLE:
+            return tr( "Reply %1 repeated the toggle bit" )
+                   .arg( e.value, 2, 16, QChar( '0' ) );
+        case EVENT_EMCY_BURST:
+            return tr( "%1 emergencies" ).arg( e.value );
+        case EVENT_FLAPPING:
+            return tr( "%1 state changes" ).arg( e.value );
+        case EVENT_UNEXPECTED_BOOT:
+            return tr( "No reset command sent since it was last running" );
+        }
+        break;
+    }
+    return QString();
+}
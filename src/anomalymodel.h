@@ -0,0 +1,60 @@
+/*----------------------------------------------------------------------------
+
+Name		anomalymodel.h
+
+Purpose		Table model over the anomalies of a NodeTimeline (heartbeat and
+            guard timeouts, EMCY bursts, flapping, unexpected boot-ups), one
+            row per anomaly with its time, node and what was seen.  Every
+            cell also carries its raw number under Qt::UserRole so a sort
+            proxy orders rows by value rather than by text.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef ANOMALYMODEL_H
+#define ANOMALYMODEL_H
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include "nodetimeline.h"
+
+class AnomalyModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit AnomalyModel( QObject* parent = 0 );
+
+    // Replaces the rows with the anomalies of a timeline; ifaces names the
+    // interfaces of its lanes
+    void setTimeline( const NodeTimeline& timeline, const QStringList& ifaces );
+
+    // Returns the event shown in a row
+    const NodeEvent& eventAt( int row ) const;
+
+    // QAbstractTableModel interface
+    int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+    int columnCount( const QModelIndex& parent = QModelIndex() ) const;
+    QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+    QVariant headerData( int section, Qt::Orientation orientation,
+                         int role = Qt::DisplayRole ) const;
+
+private:
+    // Returns the value of a cell (Qt::UserRole)
+    QVariant value( int row, int column ) const;
+    // Returns the text of a cell
+    QString text( int row, int column ) const;
+
+private:
+    // Place of one anomaly in the timeline
+    struct Row
+    {
+        int lane;
+        int event;
+    };
+
+    NodeTimeline mTimeline;         // Timeline shown (its arrays are shared)
+    QStringList mIfaces;            // Interface names
+    QVector<Row> mRows;             // Anomalies in time order
+};
+
+#endif // ANOMALYMODEL_H
@@ -0,0 +1,903 @@
+/*----------------------------------------------------------------------------
+
+Name		benchmain.cpp
+
+Purpose		Parser benchmark.  Generates synthetic CANopen dumps of the sizes
+            asked for (see DumpGenerator) and measures, for each:
+
+                ingest       - tokenizing throughput in MB/s (best and
+                               median of the repeats), then the time taken
+                               to build the frame index and SDO transfers
+                filters      - latency of a full scan under each kind of
+                               predicate (port, address, type, object
+                               index, time window, payload mask, bit and
+                               range, and all at once)
+                first render - time from Parser::loadFile to the first
+                               block of matches the table would show, and
+                               to the end of the background parse
+                peak RSS     - high water mark of the process so far
+
+            and writes the results as JSON:
+
+            canDumpBench --sizes 1M,64M,1G --format log --out bench.json
+
+            Dumps are written to --dir and reused by later runs with the
+            same seed, format, mix, nodes, interfaces and size when --keep is
+            given.
+
+            --check log checks instead that a dump of the first size reads
+            into the same frames as the candump -l log exported from it,
+            --check ingest that it reads into the same frames as a QRegExp
+            tokenizer laid out like the original parser.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Checks the log export against the text path
+            17 Oct 26  AFB	Checks the tokenizer against a reference one
+----------------------------------------------------------------------------*/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegExp>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include <sys/resource.h>
+#include "benchprobe.h"
+#include "capturefile.h"
+#include "dumpgenerator.h"
+#include "framefilter.h"
+#include "frameindex.h"
+#include "frameingest.h"
+#include "parser.h"
+#include "sdoassembler.h"
+
+// Longest a single load and parse may take before it is given up on
+static const int FIRST_RENDER_TIMEOUT = 10 * 60 * 1000;
+
+// Lines added to the dumps checked, in the forms the generator does not
+// write: remote requests and 29 bit identifiers below 0x800
+static const char CHECK_LINES[] =
+    "(0000000001.000000)  can0  701   [1]  remote request\n"
+    "(0000000001.000100)  can0  00000123   [2]  11 22\n"
+    "(0000000001.000200) can1 702#R1\n"
+    "(0000000001.000300) can1 1ABCDEF0#\n";
+
+// One predicate measured by the filter benchmark
+struct BenchPredicate
+{
+    QString name;
+    QStringList ports;
+    QStringList addrs;
+    QStringList objIdxs;
+    QVector<uint> funcs;
+    QString payload;
+    bool window;            // Middle tenth of the dump's timestamps
+};
+
+/*----------------------------------------------------------------------------
+
+Name		parseSize
+
+Purpose		Reads a size in bytes with an optional K, M or G suffix (powers
+            of 1024), e.g. 512K or 10G
+
+Return      false if the size cannot be read
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool parseSize( const QString& text, qint64& bytes )
+{
+    QString digits = text.trimmed().toUpper();
+    qint64 unit = 1;
+    if ( digits.endsWith( "K" ) )
+        unit = Q_INT64_C( 1 ) << 10;
+    else if ( digits.endsWith( "M" ) )
+        unit = Q_INT64_C( 1 ) << 20;
+    else if ( digits.endsWith( "G" ) )
+        unit = Q_INT64_C( 1 ) << 30;
+    if ( unit != 1 )
+        digits.chop( 1 );
+
+    bool ok = false;
+    double value = digits.toDouble( &ok );
+    if ( !ok || value <= 0 )
+        return false;
+
+    bytes = qint64( value * unit );
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		median
+
+Purpose		Returns the median of a set of samples
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static double median( QVector<double> samples )
+{
+    if ( samples.isEmpty() )
+        return 0.0;
+
+    std::sort( samples.begin(), samples.end() );
+    const int middle = samples.size() / 2;
+    if ( samples.size() % 2 )
+        return samples.at( middle );
+
+    return ( samples.at( middle - 1 ) + samples.at( middle ) ) / 2.0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		peakRss
+
+Purpose		Returns the most resident memory the process has used, in KB
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static qint64 peakRss()
+{
+    struct rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+        return -1;
+
+    return qint64( usage.ru_maxrss );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		predicates
+
+Purpose		Returns the predicates the filter benchmark runs, one of each
+            kind the filter has and one combining several
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QVector<BenchPredicate> predicates()
+{
+    const PktMap map = Parser::createRefMap();
+    QVector<BenchPredicate> list;
+
+    BenchPredicate none;
+    none.name = "none";
+    none.window = false;
+    list.append( none );
+
+    BenchPredicate port = none;
+    port.name = "port can1";
+    port.ports << "can1";
+    list.append( port );
+
+    BenchPredicate addr = none;
+    addr.name = "address 05";
+    addr.addrs << "05";
+    list.append( addr );
+
+    BenchPredicate type = none;
+    type.name = "type tpdo1";
+    type.funcs.append( uint( map.value( T_PDO_1 ) ) );
+    list.append( type );
+
+    BenchPredicate objIdx = none;
+    objIdx.name = "objidx 1008";
+    objIdx.objIdxs << "1008";
+    list.append( objIdx );
+
+    BenchPredicate window = none;
+    window.name = "time window";
+    window.window = true;
+    list.append( window );
+
+    BenchPredicate mask = none;
+    mask.name = "payload mask";
+    mask.payload = "FF/43";
+    list.append( mask );
+
+    BenchPredicate bit = none;
+    bit.name = "payload bit";
+    bit.payload = "0.0";
+    list.append( bit );
+
+    BenchPredicate range = none;
+    range.name = "payload range";
+    range.payload = "i1..2 > 0";
+    list.append( range );
+
+    BenchPredicate combined = none;
+    combined.name = "combined";
+    combined.addrs << "05";
+    combined.funcs.append( uint( map.value( T_PDO_1 ) ) );
+    combined.payload = "i1..2 > 0";
+    combined.window = true;
+    list.append( combined );
+
+    return list;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		filterAll
+
+Purpose		Runs a filter over a whole table the way a full scan in
+            Parser::filterFrames does (index candidates, clipped to the time
+            window), on the calling thread
+
+Input       table   - frames to filter
+            index   - index built over table
+            sdo     - SDO transfers of table
+            filter  - compiled filter
+            matches - set to the frames that make it through
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void filterAll( const FrameTable& table, const FrameIndex& index, const SdoTable& sdo,
+                       const FrameFilter& filter, QVector<FrameId>& matches )
+{
+    matches.clear();
+
+    FrameId timeBegin = 0;
+    FrameId timeEnd = FrameId( index.size() );
+    if ( filter.hasTimeWindow() )
+        index.timeRange( filter.timeFrom(), filter.timeTo(), timeBegin, timeEnd );
+
+    QVector<FrameId> candidates;
+    if ( index.candidates( filter, candidates ) )
+    {
+        QVector<FrameId>::iterator first =
+            std::lower_bound( candidates.begin(), candidates.end(), timeBegin );
+        QVector<FrameId>::iterator last =
+            std::lower_bound( first, candidates.end(), timeEnd );
+        filter.filter( table, sdo, candidates, int( first - candidates.begin() ),
+                       int( last - candidates.begin() ), matches );
+        return;
+    }
+
+    filter.filter( table, sdo, timeBegin, timeEnd, matches );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		benchIngest
+
+Purpose		Tokenizes a dump repeatedly, then builds its index and SDO
+            transfers.  The table, index and transfers of the last run are
+            handed back for the filter benchmark.
+
+Return      the ingest results as a JSON object
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QJsonObject benchIngest( const char* begin, const char* end, int repeat,
+                                FrameTable& table, FrameIndex& index, SdoTable& sdo )
+{
+    const double megabytes = double( end - begin ) / ( 1024 * 1024 );
+    QVector<double> rates;
+    int skipped = 0;
+
+    for ( int r = 0; r < repeat; ++r )
+    {
+        table = FrameTable();
+        IngestReport report = FrameIngest::parseParallel( begin, end, table );
+        rates.append( megabytes / ( qMax( report.nsecs, qint64( 1 ) ) / 1e9 ) );
+        skipped = report.skipped;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    index.build( table );
+    const double indexMsecs = timer.nsecsElapsed() / 1e6;
+
+    SdoAssembler assembler;
+    timer.start();
+    assembler.build( table, index, sdo );
+    const double sdoMsecs = timer.nsecsElapsed() / 1e6;
+
+    QJsonObject result;
+    result.insert( "frames", table.size() );
+    result.insert( "skipped", skipped );
+    result.insert( "best_mbps", *std::max_element( rates.constBegin(), rates.constEnd() ) );
+    result.insert( "median_mbps", median( rates ) );
+    result.insert( "index_ms", indexMsecs );
+    result.insert( "sdo_ms", sdoMsecs );
+    result.insert( "sdo_transfers", sdo.size() );
+    result.insert( "threads", QThread::idealThreadCount() );
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		benchFilters
+
+Purpose		Times a full scan under each predicate
+
+Return      the results as a JSON array, one object per predicate
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QJsonArray benchFilters( const FrameTable& table, const FrameIndex& index,
+                                const SdoTable& sdo, int repeat )
+{
+    // Middle tenth of the timestamps; plain dumps have none to window
+    qint64 windowFrom = NO_TIMESTAMP;
+    qint64 windowTo = NO_TIMESTAMP;
+    if ( !table.isEmpty() )
+    {
+        windowFrom = table.time( FrameId( table.size() * 0.45 ) );
+        windowTo = table.time( FrameId( table.size() * 0.55 ) );
+    }
+
+    QJsonArray results;
+    const QVector<BenchPredicate> list = predicates();
+    for ( int p = 0; p < list.size(); ++p )
+    {
+        const BenchPredicate& predicate = list.at(p);
+        if ( predicate.window && windowFrom == NO_TIMESTAMP )
+            continue;
+
+        FrameFilter filter;
+        filter.compile( predicate.ports, predicate.addrs, predicate.objIdxs, QStringList(),
+                        predicate.funcs, table.ifaces() );
+        QString badTerm;
+        filter.setPayload( predicate.payload, badTerm );
+        if ( predicate.window )
+            filter.setTimeWindow( windowFrom, windowTo );
+
+        QVector<double> msecs;
+        QVector<FrameId> matches;
+        for ( int r = 0; r < repeat; ++r )
+        {
+            QElapsedTimer timer;
+            timer.start();
+            filterAll( table, index, sdo, filter, matches );
+            msecs.append( timer.nsecsElapsed() / 1e6 );
+        }
+
+        QJsonObject result;
+        result.insert( "predicate", predicate.name );
+        result.insert( "median_ms", median( msecs ) );
+        result.insert( "min_ms", *std::min_element( msecs.constBegin(), msecs.constEnd() ) );
+        result.insert( "matches", matches.size() );
+        results.append( result );
+    }
+
+    return results;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		benchFirstRender
+
+Purpose		Loads a dump through a Parser, as the main window does, and
+            times the load, the first block of matches and the end of the
+            background parse
+
+Return      the results as a JSON object
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QJsonObject benchFirstRender( const QString& fileName, int repeat )
+{
+    QVector<double> loads;
+    QVector<double> firsts;
+    QVector<double> parses;
+
+    for ( int r = 0; r < repeat; ++r )
+    {
+        QEventLoop loop;
+        Parser parser;
+        BenchProbe probe( loop );
+        QObject::connect( &parser, SIGNAL(matchesAdded(QVector<FrameId>)),
+                          &probe, SLOT(matchesAdded(QVector<FrameId>)) );
+        QObject::connect( &parser, SIGNAL(progressChanged(int)),
+                          &probe, SLOT(progressChanged(int)) );
+
+        probe.start();
+        QElapsedTimer timer;
+        timer.start();
+        if ( !parser.loadFile( fileName ) )
+            break;
+        loads.append( timer.nsecsElapsed() / 1e6 );
+
+        QTimer::singleShot( FIRST_RENDER_TIMEOUT, &loop, SLOT(quit()) );
+        if ( probe.finished() < 0 )
+            loop.exec();
+
+        firsts.append( probe.firstMatches() );
+        parses.append( probe.finished() );
+    }
+
+    QJsonObject result;
+    result.insert( "load_ms", median( loads ) );
+    result.insert( "first_matches_ms", median( firsts ) );
+    result.insert( "parse_ms", median( parses ) );
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		sameFrames
+
+Purpose		Compares two tables column by column (all but the line offsets),
+            interface by name
+
+Input       a, b          - tables to compare
+            untimedAsZero - compare frames without a timestamp as time zero
+            difference    - set to the first frame that differs
+
+Return      true if the tables hold the same frames
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool sameFrames( const FrameTable& a, const FrameTable& b, bool untimedAsZero,
+                        QString& difference )
+{
+    if ( a.size() != b.size() )
+    {
+        difference = QString( "%1 frames against %2" ).arg( a.size() ).arg( b.size() );
+        return false;
+    }
+
+    for ( int i = 0; i < a.size(); ++i )
+    {
+        const FrameId f = FrameId( i );
+        qint64 timeA = a.time( f );
+        qint64 timeB = b.time( f );
+        if ( untimedAsZero )
+        {
+            timeA = qMax<qint64>( timeA, 0 );
+            timeB = qMax<qint64>( timeB, 0 );
+        }
+
+        if ( timeA != timeB || a.cobId( f ) != b.cobId( f ) || a.dlc( f ) != b.dlc( f ) ||
+             a.data( f ) != b.data( f ) || a.flags( f ) != b.flags( f ) ||
+             a.ifaces().value( a.iface( f ) ) != b.ifaces().value( b.iface( f ) ) )
+        {
+            difference = QString( "frame %1 reads \"%2\" against \"%3\"" )
+                         .arg( i )
+                         .arg( FrameIngest::formatLine( a, f ) )
+                         .arg( FrameIngest::formatLine( b, f ) );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		checkLog
+
+Purpose		Tokenizes a dump, exports the frames as a candump -l log, reads
+            the log back and compares the two tables
+
+Input       text       - dump
+            dir        - directory the log is written to (and removed from)
+            frames     - set to the number of frames compared
+            difference - set to the first difference, or the error
+
+Return      true if the log reads back into the same frames
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool checkLog( const QByteArray& text, const QString& dir, int& frames,
+                      QString& difference )
+{
+    FrameTable fromText;
+    FrameIngest::parseParallel( text.constData(), text.constData() + text.size(), fromText );
+    frames = fromText.size();
+
+    const QString logName = QDir( dir ).filePath( "candump-check.log" );
+    if ( !CaptureFile::exportLog( logName, fromText, difference ) )
+        return false;
+
+    QFile log( logName );
+    if ( !log.open( QIODevice::ReadOnly ) )
+    {
+        difference = log.errorString();
+        return false;
+    }
+    const QByteArray logText = log.readAll();
+    log.close();
+    QFile::remove( logName );
+
+    FrameTable fromLog;
+    FrameIngest::parseParallel( logText.constData(), logText.constData() + logText.size(),
+                                fromLog );
+
+    // The log writes frames without a timestamp at time zero
+    return sameFrames( fromText, fromLog, true, difference );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		referenceLine
+
+Purpose		Tokenizes a line the way the original parser did, splitting it on
+            white space and reading the fields by position: timestamp (when
+            the line starts with one), port, cob-id, [dlc] and data bytes.
+            A cob-id#data token is read as the candump -l form.
+
+Input       line  - line without its line break
+            table - table the frame is appended to
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void referenceLine( const QString& line, FrameTable& table )
+{
+    const QStringList tokens = line.trimmed().split( QRegExp( "\\s+" ), QString::SkipEmptyParts );
+    if ( tokens.isEmpty() )
+        return;
+
+    FrameRecord rec;
+    rec.time = NO_TIMESTAMP;
+    rec.data = 0;
+    rec.dlc = 0;
+    rec.flags = 0;
+    rec.offset = 0;
+
+    int idx = 0;
+    if ( tokens.at(0).startsWith( "(" ) )
+    {
+        const QStringList stamp = tokens.at(0).mid( 1, tokens.at(0).size() - 2 ).split( "." );
+        const QString usecs = stamp.value( 1 ).left( 6 ).leftJustified( 6, '0' );
+        rec.time = stamp.at(0).toLongLong() * 1000000 + usecs.toLongLong();
+        idx = 1;
+    }
+    if ( tokens.size() < idx + 2 )
+        return;
+
+    const QString port = tokens.at( idx );
+    const QString idToken = tokens.at( idx + 1 );
+    const int hash = idToken.indexOf( "#" );
+    const QString id = ( hash < 0 ) ? idToken : idToken.left( hash );
+    rec.cobId = id.toUInt( 0, 16 );
+    if ( id.size() > 3 )
+        rec.flags |= FRAME_EFF;
+
+    if ( hash >= 0 )
+    {
+        // cob-id#data, cob-id#R<dlc> or cob-id##<flags>data
+        QString data = idToken.mid( hash + 1 );
+        if ( data.startsWith( "R", Qt::CaseInsensitive ) )
+        {
+            rec.dlc = quint8( qBound( 0, data.mid( 1, 1 ).toInt(), 8 ) );
+            rec.flags |= FRAME_RTR;
+        }
+        else
+        {
+            if ( data.startsWith( "#" ) )
+                data = data.mid( 2 );
+            const int bytes = data.size() / 2;
+            for ( int i = 0; i < qMin( bytes, 8 ); ++i )
+                rec.data |= quint64( data.mid( 2 * i, 2 ).toUInt( 0, 16 ) ) << ( 8 * i );
+            rec.dlc = quint8( qMin( bytes, 8 ) );
+        }
+    }
+    else
+    {
+        if ( tokens.size() < idx + 3 )
+            return;
+        const QString dlc = tokens.at( idx + 2 );
+        rec.dlc = quint8( qMin( dlc.mid( 1, dlc.size() - 2 ).toInt(), 8 ) );
+
+        if ( tokens.value( idx + 3 ) == "remote" )
+        {
+            rec.flags |= FRAME_RTR;
+        }
+        else
+        {
+            for ( int i = 0; i < rec.dlc && idx + 3 + i < tokens.size(); ++i )
+                rec.data |= quint64( tokens.at( idx + 3 + i ).toUInt( 0, 16 ) ) << ( 8 * i );
+        }
+    }
+
+    rec.iface = table.ifaceId( port );
+    table.append( rec );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		checkIngest
+
+Purpose		Tokenizes a dump with FrameIngest and with the reference
+            tokenizer and compares the two tables
+
+Input       text       - dump
+            frames     - set to the number of frames compared
+            mbps       - set to the throughput of FrameIngest, then of the
+                         reference, in MB/s
+            difference - set to the first difference
+
+Return      true if both read the same frames
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool checkIngest( const QByteArray& text, int& frames, double mbps[2],
+                         QString& difference )
+{
+    QElapsedTimer timer;
+
+    FrameTable ingested;
+    timer.start();
+    FrameIngest::parseParallel( text.constData(), text.constData() + text.size(), ingested );
+    const qint64 ingestNsecs = qMax<qint64>( timer.nsecsElapsed(), 1 );
+    frames = ingested.size();
+
+    FrameTable reference;
+    timer.start();
+    const QStringList lines = QString::fromLatin1( text ).split( QRegExp( "[\r\n]" ),
+                                                                 QString::SkipEmptyParts );
+    for ( int i = 0; i < lines.size(); ++i )
+        referenceLine( lines.at(i), reference );
+    const qint64 referenceNsecs = qMax<qint64>( timer.nsecsElapsed(), 1 );
+
+    mbps[0] = text.size() * 1000.0 / ingestNsecs;
+    mbps[1] = text.size() * 1000.0 / referenceNsecs;
+
+    return sameFrames( ingested, reference, false, difference );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		main
+
+Purpose		Reads the options, generates (or reuses) a dump of each size and
+            runs the benchmarks over it
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Adds --check log
+            17 Oct 26  AFB	Adds --check ingest
+            17 Oct 26  AFB	Names kept dumps by mix, nodes and interfaces too
+----------------------------------------------------------------------------*/
+int main( int argc, char *argv[] )
+{
+    QCoreApplication app( argc, argv );
+    QCoreApplication::setApplicationName( "canDumpBench" );
+
+    QCommandLineParser cmd;
+    cmd.setApplicationDescription( "Benchmarks the dump parser on synthetic CANopen dumps." );
+    cmd.addHelpOption();
+
+    QCommandLineOption sizesOpt( "sizes", "Dump sizes, e.g. 1M,64M,10G.", "sizes", "1M,16M,128M" );
+    QCommandLineOption formatOpt( "format", "Dump form: plain, timestamped or log.",
+                                  "format", "timestamped" );
+    QCommandLineOption mixOpt( "mix", "Traffic weights, e.g. nmt=1,pdo=80,sdo=5,hb=14.", "mix" );
+    QCommandLineOption nodesOpt( "nodes", "Number of nodes (1 to 127).", "nodes", "16" );
+    QCommandLineOption ifacesOpt( "ifaces", "Number of interfaces.", "ifaces", "2" );
+    QCommandLineOption seedOpt( "seed", "Generator seed.", "seed", "1" );
+    QCommandLineOption repeatOpt( "repeat", "Runs of each measurement.", "repeat", "5" );
+    QCommandLineOption dirOpt( "dir", "Directory dumps are written to.", "dir", QDir::tempPath() );
+    QCommandLineOption keepOpt( "keep", "Keep the dumps for later runs." );
+    QCommandLineOption outOpt( "out", "JSON results file.", "file", "bench.json" );
+    QCommandLineOption generateOpt( "generate", "Only write a dump of the first size to a file.",
+                                    "file" );
+    QCommandLineOption checkOpt( "check", "Only check a dump of the first size: log (export "
+                                 "and read back as a candump -l log) or ingest (against a "
+                                 "reference tokenizer).", "check" );
+    cmd.addOption( sizesOpt );
+    cmd.addOption( formatOpt );
+    cmd.addOption( mixOpt );
+    cmd.addOption( nodesOpt );
+    cmd.addOption( ifacesOpt );
+    cmd.addOption( seedOpt );
+    cmd.addOption( repeatOpt );
+    cmd.addOption( dirOpt );
+    cmd.addOption( keepOpt );
+    cmd.addOption( outOpt );
+    cmd.addOption( generateOpt );
+    cmd.addOption( checkOpt );
+    cmd.process( app );
+
+    QVector<qint64> sizes;
+    QStringList sizeList = cmd.value( sizesOpt ).split( ',', QString::SkipEmptyParts );
+    for ( int i = 0; i < sizeList.size(); ++i )
+    {
+        qint64 bytes = 0;
+        if ( !parseSize( sizeList.at(i), bytes ) )
+        {
+            fprintf( stderr, "Unknown size: %s\n", qPrintable( sizeList.at(i) ) );
+            return 2;
+        }
+        sizes.append( bytes );
+    }
+    // Smallest first, so the peak RSS after each size is that size's own
+    std::sort( sizes.begin(), sizes.end() );
+
+    DumpGenerator::Format format;
+    if ( !DumpGenerator::parseFormat( cmd.value( formatOpt ), format ) )
+    {
+        fprintf( stderr, "Unknown format: %s\n", qPrintable( cmd.value( formatOpt ) ) );
+        return 2;
+    }
+
+    DumpMix mix;
+    if ( cmd.isSet( mixOpt ) && !DumpGenerator::parseMix( cmd.value( mixOpt ), mix ) )
+    {
+        fprintf( stderr, "Unknown mix: %s\n", qPrintable( cmd.value( mixOpt ) ) );
+        return 2;
+    }
+
+    const quint64 seed = cmd.value( seedOpt ).toULongLong();
+    const int repeat = qMax( cmd.value( repeatOpt ).toInt(), 1 );
+
+    DumpGenerator generator( seed );
+    generator.setFormat( format );
+    generator.setMix( mix );
+    generator.setNodes( cmd.value( nodesOpt ).toInt() );
+    generator.setIfaces( cmd.value( ifacesOpt ).toInt() );
+
+    QString error;
+    if ( cmd.isSet( generateOpt ) )
+    {
+        if ( sizes.isEmpty() )
+            return 2;
+
+        if ( !generator.write( cmd.value( generateOpt ), sizes.first(), error ) )
+        {
+            fprintf( stderr, "%s\n", qPrintable( error ) );
+            return 1;
+        }
+        return 0;
+    }
+
+    if ( cmd.isSet( checkOpt ) )
+    {
+        const QString check = cmd.value( checkOpt );
+        if ( sizes.isEmpty() || ( check != "log" && check != "ingest" ) )
+        {
+            fprintf( stderr, "Unknown check: %s\n", qPrintable( check ) );
+            return 2;
+        }
+
+        QByteArray text;
+        DumpGenerator fresh = generator;
+        fresh.generate( text, sizes.first() );
+        text.append( CHECK_LINES );
+
+        int frames = 0;
+        QString difference;
+        if ( check == "ingest" )
+        {
+            double mbps[2];
+            if ( !checkIngest( text, frames, mbps, difference ) )
+            {
+                fprintf( stderr, "ingest: %s\n", qPrintable( difference ) );
+                return 1;
+            }
+            printf( "ingest: %d frames read the same as the reference "
+                    "(%.0f MB/s against %.0f MB/s)\n", frames, mbps[0], mbps[1] );
+            return 0;
+        }
+
+        if ( !checkLog( text, cmd.value( dirOpt ), frames, difference ) )
+        {
+            fprintf( stderr, "log: %s\n", qPrintable( difference ) );
+            return 1;
+        }
+        printf( "log: %d frames read back the same\n", frames );
+        return 0;
+    }
+
+    // Traffic mix, nodes and interfaces, as they go into the dump names
+    const QString dumpSettings = QString( "mix%1.%2.%3.%4-nodes%5-ifaces%6" )
+                                 .arg( mix.nmt ).arg( mix.pdo ).arg( mix.sdo )
+                                 .arg( mix.heartbeat )
+                                 .arg( cmd.value( nodesOpt ).toInt() )
+                                 .arg( cmd.value( ifacesOpt ).toInt() );
+
+    QJsonArray runs;
+    for ( int s = 0; s < sizes.size(); ++s )
+    {
+        // Every dump starts from the seed, so the generator settings and a
+        // size name one dump
+        const QString fileName = QDir( cmd.value( dirOpt ) ).filePath(
+            QString( "candump-%1-%2-%3-%4.txt" ).arg( seed ).arg( cmd.value( formatOpt ) )
+                                                .arg( dumpSettings ).arg( sizes.at(s) ) );
+        const bool reuse = QFileInfo( fileName ).size() >= sizes.at(s);
+        if ( !reuse )
+        {
+            DumpGenerator fresh = generator;
+            fprintf( stderr, "Writing %s\n", qPrintable( fileName ) );
+            if ( !fresh.write( fileName, sizes.at(s), error ) )
+            {
+                fprintf( stderr, "%s\n", qPrintable( error ) );
+                return 1;
+            }
+        }
+
+        QFile file( fileName );
+        if ( !file.open( QIODevice::ReadOnly ) )
+        {
+            fprintf( stderr, "%s: %s\n", qPrintable( fileName ), qPrintable( file.errorString() ) );
+            return 1;
+        }
+
+        QJsonObject run;
+        run.insert( "dump", QFileInfo( fileName ).fileName() );
+        run.insert( "reused", reuse );
+        run.insert( "bytes", file.size() );
+
+        {
+            const char* raw = reinterpret_cast<const char*>( file.map( 0, file.size() ) );
+            if ( !raw )
+            {
+                fprintf( stderr, "%s: could not be mapped\n", qPrintable( fileName ) );
+                return 1;
+            }
+
+            FrameTable table;
+            FrameIndex index;
+            SdoTable sdo;
+            fprintf( stderr, "Ingest %lld bytes\n", sizes.at(s) );
+            run.insert( "ingest", benchIngest( raw, raw + file.size(), repeat, table, index, sdo ) );
+            fprintf( stderr, "Filters\n" );
+            run.insert( "filters", benchFilters( table, index, sdo, repeat ) );
+
+            file.unmap( reinterpret_cast<uchar*>( const_cast<char*>( raw ) ) );
+            file.close();
+        }
+
+        fprintf( stderr, "First render\n" );
+        run.insert( "first_render", benchFirstRender( fileName, repeat ) );
+        run.insert( "peak_rss_kb", peakRss() );
+        runs.append( run );
+
+        const QJsonObject ingest = run.value( "ingest" ).toObject();
+        const QJsonObject render = run.value( "first_render" ).toObject();
+        printf( "%12lld bytes  %10d frames  %8.1f MB/s  first matches %8.1f ms  "
+                "peak RSS %lld KB\n",
+                file.size(), ingest.value( "frames" ).toInt(),
+                ingest.value( "best_mbps" ).toDouble(),
+                render.value( "first_matches_ms" ).toDouble(), peakRss() );
+        const QJsonArray filters = run.value( "filters" ).toArray();
+        for ( int f = 0; f < filters.size(); ++f )
+        {
+            const QJsonObject result = filters.at(f).toObject();
+            printf( "    %-16s %10.3f ms  %10d matches\n",
+                    qPrintable( result.value( "predicate" ).toString() ),
+                    result.value( "median_ms" ).toDouble(),
+                    result.value( "matches" ).toInt() );
+        }
+        fflush( stdout );
+
+        if ( !reuse && !cmd.isSet( keepOpt ) )
+            QFile::remove( fileName );
+    }
+
+    QJsonObject settings;
+    settings.insert( "seed", QString::number( seed ) );
+    settings.insert( "format", cmd.value( formatOpt ) );
+    settings.insert( "mix", QString( "nmt=%1,pdo=%2,sdo=%3,hb=%4" )
+                                .arg( mix.nmt ).arg( mix.pdo ).arg( mix.sdo ).arg( mix.heartbeat ) );
+    settings.insert( "nodes", cmd.value( nodesOpt ).toInt() );
+    settings.insert( "ifaces", cmd.value( ifacesOpt ).toInt() );
+    settings.insert( "repeat", repeat );
+
+    QJsonObject results;
+    results.insert( "settings", settings );
+    results.insert( "runs", runs );
+
+    QFile out( cmd.value( outOpt ) );
+    if ( !out.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        fprintf( stderr, "%s: %s\n", qPrintable( out.fileName() ), qPrintable( out.errorString() ) );
+        return 1;
+    }
+    out.write( QJsonDocument( results ).toJson() );
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+/*----------------------------------------------------------------------------
+
+Name		benchprobe.cpp
+
+Purpose		Parser listener for the benchmark.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "benchprobe.h"
+
+/*----------------------------------------------------------------------------
+
+Name		BenchProbe
+
+Purpose		Constructor
+
+Input       loop   - event loop to end when a parse is done
+            parent - owning object
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+BenchProbe::BenchProbe( QEventLoop& loop, QObject* parent )
+    : QObject( parent ),
+      mLoop( loop ),
+      mFirstMatches( -1 ),
+      mFinished( -1 ),
+      mMatches( 0 )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		start
+
+Purpose		Starts the clock for a new run
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void BenchProbe::start()
+{
+    mFirstMatches = -1;
+    mFinished = -1;
+    mMatches = 0;
+    mTimer.start();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		matchesAdded
+
+Purpose		Notes when the first block of matches arrives
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void BenchProbe::matchesAdded( const QVector<FrameId>& matches )
+{
+    if ( mFirstMatches < 0 )
+        mFirstMatches = mTimer.elapsed();
+
+    mMatches += matches.size();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		progressChanged
+
+Purpose		Ends the event loop once the parse has tested every frame
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void BenchProbe::progressChanged( int percent )
+{
+    if ( percent < 100 || mFinished >= 0 )
+        return;
+
+    mFinished = mTimer.elapsed();
+    mLoop.quit();
+}
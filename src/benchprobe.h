@@ -0,0 +1,49 @@
+/*----------------------------------------------------------------------------
+
+Name		benchprobe.h
+
+Purpose		Listens to a Parser for the benchmark, noting when the first
+            block of matches arrives (what the table would first render)
+            and ending the event loop once the background parse is done.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef BENCHPROBE_H
+#define BENCHPROBE_H
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QObject>
+#include <QVector>
+#include "frametable.h"
+
+class BenchProbe : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BenchProbe( QEventLoop& loop, QObject* parent = 0 );
+
+    // Starts the clock and forgets the last run
+    void start();
+
+    // Milliseconds from start to the first matches (-1 if none came)
+    qint64 firstMatches() const { return mFirstMatches; }
+    // Milliseconds from start to the end of the parse (-1 if not done)
+    qint64 finished() const { return mFinished; }
+    // Matches delivered since start
+    qint64 matches() const { return mMatches; }
+
+public slots:
+    void matchesAdded( const QVector<FrameId>& matches );
+    void progressChanged( int percent );
+
+private:
+    QEventLoop& mLoop;              // Loop ended when the parse is done
+    QElapsedTimer mTimer;           // Running since start
+    qint64 mFirstMatches;
+    qint64 mFinished;
+    qint64 mMatches;
+};
+
+#endif // BENCHPROBE_H
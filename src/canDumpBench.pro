@@ -0,0 +1,58 @@
+#-------------------------------------------------
+#
+# Benchmark: times ingest, filtering and the first
+# render on generated CANopen dumps and writes the
+# results as JSON.
+#
+#-------------------------------------------------
+
+QT       += core concurrent
+QT       -= gui
+CONFIG   += C++11 console
+CONFIG   -= app_bundle
+
+TARGET = canDumpBench
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# See canDumpDisplay.pro
+#QMAKE_CXXFLAGS += -mavx2
+
+
+SOURCES += benchmain.cpp \
+    benchprobe.cpp \
+    dumpgenerator.cpp \
+    parser.cpp \
+    frametable.cpp \
+    frameingest.cpp \
+    framefilter.cpp \
+    frameindex.cpp \
+    framemerger.cpp \
+    trigramindex.cpp \
+    linesearch.cpp \
+    objectdictionary.cpp \
+    signaltable.cpp \
+    signalpyramid.cpp \
+    nodetimeline.cpp \
+    capturefile.cpp \
+    sdoassembler.cpp \
+    stageprofile.cpp
+
+HEADERS  += benchprobe.h \
+    dumpgenerator.h \
+    parser.h \
+    frametable.h \
+    frameingest.h \
+    framefilter.h \
+    frameindex.h \
+    framemerger.h \
+    trigramindex.h \
+    linesearch.h \
+    objectdictionary.h \
+    signaltable.h \
+    signalpyramid.h \
+    nodetimeline.h \
+    capturefile.h \
+    sdoassembler.h \
+    stageprofile.h
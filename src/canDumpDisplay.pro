@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent
 CONFIG   += C++11
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
@@ -23,12 +23,76 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# The dump tokenizer uses SSE2 on x86-64.  Uncomment the following line to let
+# it scan for line breaks 32 bytes at a time on machines that support AVX2.
+#QMAKE_CXXFLAGS += -mavx2
+
 
 SOURCES += main.cpp\
         mainwindow.cpp \
-    parser.cpp
+    parser.cpp \
+    frametable.cpp \
+    frameingest.cpp \
+    framemodel.cpp \
+    framefilter.cpp \
+    frameindex.cpp \
+    framemerger.cpp \
+    trigramindex.cpp \
+    linesearch.cpp \
+    objectdictionary.cpp \
+    signaltable.cpp \
+    signalpyramid.cpp \
+    nodetimeline.cpp \
+    capturefile.cpp \
+    livesource.cpp \
+    sdoassembler.cpp \
+    framestats.cpp \
+    statsmodel.cpp \
+    statsdock.cpp \
+    searchmodel.cpp \
+    searchdock.cpp \
+    signalmodel.cpp \
+    signaldock.cpp \
+    plotwidget.cpp \
+    plotdock.cpp \
+    anomalymodel.cpp \
+    timelinewidget.cpp \
+    timelinedock.cpp \
+    livelimitsdialog.cpp \
+    stageprofile.cpp \
+    framedelegate.cpp
 
 HEADERS  += mainwindow.h \
-    parser.h
+    parser.h \
+    frametable.h \
+    frameingest.h \
+    framemodel.h \
+    framefilter.h \
+    frameindex.h \
+    framemerger.h \
+    trigramindex.h \
+    linesearch.h \
+    objectdictionary.h \
+    signaltable.h \
+    signalpyramid.h \
+    nodetimeline.h \
+    capturefile.h \
+    livesource.h \
+    sdoassembler.h \
+    framestats.h \
+    statsmodel.h \
+    statsdock.h \
+    searchmodel.h \
+    searchdock.h \
+    signalmodel.h \
+    signaldock.h \
+    plotwidget.h \
+    plotdock.h \
+    anomalymodel.h \
+    timelinewidget.h \
+    timelinedock.h \
+    livelimitsdialog.h \
+    stageprofile.h \
+    framedelegate.h
 
 FORMS    += mainwindow.ui
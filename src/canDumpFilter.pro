@@ -0,0 +1,54 @@
+#-------------------------------------------------
+#
+# Headless filter: streams a candump from stdin or
+# a file to stdout through the same filters as
+# canDumpDisplay.
+#
+#-------------------------------------------------
+
+QT       += core concurrent
+QT       -= gui
+CONFIG   += C++11 console
+CONFIG   -= app_bundle
+
+TARGET = canDumpFilter
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# See canDumpDisplay.pro
+#QMAKE_CXXFLAGS += -mavx2
+
+
+SOURCES += filtermain.cpp \
+    parser.cpp \
+    frametable.cpp \
+    frameingest.cpp \
+    framefilter.cpp \
+    frameindex.cpp \
+    framemerger.cpp \
+    trigramindex.cpp \
+    linesearch.cpp \
+    objectdictionary.cpp \
+    signaltable.cpp \
+    signalpyramid.cpp \
+    nodetimeline.cpp \
+    capturefile.cpp \
+    sdoassembler.cpp \
+    stageprofile.cpp
+
+HEADERS  += parser.h \
+    frametable.h \
+    frameingest.h \
+    framefilter.h \
+    frameindex.h \
+    framemerger.h \
+    trigramindex.h \
+    linesearch.h \
+    objectdictionary.h \
+    signaltable.h \
+    signalpyramid.h \
+    nodetimeline.h \
+    capturefile.h \
+    sdoassembler.h \
+    stageprofile.h
@@ -0,0 +1,587 @@
+/*----------------------------------------------------------------------------
+
+Name		capturefile.cpp
+
+Purpose		Binary capture files.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "capturefile.h"
+#include <QByteArray>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QStringList>
+#include <QSysInfo>
+#include <QtConcurrent>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+// First bytes of every capture file
+static const char CAPTURE_MAGIC[4] = { 'C', 'D', 'C', 'F' };
+
+// zlib level used when saving; the fastest level already shrinks the
+// columns several times over
+static const int CAPTURE_COMPRESSION = 1;
+
+// Size the log text is written out in
+static const int LOG_BUFFER = 1024 * 1024;
+
+// Columns held in a capture, in file order
+enum CaptureColumn
+    {
+    COL_TIMES,
+    COL_IFACES,
+    COL_COB_IDS,
+    COL_DLCS,
+    COL_DATA,
+    COL_FLAGS,
+    COL_COB_POSTINGS,
+    COL_COB_STARTS,
+    COL_IFACE_POSTINGS,
+    COL_IFACE_STARTS,
+    COL_COUNT
+    };
+
+// One block of a column
+struct CaptureBlock
+{
+    quint8  column;         // CaptureColumn the block belongs to
+    bool    compressed;     // True if stored zlib compressed
+    qint64  offset;         // Offset of the stored block in the file
+    quint32 stored;         // Size of the stored block
+    quint32 raw;            // Size of the block once uncompressed
+
+    const char* src;        // Saving: column data; loading: stored block
+    char* dest;             // Loading: column data
+    QByteArray packed;      // Saving: compressed block
+    bool ok;                // Loading: false if the block did not unpack
+};
+
+/*----------------------------------------------------------------------------
+
+Name		packBlock
+
+Purpose		Compresses a block (run on a worker thread).  Blocks that do not
+            get smaller are stored as they are.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void packBlock( CaptureBlock& block )
+{
+    block.packed = qCompress( reinterpret_cast<const uchar*>( block.src ),
+                              int( block.raw ), CAPTURE_COMPRESSION );
+
+    block.compressed = ( quint32( block.packed.size() ) < block.raw );
+    if ( !block.compressed )
+        block.packed.clear();
+    block.stored = block.compressed ? quint32( block.packed.size() ) : block.raw;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		unpackBlock
+
+Purpose		Copies or decompresses a block from the mapping into its column
+            (run on a worker thread)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void unpackBlock( CaptureBlock& block )
+{
+    if ( !block.compressed )
+    {
+        memcpy( block.dest, block.src, block.raw );
+        block.ok = true;
+        return;
+    }
+
+    QByteArray raw = qUncompress( reinterpret_cast<const uchar*>( block.src ),
+                                  int( block.stored ) );
+    block.ok = ( quint32( raw.size() ) == block.raw );
+    if ( block.ok )
+        memcpy( block.dest, raw.constData(), block.raw );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		writeHeader
+
+Purpose		Serializes the capture header and block directory
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QByteArray writeHeader( int frames, const QStringList& ifaces,
+                               const QVector<CaptureBlock>& blocks )
+{
+    QByteArray header;
+    QDataStream out( &header, QIODevice::WriteOnly );
+    out.setVersion( QDataStream::Qt_5_0 );
+
+    out << CAPTURE_VERSION << quint8( QSysInfo::ByteOrder )
+        << qint32( frames ) << ifaces << quint32( blocks.size() );
+
+    for ( int i = 0; i < blocks.size(); ++i )
+    {
+        const CaptureBlock& block = blocks.at(i);
+        out << block.column << quint8( block.compressed ) << block.offset
+            << block.stored << block.raw;
+    }
+
+    return header;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		postingsFit
+
+Purpose		Returns true if restored posting lists index a table's column:
+            the starts run from 0 to frames without going back, and every
+            list holds frames of its own bucket in ascending order
+
+Input       postings - frames grouped by bucket
+            starts   - start of each bucket's list in postings
+            keys     - column the lists were grouped by
+            wide     - bucket keys at or above it are filed under
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+template <typename T>
+static bool postingsFit( const QVector<FrameId>& postings, const QVector<int>& starts,
+                         const QVector<T>& keys, quint32 wide )
+{
+    if ( starts.isEmpty() || starts.first() != 0 || starts.last() != keys.size() ||
+         postings.size() != keys.size() )
+        return false;
+
+    for ( int b = 0; b + 1 < starts.size(); ++b )
+    {
+        const int from = starts.at( b );
+        const int to = starts.at( b + 1 );
+        if ( to < from )
+            return false;
+
+        for ( int i = from; i < to; ++i )
+        {
+            const FrameId f = postings.at(i);
+            if ( f >= FrameId( keys.size() ) || ( i > from && f <= postings.at( i - 1 ) ) ||
+                 qMin<quint32>( keys.at( f ), wide ) != quint32( b ) )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		isCapture
+
+Purpose		Returns true if the data starts like a capture file
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool CaptureFile::isCapture( const char* begin, qint64 size )
+{
+    return size >= qint64( sizeof( CAPTURE_MAGIC ) ) &&
+           memcmp( begin, CAPTURE_MAGIC, sizeof( CAPTURE_MAGIC ) ) == 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		save
+
+Purpose		Writes a table and its index to a capture file.  Each column is
+            cut into blocks which are compressed on the thread pool; the file
+            is written through QSaveFile so a failed save leaves any earlier
+            file in place.
+
+Input       fileName - file to write
+            table    - frames to save
+            index    - index over table
+            error    - set to the reason if the save fails
+
+Return      true if the file was written
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Saves the frame flags
+----------------------------------------------------------------------------*/
+bool CaptureFile::save( const QString& fileName, const FrameTable& table,
+                        const FrameIndex& index, QString& error )
+{
+    // Live frames may have been appended since the index was built
+    FrameIndex rebuilt;
+    const FrameIndex* idx = &index;
+    if ( index.size() != table.size() )
+    {
+        rebuilt.build( table );
+        idx = &rebuilt;
+    }
+
+    const char* columns[ COL_COUNT ];
+    qint64 bytes[ COL_COUNT ];
+
+#define CAPTURE_COLUMN( col, vec ) \
+    columns[ col ] = reinterpret_cast<const char*>( (vec).constData() ); \
+    bytes[ col ] = qint64( (vec).size() ) * qint64( sizeof( (vec).at(0) ) );
+
+    CAPTURE_COLUMN( COL_TIMES,          table.mTimes )
+    CAPTURE_COLUMN( COL_IFACES,         table.mIfaces )
+    CAPTURE_COLUMN( COL_COB_IDS,        table.mCobIds )
+    CAPTURE_COLUMN( COL_DLCS,           table.mDlcs )
+    CAPTURE_COLUMN( COL_DATA,           table.mData )
+    CAPTURE_COLUMN( COL_FLAGS,          table.mFlags )
+    CAPTURE_COLUMN( COL_COB_POSTINGS,   idx->mCobPostings )
+    CAPTURE_COLUMN( COL_COB_STARTS,     idx->mCobStart )
+    CAPTURE_COLUMN( COL_IFACE_POSTINGS, idx->mIfacePostings )
+    CAPTURE_COLUMN( COL_IFACE_STARTS,   idx->mIfaceStart )
+
+#undef CAPTURE_COLUMN
+
+    QVector<CaptureBlock> blocks;
+    for ( int col = 0; col < COL_COUNT; ++col )
+    {
+        for ( qint64 pos = 0; pos < bytes[ col ]; pos += CAPTURE_BLOCK )
+        {
+            CaptureBlock block;
+            block.column = quint8( col );
+            block.compressed = false;
+            block.offset = 0;
+            block.raw = quint32( qMin<qint64>( CAPTURE_BLOCK, bytes[ col ] - pos ) );
+            block.stored = block.raw;
+            block.src = columns[ col ] + pos;
+            block.dest = 0;
+            block.ok = true;
+            blocks.append( block );
+        }
+    }
+
+    QtConcurrent::blockingMap( blocks, packBlock );
+
+    // The directory is fixed width, so its size is known before the
+    // offsets are
+    qint64 offset = sizeof( CAPTURE_MAGIC ) +
+                    writeHeader( table.size(), table.ifaces(), blocks ).size();
+    for ( int i = 0; i < blocks.size(); ++i )
+    {
+        blocks[i].offset = offset;
+        offset += blocks.at(i).stored;
+    }
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    file.write( CAPTURE_MAGIC, sizeof( CAPTURE_MAGIC ) );
+    file.write( writeHeader( table.size(), table.ifaces(), blocks ) );
+    for ( int i = 0; i < blocks.size(); ++i )
+    {
+        const CaptureBlock& block = blocks.at(i);
+        if ( block.compressed )
+            file.write( block.packed );
+        else
+            file.write( block.src, block.raw );
+    }
+
+    if ( !file.commit() )
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		load
+
+Purpose		Restores a table and its index from a mapped capture file.  The
+            columns are sized from the frame count, checked against the
+            directory, and every block is unpacked straight into place on
+            the thread pool.  An index whose lists are not exactly the size
+            the table calls for is not unpacked at all, and one that does
+            not file every frame in its own bucket is rebuilt rather than
+            trusted.
+
+Input       begin, size - mapped capture file
+            table       - table to fill
+            index       - index to fill
+            error       - set to the reason if the load fails
+
+Return      true if the capture was restored
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Restores the frame flags
+            17 Oct 26  AFB	Checks the index sizes before unpacking and the lists after
+----------------------------------------------------------------------------*/
+bool CaptureFile::load( const char* begin, qint64 size, FrameTable& table,
+                        FrameIndex& index, QString& error )
+{
+    table.clear();
+    index.clear();
+
+    if ( !isCapture( begin, size ) )
+    {
+        error = QObject::tr( "Not a capture file" );
+        return false;
+    }
+
+    const qint64 headerAt = sizeof( CAPTURE_MAGIC );
+    QByteArray raw = QByteArray::fromRawData( begin + headerAt, int( qMin<qint64>( size - headerAt, INT_MAX ) ) );
+    QDataStream in( raw );
+    in.setVersion( QDataStream::Qt_5_0 );
+
+    quint16 version;
+    quint8 byteOrder;
+    qint32 frames;
+    QStringList ifaces;
+    quint32 blockCount;
+    in >> version >> byteOrder >> frames >> ifaces >> blockCount;
+
+    if ( in.status() != QDataStream::Ok || version != CAPTURE_VERSION || frames < 0 )
+    {
+        error = QObject::tr( "Unsupported capture version" );
+        return false;
+    }
+    if ( byteOrder != quint8( QSysInfo::ByteOrder ) )
+    {
+        error = QObject::tr( "Capture was saved on a machine of the other byte order" );
+        return false;
+    }
+
+    // Each directory entry takes 18 bytes of the header
+    if ( qint64( blockCount ) * 18 > size )
+    {
+        error = QObject::tr( "Capture file is damaged" );
+        return false;
+    }
+
+    QVector<CaptureBlock> blocks( static_cast<int>( blockCount ) );
+    qint64 bytes[ COL_COUNT ] = { 0 };
+    for ( int i = 0; i < blocks.size(); ++i )
+    {
+        CaptureBlock& block = blocks[i];
+        quint8 compressed;
+        in >> block.column >> compressed >> block.offset >> block.stored >> block.raw;
+        block.compressed = ( compressed != 0 );
+        block.ok = false;
+
+        if ( in.status() != QDataStream::Ok || block.column >= COL_COUNT ||
+             block.offset < 0 || block.offset + block.stored > size ||
+             ( !block.compressed && block.stored != block.raw ) )
+        {
+            error = QObject::tr( "Capture file is damaged" );
+            return false;
+        }
+
+        block.src = begin + block.offset;
+        bytes[ block.column ] += block.raw;
+    }
+
+    if ( bytes[ COL_TIMES ]   != qint64( frames ) * 8 ||
+         bytes[ COL_IFACES ]  != qint64( frames ) ||
+         bytes[ COL_COB_IDS ] != qint64( frames ) * 4 ||
+         bytes[ COL_DLCS ]    != qint64( frames ) ||
+         bytes[ COL_DATA ]    != qint64( frames ) * 8 ||
+         bytes[ COL_FLAGS ]   != qint64( frames ) )
+    {
+        error = QObject::tr( "Capture file is damaged" );
+        return false;
+    }
+
+    // The index is only restored when every list is exactly the size the
+    // table calls for (the interface lists are kept for several
+    // interfaces only); otherwise its blocks are passed over and it is
+    // built again
+    const bool ifaceLists = ( ifaces.size() > 1 );
+    const bool indexSized =
+        bytes[ COL_COB_POSTINGS ]   == qint64( frames ) * qint64( sizeof( FrameId ) ) &&
+        bytes[ COL_COB_STARTS ]     == qint64( WIDE_COB_BUCKET + 2 ) * qint64( sizeof( int ) ) &&
+        bytes[ COL_IFACE_POSTINGS ] == ( ifaceLists ? qint64( frames ) * qint64( sizeof( FrameId ) ) : 0 ) &&
+        bytes[ COL_IFACE_STARTS ]   == ( ifaceLists ? qint64( 257 ) * qint64( sizeof( int ) ) : 0 );
+    if ( !indexSized )
+    {
+        QVector<CaptureBlock> tableBlocks;
+        for ( int i = 0; i < blocks.size(); ++i )
+        {
+            if ( blocks.at(i).column < COL_COB_POSTINGS )
+                tableBlocks.append( blocks.at(i) );
+        }
+        blocks = tableBlocks;
+        for ( int col = COL_COB_POSTINGS; col < COL_COUNT; ++col )
+            bytes[ col ] = 0;
+    }
+
+    table.mTimes.resize( frames );
+    table.mIfaces.resize( frames );
+    table.mCobIds.resize( frames );
+    table.mDlcs.resize( frames );
+    table.mData.resize( frames );
+    table.mFlags.resize( frames );
+    if ( indexSized )
+    {
+        index.mCobPostings.resize( frames );
+        index.mCobStart.resize( int( WIDE_COB_BUCKET ) + 2 );
+        index.mIfacePostings.resize( ifaceLists ? frames : 0 );
+        index.mIfaceStart.resize( ifaceLists ? 257 : 0 );
+    }
+
+    char* columns[ COL_COUNT ];
+    columns[ COL_TIMES ]          = reinterpret_cast<char*>( table.mTimes.data() );
+    columns[ COL_IFACES ]         = reinterpret_cast<char*>( table.mIfaces.data() );
+    columns[ COL_COB_IDS ]        = reinterpret_cast<char*>( table.mCobIds.data() );
+    columns[ COL_DLCS ]           = reinterpret_cast<char*>( table.mDlcs.data() );
+    columns[ COL_DATA ]           = reinterpret_cast<char*>( table.mData.data() );
+    columns[ COL_FLAGS ]          = reinterpret_cast<char*>( table.mFlags.data() );
+    columns[ COL_COB_POSTINGS ]   = reinterpret_cast<char*>( index.mCobPostings.data() );
+    columns[ COL_COB_STARTS ]     = reinterpret_cast<char*>( index.mCobStart.data() );
+    columns[ COL_IFACE_POSTINGS ] = reinterpret_cast<char*>( index.mIfacePostings.data() );
+    columns[ COL_IFACE_STARTS ]   = reinterpret_cast<char*>( index.mIfaceStart.data() );
+
+    for ( int i = 0; i < blocks.size(); ++i )
+    {
+        CaptureBlock& block = blocks[i];
+        block.dest = columns[ block.column ];
+        columns[ block.column ] += block.raw;
+    }
+
+    QtConcurrent::blockingMap( blocks, unpackBlock );
+
+    for ( int i = 0; i < blocks.size(); ++i )
+    {
+        if ( !blocks.at(i).ok )
+        {
+            table.clear();
+            index.clear();
+            error = QObject::tr( "Capture file is damaged" );
+            return false;
+        }
+    }
+
+    // Interface ids index the name list (and arrays sized by it)
+    const quint8* ids = table.mIfaces.constData();
+    for ( int i = 0; i < frames; ++i )
+    {
+        if ( ids[i] >= ifaces.size() )
+        {
+            table.clear();
+            index.clear();
+            error = QObject::tr( "Capture file is damaged" );
+            return false;
+        }
+    }
+
+    // Frames from a capture have no text; their lines are written out
+    table.mOffsets.fill( -1, frames );
+    table.mIfaceNames = ifaces;
+    index.mSize = frames;
+
+    // Only trust an index whose lists file every frame in its own bucket
+    bool indexOk = indexSized &&
+                   postingsFit( index.mCobPostings, index.mCobStart, table.mCobIds, WIDE_COB_BUCKET ) &&
+                   ( !ifaceLists ||
+                     postingsFit( index.mIfacePostings, index.mIfaceStart, table.mIfaces, 256 ) );
+    if ( indexOk )
+    {
+        index.buildTimes( table );
+    }
+    else
+    {
+        index.clear();
+        index.build( table );
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		exportLog
+
+Purpose		Writes the frames out as a candump -l log:
+
+            (sec.usec) port cob-id#XXXXXXXXXXXXXXXX
+
+            with remote requests as cob-id#R<dlc> and 29 bit identifiers
+            as 8 digits, so the log reads back into the same columns.
+            Frames read without a timestamp are written at time zero.
+
+Input       fileName - log to write
+            table    - frames to write
+            error    - set to the reason if the export fails
+
+Return      true if the log was written
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Writes remote requests and 29 bit identifiers by their flags
+----------------------------------------------------------------------------*/
+bool CaptureFile::exportLog( const QString& fileName, const FrameTable& table,
+                             QString& error )
+{
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    QVector<QByteArray> names;
+    for ( int i = 0; i < table.ifaces().size(); ++i )
+        names.append( table.ifaces().at(i).toLatin1() );
+
+    static const char HEX[] = "0123456789ABCDEF";
+
+    QByteArray out;
+    out.reserve( LOG_BUFFER + 256 );
+    char line[ 128 ];
+
+    for ( int f = 0; f < table.size(); ++f )
+    {
+        qint64 time = qMax<qint64>( table.time( f ), 0 );
+        quint32 cobId = table.cobId( f );
+
+        int len = snprintf( line, sizeof( line ), "(%010lld.%06lld) %s %0*X#",
+                            static_cast<long long>( time / 1000000 ),
+                            static_cast<long long>( time % 1000000 ),
+                            names.value( table.iface( f ) ).constData(),
+                            table.isExtended( f ) ? 8 : 3, cobId );
+        len = qBound( 0, len, int( sizeof( line ) ) - 20 );
+
+        if ( table.isRemote( f ) )
+        {
+            line[ len++ ] = 'R';
+            line[ len++ ] = char( '0' + qMin<int>( table.dlc( f ), 8 ) );
+        }
+        else
+        {
+            quint64 data = table.data( f );
+            for ( int i = 0; i < table.dlc( f ) && i < 8; ++i )
+            {
+                line[ len++ ] = HEX[ ( data >> ( 8 * i + 4 ) ) & 0xF ];
+                line[ len++ ] = HEX[ ( data >> ( 8 * i ) ) & 0xF ];
+            }
+        }
+        line[ len++ ] = '\n';
+
+        out.append( line, len );
+        if ( out.size() >= LOG_BUFFER )
+        {
+            file.write( out );
+            out.resize( 0 );
+        }
+    }
+    file.write( out );
+
+    if ( !file.commit() )
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,61 @@
+/*----------------------------------------------------------------------------
+
+Name		capturefile.h
+
+Purpose		Binary capture files.  A capture holds the frame table and its
+            index exactly as they are held in memory, so reopening one skips
+            tokenizing and indexing altogether:
+
+                header    - magic, version, byte order, frame count,
+                            interface names and the block directory
+                            (QDataStream)
+                blocks    - each column cut into blocks of at most
+                            CAPTURE_BLOCK bytes, zlib compressed unless
+                            that does not save space
+
+            Blocks are compressed and decompressed in parallel, straight
+            between the file mapping and the columns.
+
+            Frames can also be written out as a candump -l log.  Logs are
+            read back through the text path (FrameIngest reads the log form).
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Version 2 adds the frame flags column
+----------------------------------------------------------------------------*/
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <QString>
+#include <QVector>
+#include "frameindex.h"
+#include "frametable.h"
+
+// Largest uncompressed size of one block
+const int CAPTURE_BLOCK = 4 * 1024 * 1024;
+
+// Current version of the capture format
+const quint16 CAPTURE_VERSION = 2;
+
+class CaptureFile
+{
+public:
+    // Returns true if the data starts like a capture file
+    static bool isCapture( const char* begin, qint64 size );
+
+    // Writes the table and its index to a capture file.  The index is
+    // rebuilt for the file if it does not cover the whole table.  Returns
+    // false, with a reason in error, if the file could not be written.
+    static bool save( const QString& fileName, const FrameTable& table,
+                      const FrameIndex& index, QString& error );
+
+    // Restores a table and its index from a mapped capture file.  Returns
+    // false, with a reason in error, if the data is not a usable capture.
+    static bool load( const char* begin, qint64 size, FrameTable& table,
+                      FrameIndex& index, QString& error );
+
+    // Writes the frames out as a candump -l log
+    static bool exportLog( const QString& fileName, const FrameTable& table,
+                           QString& error );
+};
+
+#endif // CAPTUREFILE_H
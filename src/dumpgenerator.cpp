@@ -0,0 +1,548 @@
+/*----------------------------------------------------------------------------
+
+Name		dumpgenerator.cpp
+
+Purpose		Deterministic generator of synthetic CANopen candumps.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "dumpgenerator.h"
+#include <QFile>
+#include <QStringList>
+
+// Size of the blocks a dump is written to file in
+static const qint64 GENERATE_BLOCK = 4 * 1024 * 1024;
+
+// Timestamp of the first frame (seconds since the epoch)
+static const qint64 GENERATE_EPOCH = 1536766423;
+
+// Objects read and written by the SDO exchanges (index << 8 | subindex)
+static const quint32 SDO_OBJECTS[] =
+{
+    0x100000, 0x100100, 0x101700, 0x101801, 0x101802, 0x101803, 0x101804,
+    0x604000, 0x604100, 0x606400, 0x606C00, 0x200001, 0x200002, 0x200003
+};
+static const int SDO_OBJECT_COUNT = int( sizeof( SDO_OBJECTS ) / sizeof( SDO_OBJECTS[0] ) );
+
+// NMT commands sent
+static const quint8 NMT_COMMANDS[] = { 0x01, 0x02, 0x80, 0x81, 0x82 };
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+/*----------------------------------------------------------------------------
+
+Name		putDecimal
+
+Purpose		Writes a number in decimal, zero padded to a width
+
+Return      position after the digits
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline char* putDecimal( char* p, qint64 value, int width )
+{
+    char digits[20];
+    int n = 0;
+    do
+    {
+        digits[ n++ ] = char( '0' + value % 10 );
+        value /= 10;
+    } while ( value > 0 );
+
+    while ( n < width )
+        digits[ n++ ] = '0';
+    while ( n > 0 )
+        *p++ = digits[ --n ];
+
+    return p;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		putHex
+
+Purpose		Writes the low digits of a number in upper case hex
+
+Return      position after the digits
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline char* putHex( char* p, quint64 value, int digits )
+{
+    for ( int i = digits - 1; i >= 0; --i )
+        *p++ = HEX_DIGITS[ ( value >> ( 4 * i ) ) & 0xF ];
+
+    return p;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		sdoData
+
+Purpose		Packs an SDO frame: command specifier, object and four data bytes
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline quint64 sdoData( quint8 command, quint32 object, quint32 value )
+{
+    return quint64( command ) | ( quint64( object >> 8 ) << 8 ) |
+           ( quint64( object & 0xFF ) << 24 ) | ( quint64( value ) << 32 );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		DumpMix
+
+Purpose		Constructor.  The default mix is dominated by PDOs, as a
+            running CANopen bus usually is.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+DumpMix::DumpMix()
+    : nmt( 1 ),
+      pdo( 80 ),
+      sdo( 5 ),
+      heartbeat( 14 )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		DumpGenerator
+
+Purpose		Constructor
+
+Input       seed - start of the pseudo random sequence (0 is taken as 1)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+DumpGenerator::DumpGenerator( quint64 seed )
+    : mState( seed ? seed : 1 ),
+      mFormat( TIMESTAMPED ),
+      mNodes( 0 ),
+      mIfaces( 1 ),
+      mMeanGap( 200 ),
+      mTime( GENERATE_EPOCH * 1000000 ),
+      mIface( 0 ),
+      mLines( 0 )
+{
+    setNodes( 16 );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setNodes
+
+Purpose		Sets the number of nodes on the bus
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void DumpGenerator::setNodes( int nodes )
+{
+    mNodes = qBound( 1, nodes, 127 );
+    mPdoValues.fill( 0, ( mNodes + 1 ) * 4 );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setIfaces
+
+Purpose		Sets the number of interfaces the traffic is spread over
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void DumpGenerator::setIfaces( int ifaces )
+{
+    mIfaces = qBound( 1, ifaces, 10 );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setRate
+
+Purpose		Sets the mean number of frames per second the timestamps imply
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void DumpGenerator::setRate( int framesPerSec )
+{
+    mMeanGap = qMax( 1, 1000000 / qMax( framesPerSec, 1 ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		next
+
+Purpose		Returns the next number of a xorshift64* sequence
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+inline quint64 DumpGenerator::next()
+{
+    mState ^= mState >> 12;
+    mState ^= mState << 25;
+    mState ^= mState >> 27;
+
+    return mState * Q_UINT64_C( 2685821657736338717 );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		frame
+
+Purpose		Appends one frame in the current form and moves the clock on
+
+Input       out   - text appended to
+            cobId - identifier
+            dlc   - number of payload bytes
+            data  - payload, byte 0 in the least significant byte
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void DumpGenerator::frame( QByteArray& out, quint32 cobId, int dlc, quint64 data )
+{
+    mTime += 1 + qint64( next() % quint64( 2 * mMeanGap ) );
+
+    char line[96];
+    char* p = line;
+
+    if ( mFormat == PLAIN )
+    {
+        *p++ = ' ';
+        *p++ = ' ';
+    }
+    else
+    {
+        *p++ = '(';
+        p = putDecimal( p, mTime / 1000000, 1 );
+        *p++ = '.';
+        p = putDecimal( p, mTime % 1000000, 6 );
+        *p++ = ')';
+        *p++ = ' ';
+        if ( mFormat == TIMESTAMPED )
+            *p++ = ' ';
+    }
+
+    *p++ = 'c';
+    *p++ = 'a';
+    *p++ = 'n';
+    *p++ = char( '0' + mIface );
+
+    if ( mFormat == LOG )
+    {
+        *p++ = ' ';
+        p = putHex( p, cobId, 3 );
+        *p++ = '#';
+        for ( int i = 0; i < dlc; ++i )
+            p = putHex( p, data >> ( 8 * i ), 2 );
+    }
+    else
+    {
+        *p++ = ' ';
+        *p++ = ' ';
+        p = putHex( p, cobId, 3 );
+        *p++ = ' ';
+        *p++ = ' ';
+        *p++ = ' ';
+        *p++ = '[';
+        *p++ = char( '0' + dlc );
+        *p++ = ']';
+        *p++ = ' ';
+        for ( int i = 0; i < dlc; ++i )
+        {
+            *p++ = ' ';
+            p = putHex( p, data >> ( 8 * i ), 2 );
+        }
+    }
+    *p++ = '\n';
+
+    out.append( line, int( p - line ) );
+    ++mLines;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		nmtEvent
+
+Purpose		Appends an NMT node control command, now and then to all nodes
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void DumpGenerator::nmtEvent( QByteArray& out )
+{
+    quint64 r = next();
+    quint8 command = NMT_COMMANDS[ r % sizeof( NMT_COMMANDS ) ];
+    quint8 node = ( ( r >> 8 ) % 8 == 0 ) ? 0 : quint8( 1 + ( r >> 16 ) % quint64( mNodes ) );
+
+    frame( out, 0x000, 2, quint64( command ) | ( quint64( node ) << 8 ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		pdoEvent
+
+Purpose		Appends one TPDO of a node.  The four 16 bit values of each PDO
+            drift by a few counts each time, like sampled process data.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void DumpGenerator::pdoEvent( QByteArray& out )
+{
+    quint64 r = next();
+    int node = 1 + int( r % quint64( mNodes ) );
+    int pdo = int( ( r >> 8 ) & 3 );
+
+    quint64& value = mPdoValues[ node * 4 + pdo ];
+    quint64 step = next();
+    for ( int lane = 0; lane < 4; ++lane )
+    {
+        quint16 v = quint16( value >> ( 16 * lane ) );
+        v = quint16( v + int( ( step >> ( 8 * lane ) ) & 0xF ) - 7 );
+        value = ( value & ~( Q_UINT64_C( 0xFFFF ) << ( 16 * lane ) ) ) |
+                ( quint64( v ) << ( 16 * lane ) );
+    }
+
+    frame( out, quint32( 0x180 + 0x100 * pdo + node ), 8, value );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		sdoEvent
+
+Purpose		Appends a whole client / server exchange with one node: mostly
+            expedited uploads and downloads, some segmented uploads of the
+            device name (1008) and the odd aborted request
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void DumpGenerator::sdoEvent( QByteArray& out )
+{
+    quint64 r = next();
+    const quint32 node = quint32( 1 + r % quint64( mNodes ) );
+    const quint32 client = 0x600 + node;
+    const quint32 server = 0x580 + node;
+    const quint32 object = SDO_OBJECTS[ ( r >> 8 ) % SDO_OBJECT_COUNT ];
+    const quint32 value = quint32( next() );
+    const int kind = int( ( r >> 16 ) % 16 );
+
+    if ( kind < 9 )
+    {
+        // Expedited upload of four bytes
+        frame( out, client, 8, sdoData( 0x40, object, 0 ) );
+        frame( out, server, 8, sdoData( 0x43, object, value ) );
+    }
+    else if ( kind < 13 )
+    {
+        // Expedited download of four bytes
+        frame( out, client, 8, sdoData( 0x23, object, value ) );
+        frame( out, server, 8, sdoData( 0x60, object, 0 ) );
+    }
+    else if ( kind < 15 )
+    {
+        // Segmented upload of the device name
+        QByteArray name = QByteArray( "CANopen node " ) + QByteArray::number( node );
+        frame( out, client, 8, sdoData( 0x40, 0x100800, 0 ) );
+        frame( out, server, 8, sdoData( 0x41, 0x100800, quint32( name.size() ) ) );
+
+        quint8 toggle = 0;
+        for ( int sent = 0; sent < name.size(); sent += 7 )
+        {
+            const int count = qMin( 7, name.size() - sent );
+            const bool last = ( sent + count >= name.size() );
+
+            quint64 data = quint64( ( toggle << 4 ) | ( ( 7 - count ) << 1 ) | ( last ? 1 : 0 ) );
+            for ( int i = 0; i < count; ++i )
+                data |= quint64( quint8( name.at( sent + i ) ) ) << ( 8 * ( i + 1 ) );
+
+            frame( out, client, 8, quint64( 0x60 | ( toggle << 4 ) ) );
+            frame( out, server, 8, data );
+            toggle ^= 1;
+        }
+    }
+    else
+    {
+        // Request for an object the node does not have
+        frame( out, client, 8, sdoData( 0x40, 0x2FFF00, 0 ) );
+        frame( out, server, 8, sdoData( 0x80, 0x2FFF00, 0x06020000 ) );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		heartbeatEvent
+
+Purpose		Appends a heartbeat, nearly always from an operational node
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void DumpGenerator::heartbeatEvent( QByteArray& out )
+{
+    quint64 r = next();
+    quint32 node = quint32( 1 + r % quint64( mNodes ) );
+    quint8 state = ( ( r >> 8 ) % 64 == 0 ) ? 0x7F : 0x05;
+
+    frame( out, 0x700 + node, 1, state );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		generate
+
+Purpose		Appends events, chosen by the weights of the mix, until the text
+            has grown by the given size.  Events are spread over the
+            interfaces at random.
+
+Input       out   - text appended to
+            bytes - least number of bytes to append
+
+Return      number of lines appended
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+qint64 DumpGenerator::generate( QByteArray& out, qint64 bytes )
+{
+    const int start = out.size();
+    const quint64 total = quint64( qMax( mMix.nmt, 0 ) + qMax( mMix.pdo, 0 ) +
+                                   qMax( mMix.sdo, 0 ) + qMax( mMix.heartbeat, 0 ) );
+    mLines = 0;
+    if ( total == 0 )
+        return 0;
+
+    out.reserve( int( qMin( start + bytes, 2 * GENERATE_BLOCK ) + 1024 ) );
+    while ( out.size() - start < bytes )
+    {
+        quint64 r = next();
+        mIface = quint8( ( r >> 32 ) % quint64( mIfaces ) );
+
+        qint64 pick = qint64( r % total );
+        if ( ( pick -= qMax( mMix.pdo, 0 ) ) < 0 )
+            pdoEvent( out );
+        else if ( ( pick -= qMax( mMix.heartbeat, 0 ) ) < 0 )
+            heartbeatEvent( out );
+        else if ( ( pick -= qMax( mMix.sdo, 0 ) ) < 0 )
+            sdoEvent( out );
+        else
+            nmtEvent( out );
+    }
+
+    return mLines;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		write
+
+Purpose		Writes a dump to a file a block at a time
+
+Input       fileName - file to write
+            bytes    - least size of the dump
+            error    - set to the reason if the file cannot be written
+
+Return      true if the whole dump was written
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool DumpGenerator::write( const QString& fileName, qint64 bytes, QString& error )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    QByteArray block;
+    while ( bytes > 0 )
+    {
+        block.clear();
+        generate( block, qMin( bytes, GENERATE_BLOCK ) );
+        if ( file.write( block ) != block.size() )
+        {
+            error = file.errorString();
+            return false;
+        }
+        bytes -= block.size();
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		parseMix
+
+Purpose		Reads a mix written as weights by name
+
+Input       text - e.g. "nmt=1,pdo=70,sdo=20,hb=9"; kinds left out weigh 0
+            mix  - set to the weights read
+
+Return      false if a name or weight cannot be read, or all weigh 0
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool DumpGenerator::parseMix( const QString& text, DumpMix& mix )
+{
+    DumpMix read;
+    read.nmt = read.pdo = read.sdo = read.heartbeat = 0;
+
+    const QStringList terms = text.split( ',', QString::SkipEmptyParts );
+    for ( int i = 0; i < terms.size(); ++i )
+    {
+        QStringList parts = terms.at(i).split( '=' );
+        if ( parts.size() != 2 )
+            return false;
+
+        bool ok;
+        int weight = parts.at(1).trimmed().toInt( &ok );
+        if ( !ok || weight < 0 )
+            return false;
+
+        QString name = parts.at(0).trimmed().toLower();
+        if ( name == "nmt" )
+            read.nmt = weight;
+        else if ( name == "pdo" )
+            read.pdo = weight;
+        else if ( name == "sdo" )
+            read.sdo = weight;
+        else if ( name == "hb" || name == "heartbeat" )
+            read.heartbeat = weight;
+        else
+            return false;
+    }
+
+    if ( read.nmt + read.pdo + read.sdo + read.heartbeat == 0 )
+        return false;
+
+    mix = read;
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		parseFormat
+
+Purpose		Reads a format by name
+
+Input       text   - plain, timestamped or log
+            format - set to the format read
+
+Return      false if the name is not known
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool DumpGenerator::parseFormat( const QString& text, Format& format )
+{
+    QString name = text.trimmed().toLower();
+    if ( name == "plain" )
+        format = PLAIN;
+    else if ( name == "timestamped" )
+        format = TIMESTAMPED;
+    else if ( name == "log" )
+        format = LOG;
+    else
+        return false;
+
+    return true;
+}
@@ -0,0 +1,100 @@
+/*----------------------------------------------------------------------------
+
+Name		dumpgenerator.h
+
+Purpose		Deterministic generator of synthetic CANopen candumps, used to
+            benchmark the parser on dumps of any size.  The same seed and
+            settings always produce the same bytes.  Traffic is a weighted
+            mix of:
+
+                NMT       - node control commands (cob-id 000)
+                PDO       - TPDO1-4 of every node, values drifting slowly
+                SDO       - complete client / server exchanges: expedited
+                            uploads and downloads, segmented uploads of the
+                            device name and the odd abort
+                heartbeat - node state (cob-id 700 + node)
+
+            in any of the three forms FrameIngest reads.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef DUMPGENERATOR_H
+#define DUMPGENERATOR_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// Relative weights of the kinds of traffic generated
+struct DumpMix
+{
+    DumpMix();
+
+    int nmt;
+    int pdo;
+    int sdo;                // Weight of whole exchanges, not of frames
+    int heartbeat;
+};
+
+class DumpGenerator
+{
+public:
+    // Line forms written
+    enum Format
+    {
+        PLAIN,              // port  cob-id   [dlc]  XX XX ...
+        TIMESTAMPED,        // (sec.usec)  port  cob-id   [dlc]  XX XX ...
+        LOG                 // (sec.usec) port cob-id#XXXX... (candump -l)
+    };
+
+    explicit DumpGenerator( quint64 seed = 1 );
+
+    void setFormat( Format format ) { mFormat = format; }
+    void setMix( const DumpMix& mix ) { mMix = mix; }
+    // Sets the number of nodes (1 to 127) and interfaces (can0, can1 ...)
+    void setNodes( int nodes );
+    void setIfaces( int ifaces );
+    // Sets the mean number of frames per second the timestamps imply
+    void setRate( int framesPerSec );
+
+    // Appends lines to out until it has grown by at least bytes.  Returns
+    // the number of lines appended.
+    qint64 generate( QByteArray& out, qint64 bytes );
+    // Writes a dump of at least bytes to a file, a block at a time so any
+    // size can be written.  Returns false, with a reason in error, if the
+    // file could not be written.
+    bool write( const QString& fileName, qint64 bytes, QString& error );
+
+    // Reads a mix written as weights by name, e.g. "nmt=1,pdo=70,sdo=20,hb=9".
+    // Returns false if a name or weight cannot be read.
+    static bool parseMix( const QString& text, DumpMix& mix );
+    // Reads a format by name (plain, timestamped or log)
+    static bool parseFormat( const QString& text, Format& format );
+
+private:
+    // Returns the next pseudo random number
+    quint64 next();
+
+    // Appends one frame in the current form
+    void frame( QByteArray& out, quint32 cobId, int dlc, quint64 data );
+
+    // Each appends the frames of one event
+    void nmtEvent( QByteArray& out );
+    void pdoEvent( QByteArray& out );
+    void sdoEvent( QByteArray& out );
+    void heartbeatEvent( QByteArray& out );
+
+private:
+    quint64 mState;                 // xorshift state
+    Format mFormat;                 // Line form written
+    DumpMix mMix;                   // Weights of the kinds of traffic
+    int mNodes;                     // Node ids 1 .. mNodes
+    int mIfaces;                    // Interfaces can0 .. can(mIfaces - 1)
+    int mMeanGap;                   // Mean microseconds between frames
+    qint64 mTime;                   // Timestamp of the last frame (us)
+    quint8 mIface;                  // Interface of the event being written
+    qint64 mLines;                  // Lines written by the current call
+    QVector<quint64> mPdoValues;    // Last value of each node's TPDOs
+};
+
+#endif // DUMPGENERATOR_H
@@ -0,0 +1,270 @@
+/*----------------------------------------------------------------------------
+
+Name		filtermain.cpp
+
+Purpose		Headless front end to the dump filter.  Streams a candump from
+            stdin (or a file) to stdout, passing through only the lines that
+            make it through the same port, address, object index, subindex,
+            type and payload filters as the main window:
+
+            candump can0 | canDumpFilter -a 7f -t tsdo,rsdo -o 1018
+            candump can0 | canDumpFilter -t tpdo1 -d "i4..7 > 3000, 0.3"
+
+            Lines are tokenized straight out of a fixed size read buffer and
+            written back out untouched, so memory use does not grow with the
+            size of the dump.  SDO frames are followed through their transfers
+            (with bounded state per channel) so the index filters also catch
+            segments.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "framefilter.h"
+#include "frameingest.h"
+#include "parser.h"
+#include "sdoassembler.h"
+
+// Size of the read buffer; longer lines are passed on as they are
+static const int STREAM_BUFFER = 1024 * 1024;
+
+/*----------------------------------------------------------------------------
+
+Name		typeNames
+
+Purpose		Returns the packet types by the names accepted for --type
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QMap<QString, PacketType> typeNames()
+{
+    QMap<QString, PacketType> names;
+    names.insert( "nmt",    NMT );
+    names.insert( "emer",   EMER );
+    names.insert( "time",   TIME );
+    names.insert( "rsdo",   R_SDO );
+    names.insert( "rpdo1",  R_PDO_1 );
+    names.insert( "rpdo2",  R_PDO_2 );
+    names.insert( "rpdo3",  R_PDO_3 );
+    names.insert( "rpdo4",  R_PDO_4 );
+    names.insert( "tsdo",   T_SDO );
+    names.insert( "tpdo1",  T_PDO_1 );
+    names.insert( "tpdo2",  T_PDO_2 );
+    names.insert( "tpdo3",  T_PDO_3 );
+    names.insert( "tpdo4",  T_PDO_4 );
+    names.insert( "guard",  NODE_GUARD );
+
+    return names;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		writeAll
+
+Purpose		Writes a block to a file descriptor, retrying short writes
+
+Return      false if the output has gone away (e.g. the reader exited)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool writeAll( int fd, const char* p, qint64 size )
+{
+    while ( size > 0 )
+    {
+        ssize_t written = ::write( fd, p, size_t( size ) );
+        if ( written < 0 )
+        {
+            if ( errno == EINTR )
+                continue;
+            return false;
+        }
+
+        p += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		main
+
+Purpose		Parses the filter flags and streams the input through the filter.
+            Each read hands back whatever the pipe holds, and the matching
+            lines of each read are written out straight away, so output keeps
+            pace with a live candump.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Fails with status 1 on a read error
+----------------------------------------------------------------------------*/
+int main( int argc, char *argv[] )
+{
+    QCoreApplication app( argc, argv );
+    QCoreApplication::setApplicationName( "canDumpFilter" );
+
+    QCommandLineParser cmd;
+    cmd.setApplicationDescription( "Filters a candump from stdin or a file to stdout." );
+    cmd.addHelpOption();
+
+    QCommandLineOption portOpt( QStringList() << "p" << "port",
+                                "Ports to let through (e.g. can0,can1).", "ports" );
+    QCommandLineOption addrOpt( QStringList() << "a" << "addr",
+                                "Node addresses to let through, in hex.", "addrs" );
+    QCommandLineOption objIdxOpt( QStringList() << "o" << "objidx",
+                                  "SDO object indices to let through, in hex.", "indices" );
+    QCommandLineOption subIdxOpt( QStringList() << "s" << "subidx",
+                                  "SDO subindices to let through, in hex.", "subindices" );
+    QCommandLineOption typeOpt( QStringList() << "t" << "type",
+                                "Packet types to let through: nmt, emer, time, rsdo, tsdo, "
+                                "rpdo1-4, tpdo1-4, guard.", "types" );
+    QCommandLineOption dataOpt( QStringList() << "d" << "data",
+                                "Payload terms that must all hold, e.g. \"i4..7 > 3000, 0.3, "
+                                "FF00FF/2B0060\".", "terms" );
+    cmd.addOption( portOpt );
+    cmd.addOption( addrOpt );
+    cmd.addOption( objIdxOpt );
+    cmd.addOption( subIdxOpt );
+    cmd.addOption( typeOpt );
+    cmd.addOption( dataOpt );
+    cmd.addPositionalArgument( "file", "Dump to read instead of stdin." );
+    cmd.process( app );
+
+    const PktMap map = Parser::createRefMap();
+    const QMap<QString, PacketType> names = typeNames();
+    QVector<uint> funcs;
+    QStringList types = splitOnNonAlphaNum( cmd.values( typeOpt ).join( "," ) );
+    for ( int i = 0; i < types.size(); ++i )
+    {
+        QString name = types.at(i).toLower();
+        if ( !names.contains( name ) )
+        {
+            fprintf( stderr, "Unknown packet type: %s\n", qPrintable( types.at(i) ) );
+            return 2;
+        }
+        funcs.append( uint( map.value( names.value( name ) ) ) );
+    }
+
+    QStringList ports = splitOnNonAlphaNum( cmd.values( portOpt ).join( "," ) );
+    QStringList ifaces;
+
+    FrameFilter filter;
+    filter.compile( ports,
+                    splitOnNonAlphaNum( cmd.values( addrOpt ).join( "," ) ),
+                    splitOnNonAlphaNum( cmd.values( objIdxOpt ).join( "," ) ),
+                    splitOnNonAlphaNum( cmd.values( subIdxOpt ).join( "," ) ),
+                    funcs, ifaces );
+
+    QString badTerm;
+    if ( !filter.setPayload( cmd.values( dataOpt ).join( "," ), badTerm ) )
+    {
+        fprintf( stderr, "Unable to read payload term: %s\n", qPrintable( badTerm ) );
+        return 2;
+    }
+
+    int in = 0;
+    QString inName = "standard input";
+    if ( !cmd.positionalArguments().isEmpty() )
+    {
+        inName = cmd.positionalArguments().first();
+        in = ::open( QFile::encodeName( inName ).constData(), O_RDONLY );
+        if ( in < 0 )
+        {
+            fprintf( stderr, "Unable to open %s\n", qPrintable( inName ) );
+            return 1;
+        }
+    }
+
+    QByteArray buffer( STREAM_BUFFER, '\0' );
+    char* const begin = buffer.data();
+    QByteArray out;                 // Matching lines of the current read
+    out.reserve( STREAM_BUFFER + 1 );
+    int held = 0;                   // Bytes of an incomplete line held over
+    QByteArray lastIface;           // Name of the interface last seen
+    SdoAssembler sdo;               // SDO channel state
+    quint8 lastIfaceId = 0;
+
+    for ( ;; )
+    {
+        ssize_t got = ::read( in, begin + held, size_t( STREAM_BUFFER - held ) );
+        if ( got < 0 && errno == EINTR )
+            continue;
+        if ( got < 0 )
+        {
+            // Failing quietly would pass truncated output off as complete
+            fprintf( stderr, "Unable to read %s: %s\n", qPrintable( inName ), strerror( errno ) );
+            if ( in != 0 )
+                ::close( in );
+            return 1;
+        }
+
+        const bool eof = ( got == 0 );
+        const char* end = begin + held + ( eof ? 0 : got );
+        const char* p = begin;
+
+        while ( p < end )
+        {
+            // Wait for the rest of an incomplete line, unless it already
+            // fills the whole buffer
+            const char* eol = FrameIngest::lineEnd( p, end );
+            if ( eol == end && !eof && !( p == begin && end == begin + STREAM_BUFFER ) )
+                break;
+
+            FrameRecord rec;
+            const char* ifaceBegin;
+            int ifaceLen;
+            if ( FrameIngest::parseLine( p, eol, rec, ifaceBegin, ifaceLen ) )
+            {
+                if ( lastIface.size() != ifaceLen ||
+                     memcmp( lastIface.constData(), ifaceBegin, size_t( ifaceLen ) ) != 0 )
+                {
+                    lastIface = QByteArray( ifaceBegin, ifaceLen );
+                    QString name = QString::fromLatin1( lastIface );
+                    int id = ifaces.indexOf( name );
+                    if ( id < 0 )
+                    {
+                        id = ifaces.size();
+                        ifaces.append( name );
+                        filter.setIfaces( ifaces );
+                    }
+                    lastIfaceId = quint8( id );
+                }
+                rec.iface = lastIfaceId;
+
+                if ( filter.matches( rec, sdo.feed( rec ) ) )
+                {
+                    out.append( p, int( eol - p ) );
+                    out.append( '\n' );
+                }
+            }
+
+            p = ( eol < end ) ? eol + 1 : eol;
+        }
+
+        if ( !writeAll( 1, out.constData(), out.size() ) )
+            break;
+        out.resize( 0 );
+
+        if ( eof )
+            break;
+
+        // Move the incomplete last line to the front for the next read
+        held = int( end - p );
+        memmove( begin, p, size_t( held ) );
+    }
+
+    if ( in != 0 )
+        ::close( in );
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*----------------------------------------------------------------------------
+
+Name		framedelegate.cpp
+
+Purpose		Item delegate of the dump view.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "framedelegate.h"
+#include "stageprofile.h"
+
+/*----------------------------------------------------------------------------
+
+Name		FrameDelegate
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+FrameDelegate::FrameDelegate( QObject* parent )
+    : QStyledItemDelegate( parent )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		paint
+
+Purpose		Draws a row.  Reading the row's text from the model is part of
+            this, so the render stage includes the row's materialize stage.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameDelegate::paint( QPainter* painter, const QStyleOptionViewItem& option,
+                           const QModelIndex& index ) const
+{
+    StageTimer stage( STAGE_RENDER );
+    QStyledItemDelegate::paint( painter, option, index );
+}
@@ -0,0 +1,27 @@
+/*----------------------------------------------------------------------------
+
+Name		framedelegate.h
+
+Purpose		Item delegate of the dump view.  Draws rows as the default
+            delegate does, timing each as a render stage (see StageProfile).
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef FRAMEDELEGATE_H
+#define FRAMEDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+class FrameDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit FrameDelegate( QObject* parent = 0 );
+
+    // QStyledItemDelegate interface
+    void paint( QPainter* painter, const QStyleOptionViewItem& option,
+                const QModelIndex& index ) const;
+};
+
+#endif // FRAMEDELEGATE_H
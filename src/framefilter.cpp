@@ -0,0 +1,818 @@
+/*----------------------------------------------------------------------------
+
+Name		framefilter.cpp
+
+Purpose		Compiled form of the parser's filter criteria.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "framefilter.h"
+#include "sdoassembler.h"
+#include <QRegExp>
+#include <cstring>
+#include <limits>
+
+// Function codes of the two SDO channels, as bits of FrameFilter::mFuncBits
+static const quint32 SDO_FUNC_BITS = ( 1u << ( 0x580 >> 7 ) ) | ( 1u << ( 0x600 >> 7 ) );
+
+/*----------------------------------------------------------------------------
+
+Name		FrameFilter
+
+Purpose		Constructor.  An uncompiled filter lets every frame through.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Clears the payload part
+----------------------------------------------------------------------------*/
+FrameFilter::FrameFilter()
+    : mFuncBits( ~0u ),
+      mSdoOnly( false ),
+      mAnyObjIdx( true ),
+      mAnySubIdx( true ),
+      mTimeBound( false ),
+      mTimeFrom( 0 ),
+      mTimeTo( 0 )
+{
+    memset( mPortBits, 0xFF, sizeof( mPortBits ) );
+    memset( mNodeBits, 0xFF, sizeof( mNodeBits ) );
+    memset( mSubIdxBits, 0xFF, sizeof( mSubIdxBits ) );
+
+    QString none;
+    setPayload( QString(), none );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		compile
+
+Purpose		Converts the filter strings into bitmaps so that testing a frame
+            is integer work only.  An empty list sets every bit.
+
+Input       ports   - interface names to allow
+            addrs   - node addresses (hex) to allow
+            objIdxs - SDO object indices (hex) to allow
+            subIdxs - SDO subindices (hex) to allow
+            funcs   - function codes of the packet types to allow
+            ifaces  - interface names of the table, indexed by id
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameFilter::compile( const QStringList& ports, const QStringList& addrs,
+                           const QStringList& objIdxs, const QStringList& subIdxs,
+                           const QVector<uint>& funcs, const QStringList& ifaces )
+{
+    mPorts = ports;
+    setIfaces( ifaces );
+
+    if ( addrs.isEmpty() )
+    {
+        memset( mNodeBits, 0xFF, sizeof( mNodeBits ) );
+    }
+    else
+    {
+        memset( mNodeBits, 0, sizeof( mNodeBits ) );
+        for ( int i = 0; i < addrs.size(); ++i )
+        {
+            bool ok;
+            uint addr = addrs.at(i).toUInt( &ok, 16 );
+            if ( ok && addr < 0x80 )
+                setBit( mNodeBits, addr );
+        }
+    }
+
+    if ( funcs.isEmpty() )
+    {
+        mFuncBits = ~0u;
+    }
+    else
+    {
+        mFuncBits = 0;
+        for ( int i = 0; i < funcs.size(); ++i )
+            mFuncBits |= 1u << ( ( funcs.at(i) >> 7 ) & 0xF );
+    }
+
+    mAnyObjIdx = objIdxs.isEmpty();
+    mObjIdxBits.fill( mAnyObjIdx ? ~quint64( 0 ) : 0, 0x10000 / 64 );
+    for ( int i = 0; i < objIdxs.size(); ++i )
+    {
+        bool ok;
+        uint objIdx = objIdxs.at(i).toUInt( &ok, 16 );
+        if ( ok && objIdx < 0x10000 )
+            setBit( mObjIdxBits.data(), objIdx );
+    }
+
+    mAnySubIdx = subIdxs.isEmpty();
+    memset( mSubIdxBits, mAnySubIdx ? 0xFF : 0, sizeof( mSubIdxBits ) );
+    for ( int i = 0; i < subIdxs.size(); ++i )
+    {
+        bool ok;
+        uint subIdx = subIdxs.at(i).toUInt( &ok, 16 );
+        if ( ok && subIdx < 0x100 )
+            setBit( mSubIdxBits, subIdx );
+    }
+
+    // An index or subindex filter only lets SDOs through, and only those
+    // that belong to a known transfer
+    mSdoOnly = !mAnyObjIdx || !mAnySubIdx;
+    if ( mSdoOnly )
+        mFuncBits &= SDO_FUNC_BITS;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		testId
+
+Purpose		Tests the interface and identifier of a frame.  Every part is a
+            bitmap lookup; the results are combined with AND rather than
+            short-circuited so the common case does not branch.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+inline bool FrameFilter::testId( quint8 iface, quint32 cobId ) const
+{
+    // Identifiers past 11 bits fall on function code bits 16 to 31, which
+    // are only set when there is no type filter
+    quint32 func = qMin<quint32>( cobId >> 7, 31 );
+
+    return ( bit( mPortBits, iface ) &
+             bit( mNodeBits, cobId & 0x7F ) &
+             ( ( mFuncBits >> func ) & 1 ) ) != 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		testSdo
+
+Purpose		Tests the object index and subindex of an SDO frame.  The key
+            comes from the transfer the frame belongs to rather than the
+            frame's own bytes, so segments are tested against the object
+            being transferred and never against their payload.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Tests the SDO key instead of the payload bytes
+----------------------------------------------------------------------------*/
+inline bool FrameFilter::testSdo( quint32 sdoKey ) const
+{
+    uint objIdx = ( sdoKey >> 8 ) & 0xFFFF;
+    uint subIdx = sdoKey & 0xFF;
+
+    return ( bit( mObjIdxBits.constData(), objIdx ) &
+             bit( mSubIdxBits, subIdx ) &
+             quint64( sdoKey != NO_SDO_KEY ) ) != 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		acceptsId
+
+Purpose		Returns true if frames with the identifier may make it through the
+            address and type parts of the filter.  Identifiers past 11 bits
+            (WIDE_COB_BUCKET stands for all of them) take their node from
+            the low 7 bits like any other, which a single answer cannot
+            tell apart, so they are let through whenever the type filter
+            allows them and left to testId.
+
+Input       cobId - identifier to test
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Lets wider identifiers through on the type alone
+----------------------------------------------------------------------------*/
+bool FrameFilter::acceptsId( quint32 cobId ) const
+{
+    if ( cobId > 0x7FF )
+        return ( ( mFuncBits >> 31 ) & 1 ) != 0;
+
+    if ( ( ( mFuncBits >> ( cobId >> 7 ) ) & 1 ) == 0 )
+        return false;
+
+    return bit( mNodeBits, cobId & 0x7F ) != 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		acceptsAllIfaces
+
+Purpose		Returns true if there is no port filter
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool FrameFilter::acceptsAllIfaces() const
+{
+    for ( int i = 0; i < 4; ++i )
+    {
+        if ( mPortBits[i] != ~quint64( 0 ) )
+            return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setIfaces
+
+Purpose		Compiles the port filter against the interface names of a table
+
+Input       ifaces - interface names of the table, indexed by id
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameFilter::setIfaces( const QStringList& ifaces )
+{
+    if ( mPorts.isEmpty() )
+    {
+        memset( mPortBits, 0xFF, sizeof( mPortBits ) );
+        return;
+    }
+
+    memset( mPortBits, 0, sizeof( mPortBits ) );
+    for ( int i = 0; i < ifaces.size() && i < 256; ++i )
+    {
+        if ( mPorts.contains( ifaces.at(i), Qt::CaseInsensitive ) )
+            setBit( mPortBits, uint( i ) );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setTimeWindow
+
+Purpose		Only lets through frames stamped within a window.  Frames read
+            without a timestamp never make it through.
+
+Input       from, to - window, in microseconds
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameFilter::setTimeWindow( qint64 from, qint64 to )
+{
+    mTimeBound = true;
+    mTimeFrom = qMax<qint64>( from, 0 );
+    mTimeTo = to;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clearTimeWindow
+
+Purpose		Lets frames through whatever their timestamp
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameFilter::clearTimeWindow()
+{
+    mTimeBound = false;
+    mTimeFrom = 0;
+    mTimeTo = 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		readBytes
+
+Purpose		Reads a run of hex bytes, byte 0 first, into a packed payload
+
+Input       hex   - two digits per byte, at most eight bytes
+            bytes - packed bytes, byte 0 in the least significant byte
+
+Return      false if the text is not a whole number of hex bytes
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool readBytes( const QString& hex, quint64& bytes )
+{
+    if ( hex.isEmpty() || hex.size() > 16 || ( hex.size() & 1 ) )
+        return false;
+
+    bytes = 0;
+    for ( int i = 0; i < hex.size() / 2; ++i )
+    {
+        bool ok;
+        quint64 byte = hex.mid( 2 * i, 2 ).toUInt( &ok, 16 );
+        if ( !ok )
+            return false;
+        bytes |= byte << ( 8 * i );
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		bytesSpanned
+
+Purpose		Returns the number of payload bytes up to the last one a mask
+            touches
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static quint8 bytesSpanned( quint64 mask )
+{
+    quint8 n = 0;
+    while ( mask )
+    {
+        mask >>= 8;
+        ++n;
+    }
+
+    return n;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		fold
+
+Purpose		Folds an equality term into the payload mask and value.  Terms
+            that want different values for the same bit can never all hold.
+
+Input       mask, value       - mask and value built so far
+            addMask, addValue - bits of the term and their value
+            never             - set if the terms contradict each other
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void fold( quint64& mask, quint64& value, quint64 addMask, quint64 addValue,
+                  bool& never )
+{
+    addValue &= addMask;
+    if ( ( value ^ addValue ) & mask & addMask )
+        never = true;
+
+    mask |= addMask;
+    value |= addValue;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setPayload
+
+Purpose		Compiles a payload expression.  Terms are joined by commas and
+            must all hold; spaces are ignored:
+
+                FF00FF/2B0060  mask/value in hex, byte 0 first: the bits set
+                               in the mask must equal those of the value
+                0.3            bit 3 of byte 0 is set
+                !0.3           bit 3 of byte 0 is clear
+                4..7 > 3000    bytes 4 to 7 as a little endian unsigned
+                               number, compared with =, !=, <, <=, > or >=
+                i4..7 > -5     the same, read as a signed number
+                2 = 0x1F       a single byte (u2 reads it unsigned, as does 2)
+
+            Unsigned 8 byte fields (0..7) cannot be compared with negative
+            numbers.
+
+            Equality terms (mask/value, bits and =) are folded into one
+            mask and value; each other comparison takes a range slot.  A
+            term only matches frames long enough to hold the bytes it tests.
+
+Input       expr    - expression to compile
+            badTerm - set to the first term that cannot be read
+
+Return      false if a term cannot be read or there are more than
+            PAYLOAD_MAX_RANGES range terms
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool FrameFilter::setPayload( const QString& expr, QString& badTerm )
+{
+    mPayloadBound = false;
+    mPayloadDlc = 0;
+    mDataMask = 0;
+    mDataValue = 0;
+    mRangeCount = 0;
+    for ( int i = 0; i < PAYLOAD_MAX_RANGES; ++i )
+    {
+        // An open slot reads the whole payload and lets any value through
+        PayloadRange& range = mRanges[i];
+        range.left = 0;
+        range.right = 0;
+        range.sign = false;
+        range.invert = false;
+        range.flip = 0;
+        range.min = std::numeric_limits<qint64>::min();
+        range.max = std::numeric_limits<qint64>::max();
+    }
+    badTerm.clear();
+
+    const QStringList terms = expr.split( ',', QString::SkipEmptyParts );
+    bool never = false;
+    for ( int i = 0; i < terms.size(); ++i )
+    {
+        QString term = terms.at(i).simplified().remove( ' ' );
+        if ( term.isEmpty() )
+            continue;
+
+        if ( !addPayloadTerm( term, never ) )
+        {
+            badTerm = terms.at(i).trimmed();
+            QString none;
+            setPayload( QString(), none );
+            return false;
+        }
+        mPayloadBound = true;
+    }
+
+    // (data & 0) == 1 never holds, which keeps the test free of a branch
+    if ( never )
+    {
+        mDataMask = 0;
+        mDataValue = 1;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		addPayloadTerm
+
+Purpose		Adds one term to the payload filter being compiled
+
+Input       term  - term with the spaces taken out
+            never - set if the term can never hold alongside the others
+
+Return      false if the term cannot be read or no range slot is left
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool FrameFilter::addPayloadTerm( const QString& term, bool& never )
+{
+    static const qint64 LOWEST = std::numeric_limits<qint64>::min();
+    static const qint64 HIGHEST = std::numeric_limits<qint64>::max();
+
+    // mask/value
+    int slash = term.indexOf( '/' );
+    if ( slash >= 0 )
+    {
+        quint64 mask;
+        quint64 value;
+        if ( !readBytes( term.left( slash ), mask ) ||
+             !readBytes( term.mid( slash + 1 ), value ) )
+            return false;
+
+        fold( mDataMask, mDataValue, mask, value, never );
+        mPayloadDlc = qMax( mPayloadDlc, bytesSpanned( mask ) );
+        return true;
+    }
+
+    // Single bit
+    QRegExp bitTerm( "(!?)([0-7])\\.([0-7])" );
+    if ( bitTerm.exactMatch( term ) )
+    {
+        int byte = bitTerm.cap( 2 ).toInt();
+        quint64 mask = quint64( 1 ) << ( 8 * byte + bitTerm.cap( 3 ).toInt() );
+
+        fold( mDataMask, mDataValue, mask, bitTerm.cap( 1 ).isEmpty() ? mask : 0, never );
+        mPayloadDlc = qMax( mPayloadDlc, quint8( byte + 1 ) );
+        return true;
+    }
+
+    // Field compared with a number
+    QRegExp fieldTerm( "([iIuU]?)([0-7])(?:\\.\\.([0-7]))?(==|!=|<=|>=|=|<|>)(.+)" );
+    if ( !fieldTerm.exactMatch( term ) )
+        return false;
+
+    const int first = fieldTerm.cap( 2 ).toInt();
+    const int last = fieldTerm.cap( 3 ).isEmpty() ? first : fieldTerm.cap( 3 ).toInt();
+    if ( last < first )
+        return false;
+
+    const int bits = 8 * ( last - first + 1 );
+    const bool sign = fieldTerm.cap( 1 ).toLower() == "i";
+    const quint64 fieldMask = ( bits == 64 ) ? ~quint64( 0 ) : ( quint64( 1 ) << bits ) - 1;
+    const QString op = fieldTerm.cap( 4 );
+
+    // Unsigned 8 byte fields are compared with their top bit flipped, so
+    // every field and number maps onto the signed 64 bit order
+    const quint64 flip = ( !sign && bits == 64 ) ? quint64( 1 ) << 63 : 0;
+    bool ok;
+    quint64 number = flip ? fieldTerm.cap( 5 ).toULongLong( &ok, 0 )
+                          : quint64( fieldTerm.cap( 5 ).toLongLong( &ok, 0 ) );
+    if ( !ok )
+        return false;
+    const qint64 value = qint64( number ^ flip );
+
+    // Values the field can hold
+    qint64 lowest = LOWEST;
+    qint64 highest = HIGHEST;
+    if ( bits < 64 )
+    {
+        lowest = sign ? -( qint64( 1 ) << ( bits - 1 ) ) : 0;
+        highest = sign ? ( qint64( 1 ) << ( bits - 1 ) ) - 1 : qint64( fieldMask );
+    }
+
+    mPayloadDlc = qMax( mPayloadDlc, quint8( last + 1 ) );
+
+    if ( op == "=" || op == "==" )
+    {
+        if ( value < lowest || value > highest )
+            never = true;
+        else
+            fold( mDataMask, mDataValue, fieldMask << ( 8 * first ),
+                  ( number & fieldMask ) << ( 8 * first ), never );
+        return true;
+    }
+
+    if ( mRangeCount == PAYLOAD_MAX_RANGES )
+        return false;
+
+    PayloadRange& range = mRanges[ mRangeCount++ ];
+    range.left = quint8( 64 - 8 * first - bits );
+    range.right = quint8( 64 - bits );
+    range.sign = sign;
+    range.flip = flip;
+
+    if ( op == "!=" )
+    {
+        range.min = value;
+        range.max = value;
+        range.invert = true;
+    }
+    else if ( op == "<" )
+    {
+        range.max = ( value == LOWEST ) ? LOWEST : value - 1;
+        range.min = ( value == LOWEST ) ? HIGHEST : LOWEST;
+    }
+    else if ( op == "<=" )
+    {
+        range.max = value;
+    }
+    else if ( op == ">" )
+    {
+        range.min = ( value == HIGHEST ) ? HIGHEST : value + 1;
+        range.max = ( value == HIGHEST ) ? LOWEST : HIGHEST;
+    }
+    else
+    {
+        range.min = value;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		testPayload
+
+Purpose		Tests the payload of a frame.  Every range slot is read whether
+            it is in use or not, and the parts are combined with AND, so
+            the test costs the same for every frame and does not branch.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+inline bool FrameFilter::testPayload( quint8 dlc, quint64 data ) const
+{
+    quint32 pass = ( ( data & mDataMask ) == mDataValue ) & ( dlc >= mPayloadDlc );
+
+    for ( int i = 0; i < PAYLOAD_MAX_RANGES; ++i )
+    {
+        const PayloadRange& range = mRanges[i];
+
+        // Bring the field's top bit to bit 63, then shift it back down with
+        // or without sign extension
+        const quint64 top = data << range.left;
+        const quint64 sel = quint64( 0 ) - quint64( range.sign );
+        const quint64 field = ( quint64( qint64( top ) >> range.right ) & sel ) |
+                              ( ( top >> range.right ) & ~sel );
+        const qint64 value = qint64( field ^ range.flip );
+
+        pass &= quint32( ( value >= range.min ) & ( value <= range.max ) ) ^
+                quint32( range.invert );
+    }
+
+    return !mPayloadBound || pass != 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		samePayload
+
+Purpose		Returns true if the payload parts of two filters are the same
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool FrameFilter::samePayload( const FrameFilter& other ) const
+{
+    if ( mPayloadBound != other.mPayloadBound || mPayloadDlc != other.mPayloadDlc ||
+         mDataMask != other.mDataMask || mDataValue != other.mDataValue ||
+         mRangeCount != other.mRangeCount )
+        return false;
+
+    for ( int i = 0; i < mRangeCount; ++i )
+    {
+        const PayloadRange& a = mRanges[i];
+        const PayloadRange& b = other.mRanges[i];
+        if ( a.left != b.left || a.right != b.right || a.sign != b.sign ||
+             a.invert != b.invert || a.flip != b.flip || a.min != b.min || a.max != b.max )
+            return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		isSubset
+
+Purpose		Returns true if every bit set in one bitmap is also set in another
+
+Input       a, b  - bitmaps to compare
+            words - length of the bitmaps in 64 bit words
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool FrameFilter::isSubset( const quint64* a, const quint64* b, int words )
+{
+    for ( int i = 0; i < words; ++i )
+    {
+        if ( a[i] & ~b[i] )
+            return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		isSubsetOf
+
+Purpose		Returns true if every frame that makes it through this filter also
+            makes it through another.  Each part of the filter is a bitmap, so
+            this holds when every bitmap is a subset of the other filter's,
+            the index part is at least as strict and the timestamp window
+            lies within the other's.  Payload filters are only compared for
+            equality.
+
+Input       other - filter to compare against
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Compares the payload part
+----------------------------------------------------------------------------*/
+bool FrameFilter::isSubsetOf( const FrameFilter& other ) const
+{
+    if ( ( mFuncBits & ~other.mFuncBits ) != 0 ||
+         !isSubset( mPortBits, other.mPortBits, 4 ) ||
+         !isSubset( mNodeBits, other.mNodeBits, 2 ) )
+        return false;
+
+    if ( other.mTimeBound &&
+         ( !mTimeBound || mTimeFrom < other.mTimeFrom || mTimeTo > other.mTimeTo ) )
+        return false;
+
+    if ( other.mPayloadBound && !samePayload( other ) )
+        return false;
+
+    if ( !other.mSdoOnly )
+        return true;
+
+    return mSdoOnly &&
+           isSubset( mObjIdxBits.constData(), other.mObjIdxBits.constData(),
+                     mObjIdxBits.size() ) &&
+           isSubset( mSubIdxBits, other.mSubIdxBits, 4 );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		matches
+
+Purpose		Returns true if the frame makes it through every part of the
+            filter
+
+Input       table - table holding the frame
+            sdo   - SDO keys of the table's frames
+            frame - frame to test
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Tests the SDO key of the frame
+            17 Oct 26  AFB	Tests the payload
+----------------------------------------------------------------------------*/
+bool FrameFilter::matches( const FrameTable& table, const SdoTable& sdo,
+                           FrameId frame ) const
+{
+    if ( !testTime( table.time( frame ) ) )
+        return false;
+
+    if ( !testId( table.iface( frame ), table.cobId( frame ) ) )
+        return false;
+
+    if ( !testPayload( table.dlc( frame ), table.data( frame ) ) )
+        return false;
+
+    return !mSdoOnly || testSdo( sdo.frameKey( frame ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		matches
+
+Purpose		Returns true if a frame that is not held in a table (e.g. one
+            being streamed through) makes it through every part of the filter
+
+Input       rec    - tokenized frame
+            sdoKey - SDO key of the frame (see SdoAssembler::feed)
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Tests the SDO key of the frame
+            17 Oct 26  AFB	Tests the payload
+----------------------------------------------------------------------------*/
+bool FrameFilter::matches( const FrameRecord& rec, quint32 sdoKey ) const
+{
+    if ( !testTime( rec.time ) )
+        return false;
+
+    if ( !testId( rec.iface, rec.cobId ) )
+        return false;
+
+    if ( !testPayload( rec.dlc, rec.data ) )
+        return false;
+
+    return !mSdoOnly || testSdo( sdoKey );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		filter
+
+Purpose		Appends the frames of a range that make it through the filter.
+            Reads the columns through raw pointers, and only reads the
+            timestamp, SDO key and payload columns when a filter needs them.
+
+Input       table      - table holding the frames
+            sdo        - SDO keys of the table's frames
+            begin, end - range of frames to test
+            matches    - list the matching frames are appended to
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Tests the SDO key column
+            17 Oct 26  AFB	Tests the payload column
+----------------------------------------------------------------------------*/
+void FrameFilter::filter( const FrameTable& table, const SdoTable& sdo,
+                          FrameId begin, FrameId end, QVector<FrameId>& matches ) const
+{
+    const quint8* ifaces = table.ifaceIds().constData();
+    const quint32* cobIds = table.cobIds().constData();
+
+    // The time window is usually the most selective part, so it goes first
+    if ( mTimeBound || mPayloadBound )
+    {
+        const qint64* times = table.times().constData();
+        const quint32* keys = sdo.frameKeys().constData();
+        const quint8* dlcs = table.dlcs().constData();
+        const quint64* data = table.payloads().constData();
+        for ( FrameId i = begin; i < end; ++i )
+        {
+            if ( testTime( times[i] ) && testId( ifaces[i], cobIds[i] ) &&
+                 testPayload( dlcs[i], data[i] ) &&
+                 ( !mSdoOnly || testSdo( keys[i] ) ) )
+                matches.append( i );
+        }
+        return;
+    }
+
+    if ( !mSdoOnly )
+    {
+        for ( FrameId i = begin; i < end; ++i )
+        {
+            if ( testId( ifaces[i], cobIds[i] ) )
+                matches.append( i );
+        }
+        return;
+    }
+
+    const quint32* keys = sdo.frameKeys().constData();
+
+    for ( FrameId i = begin; i < end; ++i )
+    {
+        if ( testId( ifaces[i], cobIds[i] ) && testSdo( keys[i] ) )
+            matches.append( i );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		filter
+
+Purpose		Appends the candidate frames of a range that make it through the
+            filter.  Used with the posting lists of FrameIndex, which have
+            already narrowed the frames down by identifier.
+
+Input       table      - table holding the frames
+            sdo        - SDO keys of the table's frames
+            candidates - frames to test, in frame order
+            begin, end - range of candidates to test
+            matches    - list the matching frames are appended to
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Tests the SDO key column
+----------------------------------------------------------------------------*/
+void FrameFilter::filter( const FrameTable& table, const SdoTable& sdo,
+                          const QVector<FrameId>& candidates, int begin, int end,
+                          QVector<FrameId>& matches ) const
+{
+    for ( int i = begin; i < end; ++i )
+    {
+        if ( FrameFilter::matches( table, sdo, candidates.at(i) ) )
+            matches.append( candidates.at(i) );
+    }
+}
@@ -0,0 +1,166 @@
+/*----------------------------------------------------------------------------
+
+Name		framefilter.h
+
+Purpose		Compiled form of the parser's filter criteria.  The strings
+            entered by the user are converted to bitmaps once per change:
+
+                port      - one bit per interface id (256)
+                address   - one bit per node id (128)
+                type      - one bit per function code (cob-id >> 7)
+                obj index - one bit per SDO object index (65536)
+                subindex  - one bit per SDO subindex (256)
+
+            (the object index and subindex are tested against the SDO key
+            of each frame, i.e. the transfer SdoAssembler placed it in)
+
+            plus an optional timestamp window and payload predicates, after
+            which testing a frame is a handful of shifts and ANDs on the
+            table columns.  The payload predicates are folded into a single
+            64 bit mask and value, plus a few fixed slots of field ranges,
+            so testing the payload does not branch on the terms entered.
+            A FrameFilter is a plain value so a copy can be handed to a
+            worker thread while the user keeps editing the original.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef FRAMEFILTER_H
+#define FRAMEFILTER_H
+
+#include <QStringList>
+#include <QVector>
+#include "frametable.h"
+
+class SdoTable;
+
+// Most range terms (<, >, != ...) a payload filter holds
+static const int PAYLOAD_MAX_RANGES = 4;
+
+class FrameFilter
+{
+public:
+    FrameFilter();
+
+    // Compiles the filter strings.  ifaces are the interface names of the
+    // table the filter will run against, funcs the function codes of the
+    // allowed packet types.  Empty lists let everything through.
+    void compile( const QStringList& ports, const QStringList& addrs,
+                  const QStringList& objIdxs, const QStringList& subIdxs,
+                  const QVector<uint>& funcs, const QStringList& ifaces );
+
+    // Recompiles the port part for a table whose interface names have
+    // changed (e.g. frames from a new interface were appended)
+    void setIfaces( const QStringList& ifaces );
+
+    // Only lets through frames stamped within [from, to] (microseconds)
+    void setTimeWindow( qint64 from, qint64 to );
+    // Lets frames through whatever their timestamp
+    void clearTimeWindow();
+    // Returns true if a timestamp window is set
+    bool hasTimeWindow() const { return mTimeBound; }
+    qint64 timeFrom() const { return mTimeFrom; }
+    qint64 timeTo() const { return mTimeTo; }
+
+    // Compiles a payload expression: terms joined by commas, all of which
+    // must hold (see the .cpp for the terms).  An empty expression lets
+    // every payload through.  Returns false, and lets every payload
+    // through, if a term cannot be read; badTerm is then set to it.
+    bool setPayload( const QString& expr, QString& badTerm );
+    // Returns true if a payload filter is set
+    bool hasPayload() const { return mPayloadBound; }
+
+    // Returns true if the frame makes it through every part of the filter.
+    // sdo holds the SDO keys of the table's frames.
+    bool matches( const FrameTable& table, const SdoTable& sdo, FrameId frame ) const;
+    // Returns true if a frame not held in a table makes it through
+    bool matches( const FrameRecord& rec, quint32 sdoKey ) const;
+
+    // Appends the frames in [begin, end) that make it through the filter to
+    // matches.  Works straight off the table columns.
+    void filter( const FrameTable& table, const SdoTable& sdo,
+                 FrameId begin, FrameId end, QVector<FrameId>& matches ) const;
+    // Appends the frames of candidates[begin, end) that make it through the
+    // filter to matches
+    void filter( const FrameTable& table, const SdoTable& sdo,
+                 const QVector<FrameId>& candidates, int begin, int end,
+                 QVector<FrameId>& matches ) const;
+
+    // Returns true if frames with the identifier may make it through the
+    // address and type parts.  All ids past 11 bits are treated as one and
+    // pass on the type alone; their address is left to the full test.
+    bool acceptsId( quint32 cobId ) const;
+    // Returns true if frames on the interface may make it through
+    bool acceptsIface( quint8 iface ) const
+        { return bit( mPortBits, iface ) != 0; }
+    // Returns true if there is no port filter
+    bool acceptsAllIfaces() const;
+
+    // Returns true if every frame that makes it through this filter also
+    // makes it through other (this filter is the same or narrower)
+    bool isSubsetOf( const FrameFilter& other ) const;
+
+private:
+    // Little endian field of the payload compared against a range.  Values
+    // are compared as signed 64 bit numbers; unsigned 8 byte fields have
+    // their top bit flipped first so they keep their order.
+    struct PayloadRange
+    {
+        quint8 left;                // Shift that puts the field's top bit at bit 63
+        quint8 right;               // Shift that brings the field back down (64 - width)
+        bool sign;                  // True if the field is signed
+        bool invert;                // True to let through values outside [min, max]
+        quint64 flip;               // Bit flipped to keep unsigned 64 bit order
+        qint64 min;                 // Smallest value let through
+        qint64 max;                 // Largest value let through
+    };
+
+    // Adds a term to the payload filter being compiled
+    bool addPayloadTerm( const QString& term, bool& never );
+    // Returns true if the payload parts of both filters are the same
+    bool samePayload( const FrameFilter& other ) const;
+
+    // Returns bit n of a bitmap held in 64 bit words
+    static quint64 bit( const quint64* bits, uint n )
+        { return ( bits[ n >> 6 ] >> ( n & 63 ) ) & 1; }
+    // Sets bit n of a bitmap held in 64 bit words
+    static void setBit( quint64* bits, uint n )
+        { bits[ n >> 6 ] |= quint64( 1 ) << ( n & 63 ); }
+    // Returns true if every bit set in a is also set in b
+    static bool isSubset( const quint64* a, const quint64* b, int words );
+
+    // Tests the interface and identifier of a frame
+    bool testId( quint8 iface, quint32 cobId ) const;
+    // Tests the object index and subindex of an SDO frame
+    bool testSdo( quint32 sdoKey ) const;
+    // Tests the timestamp of a frame
+    bool testTime( qint64 time ) const
+        { return !mTimeBound || ( time >= mTimeFrom && time <= mTimeTo ); }
+    // Tests the payload of a frame
+    bool testPayload( quint8 dlc, quint64 data ) const;
+
+private:
+    QStringList mPorts;             // Interface names to allow
+    quint64 mPortBits[4];           // Allowed interface ids
+    quint64 mNodeBits[2];           // Allowed node addresses
+    quint32 mFuncBits;              // Allowed function codes, by cob-id >> 7
+                                    // (bit 31 stands for all wider ids)
+
+    bool mSdoOnly;                  // True if an index or subindex is set
+    bool mAnyObjIdx;                // True if the object index filter is empty
+    bool mAnySubIdx;                // True if the subindex filter is empty
+    QVector<quint64> mObjIdxBits;   // Allowed object indices
+    quint64 mSubIdxBits[4];         // Allowed subindices
+
+    bool mTimeBound;                // True if a timestamp window is set
+    qint64 mTimeFrom;               // Earliest timestamp allowed
+    qint64 mTimeTo;                 // Latest timestamp allowed
+
+    bool mPayloadBound;             // True if a payload filter is set
+    quint8 mPayloadDlc;             // Shortest payload holding every byte tested
+    quint64 mDataMask;              // Payload bits tested for equality
+    quint64 mDataValue;             // Value of the bits under mDataMask
+    int mRangeCount;                // Range slots in use
+    PayloadRange mRanges[PAYLOAD_MAX_RANGES];   // Unused slots let everything through
+};
+
+#endif // FRAMEFILTER_H
@@ -0,0 +1,445 @@
+/*----------------------------------------------------------------------------
+
+Name		frameindex.cpp
+
+Purpose		Inverted index over a FrameTable.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "frameindex.h"
+#include "stageprofile.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Share of the table above which a scan beats merging posting lists
+static const int SCAN_DIVISOR = 4;
+
+/*----------------------------------------------------------------------------
+
+Name		groupBy
+
+Purpose		Counting sort of frame ids by a small key.  Fills postings with
+            every frame id grouped by key (in frame order within a key) and
+            start with the offset of each key's group.
+
+Input       keys     - key of every frame
+            keyCount - number of distinct keys
+            keyOf    - maps a column value to its key
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+template <typename T, typename KeyFn>
+static void groupBy( const QVector<T>& keys, int keyCount, KeyFn keyOf,
+                     QVector<FrameId>& postings, QVector<int>& start )
+{
+    start.fill( 0, keyCount + 1 );
+    for ( int i = 0; i < keys.size(); ++i )
+        ++start[ keyOf( keys.at(i) ) + 1 ];
+    for ( int k = 0; k < keyCount; ++k )
+        start[ k + 1 ] += start.at( k );
+
+    QVector<int> fill = start;
+    postings.resize( keys.size() );
+    FrameId* out = postings.data();
+    for ( int i = 0; i < keys.size(); ++i )
+        out[ fill[ keyOf( keys.at(i) ) ]++ ] = FrameId( i );
+}
+
+static quint32 cobKey( quint32 cobId )
+{
+    return ( cobId < WIDE_COB_BUCKET ) ? cobId : WIDE_COB_BUCKET;
+}
+
+static quint32 ifaceKey( quint8 iface )
+{
+    return iface;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		FrameIndex
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+FrameIndex::FrameIndex()
+    : mSize( 0 )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Removes all posting lists
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameIndex::clear()
+{
+    mSize = 0;
+    mCobPostings.clear();
+    mCobStart.clear();
+    mIfacePostings.clear();
+    mIfaceStart.clear();
+    mTimeMax.clear();
+    mTimeMin.clear();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		build
+
+Purpose		Builds the posting lists of a table with two counting sorts, and
+            the sparse time index
+
+Input       table - table to index
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Times the index stage
+----------------------------------------------------------------------------*/
+void FrameIndex::build( const FrameTable& table )
+{
+    StageTimer stage( STAGE_INDEX, table.size() );
+    mSize = table.size();
+
+    groupBy( table.cobIds(), WIDE_COB_BUCKET + 1, cobKey, mCobPostings, mCobStart );
+
+    // A single interface needs no list; the port filter passes all or none
+    if ( table.ifaces().size() > 1 )
+        groupBy( table.ifaceIds(), 256, ifaceKey, mIfacePostings, mIfaceStart );
+    else
+    {
+        mIfacePostings.clear();
+        mIfaceStart.clear();
+    }
+
+    buildTimes( table );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		buildTimes
+
+Purpose		Builds the sparse time index.  Dumps are in time order, give or
+            take merged interfaces, so rather than sampling raw timestamps
+            (which need not be sorted) it keeps for every block of
+            TIME_SAMPLE frames the latest timestamp up to the block's end and
+            the earliest from the block's start on.  Both are sorted, and
+            bound where a window can begin and end.
+
+Input       table - table being indexed
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameIndex::buildTimes( const FrameTable& table )
+{
+    const int blocks = ( mSize + TIME_SAMPLE - 1 ) / TIME_SAMPLE;
+    const qint64* times = table.times().constData();
+
+    mTimeMax.resize( blocks );
+    mTimeMin.resize( blocks );
+
+    qint64 latest = NO_TIMESTAMP;
+    for ( int b = 0; b < blocks; ++b )
+    {
+        const int end = qMin( ( b + 1 ) * TIME_SAMPLE, mSize );
+        for ( int i = b * TIME_SAMPLE; i < end; ++i )
+            latest = qMax( latest, times[i] );
+        mTimeMax[b] = latest;
+    }
+
+    qint64 earliest = std::numeric_limits<qint64>::max();
+    for ( int b = blocks - 1; b >= 0; --b )
+    {
+        const int end = qMin( ( b + 1 ) * TIME_SAMPLE, mSize );
+        for ( int i = b * TIME_SAMPLE; i < end; ++i )
+            earliest = qMin( earliest, times[i] );
+        mTimeMin[b] = earliest;
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		timeRange
+
+Purpose		Narrows a range of frames to those that can have a timestamp in
+            a window, by binary search of the time index.  Every frame before
+            the first block whose running latest reaches from is too early,
+            and every frame from the first block whose earliest-onward passes
+            to is too late.  The frames left still need testing.
+
+Input       from, to   - window, in microseconds
+            begin, end - set to the range of indexed frames to test
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameIndex::timeRange( qint64 from, qint64 to, FrameId& begin, FrameId& end ) const
+{
+    int first = int( std::lower_bound( mTimeMax.constBegin(), mTimeMax.constEnd(), from )
+                     - mTimeMax.constBegin() );
+    int last = int( std::upper_bound( mTimeMin.constBegin(), mTimeMin.constEnd(), to )
+                    - mTimeMin.constBegin() );
+
+    begin = FrameId( qMin( first * TIME_SAMPLE, mSize ) );
+    end = FrameId( qMax( qMin( last * TIME_SAMPLE, mSize ), int( begin ) ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		latestTime
+
+Purpose		Returns the latest timestamp of the indexed frames
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+qint64 FrameIndex::latestTime() const
+{
+    return mTimeMax.isEmpty() ? NO_TIMESTAMP : mTimeMax.last();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		uniteBuckets
+
+Purpose		Returns the union of the given COB-ID buckets
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVector<FrameId> FrameIndex::uniteBuckets( const QVector<quint32>& buckets ) const
+{
+    QVector<const FrameId*> begins;
+    QVector<const FrameId*> ends;
+
+    if ( mCobStart.isEmpty() )
+        return QVector<FrameId>();
+
+    const FrameId* postings = mCobPostings.constData();
+    for ( int i = 0; i < buckets.size(); ++i )
+    {
+        quint32 b = buckets.at(i);
+        if ( mCobStart.at( b ) != mCobStart.at( b + 1 ) )
+        {
+            begins.append( postings + mCobStart.at( b ) );
+            ends.append( postings + mCobStart.at( b + 1 ) );
+        }
+    }
+
+    return unite( begins, ends );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		cobPostings
+
+Purpose		Returns the frames carrying a COB-ID (all wide identifiers share
+            one list)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVector<FrameId> FrameIndex::cobPostings( quint32 cobId ) const
+{
+    return uniteBuckets( QVector<quint32>() << bucket( cobId ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		nodePostings
+
+Purpose		Returns the frames sent to or from a node, merged from the 16
+            COB-IDs carrying that node id
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVector<FrameId> FrameIndex::nodePostings( quint32 node ) const
+{
+    QVector<quint32> buckets;
+    for ( quint32 func = 0; func < WIDE_COB_BUCKET; func += 0x80 )
+        buckets.append( func | ( node & 0x7F ) );
+
+    return uniteBuckets( buckets );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		funcPostings
+
+Purpose		Returns the frames of a function code, merged from the 128
+            COB-IDs carrying that function code
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVector<FrameId> FrameIndex::funcPostings( quint32 func ) const
+{
+    QVector<quint32> buckets;
+    for ( quint32 node = 0; node < 0x80; ++node )
+        buckets.append( ( func & 0x780 ) | node );
+
+    return uniteBuckets( buckets );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		candidates
+
+Purpose		Collects the frames that can match a filter.  The COB-ID lists
+            allowed by the address and type parts are merged; if only some
+            interfaces are allowed the result is intersected with theirs.
+            The object index, subindex and any finer tests are left to the
+            caller.
+
+Input       filter     - compiled filter
+            candidates - set to the candidate frames, in frame order
+
+Return      false if the filter does not narrow the identifiers enough for the
+            index to beat a scan
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool FrameIndex::candidates( const FrameFilter& filter, QVector<FrameId>& candidates ) const
+{
+    candidates.clear();
+    if ( mCobStart.isEmpty() )
+        return false;
+
+    QVector<quint32> buckets;
+    int total = 0;
+    for ( quint32 b = 0; b <= WIDE_COB_BUCKET; ++b )
+    {
+        quint32 cobId = ( b < WIDE_COB_BUCKET ) ? b : WIDE_COB_BUCKET;
+        if ( filter.acceptsId( cobId ) )
+        {
+            buckets.append( b );
+            total += mCobStart.at( b + 1 ) - mCobStart.at( b );
+        }
+    }
+
+    if ( total > mSize / SCAN_DIVISOR )
+        return false;
+
+    candidates = uniteBuckets( buckets );
+
+    if ( !mIfaceStart.isEmpty() && !filter.acceptsAllIfaces() )
+    {
+        QVector<const FrameId*> begins;
+        QVector<const FrameId*> ends;
+        const FrameId* postings = mIfacePostings.constData();
+        for ( int i = 0; i < 256; ++i )
+        {
+            if ( filter.acceptsIface( quint8( i ) ) &&
+                 mIfaceStart.at( i ) != mIfaceStart.at( i + 1 ) )
+            {
+                begins.append( postings + mIfaceStart.at( i ) );
+                ends.append( postings + mIfaceStart.at( i + 1 ) );
+            }
+        }
+
+        candidates = intersect( candidates, unite( begins, ends ) );
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		unite
+
+Purpose		Merges disjoint sorted lists into one sorted list with a k-way
+            heap merge
+
+Input       begins, ends - bounds of each list
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVector<FrameId> FrameIndex::unite( const QVector<const FrameId*>& begins,
+                                    const QVector<const FrameId*>& ends )
+{
+    QVector<FrameId> result;
+
+    int total = 0;
+    for ( int i = 0; i < begins.size(); ++i )
+        total += int( ends.at(i) - begins.at(i) );
+    result.reserve( total );
+
+    if ( begins.size() == 1 )
+    {
+        for ( const FrameId* p = begins.at(0); p != ends.at(0); ++p )
+            result.append( *p );
+        return result;
+    }
+
+    // Min-heap of (next frame id, list)
+    typedef std::pair<FrameId, int> Head;
+    std::priority_queue< Head, std::vector<Head>, std::greater<Head> > heap;
+
+    QVector<const FrameId*> pos = begins;
+    for ( int i = 0; i < pos.size(); ++i )
+    {
+        if ( pos.at(i) != ends.at(i) )
+            heap.push( Head( *pos.at(i), i ) );
+    }
+
+    while ( !heap.empty() )
+    {
+        Head head = heap.top();
+        heap.pop();
+        result.append( head.first );
+
+        const FrameId*& p = pos[ head.second ];
+        if ( ++p != ends.at( head.second ) )
+            heap.push( Head( *p, head.second ) );
+    }
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		intersect
+
+Purpose		Returns the frames present in both sorted lists.  Walks the
+            shorter list and gallops (exponential then binary search) through
+            the longer one, so a short list against a long one costs
+            O(short * log(long / short)).
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVector<FrameId> FrameIndex::intersect( const QVector<FrameId>& a,
+                                        const QVector<FrameId>& b )
+{
+    const QVector<FrameId>& small = ( a.size() <= b.size() ) ? a : b;
+    const QVector<FrameId>& large = ( a.size() <= b.size() ) ? b : a;
+
+    QVector<FrameId> result;
+    const FrameId* p = large.constData();
+    const FrameId* end = p + large.size();
+
+    for ( int i = 0; i < small.size() && p != end; ++i )
+    {
+        FrameId value = small.at(i);
+
+        // Gallop until the value is bracketed
+        int step = 1;
+        const FrameId* lo = p;
+        while ( end - lo > step && lo[ step ] < value )
+        {
+            lo += step;
+            step *= 2;
+        }
+
+        const FrameId* hi = ( end - lo > step ) ? lo + step + 1 : end;
+        p = std::lower_bound( lo, hi, value );
+
+        if ( p != end && *p == value )
+            result.append( value );
+    }
+
+    return result;
+}
@@ -0,0 +1,101 @@
+/*----------------------------------------------------------------------------
+
+Name		frameindex.h
+
+Purpose		Inverted index over a FrameTable.  For every 11 bit COB-ID (and
+            one shared bucket for wider identifiers) it holds the sorted list
+            of frames carrying that identifier, and likewise for every
+            interface.  A sparse time index samples every TIME_SAMPLE-th
+            frame so a timestamp window can be turned into a range of frames
+            by binary search.  Node and function code lists are the union
+            of the COB-ID lists they cover, so the index costs 4 bytes per
+            frame per key kind.
+
+            Filters that restrict the identifier are answered by merging the
+            posting lists of the identifiers they allow, rather than testing
+            every frame.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef FRAMEINDEX_H
+#define FRAMEINDEX_H
+
+#include <QVector>
+#include "framefilter.h"
+#include "frametable.h"
+
+// Bucket shared by every identifier wider than 11 bits
+const quint32 WIDE_COB_BUCKET = 0x800;
+
+// Frames between samples of the time index
+const int TIME_SAMPLE = 1024;
+
+class FrameIndex
+{
+public:
+    FrameIndex();
+
+    // Removes all posting lists
+    void clear();
+    // Builds the posting lists for every frame of the table
+    void build( const FrameTable& table );
+
+    // Number of frames indexed (frames appended to the table since the
+    // last build are not)
+    int size() const { return mSize; }
+
+    // Returns the frames carrying a COB-ID
+    QVector<FrameId> cobPostings( quint32 cobId ) const;
+    // Returns the frames sent to or from a node (cob-id & 0x7F)
+    QVector<FrameId> nodePostings( quint32 node ) const;
+    // Returns the frames of a function code (cob-id & 0xF80)
+    QVector<FrameId> funcPostings( quint32 func ) const;
+
+    // Collects the frames that can match the filter from the posting lists.
+    // Returns false, leaving candidates empty, when the filter would keep
+    // too many frames for the index to beat a scan.
+    bool candidates( const FrameFilter& filter, QVector<FrameId>& candidates ) const;
+
+    // Narrows [begin, end) of the indexed frames to those that can have a
+    // timestamp in [from, to]
+    void timeRange( qint64 from, qint64 to, FrameId& begin, FrameId& end ) const;
+    // Returns the latest timestamp of the indexed frames, or NO_TIMESTAMP
+    qint64 latestTime() const;
+
+    // Merges disjoint sorted lists into one sorted list
+    static QVector<FrameId> unite( const QVector<const FrameId*>& begins,
+                                   const QVector<const FrameId*>& ends );
+    // Returns the frames present in both sorted lists (galloping search)
+    static QVector<FrameId> intersect( const QVector<FrameId>& a,
+                                       const QVector<FrameId>& b );
+
+private:
+    // Returns the bucket a COB-ID is filed under
+    static quint32 bucket( quint32 cobId )
+        { return ( cobId < WIDE_COB_BUCKET ) ? cobId : WIDE_COB_BUCKET; }
+
+    // Returns the union of the given COB-ID buckets
+    QVector<FrameId> uniteBuckets( const QVector<quint32>& buckets ) const;
+
+    // Builds the sparse time index
+    void buildTimes( const FrameTable& table );
+
+private:
+    // Saves and restores the posting lists in bulk
+    friend class CaptureFile;
+
+    int mSize;                      // Number of frames indexed
+
+    QVector<FrameId> mCobPostings;  // Frames grouped by COB-ID bucket
+    QVector<int> mCobStart;         // Start of each bucket in mCobPostings
+
+    QVector<FrameId> mIfacePostings;// Frames grouped by interface
+    QVector<int> mIfaceStart;       // Start of each interface's list
+
+    QVector<qint64> mTimeMax;       // Latest timestamp up to the end of each
+                                    // sample block
+    QVector<qint64> mTimeMin;       // Earliest timestamp from the start of
+                                    // each sample block on
+};
+
+#endif // FRAMEINDEX_H
@@ -0,0 +1,724 @@
+/*----------------------------------------------------------------------------
+
+Name		frameingest.cpp
+
+Purpose		Turns raw candump text into FrameTable records.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "frameingest.h"
+#include "stageprofile.h"
+#include <QElapsedTimer>
+#include <QString>
+#include <QtAlgorithms>
+#include <QtConcurrent>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define INGEST_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define INGEST_AVX2
+#include <immintrin.h>
+#endif
+
+/*----------------------------------------------------------------------------
+
+Name		isBlank
+
+Purpose		Returns true for the characters separating candump fields
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline bool isBlank( char c )
+{
+    return ( c == ' ' || c == '\t' );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		HexTable
+
+Purpose		Lookup table of hex digit values, -1 for any other character
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+struct HexTable
+{
+    signed char value[256];
+
+    HexTable()
+    {
+        for ( int i = 0; i < 256; ++i )
+            value[i] = -1;
+        for ( int i = 0; i < 10; ++i )
+            value['0' + i] = char( i );
+        for ( int i = 0; i < 6; ++i )
+        {
+            value['a' + i] = char( 10 + i );
+            value['A' + i] = char( 10 + i );
+        }
+    }
+};
+
+static const HexTable HEX;
+
+// Bytes sampled to estimate the number of lines in a block
+static const qint64 LINE_SAMPLE = 64 * 1024;
+
+/*----------------------------------------------------------------------------
+
+Name		hexValue
+
+Purpose		Returns the value of a hex digit, or -1 if c is not one
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline int hexValue( char c )
+{
+    return HEX.value[ uchar( c ) ];
+}
+
+#ifdef INGEST_SSE2
+/*----------------------------------------------------------------------------
+
+Name		hexNibbles
+
+Purpose		Converts 16 characters to their hex digit values at once
+
+Input       v     - characters to convert
+            valid - set to 0xFF for each lane that held a hex digit
+
+Return      digit values (undefined in lanes that are not hex digits)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline __m128i hexNibbles( __m128i v, __m128i& valid )
+{
+    const __m128i minusOne = _mm_set1_epi8( -1 );
+
+    __m128i digit = _mm_sub_epi8( v, _mm_set1_epi8( '0' ) );
+    __m128i isDigit = _mm_and_si128( _mm_cmpgt_epi8( digit, minusOne ),
+                                     _mm_cmplt_epi8( digit, _mm_set1_epi8( 10 ) ) );
+
+    __m128i alpha = _mm_sub_epi8( _mm_or_si128( v, _mm_set1_epi8( 0x20 ) ),
+                                  _mm_set1_epi8( 'a' ) );
+    __m128i isAlpha = _mm_and_si128( _mm_cmpgt_epi8( alpha, minusOne ),
+                                     _mm_cmplt_epi8( alpha, _mm_set1_epi8( 6 ) ) );
+
+    valid = _mm_or_si128( isDigit, isAlpha );
+
+    return _mm_or_si128( _mm_and_si128( isDigit, digit ),
+                         _mm_and_si128( isAlpha,
+                                        _mm_add_epi8( alpha, _mm_set1_epi8( 10 ) ) ) );
+}
+#endif
+
+/*----------------------------------------------------------------------------
+
+Name		decodePayload8
+
+Purpose		Decodes the common "HH HH HH HH HH HH HH HH" payload of an eight
+            byte frame.  The SSE2 path checks and converts all 23 characters
+            with two vector loads; the fallback is the same test done a
+            character at a time.
+
+Input       p    - first character of the payload, at least 23 characters
+                   must be readable
+            data - set to the packed payload on success
+
+Return      true if the characters follow the common layout exactly
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline bool decodePayload8( const char* p, quint64& data )
+{
+#ifdef INGEST_SSE2
+    // Lanes 0-15 of a hold characters 0-15, lanes 0-15 of b characters 7-22
+    const int HEX_A = 0xB6DB;           // 0,1,3,4,6,7,9,10,12,13,15
+    const int BLANK_A = 0x4924;         // 2,5,8,11,14
+    const int HEX_B = 0xDB6D;           // 7,9,10,12,13,15,16,18,19,21,22
+    const int BLANK_B = 0x2492;         // 8,11,14,17,20
+
+    __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+    __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p + 7 ) );
+    const __m128i blank = _mm_set1_epi8( ' ' );
+
+    __m128i validA, validB;
+    __m128i nibA = hexNibbles( a, validA );
+    __m128i nibB = hexNibbles( b, validB );
+
+    if ( ( _mm_movemask_epi8( validA ) & HEX_A ) != HEX_A ||
+         ( _mm_movemask_epi8( validB ) & HEX_B ) != HEX_B ||
+         ( _mm_movemask_epi8( _mm_cmpeq_epi8( a, blank ) ) & BLANK_A ) != BLANK_A ||
+         ( _mm_movemask_epi8( _mm_cmpeq_epi8( b, blank ) ) & BLANK_B ) != BLANK_B )
+        return false;
+
+    uchar na[16], nb[16];
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( na ), nibA );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( nb ), nibB );
+
+    data = quint64( ( na[0] << 4 ) | na[1] )
+         | quint64( ( na[3] << 4 ) | na[4] ) << 8
+         | quint64( ( na[6] << 4 ) | na[7] ) << 16
+         | quint64( ( na[9] << 4 ) | na[10] ) << 24
+         | quint64( ( na[12] << 4 ) | na[13] ) << 32
+         | quint64( ( nb[8] << 4 ) | nb[9] ) << 40
+         | quint64( ( nb[11] << 4 ) | nb[12] ) << 48
+         | quint64( ( nb[14] << 4 ) | nb[15] ) << 56;
+    return true;
+#else
+    quint64 value = 0;
+    for ( int i = 0; i < 8; ++i )
+    {
+        const char* q = p + 3 * i;
+        int hi = hexValue( q[0] );
+        int lo = hexValue( q[1] );
+        if ( hi < 0 || lo < 0 || ( i < 7 && q[2] != ' ' ) )
+            return false;
+
+        value |= quint64( ( hi << 4 ) | lo ) << ( 8 * i );
+    }
+
+    data = value;
+    return true;
+#endif
+}
+
+/*----------------------------------------------------------------------------
+
+Name		skipBlanks
+
+Purpose		Advances p past any field separators
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline const char* skipBlanks( const char* p, const char* end )
+{
+    while ( p < end && isBlank( *p ) )
+        ++p;
+
+    return p;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		parseTimeStamp
+
+Purpose		Parses a "(sss.uuuuuu)" timestamp into microseconds
+
+Input       p   - position of the opening bracket, advanced past the closing
+                  bracket on success
+            end - end of the line
+
+Return      true if a timestamp was read
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool parseTimeStamp( const char*& p, const char* end, qint64& time )
+{
+    const char* q = p + 1;
+    qint64 secs = 0;
+    qint64 usecs = 0;
+    int fracDigits = 0;
+
+    while ( q < end && *q >= '0' && *q <= '9' )
+        secs = secs * 10 + ( *q++ - '0' );
+
+    if ( q < end && *q == '.' )
+    {
+        ++q;
+        while ( q < end && *q >= '0' && *q <= '9' )
+        {
+            if ( fracDigits < 6 )
+            {
+                usecs = usecs * 10 + ( *q - '0' );
+                ++fracDigits;
+            }
+            ++q;
+        }
+    }
+
+    if ( q >= end || *q != ')' )
+        return false;
+
+    for ( ; fracDigits < 6; ++fracDigits )
+        usecs *= 10;
+
+    time = secs * 1000000 + usecs;
+    p = q + 1;
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		lineEnd
+
+Purpose		Returns the position of the next line break, or end.  Scans 32
+            or 16 bytes at a time when AVX2 or SSE2 is available.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+const char* FrameIngest::lineEnd( const char* p, const char* end )
+{
+#ifdef INGEST_AVX2
+    const __m256i nl32 = _mm256_set1_epi8( '\n' );
+    const __m256i cr32 = _mm256_set1_epi8( '\r' );
+    while ( end - p >= 32 )
+    {
+        __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+        quint32 mask = quint32( _mm256_movemask_epi8(
+                           _mm256_or_si256( _mm256_cmpeq_epi8( v, nl32 ),
+                                            _mm256_cmpeq_epi8( v, cr32 ) ) ) );
+        if ( mask )
+            return p + qCountTrailingZeroBits( mask );
+        p += 32;
+    }
+#endif
+#ifdef INGEST_SSE2
+    const __m128i nl = _mm_set1_epi8( '\n' );
+    const __m128i cr = _mm_set1_epi8( '\r' );
+    while ( end - p >= 16 )
+    {
+        __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+        quint32 mask = quint32( _mm_movemask_epi8(
+                           _mm_or_si128( _mm_cmpeq_epi8( v, nl ),
+                                         _mm_cmpeq_epi8( v, cr ) ) ) );
+        if ( mask )
+            return p + qCountTrailingZeroBits( mask );
+        p += 16;
+    }
+#endif
+
+    while ( p < end && *p != '\n' && *p != '\r' )
+        ++p;
+
+    return p;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		parseLogData
+
+Purpose		Reads the data of a candump -l line (the part after cob-id#).
+            The bytes run together without blanks; a CAN FD flags field
+            (a second # and one digit) is skipped and only the first 8 bytes
+            are kept.
+
+Input       p, end - bounds of the data
+            rec    - record to fill in the DLC, payload and flags of
+
+Return      true if the data is well formed
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Flags remote requests
+----------------------------------------------------------------------------*/
+static bool parseLogData( const char* p, const char* end, FrameRecord& rec )
+{
+    rec.data = 0;
+
+    if ( p < end && ( *p == 'R' || *p == 'r' ) )
+    {
+        ++p;
+        rec.dlc = ( p < end && *p >= '0' && *p <= '8' ) ? quint8( *p - '0' ) : 0;
+        rec.flags |= FRAME_RTR;
+        return true;
+    }
+
+    if ( p < end && *p == '#' )
+    {
+        p += 2;
+        if ( p > end )
+            return false;
+    }
+
+    int n = 0;
+    while ( p + 1 < end && !isBlank( *p ) && *p != '\r' )
+    {
+        int hi = hexValue( p[0] );
+        int lo = hexValue( p[1] );
+        if ( hi < 0 || lo < 0 )
+            return false;
+
+        if ( n < 8 )
+            rec.data |= quint64( ( hi << 4 ) | lo ) << ( 8 * n );
+        ++n;
+        p += 2;
+    }
+    rec.dlc = quint8( qMin( n, 8 ) );
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		parseLine
+
+Purpose		Tokenizes a single candump line.  Besides the two display forms
+            the log form written by candump -l is read:
+
+            (sec.usec) port cob-id#XXXXXXXXXXXXXXXX
+
+            where cob-id#R marks a remote request.  Remote requests are
+            flagged FRAME_RTR in either form, and identifiers written with
+            more than 3 digits FRAME_EFF.
+
+Input       begin, end - bounds of the line (without line break)
+            rec        - record to fill (offset is left untouched)
+            ifaceBegin - set to the start of the interface name
+            ifaceLen   - set to the length of the interface name
+
+Return      true if the line follows any candump form
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Reads the candump -l log form
+            17 Oct 26  AFB	Flags remote requests
+            17 Oct 26  AFB	Flags 29 bit identifiers
+----------------------------------------------------------------------------*/
+bool FrameIngest::parseLine( const char* begin, const char* end, FrameRecord& rec,
+                             const char*& ifaceBegin, int& ifaceLen )
+{
+    const char* p = skipBlanks( begin, end );
+
+    rec.time = NO_TIMESTAMP;
+    rec.flags = 0;
+    if ( p < end && *p == '(' )
+    {
+        if ( !parseTimeStamp( p, end, rec.time ) )
+            return false;
+        p = skipBlanks( p, end );
+    }
+
+    // Port
+    ifaceBegin = p;
+    while ( p < end && !isBlank( *p ) )
+        ++p;
+    ifaceLen = int( p - ifaceBegin );
+    if ( ifaceLen == 0 )
+        return false;
+    p = skipBlanks( p, end );
+
+    // COB-ID
+    quint32 cobId = 0;
+    const char* idBegin = p;
+    int v;
+    while ( p < end && ( v = hexValue( *p ) ) >= 0 )
+    {
+        cobId = ( cobId << 4 ) | quint32( v );
+        ++p;
+    }
+    if ( p == idBegin )
+        return false;
+    rec.cobId = cobId;
+
+    // candump writes 29 bit identifiers with 8 digits, 11 bit ones with 3
+    if ( p - idBegin > 3 )
+        rec.flags |= FRAME_EFF;
+
+    if ( p < end && *p == '#' )
+        return parseLogData( p + 1, end, rec );
+
+    p = skipBlanks( p, end );
+
+    // [#]
+    if ( p >= end || *p != '[' )
+        return false;
+    ++p;
+    if ( p >= end || *p < '0' || *p > '9' )
+        return false;
+    int dlc = 0;
+    while ( p < end && *p >= '0' && *p <= '9' )
+        dlc = dlc * 10 + ( *p++ - '0' );
+    if ( p >= end || *p != ']' )
+        return false;
+    ++p;
+    rec.dlc = quint8( qMin( dlc, 8 ) );
+
+    // Data bytes
+    quint64 data = 0;
+    p = skipBlanks( p, end );
+    if ( rec.dlc == 8 && end - p >= 23 && decodePayload8( p, data ) )
+    {
+        rec.data = data;
+        return true;
+    }
+
+    // candump writes remote requests as [dlc] remote request
+    if ( end - p >= 6 && memcmp( p, "remote", 6 ) == 0 )
+    {
+        rec.data = 0;
+        rec.flags |= FRAME_RTR;
+        return true;
+    }
+
+    for ( int i = 0; i < rec.dlc; ++i )
+    {
+        p = skipBlanks( p, end );
+        if ( p + 1 >= end )
+            break;
+
+        int hi = hexValue( p[0] );
+        int lo = hexValue( p[1] );
+        if ( hi < 0 || lo < 0 )
+            break;
+
+        data |= quint64( ( hi << 4 ) | lo ) << ( 8 * i );
+        p += 2;
+    }
+    rec.data = data;
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		estimateLines
+
+Purpose		Estimates the number of lines in a block of text from the line
+            breaks of its first few kilobytes, slightly over rather than
+            under so the columns are grown only once
+
+Input       begin, end - bounds of the text
+
+Return      estimated number of lines
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static int estimateLines( const char* begin, const char* end )
+{
+    const qint64 bytes = end - begin;
+    const qint64 sample = qMin( bytes, LINE_SAMPLE );
+
+    qint64 breaks = 1;
+    for ( const char* p = begin; p < begin + sample; ++p )
+        breaks += ( *p == '\n' );
+
+    return int( qMin( bytes, breaks * bytes / sample + breaks / 16 + 1 ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		parse
+
+Purpose		Tokenizes every line of a block of candump text into the table
+
+Input       begin, end - bounds of the text
+            offset     - byte offset of begin within the original file
+            table      - table the frames are appended to
+
+Return      number of non-empty lines that could not be tokenized
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Sizes an empty table for the whole block up front
+----------------------------------------------------------------------------*/
+int FrameIngest::parse( const char* begin, const char* end, qint64 offset,
+                        FrameTable& table )
+{
+    int skipped = 0;
+
+    // A table of its own is sized for the whole block up front.  Appending
+    // to one that already holds frames is left to the columns' own growth,
+    // as reserving exactly each time would copy them on every call.
+    if ( table.isEmpty() && end > begin )
+        table.reserve( estimateLines( begin, end ) );
+
+    // The interface name rarely changes from one line to the next, so the
+    // last id is cached rather than looked up by name on every line
+    const char* lastIface = 0;
+    int lastIfaceLen = 0;
+    quint8 lastIfaceId = 0;
+
+    const char* p = begin;
+    while ( p < end )
+    {
+        const char* eol = lineEnd( p, end );
+
+        if ( eol != p )
+        {
+            FrameRecord rec;
+            const char* iface;
+            int ifaceLen;
+
+            if ( parseLine( p, eol, rec, iface, ifaceLen ) )
+            {
+                if ( !lastIface || ifaceLen != lastIfaceLen ||
+                     memcmp( iface, lastIface, size_t( ifaceLen ) ) != 0 )
+                {
+                    lastIfaceId = table.ifaceId( QString::fromLatin1( iface, ifaceLen ) );
+                    lastIface = iface;
+                    lastIfaceLen = ifaceLen;
+                }
+
+                rec.iface = lastIfaceId;
+                rec.offset = offset + ( p - begin );
+                table.append( rec );
+            }
+            else
+            {
+                ++skipped;
+            }
+        }
+
+        p = eol + 1;
+    }
+
+    return skipped;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		parseChunk
+
+Purpose		Tokenizes one chunk into a table of its own.  Run on a worker
+            thread, so it touches nothing but the chunk.
+
+Input       chunk - block of text to tokenize
+
+Return      frames of the chunk along with timing information
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Times the tokenize stage
+----------------------------------------------------------------------------*/
+IngestResult FrameIngest::parseChunk( const IngestChunk& chunk )
+{
+    IngestResult result;
+    QElapsedTimer timer;
+    timer.start();
+    StageTimer stage( STAGE_TOKENIZE );
+
+    result.skipped = parse( chunk.begin, chunk.end, chunk.offset, result.table );
+    stage.setFrames( result.table.size() );
+    result.bytes = chunk.end - chunk.begin;
+    result.nsecs = timer.nsecsElapsed();
+    result.thread = QThread::currentThreadId();
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		parseParallel
+
+Purpose		Splits a block of text into newline aligned chunks, tokenizes them
+            on the global thread pool and merges the results in file order
+
+Input       begin, end - bounds of the text (offsets are relative to begin)
+            table      - table the frames are appended to
+
+Return      summary of the ingest, including per-thread throughput
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Times the ingest stage
+----------------------------------------------------------------------------*/
+IngestReport FrameIngest::parseParallel( const char* begin, const char* end,
+                                         FrameTable& table )
+{
+    QElapsedTimer timer;
+    timer.start();
+    StageTimer stage( STAGE_INGEST );
+    const int first = table.size();
+
+    // Aim for a few chunks per thread so that uneven chunks still balance
+    qint64 chunkSize = ( end - begin ) / ( QThread::idealThreadCount() * 4 );
+    chunkSize = qBound( INGEST_MIN_CHUNK, chunkSize, INGEST_CHUNK );
+
+    QVector<IngestChunk> chunks;
+    const char* p = begin;
+    while ( p < end )
+    {
+        IngestChunk chunk;
+        chunk.begin = p;
+        chunk.end = lineEnd( p + qMin( chunkSize, qint64( end - p ) ), end );
+        chunk.offset = p - begin;
+        chunks.append( chunk );
+
+        p = chunk.end;
+    }
+
+    QVector<IngestResult> results =
+        QtConcurrent::blockingMapped< QVector<IngestResult> >( chunks, parseChunk );
+
+    IngestReport report;
+    report.skipped = 0;
+    report.bytes = end - begin;
+
+    int frames = table.size();
+    for ( int i = 0; i < results.size(); ++i )
+        frames += results.at(i).table.size();
+    table.reserve( frames );
+
+    QMap<Qt::HANDLE, QPair<qint64, qint64> > perThread;
+    for ( int i = 0; i < results.size(); ++i )
+    {
+        const IngestResult& result = results.at(i);
+        table.append( result.table );
+        report.skipped += result.skipped;
+
+        QPair<qint64, qint64>& busy = perThread[ result.thread ];
+        busy.first += result.bytes;
+        busy.second += result.nsecs;
+    }
+
+    report.nsecs = timer.nsecsElapsed();
+    stage.setFrames( table.size() - first );
+
+    QMap<Qt::HANDLE, QPair<qint64, qint64> >::const_iterator it;
+    for ( it = perThread.constBegin(); it != perThread.constEnd(); ++it )
+    {
+        double secs = qMax<qint64>( it.value().second, 1 ) / 1e9;
+        report.threadMBps.insert( it.key(), it.value().first / secs / ( 1024 * 1024 ) );
+    }
+
+    return report;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		formatLine
+
+Purpose		Writes a frame out in the candump form parseLine reads:
+
+            (sec.usec)  port  cob-id   [dlc]  XX XX XX XX XX XX XX XX
+
+            The timestamp is left out for frames read without one, and
+            remote requests read "remote request" in place of the bytes.
+
+Input       table - table holding the frame
+            frame - frame to format
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Writes remote requests as candump does
+            17 Oct 26  AFB	Pads identifiers by the 29 bit flag
+----------------------------------------------------------------------------*/
+QString FrameIngest::formatLine( const FrameTable& table, FrameId frame )
+{
+    QString line;
+
+    qint64 time = table.time( frame );
+    if ( time != NO_TIMESTAMP )
+    {
+        line += QString( "(%1.%2)  " )
+                .arg( time / 1000000 )
+                .arg( time % 1000000, 6, 10, QChar( '0' ) );
+    }
+
+    quint32 cobId = table.cobId( frame );
+    int dlc = qMin<int>( table.dlc( frame ), 8 );
+
+    line += QString( "%1  %2   [%3] " )
+            .arg( table.ifaces().value( table.iface( frame ) ) )
+            .arg( QString::number( cobId, 16 ).toUpper()
+                  .rightJustified( table.isExtended( frame ) ? 8 : 3, '0' ) )
+            .arg( dlc );
+    if ( table.isRemote( frame ) )
+    {
+        line += QString( " remote request" );
+        return line;
+    }
+    for ( int i = 0; i < dlc; ++i )
+        line += QString( " %1" ).arg( table.dataByte( frame, i ), 2, 16, QChar( '0' ) ).toUpper();
+
+    return line;
+}
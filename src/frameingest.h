@@ -0,0 +1,92 @@
+/*----------------------------------------------------------------------------
+
+Name		frameingest.h
+
+Purpose		Turns raw candump text into FrameTable records.  Lines must
+            follow the form:
+
+            port cob-id [#] XX XX XX XX XX XX XX XX
+
+            or
+
+            (XXXXXX) port cob-id [#] XX XX XX XX XX XX XX XX
+
+            or the candump -l log form
+
+            (XXXXXX) port cob-id#XXXXXXXXXXXXXXXX
+
+            Lines that do not follow any of these forms are skipped.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef FRAMEINGEST_H
+#define FRAMEINGEST_H
+
+#include "frametable.h"
+#include <QMap>
+#include <QThread>
+
+// Largest and smallest size of the blocks a dump is tokenized in
+const qint64 INGEST_CHUNK = 64 * 1024 * 1024;
+const qint64 INGEST_MIN_CHUNK = 1024 * 1024;
+
+// A newline aligned block of text handed to one worker
+struct IngestChunk
+{
+    const char* begin;
+    const char* end;
+    qint64 offset;          // Byte offset of begin within the file
+};
+
+// Frames tokenized from one chunk
+struct IngestResult
+{
+    FrameTable table;
+    int skipped;            // Lines that could not be tokenized
+    qint64 bytes;           // Size of the chunk
+    qint64 nsecs;           // Time spent tokenizing
+    Qt::HANDLE thread;      // Worker thread that tokenized the chunk
+};
+
+// Summary of a complete ingest
+struct IngestReport
+{
+    int skipped;                    // Lines that could not be tokenized
+    qint64 bytes;                   // Bytes tokenized
+    qint64 nsecs;                   // Wall clock time of the ingest
+    QMap<Qt::HANDLE, double> threadMBps;   // Throughput of each worker
+};
+
+class FrameIngest
+{
+public:
+    // Tokenizes every line in [begin, end) and appends the frames to table.
+    // offset is the byte offset of begin within the original file.
+    // Returns the number of lines that could not be tokenized.
+    static int parse( const char* begin, const char* end, qint64 offset,
+                      FrameTable& table );
+
+    // Splits [begin, end) into newline aligned chunks, tokenizes them on the
+    // global thread pool and appends the frames to table in file order.
+    static IngestReport parseParallel( const char* begin, const char* end,
+                                       FrameTable& table );
+
+    // Tokenizes a single chunk (run on a worker thread)
+    static IngestResult parseChunk( const IngestChunk& chunk );
+
+    // Tokenizes a single line in [begin, end).  The interface name is
+    // returned through ifaceBegin / ifaceLen.  Returns false if the line
+    // does not follow any candump form.
+    static bool parseLine( const char* begin, const char* end, FrameRecord& rec,
+                           const char*& ifaceBegin, int& ifaceLen );
+
+    // Returns the end of the line starting at p (position of the line break
+    // or end)
+    static const char* lineEnd( const char* p, const char* end );
+
+    // Writes a frame back out in the timestamped candump form, for frames
+    // that have no original line (e.g. read live from a socket)
+    static QString formatLine( const FrameTable& table, FrameId frame );
+};
+
+#endif // FRAMEINGEST_H
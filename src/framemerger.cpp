@@ -0,0 +1,185 @@
+/*----------------------------------------------------------------------------
+
+Name		framemerger.cpp
+
+Purpose		Timestamp ordered k-way merge of frame tables.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "framemerger.h"
+
+/*----------------------------------------------------------------------------
+
+Name		FrameMerger
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+FrameMerger::FrameMerger()
+    : mRemaining( 0 )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Drops every input, releasing their tables
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameMerger::clear()
+{
+    mInputs.clear();
+    mBases.clear();
+    mNext.clear();
+    mCarry.clear();
+    mHeap = std::priority_queue< Head, std::vector<Head>, std::greater<Head> >();
+    mRemaining = 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		addInput
+
+Purpose		Adds a table to the merge, its frames assumed to be in the order
+            they were logged
+
+Input       table - frames to merge (shared, not copied)
+            base  - added to the frames' offsets; negative for none
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameMerger::addInput( const FrameTable& table, qint64 base )
+{
+    if ( table.isEmpty() )
+        return;
+
+    const int input = mInputs.size();
+    mInputs.append( table );
+    mBases.append( base );
+    mNext.append( 0 );
+    mCarry.append( NO_TIMESTAMP );
+    mRemaining += table.size();
+
+    mHeap.push( Head( key( input, 0 ), input ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		key
+
+Purpose		Returns the timestamp a frame sorts by: its own, or the last one
+            seen in its input when it has none
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+qint64 FrameMerger::key( int input, int pos )
+{
+    const qint64 time = mInputs.at( input ).time( FrameId( pos ) );
+    if ( time == NO_TIMESTAMP )
+        return mCarry.at( input );
+
+    mCarry[ input ] = time;
+    return time;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		take
+
+Purpose		Appends one frame of an input to out
+
+Input       out    - table merged into
+            ifaces - the input's interface ids mapped to out's
+            input  - input the frame is taken from
+            pos    - frame of the input
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Keeps the frame flags
+----------------------------------------------------------------------------*/
+void FrameMerger::take( FrameTable& out, const QVector<quint8>& ifaces,
+                        int input, int pos ) const
+{
+    const FrameTable& table = mInputs.at( input );
+    const FrameId frame = FrameId( pos );
+    const qint64 base = mBases.at( input );
+
+    FrameRecord rec;
+    rec.time = table.time( frame );
+    rec.cobId = table.cobId( frame );
+    rec.data = table.data( frame );
+    rec.dlc = table.dlc( frame );
+    rec.iface = ifaces.at( table.iface( frame ) );
+    rec.flags = table.flags( frame );
+    rec.offset = ( base < 0 || table.offset( frame ) < 0 ) ? -1 : base + table.offset( frame );
+    out.append( rec );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		merge
+
+Purpose		Moves the next frames, earliest first, to the end of a table.
+            The input at the top of the heap is drained for as long as its
+            frames come no later than the next input's head, so the heap is
+            only touched where the inputs interleave.
+
+Input       out   - table the frames are appended to
+            count - most frames to append
+
+Return      the number of frames appended
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int FrameMerger::merge( FrameTable& out, int count )
+{
+    // Interface ids of every input, in terms of out's
+    QVector< QVector<quint8> > ifaces( mInputs.size() );
+    for ( int i = 0; i < mInputs.size(); ++i )
+    {
+        const QStringList& names = mInputs.at(i).ifaces();
+        for ( int n = 0; n < names.size(); ++n )
+            ifaces[i].append( out.ifaceId( names.at(n) ) );
+    }
+
+    out.reserve( out.size() + int( qMin( qint64( count ), mRemaining ) ) );
+
+    int merged = 0;
+    while ( merged < count && !mHeap.empty() )
+    {
+        const Head head = mHeap.top();
+        mHeap.pop();
+
+        const int input = head.second;
+        const int size = mInputs.at( input ).size();
+        int& pos = mNext[ input ];
+
+        // Drain the input while it stays ahead of every other head
+        qint64 time = head.first;
+        do
+        {
+            take( out, ifaces.at( input ), input, pos );
+            ++pos;
+            ++merged;
+
+            if ( pos == size )
+                break;
+            time = key( input, pos );
+        }
+        while ( merged < count &&
+                ( mHeap.empty() || Head( time, input ) < mHeap.top() ) );
+
+        if ( pos < size )
+            mHeap.push( Head( time, input ) );
+    }
+
+    mRemaining -= merged;
+    if ( mRemaining == 0 )
+        clear();
+
+    return merged;
+}
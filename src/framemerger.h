@@ -0,0 +1,69 @@
+/*----------------------------------------------------------------------------
+
+Name		framemerger.h
+
+Purpose		Timestamp ordered k-way merge of several frame tables, e.g. one
+            dump per interface.  The next frame is always taken from the
+            input whose head is earliest (a min-heap of heads), and a run of
+            frames from one input is copied without touching the heap until
+            another input's head comes first, so inputs that barely overlap
+            merge in linear time.  The merge is taken a block at a time, so
+            the merged frames can be handed on as they are produced.
+
+            Frames without a timestamp take the last timestamp seen in their
+            input, so they stay beside the frames they were logged with.
+            Ties go to the input added first.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef FRAMEMERGER_H
+#define FRAMEMERGER_H
+
+#include <QVector>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "frametable.h"
+
+class FrameMerger
+{
+public:
+    FrameMerger();
+
+    // Drops every input
+    void clear();
+
+    // Adds an input.  base is added to the frames' offsets so the inputs'
+    // offsets do not collide; a negative base marks the frames as having
+    // no line to read back (offset -1).
+    void addInput( const FrameTable& table, qint64 base );
+
+    // Returns the frames not yet merged
+    qint64 remaining() const { return mRemaining; }
+    bool atEnd() const { return mRemaining == 0; }
+
+    // Appends up to count frames, in timestamp order, to out and returns
+    // the number appended
+    int merge( FrameTable& out, int count );
+
+private:
+    // Timestamp a frame sorts by
+    qint64 key( int input, int pos );
+
+    // Appends frame pos of an input to out
+    void take( FrameTable& out, const QVector<quint8>& ifaces, int input, int pos ) const;
+
+private:
+    // Earliest unmerged frame of an input: (timestamp, input)
+    typedef std::pair<qint64, int> Head;
+
+    QVector<FrameTable> mInputs;    // Tables being merged
+    QVector<qint64> mBases;         // Offset base of each input
+    QVector<int> mNext;             // Next unmerged frame of each input
+    QVector<qint64> mCarry;         // Last timestamp seen in each input
+    std::priority_queue< Head, std::vector<Head>, std::greater<Head> > mHeap;
+    qint64 mRemaining;              // Frames not yet merged
+};
+
+#endif // FRAMEMERGER_H
@@ -0,0 +1,160 @@
+/*----------------------------------------------------------------------------
+
+Name		framemodel.cpp
+
+Purpose		List model over the frames matching the current filter.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "framemodel.h"
+#include "parser.h"
+#include <algorithm>
+
+/*----------------------------------------------------------------------------
+
+Name		FrameModel
+
+Purpose		Constructor
+
+Input       parser - parser the frames and their text are read from
+            parent - owning object
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+FrameModel::FrameModel( const Parser& parser, QObject* parent )
+    : QAbstractListModel( parent ),
+      mParser( parser ),
+      mDecode( false )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		rowCount
+
+Purpose		Returns the number of matching frames
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int FrameModel::rowCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() )
+        return 0;
+
+    return mMatches.size();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		data
+
+Purpose		Returns the original line of the frame in the given row, followed
+            when decoding by its objects.  Called by the view for visible
+            rows only, so only they are ever decoded.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Appends the decoded objects
+----------------------------------------------------------------------------*/
+QVariant FrameModel::data( const QModelIndex& index, int role ) const
+{
+    if ( !index.isValid() || index.row() >= mMatches.size() )
+        return QVariant();
+
+    if ( role == Qt::DisplayRole )
+    {
+        const FrameId frame = mMatches.at( index.row() );
+        QString text = mParser.line( frame );
+        if ( mDecode )
+        {
+            const QString decoded = mParser.decode( frame );
+            if ( !decoded.isEmpty() )
+                text += "    " + decoded;
+        }
+
+        return text;
+    }
+
+    return QVariant();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setMatches
+
+Purpose		Replaces the rows of the model
+
+Input       matches - ids of the frames to show, in display order
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameModel::setMatches( const QVector<FrameId>& matches )
+{
+    beginResetModel();
+    mMatches = matches;
+    endResetModel();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		appendMatches
+
+Purpose		Adds rows to the end of the model as the parser finds more
+            matching frames
+
+Input       matches - ids of the frames to add, in display order
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameModel::appendMatches( const QVector<FrameId>& matches )
+{
+    if ( matches.isEmpty() )
+        return;
+
+    beginInsertRows( QModelIndex(), mMatches.size(), mMatches.size() + matches.size() - 1 );
+    mMatches += matches;
+    endInsertRows();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setDecode
+
+Purpose		Turns on or off the decoded objects shown after each line
+
+Input       decode - true to decode
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameModel::setDecode( bool decode )
+{
+    if ( decode == mDecode )
+        return;
+
+    mDecode = decode;
+    if ( !mMatches.isEmpty() )
+        emit dataChanged( index( 0 ), index( mMatches.size() - 1 ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		rowOf
+
+Purpose		Returns the row showing a frame, by binary search of the
+            matches (which are in frame order)
+
+Input       frame - frame to find
+
+Return      the row, or -1 if the frame is not shown
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int FrameModel::rowOf( FrameId frame ) const
+{
+    const FrameId* begin = mMatches.constData();
+    const FrameId* end = begin + mMatches.size();
+    const FrameId* found = std::lower_bound( begin, end, frame );
+
+    return ( found != end && *found == frame ) ? int( found - begin ) : -1;
+}
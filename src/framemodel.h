@@ -0,0 +1,52 @@
+/*----------------------------------------------------------------------------
+
+Name		framemodel.h
+
+Purpose		List model over the frames matching the current filter.  Only the
+            ids of the matching frames are held; the text of a row is read
+            back from the parser when the view asks for it, so only visible
+            rows are ever rendered.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef FRAMEMODEL_H
+#define FRAMEMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include "frametable.h"
+
+class Parser;
+
+class FrameModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit FrameModel( const Parser& parser, QObject* parent = 0 );
+
+    // QAbstractListModel interface
+    int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+    QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+
+    // Returns the frame shown in the given row
+    FrameId frameAt( int row ) const { return mMatches.at( row ); }
+    // Returns the row showing a frame, or -1 if the filter hides it
+    int rowOf( FrameId frame ) const;
+
+    // Turns on or off the decoded objects shown after each line
+    void setDecode( bool decode );
+
+public slots:
+    // Replaces the rows with the given frames
+    void setMatches( const QVector<FrameId>& matches );
+    // Adds rows for the given frames to the end of the model
+    void appendMatches( const QVector<FrameId>& matches );
+
+private:
+    const Parser& mParser;          // Source of the row text
+    QVector<FrameId> mMatches;      // Frames shown, one per row
+    bool mDecode;                   // Show each row's decoded objects
+};
+
+#endif // FRAMEMODEL_H
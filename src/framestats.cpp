@@ -0,0 +1,394 @@
+/*----------------------------------------------------------------------------
+
+Name		framestats.cpp
+
+Purpose		Traffic statistics over a FrameTable.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "framestats.h"
+#include <QThread>
+#include <QtConcurrent>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// Identifier slots per interface: every 11 bit COB-ID, plus one shared by
+// all wider ids
+static const int COB_KEYS = 0x801;
+
+// One chunk of the table, counted on a worker thread
+struct StatsChunk
+{
+    const FrameTable* table;
+    int begin;                          // Frames counted
+    int end;
+    int ifaceCount;
+    qint64 slot;                        // Length of a load slot (microseconds)
+
+    qint64 earliest;                    // Earliest timestamp in the chunk
+    qint64 latest;                      // Latest timestamp in the chunk
+
+    QVector<CobStats> cobs;             // ifaceCount * COB_KEYS, dense
+    QVector< QVector<quint64> > slotBits;   // Bits sent in each slot, per
+                                            // interface, from the slot of
+                                            // earliest on
+};
+
+/*----------------------------------------------------------------------------
+
+Name		scanTimes
+
+Purpose		Finds the earliest and latest timestamp of a chunk.  A plain
+            min / max over the column, which the compiler vectorizes.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void scanTimes( StatsChunk& chunk )
+{
+    const qint64* times = chunk.table->times().constData();
+    qint64 earliest = std::numeric_limits<qint64>::max();
+    qint64 latest = NO_TIMESTAMP;
+
+    for ( int i = chunk.begin; i < chunk.end; ++i )
+    {
+        const qint64 t = times[i];
+        earliest = ( t >= 0 && t < earliest ) ? t : earliest;
+        latest = ( t > latest ) ? t : latest;
+    }
+
+    chunk.earliest = earliest;
+    chunk.latest = latest;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		countChunk
+
+Purpose		Counts the frames of a chunk.  The columns are read through raw
+            pointers in one pass; the period of each COB-ID is measured from
+            the last frame of that COB-ID seen in the chunk.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void countChunk( StatsChunk& chunk )
+{
+    const qint64* times = chunk.table->times().constData();
+    const quint8* ifaces = chunk.table->ifaceIds().constData();
+    const quint32* cobIds = chunk.table->cobIds().constData();
+    const quint8* dlcs = chunk.table->dlcs().constData();
+
+    CobStats empty;
+    memset( &empty, 0, sizeof( empty ) );
+    empty.first = NO_TIMESTAMP;
+    empty.last = NO_TIMESTAMP;
+    chunk.cobs.fill( empty, chunk.ifaceCount * COB_KEYS );
+
+    const qint64 origin = ( chunk.latest >= 0 ) ? chunk.earliest / chunk.slot : 0;
+    const int slotCount = ( chunk.latest >= 0 )
+                          ? int( chunk.latest / chunk.slot - origin ) + 1 : 0;
+    chunk.slotBits.resize( chunk.ifaceCount );
+    for ( int i = 0; i < chunk.ifaceCount; ++i )
+        chunk.slotBits[i].fill( 0, slotCount );
+
+    CobStats* cobs = chunk.cobs.data();
+    for ( int i = chunk.begin; i < chunk.end; ++i )
+    {
+        const quint32 cobId = cobIds[i];
+        const quint8 dlc = qMin<quint8>( dlcs[i], 8 );
+        const quint32 bits = FrameStats::frameBits( cobId, dlc );
+
+        CobStats& s = cobs[ ifaces[i] * COB_KEYS + qMin<quint32>( cobId, 0x800 ) ];
+        ++s.count;
+        ++s.dlcs[ dlc ];
+        s.bits += bits;
+
+        const qint64 t = times[i];
+        if ( t < 0 )
+            continue;
+
+        if ( s.last >= 0 && t >= s.last )
+        {
+            const qint64 gap = t - s.last;
+            ++s.gaps;
+            s.gapSum += gap;
+            s.gapMax = qMax( s.gapMax, gap );
+            s.gapSqSum += double( gap ) * double( gap );
+        }
+        else if ( s.first < 0 )
+        {
+            s.first = t;
+        }
+        s.last = t;
+
+        chunk.slotBits[ ifaces[i] ][ int( t / chunk.slot - origin ) ] += bits;
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mergeCob
+
+Purpose		Adds the statistics of a later chunk to those of the chunks
+            before it.  The period between the two is counted as well.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void mergeCob( CobStats& acc, const CobStats& next )
+{
+    if ( next.count == 0 )
+        return;
+
+    if ( acc.last >= 0 && next.first >= acc.last )
+    {
+        const qint64 gap = next.first - acc.last;
+        ++acc.gaps;
+        acc.gapSum += gap;
+        acc.gapMax = qMax( acc.gapMax, gap );
+        acc.gapSqSum += double( gap ) * double( gap );
+    }
+
+    if ( acc.first < 0 )
+        acc.first = next.first;
+    if ( next.last >= 0 )
+        acc.last = next.last;
+
+    acc.count += next.count;
+    acc.gaps += next.gaps;
+    acc.gapSum += next.gapSum;
+    acc.gapMax = qMax( acc.gapMax, next.gapMax );
+    acc.gapSqSum += next.gapSqSum;
+    acc.bits += next.bits;
+    for ( int d = 0; d < 9; ++d )
+        acc.dlcs[d] += next.dlcs[d];
+}
+
+/*----------------------------------------------------------------------------
+
+Name		jitter
+
+Purpose		Returns the standard deviation of the period, in microseconds
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+double CobStats::jitter() const
+{
+    if ( gaps < 2 )
+        return 0.0;
+
+    const double mean = meanGap();
+    const double variance = gapSqSum / gaps - mean * mean;
+    return variance > 0.0 ? std::sqrt( variance ) : 0.0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		FrameStats
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+FrameStats::FrameStats()
+    : mSpan( 0 ),
+      mBitrate( 0 ),
+      mWindow( 0 )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		frameBits
+
+Purpose		Returns the bits a frame takes on the bus: the fixed fields of a
+            base (47) or extended (67) frame, the data, and the most stuff
+            bits the stuffed part can need.  Loads worked out from this are
+            an upper bound.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+quint32 FrameStats::frameBits( quint32 cobId, quint8 dlc )
+{
+    const quint32 data = 8u * dlc;
+    if ( cobId > 0x7FF )
+        return 67 + data + ( 54 + data - 1 ) / 4;
+
+    return 47 + data + ( 34 + data - 1 ) / 4;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		compute
+
+Purpose		Gathers the statistics of every frame in the table.  The chunks
+            are scanned for their time range first, so each only keeps load
+            slots for its own stretch of time, then counted in waves of a few
+            per thread and merged in frame order.
+
+Input       table   - frames to count
+            bitrate - bus speed, bits per second
+            window  - length of the bus load window, microseconds
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameStats::compute( const FrameTable& table, int bitrate, qint64 window )
+{
+    mCobs.clear();
+    mNodes.clear();
+    mLoads.clear();
+    mSpan = 0;
+    mBitrate = bitrate;
+    mWindow = qMax<qint64>( window, STATS_WINDOW_SLOTS );
+
+    const int ifaceCount = table.ifaces().size();
+    if ( table.isEmpty() || ifaceCount == 0 )
+        return;
+
+    QVector<StatsChunk> chunks;
+    for ( int begin = 0; begin < table.size(); begin += STATS_CHUNK )
+    {
+        StatsChunk chunk;
+        chunk.table = &table;
+        chunk.begin = begin;
+        chunk.end = qMin( begin + STATS_CHUNK, table.size() );
+        chunk.ifaceCount = ifaceCount;
+        chunk.slot = 1;
+        chunks.append( chunk );
+    }
+
+    QtConcurrent::blockingMap( chunks, scanTimes );
+
+    qint64 earliest = std::numeric_limits<qint64>::max();
+    qint64 latest = NO_TIMESTAMP;
+    for ( int i = 0; i < chunks.size(); ++i )
+    {
+        earliest = qMin( earliest, chunks.at(i).earliest );
+        latest = qMax( latest, chunks.at(i).latest );
+    }
+    mSpan = ( latest >= 0 ) ? latest - earliest : 0;
+
+    // Widen the slots (and with them the window) if the dump is too long
+    // to hold them all
+    qint64 slot = mWindow / STATS_WINDOW_SLOTS;
+    if ( mSpan / slot >= STATS_MAX_SLOTS )
+    {
+        slot = mSpan / ( STATS_MAX_SLOTS - 1 ) + 1;
+        mWindow = slot * STATS_WINDOW_SLOTS;
+    }
+
+    const qint64 origin = ( latest >= 0 ) ? earliest / slot : 0;
+    const int slotCount = ( latest >= 0 ) ? int( latest / slot - origin ) + 1 : 0;
+
+    CobStats empty;
+    memset( &empty, 0, sizeof( empty ) );
+    empty.first = NO_TIMESTAMP;
+    empty.last = NO_TIMESTAMP;
+    QVector<CobStats> cobs( ifaceCount * COB_KEYS, empty );
+
+    QVector< QVector<quint64> > slotBits( ifaceCount );
+    for ( int i = 0; i < ifaceCount; ++i )
+        slotBits[i].fill( 0, slotCount );
+
+    // Count a few chunks per thread at a time so the dense per-chunk
+    // tables do not all exist at once
+    const int wave = qMax( 1, QThread::idealThreadCount() * 2 );
+    for ( int first = 0; first < chunks.size(); first += wave )
+    {
+        const int last = qMin( first + wave, chunks.size() );
+        for ( int c = first; c < last; ++c )
+            chunks[c].slot = slot;
+
+        QtConcurrent::blockingMap( chunks.begin() + first, chunks.begin() + last,
+                                   countChunk );
+
+        for ( int c = first; c < last; ++c )
+        {
+            StatsChunk& chunk = chunks[c];
+            for ( int k = 0; k < cobs.size(); ++k )
+                mergeCob( cobs[k], chunk.cobs.at(k) );
+
+            if ( chunk.latest >= 0 )
+            {
+                const int offset = int( chunk.earliest / slot - origin );
+                for ( int i = 0; i < ifaceCount; ++i )
+                {
+                    const QVector<quint64>& from = chunk.slotBits.at(i);
+                    quint64* to = slotBits[i].data() + offset;
+                    for ( int s = 0; s < from.size(); ++s )
+                        to[s] += from.at(s);
+                }
+            }
+
+            chunk.cobs.clear();
+            chunk.slotBits.clear();
+        }
+    }
+
+    // COB-IDs and nodes seen
+    QVector<NodeStats> nodes( 128 );
+    for ( int n = 0; n < nodes.size(); ++n )
+    {
+        nodes[n].node = quint8( n );
+        nodes[n].count = 0;
+        nodes[n].bits = 0;
+        nodes[n].cobIds = 0;
+    }
+
+    QVector<quint64> ifaceBits( ifaceCount, 0 );
+    for ( int k = 0; k < cobs.size(); ++k )
+    {
+        CobStats& s = cobs[k];
+        if ( s.count == 0 )
+            continue;
+
+        s.iface = quint8( k / COB_KEYS );
+        s.cobId = quint32( k % COB_KEYS );
+        mCobs.append( s );
+        ifaceBits[ s.iface ] += s.bits;
+
+        if ( s.cobId < 0x800 )
+        {
+            NodeStats& node = nodes[ s.cobId & 0x7F ];
+            node.count += s.count;
+            node.bits += s.bits;
+            ++node.cobIds;
+        }
+    }
+
+    for ( int n = 0; n < nodes.size(); ++n )
+    {
+        if ( nodes.at(n).count )
+            mNodes.append( nodes.at(n) );
+    }
+
+    // Mean load over the dump, and the busiest window
+    const double windowBits = double( bitrate ) * mWindow / 1e6;
+    for ( int i = 0; i < ifaceCount; ++i )
+    {
+        BusLoad load;
+        load.iface = quint8( i );
+        load.mean = mSpan > 0 ? 100.0 * ifaceBits.at(i) / ( double( bitrate ) * mSpan / 1e6 ) : 0.0;
+        load.peak = 0.0;
+        load.peakTime = NO_TIMESTAMP;
+
+        const QVector<quint64>& bits = slotBits.at(i);
+        quint64 sum = 0;
+        for ( int s = 0; s < bits.size(); ++s )
+        {
+            sum += bits.at(s);
+            if ( s >= STATS_WINDOW_SLOTS )
+                sum -= bits.at( s - STATS_WINDOW_SLOTS );
+
+            const double percent = 100.0 * sum / windowBits;
+            if ( percent > load.peak )
+            {
+                load.peak = percent;
+                load.peakTime = ( origin + qMax( 0, s - STATS_WINDOW_SLOTS + 1 ) ) * slot;
+            }
+        }
+
+        mLoads.append( load );
+    }
+}
@@ -0,0 +1,114 @@
+/*----------------------------------------------------------------------------
+
+Name		framestats.h
+
+Purpose		Traffic statistics over a FrameTable.  One pass over the
+            timestamp, identifier and DLC columns gathers, for every COB-ID
+            on every interface:
+
+                count     - frames sent
+                gaps      - mean and largest time between frames, and the
+                            jitter (standard deviation) of that period
+                DLCs      - how many frames were sent with each length
+                bits      - estimated bits on the bus
+
+            from which per-node totals and the bus load of each interface
+            (mean, and peak over a sliding window) are derived.  The table
+            is cut into chunks that are counted on the thread pool and
+            merged in frame order, so periods that straddle two chunks are
+            still counted.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <QVector>
+#include "frametable.h"
+
+// Frames counted by one worker
+const int STATS_CHUNK = 1024 * 1024;
+
+// Slots of the sliding bus load window (the window moves on by one slot)
+const int STATS_WINDOW_SLOTS = 4;
+
+// Most slots kept per interface; longer dumps get wider slots
+const int STATS_MAX_SLOTS = 1024 * 1024;
+
+// Statistics of one COB-ID on one interface
+struct CobStats
+{
+    quint8  iface;          // Interface id
+    quint32 cobId;          // COB-ID (wider ids are counted as one, 0x800)
+    quint64 count;          // Frames sent
+    qint64  first;          // Timestamp of the first frame, or NO_TIMESTAMP
+    qint64  last;           // Timestamp of the last frame, or NO_TIMESTAMP
+    quint64 gaps;           // Number of periods measured
+    qint64  gapSum;         // Sum of the periods (microseconds)
+    qint64  gapMax;         // Longest period (microseconds)
+    double  gapSqSum;       // Sum of the squared periods
+    quint64 bits;           // Estimated bits on the bus
+    quint64 dlcs[9];        // Frames sent with each DLC
+
+    // Mean period in microseconds, or 0 if there were fewer than two frames
+    double meanGap() const { return gaps ? double( gapSum ) / gaps : 0.0; }
+    // Standard deviation of the period in microseconds
+    double jitter() const;
+};
+
+// Statistics of one node (the 11 bit COB-IDs it sends or is sent)
+struct NodeStats
+{
+    quint8  node;           // Node id
+    quint64 count;          // Frames
+    quint64 bits;           // Estimated bits on the bus
+    int     cobIds;         // Number of COB-IDs seen
+};
+
+// Bus load of one interface
+struct BusLoad
+{
+    quint8 iface;           // Interface id
+    double mean;            // Mean load over the dump (percent)
+    double peak;            // Highest load over any window (percent)
+    qint64 peakTime;        // Start of the busiest window (microseconds)
+};
+
+class FrameStats
+{
+public:
+    FrameStats();
+
+    // Gathers the statistics of every frame in the table.  bitrate is the
+    // bus speed in bits per second, window the length of the bus load
+    // window in microseconds.
+    void compute( const FrameTable& table, int bitrate, qint64 window );
+
+    // COB-IDs seen, ordered by interface and COB-ID
+    const QVector<CobStats>& cobs() const { return mCobs; }
+    // Nodes seen, ordered by node id
+    const QVector<NodeStats>& nodes() const { return mNodes; }
+    // Bus load of each interface seen
+    const QVector<BusLoad>& loads() const { return mLoads; }
+
+    // Time from the first to the last timestamp (microseconds)
+    qint64 span() const { return mSpan; }
+    // Bus speed the load was worked out for
+    int bitrate() const { return mBitrate; }
+    // Length of the bus load window used (microseconds); may be longer than
+    // asked for on very long dumps
+    qint64 window() const { return mWindow; }
+
+    // Estimated bits a frame takes on the bus, with worst case stuffing
+    static quint32 frameBits( quint32 cobId, quint8 dlc );
+
+private:
+    QVector<CobStats> mCobs;        // COB-IDs seen
+    QVector<NodeStats> mNodes;      // Nodes seen
+    QVector<BusLoad> mLoads;        // Load of each interface
+    qint64 mSpan;                   // Time from first to last timestamp
+    int mBitrate;                   // Bus speed, bits per second
+    qint64 mWindow;                 // Bus load window, microseconds
+};
+
+#endif // FRAMESTATS_H
@@ -0,0 +1,215 @@
+/*----------------------------------------------------------------------------
+
+Name		frametable.cpp
+
+Purpose		Compact, column oriented store of parsed candump frames.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "frametable.h"
+
+/*----------------------------------------------------------------------------
+
+Name		FrameTable
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+FrameTable::FrameTable()
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Removes all frames and interface names from the table
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameTable::clear()
+{
+    mTimes.clear();
+    mIfaces.clear();
+    mCobIds.clear();
+    mDlcs.clear();
+    mData.clear();
+    mOffsets.clear();
+    mFlags.clear();
+    mIfaceNames.clear();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		reserve
+
+Purpose		Reserves room in every column for the given number of frames
+
+Input       size - number of frames to reserve room for
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameTable::reserve( int size )
+{
+    mTimes.reserve( size );
+    mIfaces.reserve( size );
+    mCobIds.reserve( size );
+    mDlcs.reserve( size );
+    mData.reserve( size );
+    mOffsets.reserve( size );
+    mFlags.reserve( size );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		append
+
+Purpose		Appends a frame to the end of the table
+
+Input       rec - tokenized frame
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameTable::append( const FrameRecord& rec )
+{
+    mTimes.append( rec.time );
+    mIfaces.append( rec.iface );
+    mCobIds.append( rec.cobId );
+    mDlcs.append( rec.dlc );
+    mData.append( rec.data );
+    mOffsets.append( rec.offset );
+    mFlags.append( rec.flags );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		append
+
+Purpose		Appends every frame of another table to the end of this one.  The
+            interface ids of the other table are mapped onto this table's.
+
+Input       other - table to append
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameTable::append( const FrameTable& other )
+{
+    QVector<quint8> remap( other.mIfaceNames.size() );
+    bool identity = true;
+    for ( int i = 0; i < remap.size(); ++i )
+    {
+        remap[i] = ifaceId( other.mIfaceNames.at(i) );
+        identity &= ( remap.at(i) == i );
+    }
+
+    mTimes += other.mTimes;
+    mCobIds += other.mCobIds;
+    mDlcs += other.mDlcs;
+    mData += other.mData;
+    mOffsets += other.mOffsets;
+    mFlags += other.mFlags;
+
+    if ( identity )
+    {
+        mIfaces += other.mIfaces;
+    }
+    else
+    {
+        for ( int i = 0; i < other.mIfaces.size(); ++i )
+            mIfaces.append( remap.at( other.mIfaces.at(i) ) );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		ifaceId
+
+Purpose		Returns the id of the named interface, registering it if it has
+            not been seen before
+
+Input       name - interface name (e.g. can0)
+
+Return      id of the interface
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+quint8 FrameTable::ifaceId( const QString& name )
+{
+    int idx = mIfaceNames.indexOf( name );
+    if ( idx < 0 )
+    {
+        idx = mIfaceNames.size();
+        mIfaceNames.append( name );
+    }
+
+    return quint8( idx );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		removeFirst
+
+Purpose		Removes the oldest frames.  The columns keep their capacity, so a
+            table that is trimmed as it is appended to stays the same size.
+
+Input       count - number of frames to remove from the front
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameTable::removeFirst( int count )
+{
+    count = qMin( count, size() );
+    if ( count <= 0 )
+        return;
+
+    mTimes.remove( 0, count );
+    mIfaces.remove( 0, count );
+    mCobIds.remove( 0, count );
+    mDlcs.remove( 0, count );
+    mData.remove( 0, count );
+    mOffsets.remove( 0, count );
+    mFlags.remove( 0, count );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mid
+
+Purpose		Returns a copy of a run of frames
+
+Input       begin - first frame to copy
+            count - number of frames to copy
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+FrameTable FrameTable::mid( int begin, int count ) const
+{
+    FrameTable part;
+    part.mTimes = mTimes.mid( begin, count );
+    part.mIfaces = mIfaces.mid( begin, count );
+    part.mCobIds = mCobIds.mid( begin, count );
+    part.mDlcs = mDlcs.mid( begin, count );
+    part.mData = mData.mid( begin, count );
+    part.mOffsets = mOffsets.mid( begin, count );
+    part.mFlags = mFlags.mid( begin, count );
+    part.mIfaceNames = mIfaceNames;
+
+    return part;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clearOffsets
+
+Purpose		Forgets the original lines of every frame, as for frames restored
+            from a capture file
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void FrameTable::clearOffsets()
+{
+    mOffsets.fill( -1 );
+}
@@ -0,0 +1,122 @@
+/*----------------------------------------------------------------------------
+
+Name		frametable.h
+
+Purpose		Compact, column oriented store of parsed candump frames.  Each
+            line of a dump is tokenized once into a fixed size record which
+            is spread across a set of contiguous columns (struct of arrays),
+            so that filtering only ever touches the integers it needs.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+
+// Index of a frame within the table
+typedef quint32 FrameId;
+
+// Timestamp value used for frames read without one
+const qint64 NO_TIMESTAMP = -1;
+
+// Bits of FrameRecord::flags
+enum FrameFlag
+{
+    FRAME_RTR = 0x01,   // Remote request (the DLC is the one requested)
+    FRAME_EFF = 0x02    // 29 bit identifier, whatever its value
+};
+
+// A single tokenized candump line
+struct FrameRecord
+{
+    qint64  time;       // Timestamp in microseconds or NO_TIMESTAMP
+    quint32 cobId;      // CAN identifier
+    quint64 data;       // Payload, byte 0 held in the least significant byte
+    quint8  dlc;        // Data length code
+    quint8  iface;      // Interface id (index into FrameTable::ifaces)
+    quint8  flags;      // FrameFlag bits
+    qint64  offset;     // Byte offset of the original line
+};
+
+class FrameTable
+{
+public:
+    FrameTable();
+
+    // Removes all frames and interfaces
+    void clear();
+    // Reserves room for the given number of frames
+    void reserve( int size );
+
+    // Number of frames held
+    int size() const { return mCobIds.size(); }
+    bool isEmpty() const { return mCobIds.isEmpty(); }
+
+    // Appends a frame to the end of the table
+    void append( const FrameRecord& rec );
+    // Appends all frames of another table, mapping its interface ids
+    void append( const FrameTable& other );
+
+    // Removes the first count frames; the frames after them move down to
+    // id 0.  The room reserved in the columns is kept.
+    void removeFirst( int count );
+    // Returns a copy of count frames starting at begin, with the same
+    // interface names
+    FrameTable mid( int begin, int count ) const;
+    // Sets every frame's offset to -1, for when the text the frames were
+    // read from has gone
+    void clearOffsets();
+
+    // Returns the id of the named interface, adding it if it is not known
+    quint8 ifaceId( const QString& name );
+    // Returns the names of all known interfaces, indexed by id
+    const QStringList& ifaces() const { return mIfaceNames; }
+
+    // Per-frame accessors
+    qint64  time( FrameId id ) const    { return mTimes.at( id ); }
+    quint8  iface( FrameId id ) const   { return mIfaces.at( id ); }
+    quint32 cobId( FrameId id ) const   { return mCobIds.at( id ); }
+    quint8  dlc( FrameId id ) const     { return mDlcs.at( id ); }
+    quint64 data( FrameId id ) const    { return mData.at( id ); }
+    qint64  offset( FrameId id ) const  { return mOffsets.at( id ); }
+    quint8  flags( FrameId id ) const   { return mFlags.at( id ); }
+
+    // Returns true if a frame is a remote request
+    bool isRemote( FrameId id ) const
+        { return ( mFlags.at( id ) & FRAME_RTR ) != 0; }
+    // Returns true if a frame has a 29 bit identifier
+    bool isExtended( FrameId id ) const
+        { return ( mFlags.at( id ) & FRAME_EFF ) != 0; }
+
+    // Returns the n-th payload byte of a frame
+    quint8 dataByte( FrameId id, int n ) const
+        { return quint8( mData.at( id ) >> ( 8 * n ) ); }
+
+    // Column accessors
+    const QVector<qint64>&  times() const   { return mTimes; }
+    const QVector<quint8>&  ifaceIds() const { return mIfaces; }
+    const QVector<quint32>& cobIds() const  { return mCobIds; }
+    const QVector<quint8>&  dlcs() const    { return mDlcs; }
+    const QVector<quint64>& payloads() const { return mData; }
+    const QVector<qint64>&  offsets() const { return mOffsets; }
+    const QVector<quint8>&  flags() const   { return mFlags; }
+
+private:
+    // Saves and restores the columns in bulk
+    friend class CaptureFile;
+
+    QVector<qint64>  mTimes;        // Timestamps in microseconds
+    QVector<quint8>  mIfaces;       // Interface ids
+    QVector<quint32> mCobIds;       // CAN identifiers
+    QVector<quint8>  mDlcs;         // Data length codes
+    QVector<quint64> mData;         // Packed payloads
+    QVector<qint64>  mOffsets;      // Byte offsets of the original lines
+    QVector<quint8>  mFlags;        // FrameFlag bits
+
+    QStringList mIfaceNames;        // Interface names, indexed by id
+};
+
+#endif // FRAMETABLE_H
@@ -0,0 +1,286 @@
+/*----------------------------------------------------------------------------
+
+Name		linesearch.cpp
+
+Purpose		Indexed search over the raw lines of the mapped dumps.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "linesearch.h"
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+// Candidate blocks searched in parallel before their hits are handed back
+static const int SEARCH_BATCH = 64;
+
+// One candidate block and the expression it is searched for
+struct SearchBlock
+{
+    const TextBlock* block;
+    const QRegularExpression* expression;
+};
+
+/*----------------------------------------------------------------------------
+
+Name		LineSearch
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+LineSearch::LineSearch( QObject* parent )
+    : QObject( parent )
+{
+    qRegisterMetaType< QVector<qint64> >( "QVector<qint64>" );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		~LineSearch
+
+Purpose		Destructor.  Stops any search before the texts go away.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+LineSearch::~LineSearch()
+{
+    cancel();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setTexts
+
+Purpose		Sets the texts searched and drops the index of the old ones
+
+Input       texts - texts to search, in offset order
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void LineSearch::setTexts( const QVector<TextBlock>& texts )
+{
+    cancel();
+    mIndex.clear();
+    mTexts = texts;
+    emit hitsCleared();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Stops any search and forgets the texts and their index
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void LineSearch::clear()
+{
+    setTexts( QVector<TextBlock>() );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		cancel
+
+Purpose		Stops any search and waits for it to finish
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void LineSearch::cancel()
+{
+    mGeneration.fetchAndAddOrdered( 1 );
+    mFuture.waitForFinished();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		search
+
+Purpose		Starts a search on a worker thread, cancelling any in flight.
+            Plain text is escaped into an expression, so both are matched
+            the same way.  The expression is compiled (JIT where available)
+            here, once, rather than by each worker.
+
+Input       pattern       - text or regular expression to find
+            regex         - true if pattern is a regular expression
+            caseSensitive - true if letters must match in case
+            error         - set to the reason if the pattern is invalid
+
+Return      true if the search was started
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool LineSearch::search( const QString& pattern, bool regex, bool caseSensitive,
+                         QString& error )
+{
+    QRegularExpression::PatternOptions options = QRegularExpression::MultilineOption;
+    if ( !caseSensitive )
+        options |= QRegularExpression::CaseInsensitiveOption;
+
+    QRegularExpression expression( regex ? pattern : QRegularExpression::escape( pattern ),
+                                   options );
+    if ( !expression.isValid() )
+    {
+        error = expression.errorString();
+        return false;
+    }
+    expression.optimize();
+
+    cancel();
+    emit hitsCleared();
+    emit progressChanged( 0 );
+
+    mFuture = QtConcurrent::run( &LineSearch::run, this, expression,
+                                 TrigramIndex::literals( pattern, regex ),
+                                 int( mGeneration.load() ) );
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		run
+
+Purpose		Searches the texts on a worker thread.  The index is built first
+            if this is the first search since the texts were set.  Its
+            candidate blocks are then searched SEARCH_BATCH at a time across
+            the thread pool, and each batch's hits queued back in order; the
+            work stops as soon as a newer search has been started.
+
+Input       search     - search owning the texts and index
+            expression - compiled expression to find
+            literals   - strings every match contains, to narrow the blocks
+            generation - generation of the search this work belongs to
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void LineSearch::run( LineSearch* search, QRegularExpression expression,
+                      QList<QByteArray> literals, int generation )
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    TrigramIndex& index = search->mIndex;
+    qint64 indexMsecs = -1;
+    if ( !index.isBuilt() )
+    {
+        if ( !index.build( search->mTexts, search->mGeneration, generation ) )
+            return;
+        indexMsecs = timer.elapsed();
+    }
+
+    const QVector<BlockId> candidates = index.candidates( literals );
+    qint64 hits = 0;
+
+    for ( int first = 0; first < candidates.size(); first += SEARCH_BATCH )
+    {
+        if ( search->mGeneration.load() != generation )
+            return;
+
+        const int last = qMin( first + SEARCH_BATCH, candidates.size() );
+        QVector<SearchBlock> batch;
+        for ( int i = first; i < last; ++i )
+        {
+            SearchBlock block;
+            block.block = &index.block( int( candidates.at(i) ) );
+            block.expression = &expression;
+            batch.append( block );
+        }
+
+        QVector< QVector<qint64> > found =
+            QtConcurrent::blockingMapped< QVector< QVector<qint64> > >( batch, matchBlock );
+
+        QVector<qint64> offsets;
+        for ( int i = 0; i < found.size(); ++i )
+            offsets += found.at(i);
+        hits += offsets.size();
+
+        if ( !offsets.isEmpty() )
+        {
+            QMetaObject::invokeMethod( search, "deliverHits", Qt::QueuedConnection,
+                                       Q_ARG( int, generation ),
+                                       Q_ARG( QVector<qint64>, offsets ),
+                                       Q_ARG( int, int( qint64( last ) * 100 / candidates.size() ) ),
+                                       Q_ARG( QString, QString() ) );
+        }
+    }
+
+    QString summary = tr( "%1 lines found in %2 ms, %3 of %4 blocks searched" )
+                      .arg( hits )
+                      .arg( timer.elapsed() )
+                      .arg( candidates.size() )
+                      .arg( index.blockCount() );
+    if ( indexMsecs >= 0 )
+        summary += tr( " (indexed in %1 ms)" ).arg( indexMsecs );
+
+    QMetaObject::invokeMethod( search, "deliverHits", Qt::QueuedConnection,
+                               Q_ARG( int, generation ),
+                               Q_ARG( QVector<qint64>, QVector<qint64>() ),
+                               Q_ARG( int, 100 ),
+                               Q_ARG( QString, summary ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		matchBlock
+
+Purpose		Returns the offsets of the lines of a block that match.  Once a
+            line has matched, the search goes on from the next line.
+
+Input       block - block to search and the expression to find
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVector<qint64> LineSearch::matchBlock( const SearchBlock& block )
+{
+    const TextBlock& text = *block.block;
+    const QString lines = QString::fromLatin1( text.begin, int( text.end - text.begin ) );
+
+    QVector<qint64> offsets;
+    int from = 0;
+    while ( from < lines.size() )
+    {
+        QRegularExpressionMatch match = block.expression->match( lines, from );
+        if ( !match.hasMatch() )
+            break;
+
+        const int start = match.capturedStart();
+        const int lineStart = ( start > 0 ) ? lines.lastIndexOf( '\n', start - 1 ) + 1 : 0;
+        offsets.append( text.offset + lineStart );
+
+        const int lineEnd = lines.indexOf( '\n', start );
+        if ( lineEnd < 0 )
+            break;
+        from = lineEnd + 1;
+    }
+
+    return offsets;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		deliverHits
+
+Purpose		Receives a batch of hits from the worker thread.  Batches from a
+            superseded search are dropped.
+
+Input       generation - generation of the search that found the hits
+            offsets    - offsets of the matching lines, in file order
+            percent    - share of the candidate blocks searched so far
+            summary    - set on the last batch
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void LineSearch::deliverHits( int generation, QVector<qint64> offsets, int percent,
+                              QString summary )
+{
+    if ( generation != mGeneration.load() )
+        return;
+
+    if ( !offsets.isEmpty() )
+        emit hitsAdded( offsets );
+    emit progressChanged( percent );
+
+    if ( !summary.isEmpty() )
+        emit finished( summary );
+}
@@ -0,0 +1,78 @@
+/*----------------------------------------------------------------------------
+
+Name		linesearch.h
+
+Purpose		Free text and regular expression search over the raw lines of
+            the mapped dumps.  A search first narrows the text to the blocks
+            the trigram index says can hold a match (building the index on
+            the first search after a load), then runs the expression over
+            those blocks in parallel batches on the thread pool.  Matching
+            lines are handed back batch by batch, in file order, as the
+            offsets of their first byte.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef LINESEARCH_H
+#define LINESEARCH_H
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QObject>
+#include <QRegularExpression>
+#include <QVector>
+#include "trigramindex.h"
+
+struct SearchBlock;
+
+class LineSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LineSearch( QObject* parent = 0 );
+    ~LineSearch();
+
+    // Sets the texts searched.  Any index of the texts before is dropped;
+    // the next search builds one.
+    void setTexts( const QVector<TextBlock>& texts );
+    // Stops any search and forgets the texts (before they are unmapped)
+    void clear();
+
+    // Starts searching the texts for a pattern, as plain text or a regular
+    // expression.  Returns false, with the reason in error, if the pattern
+    // is not a valid regular expression.
+    bool search( const QString& pattern, bool regex, bool caseSensitive, QString& error );
+    // Stops any search and waits for it to finish
+    void cancel();
+
+signals:
+    // emitted when a search starts or the texts change
+    void hitsCleared();
+    // emitted with each further batch of matching lines, in file order
+    void hitsAdded( const QVector<qint64>& offsets );
+    // emitted as the search progresses (percent of candidate blocks searched)
+    void progressChanged( int percent );
+    // emitted with a summary once a search has finished
+    void finished( const QString& summary );
+
+private:
+    // Runs on a worker thread: builds the index if need be, then searches
+    // the candidate blocks until done or generation is superseded
+    static void run( LineSearch* search, QRegularExpression expression,
+                     QList<QByteArray> literals, int generation );
+
+    // Returns the offsets of the lines of a block that match
+    static QVector<qint64> matchBlock( const SearchBlock& block );
+
+private slots:
+    // Receives a batch of hits from the worker thread
+    void deliverHits( int generation, QVector<qint64> offsets, int percent, QString summary );
+
+private:
+    QVector<TextBlock> mTexts;      // Texts searched, in offset order
+    TrigramIndex mIndex;            // Index of mTexts, once a search has built it
+    QAtomicInt mGeneration;         // Incremented whenever a search starts or stops
+    QFuture<void> mFuture;          // Search in flight
+};
+
+#endif // LINESEARCH_H
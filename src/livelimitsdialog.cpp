@@ -0,0 +1,136 @@
+/*----------------------------------------------------------------------------
+
+Name		livelimitsdialog.cpp
+
+Purpose		Dialog setting the bounds on the frames held while frames are
+            read live.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "livelimitsdialog.h"
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+
+// Longest time horizon offered, in seconds (30 days)
+static const int HORIZON_MAX = 30 * 24 * 3600;
+
+/*----------------------------------------------------------------------------
+
+Name		LiveLimitsDialog
+
+Purpose		Constructor.  Builds the controls and fills them with the limits
+            currently set.
+
+Input       maxFrames - most frames held, 0 for no limit
+            horizon   - age of the oldest frame held (us), 0 for no limit
+            spillDir  - directory evicted frames are written to
+            parent    - owning widget
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+LiveLimitsDialog::LiveLimitsDialog( int maxFrames, qint64 horizon,
+                                    const QString& spillDir, QWidget* parent )
+    : QDialog( parent )
+{
+    setWindowTitle( tr( "Live Limits" ) );
+
+    mFramesSpin = new QSpinBox( this );
+    mFramesSpin->setRange( 0, 2000000 );
+    mFramesSpin->setSingleStep( 1000 );
+    mFramesSpin->setSuffix( tr( " thousand frames" ) );
+    mFramesSpin->setSpecialValueText( tr( "No limit" ) );
+    mFramesSpin->setValue( maxFrames / 1000 );
+
+    mHorizonSpin = new QSpinBox( this );
+    mHorizonSpin->setRange( 0, HORIZON_MAX );
+    mHorizonSpin->setSingleStep( 60 );
+    mHorizonSpin->setSuffix( tr( " s" ) );
+    mHorizonSpin->setSpecialValueText( tr( "No limit" ) );
+    mHorizonSpin->setValue( int( qMin<qint64>( horizon / 1000000, HORIZON_MAX ) ) );
+
+    mSpillEdit = new QLineEdit( spillDir, this );
+    mSpillEdit->setPlaceholderText( tr( "Evicted frames are let go" ) );
+    QPushButton* browseBtn = new QPushButton( tr( "Browse..." ), this );
+
+    QHBoxLayout* spill = new QHBoxLayout;
+    spill->addWidget( mSpillEdit );
+    spill->addWidget( browseBtn );
+
+    QDialogButtonBox* buttons =
+        new QDialogButtonBox( QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this );
+
+    QFormLayout* layout = new QFormLayout;
+    layout->addRow( tr( "Keep at most" ), mFramesSpin );
+    layout->addRow( tr( "Keep the last" ), mHorizonSpin );
+    layout->addRow( tr( "Spill evicted frames to" ), spill );
+    layout->addRow( buttons );
+    setLayout( layout );
+
+    connect( browseBtn,             SIGNAL( clicked() ),
+             this,                  SLOT( browse() ) );
+
+    connect( buttons,               SIGNAL( accepted() ),
+             this,                  SLOT( accept() ) );
+
+    connect( buttons,               SIGNAL( rejected() ),
+             this,                  SLOT( reject() ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		maxFrames
+
+Purpose		Returns the frame limit, 0 for no limit
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int LiveLimitsDialog::maxFrames() const
+{
+    return mFramesSpin->value() * 1000;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		horizon
+
+Purpose		Returns the time horizon in microseconds, 0 for no limit
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+qint64 LiveLimitsDialog::horizon() const
+{
+    return qint64( mHorizonSpin->value() ) * 1000000;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		spillDir
+
+Purpose		Returns the spill directory, empty to let evicted frames go
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QString LiveLimitsDialog::spillDir() const
+{
+    return mSpillEdit->text().trimmed();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		browse
+
+Purpose		Picks the spill directory
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void LiveLimitsDialog::browse()
+{
+    QString dir = QFileDialog::getExistingDirectory( this, tr( "Spill Directory" ),
+                                                     mSpillEdit->text() );
+    if ( !dir.isEmpty() )
+        mSpillEdit->setText( dir );
+}
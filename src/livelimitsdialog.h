@@ -0,0 +1,44 @@
+/*----------------------------------------------------------------------------
+
+Name		livelimitsdialog.h
+
+Purpose		Dialog setting the bounds on the frames held while frames are
+            read live: a frame limit, a time horizon and the directory
+            evicted frames are spilled to (see Parser::setLimits).
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef LIVELIMITSDIALOG_H
+#define LIVELIMITSDIALOG_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QSpinBox>
+
+class LiveLimitsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    // Shows the limits currently set; 0 stands for no limit
+    LiveLimitsDialog( int maxFrames, qint64 horizon, const QString& spillDir,
+                      QWidget* parent = 0 );
+
+    // Most frames held, 0 for no limit
+    int maxFrames() const;
+    // Age of the oldest frame held in microseconds, 0 for no limit
+    qint64 horizon() const;
+    // Directory evicted frames are written to, empty to let them go
+    QString spillDir() const;
+
+private slots:
+    // Picks the spill directory
+    void browse();
+
+private:
+    QSpinBox* mFramesSpin;          // Frame limit, in thousands
+    QSpinBox* mHorizonSpin;         // Time horizon, in seconds
+    QLineEdit* mSpillEdit;          // Spill directory
+};
+
+#endif // LIVELIMITSDIALOG_H
@@ -0,0 +1,443 @@
+/*----------------------------------------------------------------------------
+
+Name		livesource.cpp
+
+Purpose		Feeds frames to the parser while they are being captured.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "livesource.h"
+#include "frameingest.h"
+#include <QFileInfo>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+// Most bytes read from the followed file in one go; the rest is read on the
+// next pass through the event loop
+static const qint64 LIVE_READ_LIMIT = 4 * 1024 * 1024;
+
+// Most frames read from the socket per notification
+static const int LIVE_SOCKET_BATCH = 1024;
+
+// Receive buffer asked for on the socket, enough for a second of a fully
+// loaded 1 Mbit/s bus
+static const int LIVE_SOCKET_BUFFER = 1024 * 1024;
+
+/*----------------------------------------------------------------------------
+
+Name		isReplaced
+
+Purpose		Returns true if a path no longer names the file held open, as
+            after log rotation renames the file away and creates a new one.
+            Files are told apart by device and inode where there are any,
+            else by the file at the path being the shorter.  A path that
+            does not exist (yet) is not a replacement.
+
+Input       file - file held open
+            name - path it was opened by
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool isReplaced( QFile& file, const QString& name )
+{
+#ifdef Q_OS_UNIX
+    struct stat held;
+    struct stat named;
+    if ( fstat( file.handle(), &held ) != 0 ||
+         stat( QFile::encodeName( name ).constData(), &named ) != 0 )
+        return false;
+
+    return held.st_dev != named.st_dev || held.st_ino != named.st_ino;
+#else
+    QFileInfo info( name );
+    return info.exists() && info.size() < file.size();
+#endif
+}
+
+/*----------------------------------------------------------------------------
+
+Name		LiveSource
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+LiveSource::LiveSource( QObject* parent )
+    : QObject( parent ),
+      mFilePos( 0 ),
+      mOffsetBase( 0 ),
+      mSocket( -1 ),
+      mNotifier( 0 ),
+      mRateFrames( 0 )
+{
+    mFlushTimer.setInterval( LIVE_FLUSH_INTERVAL );
+    connect( &mFlushTimer,  SIGNAL( timeout() ),
+             this,          SLOT( flush() ) );
+
+    connect( &mWatcher,     SIGNAL( fileChanged(QString) ),
+             this,          SLOT( readFile() ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		~LiveSource
+
+Purpose		Destructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+LiveSource::~LiveSource()
+{
+    stop();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		followFile
+
+Purpose		Follows a candump file as it grows.  Changes are reported by the
+            file system watcher (inotify on Linux).
+
+Input       fileName - file to follow
+            from     - byte offset to start reading at
+
+Return      true if the file could be opened
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool LiveSource::followFile( const QString& fileName, qint64 from )
+{
+    stop();
+
+    mFile.setFileName( fileName );
+    if ( !mFile.open( QIODevice::ReadOnly ) )
+        return false;
+
+    mName = fileName;
+    mFilePos = from;
+    mWatcher.addPath( fileName );
+
+    mRateTimer.start();
+    mFlushTimer.start();
+
+    readFile();
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		openInterface
+
+Purpose		Opens a raw SocketCAN socket on an interface.  The kernel stamps
+            each frame as it is received, so timestamps do not depend on how
+            quickly the event loop gets to the socket.
+
+Input       iface - interface name (e.g. can0 or vcan0)
+
+Return      true if the socket could be opened and bound
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool LiveSource::openInterface( const QString& iface )
+{
+    stop();
+
+#ifdef Q_OS_LINUX
+    unsigned int index = if_nametoindex( iface.toLocal8Bit().constData() );
+    if ( index == 0 )
+        return false;
+
+    int fd = socket( PF_CAN, SOCK_RAW | SOCK_NONBLOCK, CAN_RAW );
+    if ( fd < 0 )
+        return false;
+
+    int on = 1;
+    int rcvBuf = LIVE_SOCKET_BUFFER;
+    setsockopt( fd, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof( on ) );
+    setsockopt( fd, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof( rcvBuf ) );
+
+    struct sockaddr_can addr;
+    memset( &addr, 0, sizeof( addr ) );
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = int( index );
+    if ( bind( fd, reinterpret_cast<struct sockaddr*>( &addr ), sizeof( addr ) ) < 0 )
+    {
+        close( fd );
+        return false;
+    }
+
+    mName = iface;
+    mSocket = fd;
+    mNotifier = new QSocketNotifier( fd, QSocketNotifier::Read, this );
+    connect( mNotifier,     SIGNAL( activated(int) ),
+             this,          SLOT( readSocket() ) );
+
+    mRateTimer.start();
+    mFlushTimer.start();
+    return true;
+#else
+    Q_UNUSED( iface );
+    return false;
+#endif
+}
+
+/*----------------------------------------------------------------------------
+
+Name		stop
+
+Purpose		Stops following the file or interface.  Frames already read are
+            handed over first.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Resets the offset base
+----------------------------------------------------------------------------*/
+void LiveSource::stop()
+{
+    flush();
+    mFlushTimer.stop();
+
+    if ( !mWatcher.files().isEmpty() )
+        mWatcher.removePath( mName );
+    mFile.close();
+    mPartial.clear();
+    mFilePos = 0;
+    mOffsetBase = 0;
+
+    delete mNotifier;
+    mNotifier = 0;
+#ifdef Q_OS_LINUX
+    if ( mSocket >= 0 )
+        close( mSocket );
+#endif
+    mSocket = -1;
+
+    mRateFrames = 0;
+    mRateTimer.invalidate();
+    mName.clear();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		isActive
+
+Purpose		Returns true while following a file or interface
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool LiveSource::isActive() const
+{
+    return mFile.isOpen() || mSocket >= 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		readFile
+
+Purpose		Reads the lines appended to the followed file since the last
+            call.  At most LIVE_READ_LIMIT bytes are read at a time so a large
+            append cannot stall the UI; the rest is picked up on the next pass
+            through the event loop.  A line still being written is held back
+            until its line break arrives.
+
+            Once the file has been read to its end and the path names a
+            new file (log rotation), the new file is read from the top.
+            Frames read after a truncation or rotation are given offsets
+            past those of everything read before, so they are never taken
+            for lines of the dump loaded from the file.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Goes on with the new file after log rotation
+            17 Oct 26  AFB	Moves the offsets on past a truncation or rotation
+----------------------------------------------------------------------------*/
+void LiveSource::readFile()
+{
+    if ( !mFile.isOpen() )
+        return;
+
+    // Editors and log rotation replace the file, which drops the watch
+    if ( mWatcher.files().isEmpty() )
+        mWatcher.addPath( mName );
+
+    qint64 size = mFile.size();
+    if ( size < mFilePos )
+    {
+        // Truncated; start again from the top.  The text loaded from the
+        // file is gone, so whoever mapped it must let go first.
+        emit statusChanged( tr( "%1 was truncated" ).arg( mName ) );
+        emit truncated();
+        mFile.close();
+        if ( !mFile.open( QIODevice::ReadOnly ) )
+            return;
+        mOffsetBase += mFilePos;
+        mFilePos = 0;
+        mPartial.clear();
+    }
+    else if ( size == mFilePos && isReplaced( mFile, mName ) )
+    {
+        // Rotated; the old file has been read to its end, so go on with
+        // the new one from the top
+        emit statusChanged( tr( "%1 was replaced" ).arg( mName ) );
+        mFile.close();
+        if ( !mFile.open( QIODevice::ReadOnly ) )
+            return;
+        mOffsetBase += mFilePos;
+        mFilePos = 0;
+        mPartial.clear();
+        size = mFile.size();
+    }
+
+    if ( size == mFilePos || !mFile.seek( mFilePos ) )
+        return;
+
+    QByteArray block = mFile.read( qMin( size - mFilePos, LIVE_READ_LIMIT ) );
+    if ( block.isEmpty() )
+        return;
+
+    qint64 blockOffset = mOffsetBase + mFilePos - mPartial.size();
+    mFilePos += block.size();
+
+    if ( !mPartial.isEmpty() )
+    {
+        block.prepend( mPartial );
+        mPartial.clear();
+    }
+
+    int last = block.lastIndexOf( '\n' );
+    if ( last < 0 )
+    {
+        mPartial = block;
+    }
+    else
+    {
+        int before = mPending.size();
+        const char* begin = block.constData();
+        FrameIngest::parse( begin, begin + last + 1, blockOffset, mPending );
+        mRateFrames += mPending.size() - before;
+
+        mPartial = block.mid( last + 1 );
+    }
+
+    if ( mFilePos < size )
+        QTimer::singleShot( 0, this, SLOT( readFile() ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		readSocket
+
+Purpose		Reads the frames waiting on the socket, up to LIVE_SOCKET_BATCH
+            at a time.  The notifier fires again if more are left.  Error
+            frames are dropped.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Flags remote requests
+            17 Oct 26  AFB	Flags 29 bit identifiers
+----------------------------------------------------------------------------*/
+void LiveSource::readSocket()
+{
+#ifdef Q_OS_LINUX
+    struct can_frame frame;
+    struct iovec iov;
+    char control[ CMSG_SPACE( sizeof( struct timeval ) ) ];
+    struct msghdr msg;
+
+    quint8 iface = mPending.ifaceId( mName );
+
+    for ( int n = 0; n < LIVE_SOCKET_BATCH; ++n )
+    {
+        iov.iov_base = &frame;
+        iov.iov_len = sizeof( frame );
+        memset( &msg, 0, sizeof( msg ) );
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof( control );
+
+        ssize_t got = recvmsg( mSocket, &msg, 0 );
+        if ( got < ssize_t( sizeof( frame ) ) )
+            break;
+
+        if ( frame.can_id & CAN_ERR_FLAG )
+            continue;
+
+        FrameRecord rec;
+        rec.time = NO_TIMESTAMP;
+        for ( struct cmsghdr* c = CMSG_FIRSTHDR( &msg ); c; c = CMSG_NXTHDR( &msg, c ) )
+        {
+            if ( c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_TIMESTAMP )
+            {
+                struct timeval tv;
+                memcpy( &tv, CMSG_DATA( c ), sizeof( tv ) );
+                rec.time = qint64( tv.tv_sec ) * 1000000 + tv.tv_usec;
+            }
+        }
+
+        rec.cobId = ( frame.can_id & CAN_EFF_FLAG ) ? ( frame.can_id & CAN_EFF_MASK )
+                                                   : ( frame.can_id & CAN_SFF_MASK );
+        rec.dlc = qMin<quint8>( frame.can_dlc, 8 );
+        rec.data = 0;
+        rec.flags = 0;
+        if ( frame.can_id & CAN_RTR_FLAG )
+            rec.flags |= FRAME_RTR;
+        if ( frame.can_id & CAN_EFF_FLAG )
+            rec.flags |= FRAME_EFF;
+        if ( !( frame.can_id & CAN_RTR_FLAG ) )
+        {
+            for ( int i = 0; i < rec.dlc; ++i )
+                rec.data |= quint64( frame.data[i] ) << ( 8 * i );
+        }
+        rec.iface = iface;
+        rec.offset = -1;
+
+        mPending.append( rec );
+        ++mRateFrames;
+    }
+#endif
+}
+
+/*----------------------------------------------------------------------------
+
+Name		flush
+
+Purpose		Hands the frames read since the last flush over, and reports the
+            rate they are arriving at about once a second.  Looks for the
+            followed file again while it cannot be watched.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Looks for the followed file while it is not watched
+----------------------------------------------------------------------------*/
+void LiveSource::flush()
+{
+    // A rotated file that has not been created again cannot be watched,
+    // so look for it at each flush until it can
+    if ( mFile.isOpen() && mWatcher.files().isEmpty() )
+        readFile();
+
+    if ( !mPending.isEmpty() )
+    {
+        emit framesArrived( mPending );
+        mPending.clear();
+    }
+
+    if ( mRateTimer.isValid() && mRateTimer.elapsed() >= 1000 )
+    {
+        emit statusChanged( tr( "Live from %1: %2 frames/s" )
+                            .arg( mName )
+                            .arg( mRateFrames * 1000 / mRateTimer.restart() ) );
+        mRateFrames = 0;
+    }
+}
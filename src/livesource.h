@@ -0,0 +1,89 @@
+/*----------------------------------------------------------------------------
+
+Name		livesource.h
+
+Purpose		Feeds frames to the parser while they are being captured, either
+            by following a candump file as it grows or by reading a SocketCAN
+            interface (e.g. vcan0) directly.
+
+            Frames are gathered into a small table and handed over at a fixed
+            interval, so the cost to the UI thread stays bounded however busy
+            the bus is.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef LIVESOURCE_H
+#define LIVESOURCE_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QSocketNotifier>
+#include <QTimer>
+#include "frametable.h"
+
+// Interval at which frames read live are handed to the parser (ms)
+const int LIVE_FLUSH_INTERVAL = 50;
+
+class LiveSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LiveSource( QObject* parent = 0 );
+    ~LiveSource();
+
+    // Follows a candump file, reading the lines appended from byte offset
+    // from onward.  Returns false if the file could not be opened.
+    bool followFile( const QString& fileName, qint64 from );
+
+    // Reads frames from a SocketCAN interface.  Returns false if the
+    // interface could not be opened (or SocketCAN is not available).
+    bool openInterface( const QString& iface );
+
+    // Stops following the file or interface
+    void stop();
+
+    // Returns true while following a file or interface
+    bool isActive() const;
+
+signals:
+    // emitted at most every LIVE_FLUSH_INTERVAL with the frames read since
+    void framesArrived( const FrameTable& frames );
+    // emitted about once a second with the rate frames are arriving at
+    void statusChanged( const QString& status );
+    // emitted when the followed file is found truncated, before anything
+    // more is read from it
+    void truncated();
+
+private slots:
+    // Reads what has been appended to the followed file
+    void readFile();
+    // Reads the frames waiting on the socket
+    void readSocket();
+    // Hands the frames read so far to whoever is listening
+    void flush();
+
+private:
+    QString mName;                  // File or interface being followed
+
+    QFile mFile;                    // Followed file
+    QFileSystemWatcher mWatcher;    // Reports changes to mFile (inotify)
+    qint64 mFilePos;                // Offset of the next byte to read
+    qint64 mOffsetBase;             // Added to the offsets of frames read;
+                                    // moved on past a truncation or rotation
+    QByteArray mPartial;            // Incomplete last line read so far
+
+    int mSocket;                    // SocketCAN socket, or -1
+    QSocketNotifier* mNotifier;     // Reports frames waiting on mSocket
+
+    FrameTable mPending;            // Frames not yet handed over
+    QTimer mFlushTimer;             // Hands mPending over at a fixed rate
+
+    QElapsedTimer mRateTimer;       // Time since the last rate report
+    int mRateFrames;                // Frames read since the last rate report
+};
+
+#endif // LIVESOURCE_H
@@ -8,10 +8,15 @@ History		12 May 18  AFB	Created
 ----------------------------------------------------------------------------*/
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
-#include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QFont>
-#include <QTextStream>
+#include <QInputDialog>
+#include "livelimitsdialog.h"
+#include "stageprofile.h"
+
+// Milliseconds between refreshes of the stage timings
+static const int STAGE_REFRESH = 500;
 
 /*----------------------------------------------------------------------------
 
@@ -20,17 +25,65 @@ Name		MainWindow
 Purpose		Constructor
 
 History		12 May 18  AFB	Created
+            17 Oct 26  AFB	Adds the statistics dock
+            17 Oct 26  AFB	Adds the stage timings
+            17 Oct 26  AFB	Adds the search dock
+            17 Oct 26  AFB	Adds the signal dock
+            17 Oct 26  AFB	Adds the plot dock
+            17 Oct 26  AFB	Adds the node timeline dock
 ----------------------------------------------------------------------------*/
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    mModel( mParser ),
+    mStageCalls( 0 )
 {
     ui->setupUi(this);
+    ui->mDumpBrowser->setModel( &mModel );
+    ui->mDumpBrowser->setItemDelegate( &mDelegate );
     QFont font;
     font.setWeight( QFont::DemiBold );
     font.setFamily("Courier");
     font.setPointSize(11);
     ui->mDumpBrowser->setFont( font );
+
+    mProgressBar = new QProgressBar( this );
+    mProgressBar->setRange( 0, 100 );
+    mProgressBar->setMaximumWidth( 150 );
+    mProgressBar->hide();
+    mMatchLbl = new QLabel( this );
+    mStageLbl = new QLabel( this );
+    mStageLbl->hide();
+    ui->mStatusBar->addPermanentWidget( mStageLbl );
+    ui->mStatusBar->addPermanentWidget( mMatchLbl );
+    ui->mStatusBar->addPermanentWidget( mProgressBar );
+    mStageTimer.setInterval( STAGE_REFRESH );
+
+    mStatsDock = new StatsDock( mParser, this );
+    addDockWidget( Qt::RightDockWidgetArea, mStatsDock );
+    mStatsDock->hide();
+    ui->menuView->addAction( mStatsDock->toggleViewAction() );
+
+    mSearchDock = new SearchDock( mParser, this );
+    addDockWidget( Qt::BottomDockWidgetArea, mSearchDock );
+    mSearchDock->hide();
+    ui->menuView->addAction( mSearchDock->toggleViewAction() );
+
+    mSignalDock = new SignalDock( mParser, this );
+    addDockWidget( Qt::RightDockWidgetArea, mSignalDock );
+    mSignalDock->hide();
+    ui->menuView->addAction( mSignalDock->toggleViewAction() );
+
+    mPlotDock = new PlotDock( mParser, this );
+    addDockWidget( Qt::BottomDockWidgetArea, mPlotDock );
+    mPlotDock->hide();
+    ui->menuView->addAction( mPlotDock->toggleViewAction() );
+
+    mTimelineDock = new TimelineDock( mParser, this );
+    addDockWidget( Qt::BottomDockWidgetArea, mTimelineDock );
+    mTimelineDock->hide();
+    ui->menuView->addAction( mTimelineDock->toggleViewAction() );
+
     connectSigSlot();
 }
 
@@ -49,46 +102,191 @@ MainWindow::~MainWindow()
 
 /*----------------------------------------------------------------------------
 
-Name		updateText
-
-Purpose		Slot for updating text returned from the parser
+Name		loadFile
 
-Input       text - text from the parser
+Purpose		Loads a file into the program.  Several files picked together
+            are merged into one timeline.
 
 History		12 May 18  AFB	Created
+            17 Oct 26  AFB	The parser maps the file rather than taking text
+            17 Oct 26  AFB	Stops any live capture
+            17 Oct 26  AFB	Refreshes the statistics dock
+            17 Oct 26  AFB	Takes several files, merged by timestamp
+            17 Oct 26  AFB	Refreshes the signal dock
+            17 Oct 26  AFB	Refreshes the node timeline dock
 ----------------------------------------------------------------------------*/
-void MainWindow::updateText(QString text)
+void MainWindow::loadFile()
 {
-    ui->mDumpBrowser->setText( text );
+    QFileDialog diag(this);
+    diag.setFileMode( QFileDialog::ExistingFiles );
+
+    QStringList fnames = diag.getOpenFileNames( this );
+    if ( fnames.isEmpty() )
+        return;
+
+    stopLive();
+
+    if ( !mParser.loadFiles( fnames ) )
+    {
+        ui->mStatusBar->showMessage( tr( "Unable to open %1" ).arg( fnames.join( ", " ) ) );
+        return;
+    }
+
+    if ( mStatsDock->isVisible() )
+        mStatsDock->refresh();
+    if ( mSignalDock->isVisible() )
+        mSignalDock->refresh();
+    if ( mTimelineDock->isVisible() )
+        mTimelineDock->refresh();
 }
 
 /*----------------------------------------------------------------------------
 
-Name		loadFile
+Name		saveCapture
 
-Purpose		Loads a file into the program.
+Purpose		Saves the frames to a binary capture file, which reopens without
+            being tokenized again
 
-Input       text - text from the parser
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::saveCapture()
+{
+    QString fname = QFileDialog::getSaveFileName( this, tr( "Save Capture" ),
+                                                  QString(), tr( "Captures (*.cdc)" ) );
+    if ( fname.isEmpty() )
+        return;
 
-History		12 May 18  AFB	Created
+    QString error;
+    if ( !mParser.saveCapture( fname, error ) )
+    {
+        ui->mStatusBar->showMessage( tr( "Unable to save %1: %2" ).arg( fname ).arg( error ) );
+        return;
+    }
+
+    ui->mStatusBar->showMessage( tr( "Saved %1" ).arg( fname ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		exportLog
+
+Purpose		Writes the frames out as a candump -l log
+
+History		17 Oct 26  AFB	Created
 ----------------------------------------------------------------------------*/
-void MainWindow::loadFile()
+void MainWindow::exportLog()
 {
-    QFileDialog diag(this);
-    diag.setFileMode( QFileDialog::ExistingFile );
+    QString fname = QFileDialog::getSaveFileName( this, tr( "Export candump Log" ),
+                                                  QString(), tr( "candump logs (*.log)" ) );
+    if ( fname.isEmpty() )
+        return;
+
+    QString error;
+    if ( !mParser.exportLog( fname, error ) )
+    {
+        ui->mStatusBar->showMessage( tr( "Unable to export %1: %2" ).arg( fname ).arg( error ) );
+        return;
+    }
+
+    ui->mStatusBar->showMessage( tr( "Exported %1" ).arg( fname ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		followFile
+
+Purpose		Loads a dump file that is still being written (e.g. by
+            candump can0 | tee sample.txt) and keeps reading the lines
+            appended to it
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::followFile()
+{
+    QString fname = QFileDialog::getOpenFileName( this, tr( "Follow File" ) );
+    if ( fname.isEmpty() )
+        return;
+
+    stopLive();
 
-    QString fname = diag.getOpenFileName( this );
+    // An empty file cannot be mapped, but can still be followed
+    if ( !mParser.loadFile( fname ) )
+        mParser.unload();
 
-    QFile file( fname );
-    if ( !file.open(QIODevice::ReadOnly) )
+    if ( !mLive.followFile( fname, mParser.loadedBytes() ) )
     {
+        ui->mStatusBar->showMessage( tr( "Unable to open %1" ).arg( fname ) );
         return;
     }
-    QTextStream in( &file );
-    QString txt = in.readAll();
 
-    ui->mDumpBrowser->setText(txt);
-    mParser.setText( txt );
+    ui->mActionStopLive->setEnabled( true );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		captureInterface
+
+Purpose		Clears the frames shown and reads frames live from a SocketCAN
+            interface
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::captureInterface()
+{
+    bool ok;
+    QString iface = QInputDialog::getText( this, tr( "Capture Interface" ),
+                                           tr( "SocketCAN interface:" ),
+                                           QLineEdit::Normal, "vcan0", &ok );
+    if ( !ok || iface.isEmpty() )
+        return;
+
+    stopLive();
+    mParser.unload();
+
+    if ( !mLive.openInterface( iface ) )
+    {
+        ui->mStatusBar->showMessage( tr( "Unable to open interface %1" ).arg( iface ) );
+        return;
+    }
+
+    ui->mActionStopLive->setEnabled( true );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		stopLive
+
+Purpose		Stops following a file or interface.  The frames read so far stay.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::stopLive()
+{
+    if ( !mLive.isActive() )
+        return;
+
+    mLive.stop();
+    ui->mActionStopLive->setEnabled( false );
+    ui->mStatusBar->showMessage( tr( "Live capture stopped" ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setLiveLimits
+
+Purpose		Asks for the bounds on the frames held while reading live, so a
+            long session runs in constant memory
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::setLiveLimits()
+{
+    LiveLimitsDialog dialog( mParser.maxFrames(), mParser.horizon(),
+                             mParser.spillDir(), this );
+    if ( dialog.exec() != QDialog::Accepted )
+        return;
+
+    mParser.setLimits( dialog.maxFrames(), dialog.horizon(), dialog.spillDir() );
 }
 
 /*----------------------------------------------------------------------------
@@ -98,12 +296,46 @@ Name		connectSigSlot
 Purpose		Connects all signals and slots
 
 History		12 May 18  AFB	Created
+            17 Oct 26  AFB	Lets the parser unmap a followed file that is truncated
 ----------------------------------------------------------------------------*/
 void MainWindow::connectSigSlot()
 {
     connect( ui->mActionOpen,       SIGNAL(triggered() ),
              this,                  SLOT( loadFile()) );
 
+    connect( ui->mActionSaveCapture, SIGNAL( triggered() ),
+             this,                  SLOT( saveCapture() ) );
+
+    connect( ui->mActionExportLog,  SIGNAL( triggered() ),
+             this,                  SLOT( exportLog() ) );
+
+    connect( ui->mActionFollow,     SIGNAL( triggered() ),
+             this,                  SLOT( followFile() ) );
+
+    connect( ui->mActionCapture,    SIGNAL( triggered() ),
+             this,                  SLOT( captureInterface() ) );
+
+    connect( ui->mActionStopLive,   SIGNAL( triggered() ),
+             this,                  SLOT( stopLive() ) );
+
+    connect( ui->mActionLiveLimits, SIGNAL( triggered() ),
+             this,                  SLOT( setLiveLimits() ) );
+
+    connect( ui->mActionLoadDictionary, SIGNAL( triggered() ),
+             this,                  SLOT( loadDictionary() ) );
+
+    connect( ui->mActionDecodeObjects, SIGNAL( toggled(bool) ),
+             this,                  SLOT( decodeObjects(bool) ) );
+
+    connect( ui->mActionStageTimings, SIGNAL( toggled(bool) ),
+             this,                  SLOT( showStageTimings(bool) ) );
+
+    connect( ui->mActionRecordTrace, SIGNAL( toggled(bool) ),
+             this,                  SLOT( recordTrace(bool) ) );
+
+    connect( &mStageTimer,          SIGNAL( timeout() ),
+             this,                  SLOT( updateStageTimings() ) );
+
     connect( ui->mActionExit,       SIGNAL( triggered()),
              this,                  SLOT(close() ) );
 
@@ -119,11 +351,62 @@ void MainWindow::connectSigSlot()
     connect( ui->mSubIdxEdit,       SIGNAL( editingFinished()),
              this,                  SLOT( updateSubIdx() ) );
 
+    connect( ui->mTimeFromEdit,     SIGNAL( editingFinished()),
+             this,                  SLOT( updateTimeFrom() ) );
+
+    connect( ui->mTimeToEdit,       SIGNAL( editingFinished()),
+             this,                  SLOT( updateTimeTo() ) );
+
+    connect( ui->mDataEdit,         SIGNAL( editingFinished()),
+             this,                  SLOT( updatePayload() ) );
+
     connect( ui->mTypeBtnGrp,       SIGNAL(buttonClicked( int ) ),
              this,                  SLOT(parseChkBtnGrp( int )) );
 
-    connect( &mParser,              SIGNAL( textChanged(QString) ),
-             this,                  SLOT( updateText( QString ) ) );
+    connect( &mParser,              SIGNAL( matchesChanged(QVector<FrameId>) ),
+             &mModel,               SLOT( setMatches(QVector<FrameId>) ) );
+
+    connect( &mParser,              SIGNAL( matchesAdded(QVector<FrameId>) ),
+             &mModel,               SLOT( appendMatches(QVector<FrameId>) ) );
+
+    connect( &mParser,              SIGNAL( progressChanged(int) ),
+             this,                  SLOT( updateProgress(int) ) );
+
+    connect( &mParser,              SIGNAL( statusChanged(QString) ),
+             ui->mStatusBar,        SLOT( showMessage(QString) ) );
+
+    connect( &mLive,                SIGNAL( framesArrived(FrameTable) ),
+             &mParser,              SLOT( appendFrames(FrameTable) ) );
+
+    connect( &mLive,                SIGNAL( statusChanged(QString) ),
+             ui->mStatusBar,        SLOT( showMessage(QString) ) );
+
+    connect( &mLive,                SIGNAL( truncated() ),
+             &mParser,              SLOT( releaseDumps() ) );
+
+    connect( mStatsDock->toggleViewAction(), SIGNAL( triggered() ),
+             mStatsDock,            SLOT( refresh() ) );
+
+    connect( mSignalDock->toggleViewAction(), SIGNAL( triggered() ),
+             mSignalDock,           SLOT( refresh() ) );
+
+    connect( mSignalDock,           SIGNAL( refreshed() ),
+             mPlotDock,             SLOT( refreshSignals() ) );
+
+    connect( mSignalDock,           SIGNAL( signalActivated(int) ),
+             this,                  SLOT( plotSignal(int) ) );
+
+    connect( mPlotDock->toggleViewAction(), SIGNAL( triggered() ),
+             mPlotDock,             SLOT( refreshSignals() ) );
+
+    connect( mPlotDock,             SIGNAL( frameClicked(FrameId) ),
+             this,                  SLOT( showFrame(FrameId) ) );
+
+    connect( mTimelineDock->toggleViewAction(), SIGNAL( triggered() ),
+             mTimelineDock,         SLOT( refresh() ) );
+
+    connect( mTimelineDock,         SIGNAL( frameClicked(FrameId) ),
+             this,                  SLOT( showFrame(FrameId) ) );
 
 }
 
@@ -185,6 +468,48 @@ void MainWindow::updateSubIdx()
 
 /*----------------------------------------------------------------------------
 
+Name		updateTimeFrom
+
+Purpose		Grabs the start of the timestamp window from the appropriate line
+            edit and adds it to the parser.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::updateTimeFrom()
+{
+    mParser.setTimeFrom( ui->mTimeFromEdit->text() );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		updateTimeTo
+
+Purpose		Grabs the end of the timestamp window from the appropriate line
+            edit and adds it to the parser.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::updateTimeTo()
+{
+    mParser.setTimeTo( ui->mTimeToEdit->text() );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		updatePayload
+
+Purpose		Grabs the payload predicates from the appropriate line edit and
+            adds them to the parser.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::updatePayload()
+{
+    mParser.setPayload( ui->mDataEdit->text() );
+}
+
+/*----------------------------------------------------------------------------
+
 Name		updateType
 
 Purpose		Updates the parser based on whether a button was selected or not.
@@ -225,3 +550,257 @@ void MainWindow::parseChkBtnGrp( int )
     updateType( NODE_GUARD, ui->mNodeGuardChkBox->isChecked() );
 
 }
+
+/*----------------------------------------------------------------------------
+
+Name		updateProgress
+
+Purpose		Shows the progress of a background parse and the number of
+            matches found so far in the status bar
+
+Input       percent - share of the frames tested so far
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::updateProgress( int percent )
+{
+    mProgressBar->setValue( percent );
+    mProgressBar->setVisible( percent < 100 );
+
+    mMatchLbl->setText( tr( "%1 matches" ).arg( mModel.rowCount() ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		loadDictionary
+
+Purpose		Reads the EDS or DCF files of nodes.  A DCF names its node; for
+            an EDS the node is asked for, 0 applying it to every node.
+            Decoding is turned on once a file has been read.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Refreshes the signal dock
+            17 Oct 26  AFB	Refreshes the node timeline dock
+----------------------------------------------------------------------------*/
+void MainWindow::loadDictionary()
+{
+    QStringList fnames = QFileDialog::getOpenFileNames( this, tr( "Load Object Dictionary" ),
+                                                        QString(),
+                                                        tr( "Object dictionaries (*.eds *.dcf)" ) );
+    int loaded = 0;
+    for ( int i = 0; i < fnames.size(); ++i )
+    {
+        const QString& fname = fnames.at(i);
+        int node = -1;
+        if ( QFileInfo( fname ).suffix().toLower() != "dcf" )
+        {
+            bool ok;
+            node = QInputDialog::getInt( this, tr( "Load Object Dictionary" ),
+                                         tr( "Node id of %1 (0 for every node):" )
+                                         .arg( QFileInfo( fname ).fileName() ),
+                                         0, 0, 127, 1, &ok );
+            if ( !ok )
+                continue;
+        }
+
+        QString error;
+        if ( !mParser.loadDictionary( fname, node, error ) )
+        {
+            ui->mStatusBar->showMessage( tr( "Unable to read %1: %2" ).arg( fname ).arg( error ) );
+            return;
+        }
+        ++loaded;
+    }
+
+    if ( loaded == 0 )
+        return;
+
+    ui->mActionDecodeObjects->setChecked( true );
+    ui->mStatusBar->showMessage( tr( "%1 object dictionaries loaded, %2 PDO fields mapped" )
+                                 .arg( mParser.dictionary().files().size() )
+                                 .arg( mParser.dictionary().pdoFields().size() ) );
+
+    if ( mSignalDock->isVisible() )
+        mSignalDock->refresh();
+    if ( mTimelineDock->isVisible() )
+        mTimelineDock->refresh();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		decodeObjects
+
+Purpose		Turns the decoded objects after each row on or off
+
+Input       decode - true to decode
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::decodeObjects( bool decode )
+{
+    mModel.setDecode( decode );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		plotSignal
+
+Purpose		Shows the plot dock with a signal of the parser's signal table
+
+Input       signal - position of the signal in the table
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::plotSignal( int signal )
+{
+    mPlotDock->show();
+    mPlotDock->raise();
+    mPlotDock->plotSignal( signal );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		showFrame
+
+Purpose		Selects and scrolls to the row of a frame, if the filter shows it
+
+Input       frame - frame to show
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::showFrame( FrameId frame )
+{
+    const int row = mModel.rowOf( frame );
+    if ( row < 0 )
+    {
+        ui->mStatusBar->showMessage( tr( "Frame %1 is hidden by the filter" ).arg( frame ) );
+        return;
+    }
+
+    const QModelIndex index = mModel.index( row );
+    ui->mDumpBrowser->setCurrentIndex( index );
+    ui->mDumpBrowser->scrollTo( index, QAbstractItemView::PositionAtCenter );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		showStageTimings
+
+Purpose		Turns stage timing on, with the totals in the status bar, or off.
+            Turning it off ends (and offers to save) any trace.
+
+Input       show - true to time the stages
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::showStageTimings( bool show )
+{
+    if ( !show )
+    {
+        ui->mActionRecordTrace->setChecked( false );
+        StageProfile::setEnabled( false );
+        mStageTimer.stop();
+        mStageLbl->hide();
+        return;
+    }
+
+    StageProfile::setEnabled( true );
+    mStageCalls = 0;
+    mStageLbl->setText( tr( "No stages timed yet" ) );
+    mStageLbl->show();
+    mStageTimer.start();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		recordTrace
+
+Purpose		Starts recording every stage, or stops and asks where to save
+            the recording as a Chrome trace-event file
+
+Input       record - true to start recording
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::recordTrace( bool record )
+{
+    if ( record )
+    {
+        ui->mActionStageTimings->setChecked( true );
+        StageProfile::startTrace();
+        ui->mStatusBar->showMessage( tr( "Recording trace" ) );
+        return;
+    }
+
+    const bool full = !StageProfile::isTracing() &&
+                      StageProfile::tracedEvents() == TRACE_MAX_EVENTS;
+    StageProfile::stopTrace();
+    if ( StageProfile::tracedEvents() == 0 )
+    {
+        ui->mStatusBar->showMessage( tr( "Trace stopped; no stages were recorded" ) );
+        return;
+    }
+
+    QString fname = QFileDialog::getSaveFileName( this, tr( "Save Trace" ),
+                                                  QString(), tr( "Chrome traces (*.json)" ) );
+    if ( fname.isEmpty() )
+        return;
+
+    QString error;
+    if ( !StageProfile::writeTrace( fname, error ) )
+    {
+        ui->mStatusBar->showMessage( tr( "Unable to save %1: %2" ).arg( fname ).arg( error ) );
+        return;
+    }
+
+    ui->mStatusBar->showMessage( full ? tr( "Saved %1 (the trace filled and stopped early)" ).arg( fname )
+                                      : tr( "Saved %1" ).arg( fname ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		updateStageTimings
+
+Purpose		Shows the time spent in each stage since timing was turned on,
+            with calls and frames in the tooltip.  Nothing is redrawn while
+            no stage has run, so an idle program does no work here.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void MainWindow::updateStageTimings()
+{
+    StageTotals totals[ STAGE_COUNT ];
+    quint64 calls = 0;
+    for ( int s = 0; s < STAGE_COUNT; ++s )
+    {
+        totals[s] = StageProfile::totals( Stage( s ) );
+        calls += totals[s].calls;
+    }
+
+    // The label's own repaint is not a stage, so this settles when idle
+    if ( calls == mStageCalls )
+        return;
+    mStageCalls = calls;
+
+    QStringList text;
+    QStringList tip;
+    for ( int s = 0; s < STAGE_COUNT; ++s )
+    {
+        if ( totals[s].calls == 0 )
+            continue;
+
+        const double msecs = totals[s].nsecs / 1e6;
+        text << QString( "%1 %2 ms" ).arg( StageProfile::name( Stage( s ) ) )
+                                      .arg( msecs, 0, 'f', 1 );
+        tip << tr( "%1: %2 ms in %3 calls, %4 frames (%5 ns a frame)" )
+                   .arg( StageProfile::name( Stage( s ) ) )
+                   .arg( msecs, 0, 'f', 3 )
+                   .arg( totals[s].calls )
+                   .arg( totals[s].frames )
+                   .arg( totals[s].frames ? double( totals[s].nsecs ) / totals[s].frames : 0.0,
+                         0, 'f', 1 );
+    }
+
+    mStageLbl->setText( text.join( "  " ) );
+    mStageLbl->setToolTip( tip.join( "\n" ) );
+}
@@ -9,8 +9,19 @@ History		12 May 18  AFB	Created
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QLabel>
 #include <QMainWindow>
+#include <QProgressBar>
+#include <QTimer>
+#include "framedelegate.h"
+#include "framemodel.h"
+#include "livesource.h"
 #include "parser.h"
+#include "plotdock.h"
+#include "searchdock.h"
+#include "signaldock.h"
+#include "statsdock.h"
+#include "timelinedock.h"
 
 namespace Ui
 {
@@ -25,24 +36,57 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
-public slots:
-    // Update the text within the browser
-    void updateText( QString text );
-
 private slots:
     // Loads a file into the program
     void loadFile();
 
+    // Saves the frames to a binary capture file
+    void saveCapture();
+    // Writes the frames out as a candump -l log
+    void exportLog();
+
+    // Loads a file and keeps reading the lines appended to it
+    void followFile();
+    // Reads frames live from a SocketCAN interface
+    void captureInterface();
+    // Stops following a file or interface
+    void stopLive();
+    // Bounds the frames held while reading live
+    void setLiveLimits();
+
+    // Reads the EDS or DCF files of nodes
+    void loadDictionary();
+    // Turns the decoded objects after each row on or off
+    void decodeObjects( bool decode );
+
+    // Shows the plot dock with a signal of the parser's signal table
+    void plotSignal( int signal );
+    // Selects and scrolls to the row of a frame
+    void showFrame( FrameId frame );
+
     // The following group of slots update the parser
     void updatePort();
     void updateAddr();
     void updateObjIdx();
     void updateSubIdx();
+    void updateTimeFrom();
+    void updateTimeTo();
+    void updatePayload();
     void updateType( PacketType pktType, bool checked );
 
     // Determines which buttons were selected, the updates the parser
     void parseChkBtnGrp( int );
 
+    // Shows the progress of a background parse in the status bar
+    void updateProgress( int percent );
+
+    // Turns the per-stage timings in the status bar on or off
+    void showStageTimings( bool show );
+    // Starts recording a trace, or stops and saves it
+    void recordTrace( bool record );
+    // Refreshes the per-stage timings in the status bar
+    void updateStageTimings();
+
 private:
     // Connects all program signals and slots
     void connectSigSlot();
@@ -50,6 +94,20 @@ private:
     Ui::MainWindow *ui;
 
     Parser mParser;
+    FrameModel mModel;
+    FrameDelegate mDelegate;
+    LiveSource mLive;
+
+    QProgressBar* mProgressBar;     // Background parse progress
+    QLabel* mMatchLbl;              // Number of matching frames
+    QLabel* mStageLbl;              // Time spent in each stage
+    QTimer mStageTimer;             // Refreshes mStageLbl
+    quint64 mStageCalls;            // Stages timed at the last refresh
+    StatsDock* mStatsDock;          // Traffic statistics
+    SearchDock* mSearchDock;        // Search of the raw lines
+    SignalDock* mSignalDock;        // Signals carried by the PDOs
+    PlotDock* mPlotDock;            // Plot of one signal
+    TimelineDock* mTimelineDock;    // NMT states and anomalies of the nodes
 };
 
 #endif // MAINWINDOW_H
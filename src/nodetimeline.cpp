@@ -0,0 +1,813 @@
+/*----------------------------------------------------------------------------
+
+Name		nodetimeline.cpp
+
+Purpose		NMT state and heartbeat timeline of every node.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "nodetimeline.h"
+#include "stageprofile.h"
+#include <QtConcurrent>
+#include <algorithm>
+
+// COB-IDs of NMT commands, and the first of the emergency and heartbeat
+// COB-IDs (plus the node id)
+static const quint32 NMT_COB_ID = 0x000;
+static const quint32 EMCY_COB_BASE = 0x080;
+static const quint32 HEARTBEAT_COB_BASE = 0x700;
+
+// Highest node id
+static const int MAX_NODE = 127;
+
+// NMT commands after which a node boots up again
+static const quint8 NMT_RESET_NODE = 0x81;
+static const quint8 NMT_RESET_COMMUNICATION = 0x82;
+
+// Producer heartbeat time, in milliseconds
+static const quint16 PRODUCER_HEARTBEAT = 0x1017;
+
+// Bit of a guard reply that alternates from one reply to the next
+static const quint8 GUARD_TOGGLE = 0x80;
+
+// Producer heartbeat time in force from a frame on
+struct HeartbeatSetting
+{
+    FrameId from;                       // First frame it applies to
+    int iface;                          // Interface, or -1 for every one
+    qint64 period;                      // Microseconds, 0 for no heartbeat
+};
+
+// Frames of one node, walked on a worker thread
+struct TimelineWork
+{
+    const FrameTable* table;
+    const QVector<FrameId>* commands;   // Frames of the NMT COB-ID
+    quint8 node;
+    bool timed;                         // Positions are microseconds
+    qint64 end;                         // Position of the last frame
+    QVector<FrameId> beats;             // Heartbeat / guard frames of the node
+    QVector<FrameId> emcys;             // Emergency frames of the node
+    QVector<HeartbeatSetting> settings; // Heartbeat times, in frame order
+    QVector<NodeLane> lanes;            // One per interface heard on
+};
+
+// State of one lane while its frames are walked
+struct LaneWalk
+{
+    NodeLane lane;
+    const TimelineWork* work;
+    qint64 estimate;                    // Median heartbeat period seen, or 0
+    int setting;                        // Next heartbeat setting to apply
+    bool heard;                         // A heartbeat has been seen
+    qint64 lastBeat;                    // Position of the last heartbeat
+    FrameId lastBeatFrame;
+    bool running;                       // Reported a state other than boot-up
+    bool resetSent;                     // Reset command sent since the last boot-up
+    bool guardPending;                  // Guard request not answered yet
+    qint64 guardTime;                   // Position of that request
+    FrameId guardFrame;
+    int toggle;                         // Toggle bit of the next reply, or -1
+    QVector<qint64> emcyTimes;          // Emergencies counted towards bursts
+    QVector<FrameId> emcyFrames;
+    int emcyStart;                      // First of them within EMCY_WINDOW
+    int burst;                          // Event of the current burst, or -1
+    QVector<qint64> changes;            // Positions of the state changes
+    QVector<FrameId> changeFrames;
+    int changeStart;                    // First of them within FLAP_WINDOW
+    int flapping;                       // Event of the current spell, or -1
+};
+
+/*----------------------------------------------------------------------------
+
+Name		position
+
+Purpose		Returns where a frame sits on the timeline: its timestamp, or
+            its number for dumps without timestamps
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline qint64 position( const FrameTable& table, FrameId frame, bool timed )
+{
+    return timed ? table.time( frame ) : qint64( frame );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		stateOf
+
+Purpose		Returns the state a heartbeat or guard reply reports
+
+Input       value - the reply's first byte, without the toggle bit
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static quint8 stateOf( quint8 value )
+{
+    switch ( value )
+    {
+    case 0x00:  return NODE_BOOTUP;
+    case 0x04:  return NODE_STOPPED;
+    case 0x05:  return NODE_OPERATIONAL;
+    case 0x7F:  return NODE_PRE_OPERATIONAL;
+    default:    return NODE_UNKNOWN;
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		eventBefore
+
+Purpose		Orders events by position
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool eventBefore( const NodeEvent& a, const NodeEvent& b )
+{
+    return a.begin < b.begin;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		addEvent
+
+Purpose		Adds an event to the lane being walked
+
+Return      its position among the lane's events
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static int addEvent( LaneWalk& walk, quint8 kind, qint64 begin, qint64 end,
+                     FrameId frame, quint32 value )
+{
+    NodeEvent event;
+    event.begin = begin;
+    event.end = end;
+    event.frame = frame;
+    event.value = value;
+    event.kind = kind;
+    walk.lane.events.append( event );
+
+    return walk.lane.events.size() - 1;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		countSpell
+
+Purpose		Counts one more occurrence towards a spell (an EMCY burst, or
+            flapping): once threshold occurrences fall within window, an
+            event is added from the first of them, and then stretched for
+            as long as that holds
+
+Input       walk      - lane being walked
+            times     - positions of the occurrences so far, the last being
+                        this one
+            frames    - their frames
+            start     - first occurrence within window of the one before
+            spell     - event of the current spell, or -1
+            kind      - kind of event to add
+            threshold - occurrences that make a spell
+            window    - span they must fall within
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void countSpell( LaneWalk& walk, const QVector<qint64>& times,
+                        const QVector<FrameId>& frames, int& start, int& spell,
+                        quint8 kind, int threshold, qint64 window )
+{
+    const qint64 at = times.last();
+    while ( times.at( start ) < at - window )
+        ++start;
+
+    const int within = times.size() - start;
+    if ( within < threshold )
+    {
+        spell = -1;
+    }
+    else if ( spell >= 0 )
+    {
+        NodeEvent& event = walk.lane.events[ spell ];
+        event.end = at;
+        event.value += 1;
+    }
+    else
+    {
+        spell = addEvent( walk, kind, times.at( start ), at, frames.at( start ),
+                          quint32( within ) );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		enterState
+
+Purpose		Moves the lane being walked into a state, opening an interval
+            for it unless the node is in that state already.  Changes
+            between the states a running node reports count towards
+            flapping; booting up and falling silent are flagged otherwise.
+
+Input       walk  - lane being walked
+            at    - position of the change
+            frame - frame that reported it
+            state - NodeState
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void enterState( LaneWalk& walk, qint64 at, FrameId frame, quint8 state )
+{
+    QVector<NodeInterval>& intervals = walk.lane.intervals;
+    if ( !intervals.isEmpty() )
+    {
+        if ( intervals.last().state == state )
+            return;
+        const quint8 from = intervals.last().state;
+        intervals.last().end = at;
+
+        if ( walk.work->timed && from != NODE_BOOTUP && from != NODE_SILENT
+             && state != NODE_BOOTUP && state != NODE_SILENT )
+        {
+            walk.changes.append( at );
+            walk.changeFrames.append( frame );
+            countSpell( walk, walk.changes, walk.changeFrames, walk.changeStart,
+                        walk.flapping, EVENT_FLAPPING, FLAP_CHANGES, FLAP_WINDOW );
+        }
+    }
+
+    NodeInterval interval;
+    interval.begin = at;
+    interval.end = at;
+    interval.frame = frame;
+    interval.state = state;
+    intervals.append( interval );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		checkSilence
+
+Purpose		Marks the node silent if its last heartbeat was more than
+            HEARTBEAT_TOLERANCE periods before now
+
+Input       walk  - lane being walked
+            now   - position of the next heartbeat, or the end of the dump
+            frame - frame of the next heartbeat, or of the last
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void checkSilence( LaneWalk& walk, qint64 now, FrameId frame )
+{
+    const qint64 period = walk.lane.period;
+    if ( !walk.work->timed || !walk.heard || period <= 0 )
+        return;
+
+    const qint64 due = walk.lastBeat + qint64( period * HEARTBEAT_TOLERANCE );
+    if ( now <= due )
+        return;
+
+    enterState( walk, due, walk.lastBeatFrame, NODE_SILENT );
+    addEvent( walk, EVENT_HEARTBEAT_TIMEOUT, due, now, frame, quint32( qMin<qint64>( period, 0xFFFFFFFF ) ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		applySettings
+
+Purpose		Brings the heartbeat period of the lane being walked up to a
+            frame: the last producer heartbeat time set for the lane's
+            interface by then, or else the median period seen
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void applySettings( LaneWalk& walk, FrameId frame )
+{
+    const QVector<HeartbeatSetting>& settings = walk.work->settings;
+    while ( walk.setting < settings.size() && settings.at( walk.setting ).from <= frame )
+    {
+        const HeartbeatSetting& setting = settings.at( walk.setting++ );
+        if ( setting.iface < 0 || setting.iface == walk.lane.iface )
+        {
+            walk.lane.period = setting.period;
+            walk.lane.configured = true;
+        }
+    }
+
+    if ( !walk.lane.configured )
+        walk.lane.period = walk.estimate;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		medianPeriod
+
+Purpose		Returns the median time between the heartbeats of a lane.  A
+            reply to a guard request is not a heartbeat.
+
+Input       table  - frames
+            frames - heartbeat / guard frames of the lane, in frame order
+
+Return      the median, or 0 if fewer than two heartbeats were seen
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Tells guard requests by the remote flag, not the DLC
+----------------------------------------------------------------------------*/
+static qint64 medianPeriod( const FrameTable& table, const QVector<FrameId>& frames )
+{
+    QVector<qint64> gaps;
+    bool requested = false;
+    bool heard = false;
+    qint64 last = 0;
+    for ( int i = 0; i < frames.size(); ++i )
+    {
+        const FrameId f = frames.at(i);
+        if ( table.isRemote( f ) )
+        {
+            requested = true;
+            continue;
+        }
+        if ( table.dlc( f ) == 0 )
+            continue;
+        if ( requested )
+        {
+            requested = false;
+            continue;
+        }
+
+        const qint64 t = table.time( f );
+        if ( heard )
+            gaps.append( t - last );
+        heard = true;
+        last = t;
+    }
+
+    if ( gaps.isEmpty() )
+        return 0;
+
+    qint64* middle = gaps.data() + gaps.size() / 2;
+    std::nth_element( gaps.data(), middle, gaps.data() + gaps.size() );
+    return *middle;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		walkBeat
+
+Purpose		Walks a frame of the heartbeat / node guard COB-ID: a guard
+            request when it is a remote frame, else a heartbeat, boot-up or
+            (after a request) guard reply.  Data frames without data say
+            nothing and are passed over.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Tells guard requests by the remote flag, not the DLC
+----------------------------------------------------------------------------*/
+static void walkBeat( LaneWalk& walk, FrameId f )
+{
+    const FrameTable& table = *walk.work->table;
+    const qint64 t = position( table, f, walk.work->timed );
+
+    if ( table.isRemote( f ) )
+    {
+        if ( walk.guardPending )
+            addEvent( walk, EVENT_GUARD_TIMEOUT, walk.guardTime, t, walk.guardFrame, 0 );
+        walk.guardPending = true;
+        walk.guardTime = t;
+        walk.guardFrame = f;
+        return;
+    }
+    if ( table.dlc( f ) == 0 )
+        return;
+
+    const quint8 value = table.dataByte( f, 0 );
+    const bool guard = walk.guardPending;
+    walk.guardPending = false;
+
+    if ( guard )
+    {
+        const int toggle = ( value & GUARD_TOGGLE ) ? 1 : 0;
+        if ( walk.toggle >= 0 && toggle != walk.toggle )
+            addEvent( walk, EVENT_GUARD_TOGGLE, t, t, f, value );
+        walk.toggle = 1 - toggle;
+    }
+    else
+    {
+        checkSilence( walk, t, f );
+        walk.heard = true;
+        walk.lastBeat = t;
+        walk.lastBeatFrame = f;
+    }
+    applySettings( walk, f );
+
+    const quint8 state = stateOf( guard ? quint8( value & ~GUARD_TOGGLE ) : value );
+    if ( state == NODE_BOOTUP )
+    {
+        if ( walk.running && !walk.resetSent )
+            addEvent( walk, EVENT_UNEXPECTED_BOOT, t, t, f, 0 );
+        walk.running = false;
+        walk.resetSent = false;
+        walk.toggle = 0;
+    }
+    else
+    {
+        walk.running = true;
+    }
+
+    enterState( walk, t, f, state );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		walkEmcy
+
+Purpose		Walks an emergency frame, counting it towards a burst unless it
+            is an error reset (error code 0)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void walkEmcy( LaneWalk& walk, FrameId f )
+{
+    const FrameTable& table = *walk.work->table;
+    const qint64 t = position( table, f, walk.work->timed );
+    const quint32 code = quint32( table.data( f ) & 0xFFFF );
+    const quint32 reg = table.dataByte( f, 2 );
+
+    addEvent( walk, EVENT_EMCY, t, t, f, reg << 16 | code );
+
+    if ( walk.work->timed && code != 0 )
+    {
+        walk.emcyTimes.append( t );
+        walk.emcyFrames.append( f );
+        countSpell( walk, walk.emcyTimes, walk.emcyFrames, walk.emcyStart, walk.burst,
+                    EVENT_EMCY_BURST, EMCY_BURST, EMCY_WINDOW );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		walkCommand
+
+Purpose		Walks an NMT command, if it is for the lane's node
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Passes over remote frames
+----------------------------------------------------------------------------*/
+static void walkCommand( LaneWalk& walk, FrameId f )
+{
+    const FrameTable& table = *walk.work->table;
+    if ( table.iface( f ) != walk.lane.iface || table.isRemote( f ) || table.dlc( f ) < 2 )
+        return;
+
+    const quint8 command = table.dataByte( f, 0 );
+    const quint8 target = table.dataByte( f, 1 );
+    if ( target != 0 && target != walk.lane.node )
+        return;
+
+    const qint64 t = position( table, f, walk.work->timed );
+    addEvent( walk, EVENT_NMT_COMMAND, t, t, f, quint32( target ) << 8 | command );
+
+    if ( command == NMT_RESET_NODE || command == NMT_RESET_COMMUNICATION )
+        walk.resetSent = true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		walkLane
+
+Purpose		Walks the frames of a node on one interface in frame order and
+            returns its lane
+
+Input       work  - frames of the node
+            iface - interface
+            beats - heartbeat / guard frames of the node on iface
+            emcys - emergency frames of the node on iface
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static NodeLane walkLane( const TimelineWork& work, quint8 iface,
+                          const QVector<FrameId>& beats, const QVector<FrameId>& emcys )
+{
+    LaneWalk walk;
+    walk.lane.iface = iface;
+    walk.lane.node = work.node;
+    walk.lane.period = 0;
+    walk.lane.configured = false;
+    walk.lane.anomalies = 0;
+    walk.work = &work;
+    walk.estimate = work.timed ? medianPeriod( *work.table, beats ) : 0;
+    walk.setting = 0;
+    walk.heard = false;
+    walk.lastBeat = 0;
+    walk.lastBeatFrame = 0;
+    walk.running = false;
+    walk.resetSent = false;
+    walk.guardPending = false;
+    walk.guardTime = 0;
+    walk.guardFrame = 0;
+    walk.toggle = -1;
+    walk.emcyStart = 0;
+    walk.burst = -1;
+    walk.changeStart = 0;
+    walk.flapping = -1;
+    applySettings( walk, 0 );
+
+    // Merge the three lists by frame; no frame is on two of them
+    const FrameId none = FrameId( work.table->size() );
+    const QVector<FrameId>& commands = *work.commands;
+    int b = 0;
+    int e = 0;
+    int c = 0;
+    for ( ;; )
+    {
+        const FrameId fb = ( b < beats.size() ) ? beats.at( b ) : none;
+        const FrameId fe = ( e < emcys.size() ) ? emcys.at( e ) : none;
+        const FrameId fc = ( c < commands.size() ) ? commands.at( c ) : none;
+        if ( fb == none && fe == none && fc == none )
+            break;
+
+        if ( fb < fe && fb < fc )
+        {
+            walkBeat( walk, fb );
+            ++b;
+        }
+        else if ( fe < fc )
+        {
+            walkEmcy( walk, fe );
+            ++e;
+        }
+        else
+        {
+            walkCommand( walk, fc );
+            ++c;
+        }
+    }
+
+    applySettings( walk, none - 1 );
+    checkSilence( walk, work.end, walk.lastBeatFrame );
+    if ( !walk.lane.intervals.isEmpty() )
+        walk.lane.intervals.last().end = work.end;
+
+    // Timeouts are found late, so the events are sorted into place
+    std::stable_sort( walk.lane.events.begin(), walk.lane.events.end(), eventBefore );
+    for ( int i = 0; i < walk.lane.events.size(); ++i )
+        walk.lane.anomalies += NodeTimeline::isAnomaly( walk.lane.events.at(i).kind ) ? 1 : 0;
+
+    return walk.lane;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		walkNode
+
+Purpose		Splits the frames of a node by interface and walks each
+            interface it was heard on, or commanded on by name, as a lane
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Passes over remote frames
+----------------------------------------------------------------------------*/
+static void walkNode( TimelineWork& work )
+{
+    const FrameTable& table = *work.table;
+    const int ifaces = qMax( table.ifaces().size(), 1 );
+
+    QVector< QVector<FrameId> > beats( ifaces );
+    QVector< QVector<FrameId> > emcys( ifaces );
+    QVector<bool> heard( ifaces, false );
+    for ( int i = 0; i < work.beats.size(); ++i )
+    {
+        const quint8 iface = table.iface( work.beats.at(i) );
+        beats[ iface ].append( work.beats.at(i) );
+        heard[ iface ] = true;
+    }
+    for ( int i = 0; i < work.emcys.size(); ++i )
+    {
+        const quint8 iface = table.iface( work.emcys.at(i) );
+        emcys[ iface ].append( work.emcys.at(i) );
+        heard[ iface ] = true;
+    }
+    for ( int i = 0; i < work.commands->size(); ++i )
+    {
+        const FrameId f = work.commands->at(i);
+        if ( !table.isRemote( f ) && table.dlc( f ) >= 2 && table.dataByte( f, 1 ) == work.node )
+            heard[ table.iface( f ) ] = true;
+    }
+
+    for ( int iface = 0; iface < ifaces; ++iface )
+    {
+        if ( heard.at( iface ) )
+            work.lanes.append( walkLane( work, quint8( iface ), beats.at( iface ), emcys.at( iface ) ) );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		NodeTimeline
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+NodeTimeline::NodeTimeline()
+    : mTimed( false ),
+      mBegin( 0 ),
+      mEnd( 0 )
+{
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Removes every lane
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void NodeTimeline::clear()
+{
+    mLanes.clear();
+    mTimed = false;
+    mBegin = 0;
+    mEnd = 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		build
+
+Purpose		Builds the lane of every node heard from, or sent a command of
+            its own, on each interface.  The NMT, emergency and heartbeat
+            frames are taken from the index, with any frames past it added
+            by a scan, and the nodes then walked one per worker.
+
+Input       table      - frames to build over
+            index      - posting lists over table
+            sdo        - SDO transfers of table
+            dictionary - object dictionaries of the nodes
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Passes over remote frames
+----------------------------------------------------------------------------*/
+void NodeTimeline::build( const FrameTable& table, const FrameIndex& index,
+                          const SdoTable& sdo, const ObjectDictionary& dictionary )
+{
+    StageTimer stage( STAGE_INDEX, table.size() );
+    clear();
+
+    if ( table.isEmpty() )
+        return;
+
+    mTimed = table.time( 0 ) != NO_TIMESTAMP;
+    mBegin = position( table, 0, mTimed );
+    mEnd = position( table, FrameId( table.size() - 1 ), mTimed );
+
+    QVector<FrameId> commands = index.cobPostings( NMT_COB_ID );
+    QVector<TimelineWork> nodes( MAX_NODE );
+    for ( int n = 0; n < MAX_NODE; ++n )
+    {
+        TimelineWork& work = nodes[n];
+        work.table = &table;
+        work.commands = &commands;
+        work.node = quint8( n + 1 );
+        work.timed = mTimed;
+        work.end = mEnd;
+        work.beats = index.cobPostings( HEARTBEAT_COB_BASE + work.node );
+        work.emcys = index.cobPostings( EMCY_COB_BASE + work.node );
+
+        const OdEntry* entry = dictionary.find( work.node, PRODUCER_HEARTBEAT, 0 );
+        if ( entry && entry->hasValue )
+        {
+            HeartbeatSetting setting;
+            setting.from = 0;
+            setting.iface = -1;
+            setting.period = entry->value * 1000;
+            work.settings.append( setting );
+        }
+    }
+
+    // Frames appended since the index was built
+    const quint32* cobIds = table.cobIds().constData();
+    for ( int f = index.size(); f < table.size(); ++f )
+    {
+        const quint32 node = cobIds[f] & 0x7F;
+        const quint32 func = cobIds[f] & ~quint32( 0x7F );
+        if ( cobIds[f] == NMT_COB_ID )
+            commands.append( FrameId( f ) );
+        else if ( node != 0 && func == HEARTBEAT_COB_BASE )
+            nodes[ node - 1 ].beats.append( FrameId( f ) );
+        else if ( node != 0 && func == EMCY_COB_BASE )
+            nodes[ node - 1 ].emcys.append( FrameId( f ) );
+    }
+
+    // Producer heartbeat times downloaded, in the order they closed
+    const QVector<int> transfers = sdo.transfersOf( PRODUCER_HEARTBEAT );
+    for ( int i = 0; i < transfers.size(); ++i )
+    {
+        const SdoTransfer& t = sdo.at( transfers.at(i) );
+        if ( t.upload || t.status != SdoTransfer::COMPLETE || t.subIdx != 0
+             || t.kept == 0 || t.node == 0 || t.node > MAX_NODE )
+            continue;
+
+        const QByteArray bytes = sdo.payload( transfers.at(i) );
+        qint64 ms = 0;
+        for ( int b = 0; b < bytes.size() && b < 2; ++b )
+            ms |= qint64( quint8( bytes.at( b ) ) ) << ( 8 * b );
+
+        HeartbeatSetting setting;
+        setting.from = t.last + 1;
+        setting.iface = t.iface;
+        setting.period = ms * 1000;
+        nodes[ t.node - 1 ].settings.append( setting );
+    }
+
+    // Only nodes heard from, or sent a command of their own, get a lane
+    QVector<bool> commanded( MAX_NODE + 1, false );
+    for ( int i = 0; i < commands.size(); ++i )
+    {
+        if ( !table.isRemote( commands.at(i) ) && table.dlc( commands.at(i) ) >= 2 )
+            commanded[ table.dataByte( commands.at(i), 1 ) & 0x7F ] = true;
+    }
+
+    QVector<TimelineWork> work;
+    for ( int n = 0; n < MAX_NODE; ++n )
+    {
+        if ( !nodes.at(n).beats.isEmpty() || !nodes.at(n).emcys.isEmpty()
+             || commanded.at( n + 1 ) )
+            work.append( nodes.at(n) );
+    }
+
+    QtConcurrent::blockingMap( work, walkNode );
+
+    // Lanes by interface, then node
+    for ( int iface = 0; iface < qMax( table.ifaces().size(), 1 ); ++iface )
+    {
+        for ( int w = 0; w < work.size(); ++w )
+        {
+            for ( int l = 0; l < work.at( w ).lanes.size(); ++l )
+            {
+                if ( work.at( w ).lanes.at( l ).iface == iface )
+                    mLanes.append( work.at( w ).lanes.at( l ) );
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		removeFirst
+
+Purpose		Forgets what happened before the oldest frames were removed from
+            the table.  Events seen in those frames are dropped; the interval
+            the node was in when the table now starts is cut to start there.
+            Lanes left with nothing are dropped.
+
+Input       count - number of frames removed from the front of the table
+            table - the table, with them removed
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void NodeTimeline::removeFirst( FrameId count, const FrameTable& table )
+{
+    if ( count == 0 || mLanes.isEmpty() )
+        return;
+
+    // Without timestamps positions are frames, which move down
+    const qint64 shift = mTimed ? 0 : qint64( count );
+    mBegin = table.isEmpty() ? mEnd - shift : position( table, 0, mTimed );
+    mEnd -= shift;
+
+    int kept = 0;
+    for ( int i = 0; i < mLanes.size(); ++i )
+    {
+        NodeLane& lane = mLanes[i];
+
+        int gone = 0;
+        while ( gone < lane.intervals.size() && lane.intervals.at( gone ).end - shift <= mBegin )
+            ++gone;
+        lane.intervals.remove( 0, gone );
+        for ( int n = 0; n < lane.intervals.size(); ++n )
+        {
+            NodeInterval& interval = lane.intervals[n];
+            interval.begin = qMax( interval.begin - shift, mBegin );
+            interval.end -= shift;
+            interval.frame = ( interval.frame < count ) ? 0 : interval.frame - count;
+        }
+
+        QVector<NodeEvent> events;
+        lane.anomalies = 0;
+        for ( int n = 0; n < lane.events.size(); ++n )
+        {
+            NodeEvent event = lane.events.at( n );
+            if ( event.frame < count )
+                continue;
+            event.begin -= shift;
+            event.end -= shift;
+            event.frame -= count;
+            events.append( event );
+            lane.anomalies += isAnomaly( event.kind ) ? 1 : 0;
+        }
+        lane.events = events;
+
+        if ( !lane.intervals.isEmpty() || !lane.events.isEmpty() )
+            mLanes[ kept++ ] = lane;
+    }
+    mLanes.resize( kept );
+}
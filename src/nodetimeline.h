@@ -0,0 +1,159 @@
+/*----------------------------------------------------------------------------
+
+Name		nodetimeline.h
+
+Purpose		Network management timeline of every node: the NMT states it
+            reported, as intervals, and the events that matter after a
+            failure.  For each node (on each interface) the frames of its
+            heartbeat / node guard COB-ID (0x700 + node), its emergency
+            COB-ID (0x080 + node) and the NMT commands addressed to it
+            (COB-ID 0, to the node or to all) are taken from the posting
+            lists of the frame index and walked once, in frame order:
+
+                - a heartbeat, boot-up or guard reply opens an interval of
+                  the state it reports, which runs until the state changes
+                - a heartbeat later than HEARTBEAT_TOLERANCE periods marks
+                  the node silent from when it was due until it is heard
+                  again (or the dump ends).  The period is the producer
+                  heartbeat time (0x1017) of the node's dictionary, as
+                  changed by any SDO download in the dump, or else the
+                  median of the periods seen
+                - a guard request (a remote frame, FRAME_RTR) left unanswered
+                  until the next, or a reply whose toggle bit does not
+                  alternate, is flagged
+                - EMCY_BURST or more emergencies (not error resets) within
+                  EMCY_WINDOW are flagged as one burst
+                - FLAP_CHANGES or more changes between the states of a
+                  running node within FLAP_WINDOW are flagged as one spell
+                  of flapping
+                - a boot-up from a node already running with no reset
+                  command sent since is flagged
+
+            Nodes are walked one per worker.  The intervals and events are
+            held as flat arrays per node, sorted by time, so a view finds
+            those in range by binary search.  Dumps without timestamps are
+            laid out by frame number, and the checks that need time (the
+            heartbeat timeout, bursts and flapping) are skipped.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef NODETIMELINE_H
+#define NODETIMELINE_H
+
+#include <QVector>
+#include "frameindex.h"
+#include "frametable.h"
+#include "objectdictionary.h"
+#include "sdoassembler.h"
+
+// Periods past the heartbeat period before a node counts as silent
+const double HEARTBEAT_TOLERANCE = 1.5;
+
+// Emergencies within EMCY_WINDOW microseconds that make a burst
+const int EMCY_BURST = 3;
+const qint64 EMCY_WINDOW = 1000000;
+
+// Changes between pre-operational, operational and stopped within
+// FLAP_WINDOW microseconds that count as flapping
+const int FLAP_CHANGES = 4;
+const qint64 FLAP_WINDOW = 10000000;
+
+// States of a node's timeline
+enum NodeState
+    {
+    NODE_BOOTUP,            // Boot-up message
+    NODE_STOPPED,           // Heartbeat or guard reply of 0x04
+    NODE_OPERATIONAL,       // 0x05
+    NODE_PRE_OPERATIONAL,   // 0x7F
+    NODE_UNKNOWN,           // Any other value
+    NODE_SILENT,            // Heartbeat overdue, until the node is heard again
+    NODE_STATE_COUNT
+    };
+
+// Kinds of event on a node's timeline
+enum NodeEventKind
+    {
+    EVENT_NMT_COMMAND,      // NMT command to the node or all (value: command)
+    EVENT_EMCY,             // Emergency (value: error register << 16 | error code)
+    EVENT_HEARTBEAT_TIMEOUT,// Heartbeat overdue (value: period in microseconds)
+    EVENT_GUARD_TIMEOUT,    // Guard request left unanswered
+    EVENT_GUARD_TOGGLE,     // Guard reply with the toggle bit not alternated
+    EVENT_EMCY_BURST,       // Burst of emergencies (value: how many)
+    EVENT_FLAPPING,         // Spell of state changes (value: how many)
+    EVENT_UNEXPECTED_BOOT,  // Boot-up with no reset command sent
+    EVENT_KIND_COUNT
+    };
+
+// Time a node spent in one state.  Positions are microseconds, or frame
+// numbers for dumps without timestamps.
+struct NodeInterval
+{
+    qint64  begin;          // Start of the interval
+    qint64  end;            // Start of the next, or the end of the dump
+    FrameId frame;          // Frame that reported the state
+    quint8  state;          // NodeState
+};
+
+// Something that happened to a node, at a point or (for bursts, flapping
+// and timeouts) over a span
+struct NodeEvent
+{
+    qint64  begin;          // Position of the event
+    qint64  end;            // End of its span, or begin
+    FrameId frame;          // Frame it was seen in
+    quint32 value;          // Depends on the kind
+    quint8  kind;           // NodeEventKind
+};
+
+// Timeline of one node on one interface
+struct NodeLane
+{
+    quint8  iface;          // Interface id
+    quint8  node;           // Node id
+    qint64  period;         // Heartbeat period last used for the timeout, or 0
+    bool    configured;     // True if period came from the dictionary or SDO
+    int     anomalies;      // Events that are not commands or emergencies
+    QVector<NodeInterval> intervals;    // In time order, not overlapping
+    QVector<NodeEvent> events;          // In time order
+};
+
+class NodeTimeline
+{
+public:
+    NodeTimeline();
+
+    // Removes every lane
+    void clear();
+
+    // Number of lanes
+    int size() const { return mLanes.size(); }
+    bool isEmpty() const { return mLanes.isEmpty(); }
+    // Returns a lane; lanes are ordered by interface and node
+    const NodeLane& at( int i ) const { return mLanes.at( i ); }
+
+    // True if positions are microseconds, false if frame numbers
+    bool isTimed() const { return mTimed; }
+    // Positions of the first and last frame of the table built over
+    qint64 begin() const { return mBegin; }
+    qint64 end() const { return mEnd; }
+
+    // Builds the lanes of every node heard from or commanded in the table
+    void build( const FrameTable& table, const FrameIndex& index,
+                const SdoTable& sdo, const ObjectDictionary& dictionary );
+
+    // Drops what happened before the first count frames were removed from
+    // table, and moves the frames of the rest down
+    void removeFirst( FrameId count, const FrameTable& table );
+
+    // True for the kinds of event that are anomalies
+    static bool isAnomaly( quint8 kind )
+        { return kind != EVENT_NMT_COMMAND && kind != EVENT_EMCY; }
+
+private:
+    QVector<NodeLane> mLanes;       // Lanes by interface and node
+    bool mTimed;                    // Positions are microseconds
+    qint64 mBegin;                  // Extent of the table built over
+    qint64 mEnd;
+};
+
+#endif // NODETIMELINE_H
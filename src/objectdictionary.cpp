@@ -0,0 +1,652 @@
+/*----------------------------------------------------------------------------
+
+Name		objectdictionary.cpp
+
+Purpose		CANopen object dictionaries read from EDS and DCF files.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "objectdictionary.h"
+#include "sdoassembler.h"
+#include <QFile>
+#include <algorithm>
+#include <cstring>
+
+// Communication and mapping objects of the first RPDO and TPDO; each
+// runs on for PDO_COUNT objects
+static const quint16 RPDO_COMM = 0x1400;
+static const quint16 RPDO_MAP = 0x1600;
+static const quint16 TPDO_COMM = 0x1800;
+static const quint16 TPDO_MAP = 0x1A00;
+static const int PDO_COUNT = 512;
+
+// COB-ID bit marking a PDO as not valid
+static const qint64 PDO_INVALID = 0x80000000LL;
+
+// Keys of one section of an EDS file, in lower case
+typedef QMap<QString, QString> EdsSection;
+
+/*----------------------------------------------------------------------------
+
+Name		entryBefore, objectBefore, fieldBefore
+
+Purpose		Orders entries and objects by key, and PDO fields by COB-ID then
+            bit offset
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool entryBefore( const OdEntry& a, const OdEntry& b )
+{
+    return a.key < b.key;
+}
+
+static bool objectBefore( const OdObject& a, const OdObject& b )
+{
+    return a.key < b.key;
+}
+
+static bool fieldBefore( const PdoField& a, const PdoField& b )
+{
+    return ( a.cobId != b.cobId ) ? a.cobId < b.cobId : a.bitOffset < b.bitOffset;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		parseValue
+
+Purpose		Reads a value of an EDS file: decimal, 0x hex, or either plus
+            $NODEID (e.g. $NODEID+0x180)
+
+Input       text  - value as written
+            node  - node id $NODEID stands for; 0 if not known
+            value - set to the value read
+
+Return      true if a value was read
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool parseValue( QString text, int node, qint64& value )
+{
+    text = text.trimmed().toUpper();
+
+    qint64 add = 0;
+    if ( text.contains( "$NODEID" ) )
+    {
+        if ( node <= 0 )
+            return false;
+        text.remove( "$NODEID" );
+        text.remove( '+' );
+        text = text.trimmed();
+        add = node;
+    }
+
+    bool ok;
+    if ( text.startsWith( "0X" ) )
+        value = qint64( text.mid( 2 ).toULongLong( &ok, 16 ) );
+    else
+        value = text.toLongLong( &ok, 10 );
+
+    value += add;
+    return ok;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		readEds
+
+Purpose		Splits an EDS or DCF file into its sections.  Section names are
+            upper cased and keys lower cased, as both are case blind.
+
+Input       fileName - file to read
+            sections - set to the keys of every section
+            error    - set to the reason if the file cannot be read
+
+Return      true if the file was read
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool readEds( const QString& fileName, QMap<QString, EdsSection>& sections,
+                     QString& error )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    const QStringList lines = QString::fromLatin1( file.readAll() ).split( '\n' );
+    QString section;
+    for ( int i = 0; i < lines.size(); ++i )
+    {
+        const QString line = lines.at(i).trimmed();
+        if ( line.isEmpty() || line.startsWith( ";" ) )
+            continue;
+
+        if ( line.startsWith( "[" ) && line.endsWith( "]" ) )
+        {
+            section = line.mid( 1, line.size() - 2 ).trimmed().toUpper();
+            continue;
+        }
+
+        const int eq = line.indexOf( '=' );
+        if ( eq > 0 && !section.isEmpty() )
+            sections[ section ].insert( line.left( eq ).trimmed().toLower(),
+                                        line.mid( eq + 1 ).trimmed() );
+    }
+
+    if ( sections.isEmpty() )
+    {
+        error = QObject::tr( "no sections found" );
+        return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		ObjectDictionary
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+ObjectDictionary::ObjectDictionary()
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Forgets every dictionary
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void ObjectDictionary::clear()
+{
+    mEntries.clear();
+    mObjects.clear();
+    mPdo.clear();
+    mStrings.clear();
+    mFiles.clear();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		load
+
+Purpose		Reads an EDS or DCF file into the dictionary of a node.  Every
+            section named by an index ([6083]) or subindex ([1600sub1])
+            with a DataType becomes an entry, and every named index an
+            object.  The entries of the node loaded before are dropped, the
+            arrays sorted again and the PDO fields rebuilt.
+
+Input       fileName - file to read
+            node     - node described, 0 for every node, -1 for the NodeID
+                       of a DCF (every node if it has none)
+            error    - set to the reason if the file cannot be read
+
+Return      true if the file was read
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool ObjectDictionary::load( const QString& fileName, int node, QString& error )
+{
+    QMap<QString, EdsSection> sections;
+    if ( !readEds( fileName, sections, error ) )
+        return false;
+
+    if ( node < 0 )
+    {
+        qint64 nodeId = 0;
+        parseValue( sections.value( "DEVICECOMISSIONING" ).value( "nodeid" ), 0, nodeId );
+        node = int( nodeId );
+    }
+    if ( node < 0 || node > 127 )
+    {
+        error = QObject::tr( "node %1 is out of range" ).arg( node );
+        return false;
+    }
+
+    // Drop what the node had
+    QVector<OdEntry> entries;
+    for ( int i = 0; i < mEntries.size(); ++i )
+        if ( int( mEntries.at(i).key >> 24 ) != node )
+            entries.append( mEntries.at(i) );
+    QVector<OdObject> objects;
+    for ( int i = 0; i < mObjects.size(); ++i )
+        if ( int( mObjects.at(i).key >> 16 ) != node )
+            objects.append( mObjects.at(i) );
+
+    QMap<QString, EdsSection>::const_iterator it;
+    for ( it = sections.constBegin(); it != sections.constEnd(); ++it )
+    {
+        const QString& name = it.key();
+        const EdsSection& keys = it.value();
+
+        bool ok = false;
+        const quint16 index = quint16( name.left( 4 ).toUInt( &ok, 16 ) );
+        if ( !ok || name.size() < 4 )
+            continue;
+
+        int subIndex = 0;
+        if ( name.size() > 4 )
+        {
+            if ( !name.mid( 4 ).startsWith( "SUB" ) )
+                continue;
+            subIndex = int( name.mid( 7 ).toUInt( &ok, 16 ) );
+            if ( !ok || subIndex > 0xFF )
+                continue;
+        }
+        else if ( keys.contains( "parametername" ) )
+        {
+            OdObject object;
+            object.key = ( quint32( node ) << 16 ) | index;
+            object.name = addString( keys.value( "parametername" ) );
+            objects.append( object );
+        }
+
+        qint64 type = 0;
+        if ( !parseValue( keys.value( "datatype" ), node, type ) )
+            continue;
+
+        OdEntry entry;
+        entry.key = entryKey( node, index, quint8( subIndex ) );
+        entry.type = quint16( type );
+        entry.hasValue = parseValue( keys.value( "parametervalue" ), node, entry.value )
+                      || parseValue( keys.value( "defaultvalue" ), node, entry.value );
+        if ( !entry.hasValue )
+            entry.value = 0;
+        entry.name = addString( keys.value( "parametername" ) );
+        entry.unit = keys.contains( "unit" ) ? addString( keys.value( "unit" ) ) : -1;
+
+        bool factorOk = false;
+        bool offsetOk = false;
+        entry.factor = keys.value( "factor" ).toDouble( &factorOk );
+        entry.offset = keys.value( "offset" ).toDouble( &offsetOk );
+        if ( !factorOk )
+            entry.factor = 1.0;
+        if ( !offsetOk )
+            entry.offset = 0.0;
+
+        entries.append( entry );
+    }
+
+    std::sort( entries.begin(), entries.end(), entryBefore );
+    std::sort( objects.begin(), objects.end(), objectBefore );
+    mEntries = entries;
+    mObjects = objects;
+    mFiles.insert( node, fileName );
+
+    compilePdo();
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		addString
+
+Purpose		Adds a string to the string table
+
+Return      position of the string
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int ObjectDictionary::addString( const QString& text )
+{
+    mStrings.append( text );
+    return mStrings.size() - 1;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		compilePdo
+
+Purpose		Rebuilds the PDO fields.  For every node with a dictionary of its
+            own, each RPDO and TPDO whose COB-ID (subindex 1 of its
+            communication object) is valid contributes the objects of its
+            mapping object, in order, each 32 bit mapping value giving the
+            index, subindex and length of a field.  A dictionary for every
+            node maps nothing, as $NODEID cannot be resolved for it.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void ObjectDictionary::compilePdo()
+{
+    mPdo.clear();
+
+    QMap<int, QString>::const_iterator it;
+    for ( it = mFiles.constBegin(); it != mFiles.constEnd(); ++it )
+    {
+        const int node = it.key();
+        if ( node == 0 )
+            continue;
+
+        for ( int n = 0; n < 2 * PDO_COUNT; ++n )
+        {
+            const bool receive = n < PDO_COUNT;
+            const quint16 comm = quint16( ( receive ? RPDO_COMM : TPDO_COMM ) + n % PDO_COUNT );
+            const quint16 map = quint16( ( receive ? RPDO_MAP : TPDO_MAP ) + n % PDO_COUNT );
+
+            const OdEntry* cobId = findKey( entryKey( node, comm, 1 ) );
+            const OdEntry* count = findKey( entryKey( node, map, 0 ) );
+            if ( !cobId || !count || !cobId->hasValue || !count->hasValue
+                 || ( cobId->value & PDO_INVALID ) )
+                continue;
+
+            int bit = 0;
+            for ( int s = 1; s <= count->value && s <= 0x40; ++s )
+            {
+                const OdEntry* mapping = findKey( entryKey( node, map, quint8( s ) ) );
+                if ( !mapping || !mapping->hasValue )
+                    break;
+
+                const quint32 value = quint32( mapping->value );
+                const int bits = value & 0xFF;
+                if ( bits == 0 || bit + bits > 64 )
+                    break;
+
+                PdoField field;
+                field.cobId = quint32( cobId->value ) & 0x1FFFFFFF;
+                field.node = quint8( node );
+                field.bitOffset = quint8( bit );
+                field.bits = quint8( bits );
+                field.receive = receive;
+                field.objKey = value >> 8;
+
+                const OdEntry* object = find( node, quint16( value >> 16 ), quint8( value >> 8 ) );
+                field.entry = object ? int( object - mEntries.constData() ) : -1;
+
+                mPdo.append( field );
+                bit += bits;
+            }
+        }
+    }
+
+    std::sort( mPdo.begin(), mPdo.end(), fieldBefore );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		findKey
+
+Purpose		Binary search of the entries for a key
+
+Return      the entry, or 0 if there is none
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+const OdEntry* ObjectDictionary::findKey( quint32 key ) const
+{
+    OdEntry probe;
+    probe.key = key;
+    const OdEntry* begin = mEntries.constData();
+    const OdEntry* end = begin + mEntries.size();
+    const OdEntry* found = std::lower_bound( begin, end, probe, entryBefore );
+
+    return ( found != end && found->key == key ) ? found : 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		find
+
+Purpose		Returns the entry of a node's object, from the node's own
+            dictionary if it has one, else from a dictionary for every node
+
+Input       node     - node id
+            index    - object index
+            subIndex - subindex
+
+Return      the entry, or 0 if there is none
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+const OdEntry* ObjectDictionary::find( int node, quint16 index, quint8 subIndex ) const
+{
+    const OdEntry* found = findKey( entryKey( node, index, subIndex ) );
+    if ( !found && node != 0 )
+        found = findKey( entryKey( 0, index, subIndex ) );
+
+    return found;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		indicesNamed
+
+Purpose		Returns the indices of the objects (or, for objects without a
+            name of their own, entries) whose name contains some text
+
+Input       text - text to look for, in any case
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVector<quint16> ObjectDictionary::indicesNamed( const QString& text ) const
+{
+    QVector<quint16> indices;
+    if ( text.isEmpty() )
+        return indices;
+
+    for ( int i = 0; i < mObjects.size(); ++i )
+    {
+        if ( mStrings.at( mObjects.at(i).name ).contains( text, Qt::CaseInsensitive ) )
+            indices.append( quint16( mObjects.at(i).key ) );
+    }
+    for ( int i = 0; i < mEntries.size(); ++i )
+    {
+        if ( mStrings.at( mEntries.at(i).name ).contains( text, Qt::CaseInsensitive ) )
+            indices.append( quint16( mEntries.at(i).key >> 8 ) );
+    }
+
+    std::sort( indices.begin(), indices.end() );
+    indices.erase( std::unique( indices.begin(), indices.end() ), indices.end() );
+    return indices;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		pdoFields
+
+Purpose		Returns the fields of the PDOs sent with a COB-ID, by binary
+            search of the sorted fields
+
+Input       cobId - COB-ID of the PDO
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVector<PdoField> ObjectDictionary::pdoFields( quint32 cobId ) const
+{
+    PdoField probe;
+    probe.cobId = cobId;
+    probe.bitOffset = 0;
+    const PdoField* begin = mPdo.constData();
+    const PdoField* end = begin + mPdo.size();
+
+    QVector<PdoField> fields;
+    for ( const PdoField* f = std::lower_bound( begin, end, probe, fieldBefore );
+          f != end && f->cobId == cobId; ++f )
+        fields.append( *f );
+
+    return fields;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		format
+
+Purpose		Formats a raw value by the data type of its entry.  Integers are
+            sign extended from their length, reals read from their bits and
+            strings from their bytes; scaled values are shown as a number
+            and units appended.
+
+Input       entry - entry the value belongs to
+            raw   - value, byte 0 in the least significant byte
+            bits  - length of the value in bits
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QString ObjectDictionary::format( const OdEntry& entry, quint64 raw, int bits ) const
+{
+    if ( bits < 64 )
+        raw &= ( quint64( 1 ) << bits ) - 1;
+
+    double number = 0;
+    QString text;
+    switch ( entry.type )
+    {
+    case OD_BOOLEAN:
+        number = raw ? 1 : 0;
+        text = raw ? "TRUE" : "FALSE";
+        break;
+
+    case OD_INTEGER8:
+    case OD_INTEGER16:
+    case OD_INTEGER24:
+    case OD_INTEGER32:
+    case OD_INTEGER40:
+    case OD_INTEGER48:
+    case OD_INTEGER56:
+    case OD_INTEGER64:
+    {
+        qint64 value = qint64( raw );
+        if ( bits > 0 && bits < 64 && ( raw >> ( bits - 1 ) ) & 1 )
+            value = qint64( raw | ~( ( quint64( 1 ) << bits ) - 1 ) );
+        number = double( value );
+        text = QString::number( value );
+        break;
+    }
+
+    case OD_REAL32:
+    {
+        quint32 word = quint32( raw );
+        float value;
+        memcpy( &value, &word, sizeof( value ) );
+        number = value;
+        text = QString::number( double( value ), 'g', 7 );
+        break;
+    }
+
+    case OD_REAL64:
+    {
+        double value;
+        memcpy( &value, &raw, sizeof( value ) );
+        number = value;
+        text = QString::number( value, 'g', 15 );
+        break;
+    }
+
+    case OD_VISIBLE_STRING:
+    {
+        char bytes[ 8 ];
+        int n = 0;
+        for ( ; n < bits / 8 && ( raw >> ( n * 8 ) ) & 0xFF; ++n )
+            bytes[n] = char( raw >> ( n * 8 ) );
+        return "\"" + QString::fromLatin1( bytes, n ) + "\"";
+    }
+
+    case OD_UNSIGNED8:
+    case OD_UNSIGNED16:
+    case OD_UNSIGNED24:
+    case OD_UNSIGNED32:
+    case OD_UNSIGNED40:
+    case OD_UNSIGNED48:
+    case OD_UNSIGNED56:
+    case OD_UNSIGNED64:
+        number = double( raw );
+        text = QString::number( raw );
+        break;
+
+    default:
+        return "0x" + QString::number( raw, 16 ).toUpper();
+    }
+
+    if ( entry.factor != 1.0 || entry.offset != 0.0 )
+        text = QString::number( number * entry.factor + entry.offset, 'g', 10 );
+    if ( entry.unit >= 0 )
+        text += " " + mStrings.at( entry.unit );
+
+    return text;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		decode
+
+Purpose		Describes a frame from the dictionary:
+
+                SDO - "index.sub name", with "= value" when the frame
+                      opens an expedited download or answers an expedited
+                      upload
+                PDO - "name = value" for every mapped field the frame is
+                      long enough to hold, from the sender's TPDO mapping
+                      if known, else from the receivers' RPDO mappings
+
+Input       cobId  - COB-ID of the frame
+            dlc    - its length
+            data   - its payload, byte 0 in the least significant byte
+            sdoKey - its SDO key (see SdoTable::frameKey)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QString ObjectDictionary::decode( quint32 cobId, quint8 dlc, quint64 data, quint32 sdoKey ) const
+{
+    if ( mEntries.isEmpty() )
+        return QString();
+
+    // SDO frames carry the node in the low bits of their COB-ID
+    if ( sdoKey != NO_SDO_KEY )
+    {
+        const int node = cobId & 0x7F;
+        const quint16 index = quint16( sdoKey >> 8 );
+        const quint8 subIndex = quint8( sdoKey );
+        const OdEntry* entry = find( node, index, subIndex );
+        if ( !entry )
+            return QString();
+
+        QString text = QString( "%1.%2 %3" )
+               .arg( QString::number( index, 16 ).toUpper().rightJustified( 4, '0' ) )
+               .arg( QString::number( subIndex, 16 ).toUpper().rightJustified( 2, '0' ) )
+               .arg( mStrings.at( entry->name ) );
+
+        // Initiate download (client) or initiate upload response (server),
+        // expedited
+        const quint8 command = quint8( data );
+        const quint32 function = cobId & 0x780;
+        const bool download = function == 0x600 && ( command & 0xE0 ) == 0x20;
+        const bool upload = function == 0x580 && ( command & 0xE0 ) == 0x40;
+        if ( ( download || upload ) && ( command & 0x02 ) && dlc >= 8 )
+        {
+            const int bytes = ( command & 0x01 ) ? 4 - ( ( command >> 2 ) & 0x03 ) : 4;
+            text += " = " + format( *entry, data >> 32, bytes * 8 );
+        }
+
+        return text;
+    }
+
+    // When the sender's TPDO and a receiver's RPDO share the COB-ID, the
+    // sender's mapping is the one shown
+    const QVector<PdoField> pdo = pdoFields( cobId );
+    bool transmit = false;
+    for ( int i = 0; i < pdo.size(); ++i )
+        transmit |= !pdo.at(i).receive;
+
+    QStringList fields;
+    for ( int i = 0; i < pdo.size(); ++i )
+    {
+        const PdoField& field = pdo.at(i);
+        if ( field.entry < 0 || ( transmit && field.receive )
+             || field.bitOffset + field.bits > dlc * 8 )
+            continue;
+
+        const OdEntry& entry = mEntries.at( field.entry );
+        fields << mStrings.at( entry.name ) + " = "
+                  + format( entry, data >> field.bitOffset, field.bits );
+    }
+
+    return fields.join( ", " );
+}
@@ -0,0 +1,162 @@
+/*----------------------------------------------------------------------------
+
+Name		objectdictionary.h
+
+Purpose		CANopen object dictionaries read from EDS and DCF files, one per
+            node (or one for every node), compiled into sorted arrays:
+
+                entries - name, data type, scaling and value of every
+                          (node, index, subindex), found by binary search
+                          on a 32 bit key
+                objects - name of every (node, index), so an object name
+                          can be resolved to its indices once when a filter
+                          is compiled
+                PDOs    - the fields each PDO COB-ID carries, from the
+                          communication (0x1400 / 0x1800) and mapping
+                          (0x1600 / 0x1A00) objects of each node
+
+            Nothing is decoded while a dump is read; decode() describes one
+            frame when its row is drawn.
+
+            Scaling is not part of CiA 306.  Entries may give it with the
+            optional keys Factor, Offset and Unit, and values are shown as
+            raw * Factor + Offset.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef OBJECTDICTIONARY_H
+#define OBJECTDICTIONARY_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// CANopen basic data types (CiA 301), as written in DataType
+enum OdType
+{
+    OD_BOOLEAN          = 0x01,
+    OD_INTEGER8         = 0x02,
+    OD_INTEGER16        = 0x03,
+    OD_INTEGER32        = 0x04,
+    OD_UNSIGNED8        = 0x05,
+    OD_UNSIGNED16       = 0x06,
+    OD_UNSIGNED32       = 0x07,
+    OD_REAL32           = 0x08,
+    OD_VISIBLE_STRING   = 0x09,
+    OD_OCTET_STRING     = 0x0A,
+    OD_UNICODE_STRING   = 0x0B,
+    OD_DOMAIN           = 0x0F,
+    OD_INTEGER24        = 0x10,
+    OD_REAL64           = 0x11,
+    OD_INTEGER40        = 0x12,
+    OD_INTEGER48        = 0x13,
+    OD_INTEGER56        = 0x14,
+    OD_INTEGER64        = 0x15,
+    OD_UNSIGNED24       = 0x16,
+    OD_UNSIGNED40       = 0x18,
+    OD_UNSIGNED48       = 0x19,
+    OD_UNSIGNED56       = 0x1A,
+    OD_UNSIGNED64       = 0x1B
+};
+
+// One (node, index, subindex) of a dictionary
+struct OdEntry
+{
+    quint32 key;            // node << 24 | index << 8 | subindex; node 0 for every node
+    quint16 type;           // Data type (OdType), 0 if not given
+    bool    hasValue;       // True if the file gave a value
+    qint64  value;          // ParameterValue (DCF) or DefaultValue
+    int     name;           // Name, in the string table
+    int     unit;           // Unit in the string table, or -1
+    double  factor;         // Scaling: shown value = raw * factor + offset
+    double  offset;
+};
+
+// Name of one (node, index)
+struct OdObject
+{
+    quint32 key;            // node << 16 | index
+    int     name;           // Name, in the string table
+};
+
+// One field of a PDO
+struct PdoField
+{
+    quint32 cobId;          // COB-ID of the PDO
+    quint8  node;           // Node the mapping was read from
+    quint8  bitOffset;      // First bit of the field in the payload
+    quint8  bits;           // Length of the field in bits
+    bool    receive;        // True for an RPDO of the node, false for a TPDO
+    quint32 objKey;         // Object mapped: index << 8 | subindex
+    int     entry;          // Entry of the object, or -1 if not in the dictionary
+};
+
+class ObjectDictionary
+{
+public:
+    ObjectDictionary();
+
+    // Forgets every dictionary
+    void clear();
+    // Returns true if no dictionary is loaded
+    bool isEmpty() const { return mEntries.isEmpty(); }
+    // Returns the files loaded, by node (0 for every node)
+    const QMap<int, QString>& files() const { return mFiles; }
+
+    // Reads an EDS or DCF file and compiles it in, replacing any loaded
+    // for the same node.  node is the node it describes, 0 for every node
+    // or -1 to take the NodeID of a DCF.  Returns false, with the reason
+    // in error, if the file cannot be read.
+    bool load( const QString& fileName, int node, QString& error );
+
+    // Returns the entry of a node's object, falling back to a dictionary
+    // for every node, or 0 if there is none
+    const OdEntry* find( int node, quint16 index, quint8 subIndex ) const;
+    // Returns an entry by position, as given in PdoField::entry
+    const OdEntry& entry( int i ) const { return mEntries.at( i ); }
+    // Returns the position of an entry returned by find(), or -1 for none
+    int entryIndex( const OdEntry* entry ) const
+        { return entry ? int( entry - mEntries.constData() ) : -1; }
+    // Returns a string of the string table (names and units)
+    const QString& string( int i ) const { return mStrings.at( i ); }
+
+    // Returns the object indices whose name contains text (any case), in
+    // order and without repeats
+    QVector<quint16> indicesNamed( const QString& text ) const;
+
+    // Returns the fields of the PDOs sent with a COB-ID, in bit order
+    QVector<PdoField> pdoFields( quint32 cobId ) const;
+    // Returns every PDO field, by COB-ID then bit order
+    const QVector<PdoField>& pdoFields() const { return mPdo; }
+
+    // Formats a raw value of an entry (bits long, little endian) by its
+    // data type and scaling
+    QString format( const OdEntry& entry, quint64 raw, int bits ) const;
+
+    // Describes a frame: the object of an SDO (with the value of an
+    // expedited transfer), or the mapped fields of a PDO.  Returns an
+    // empty string for other frames and objects not in the dictionary.
+    QString decode( quint32 cobId, quint8 dlc, quint64 data, quint32 sdoKey ) const;
+
+    // Returns the key of an entry
+    static quint32 entryKey( int node, quint16 index, quint8 subIndex )
+        { return ( quint32( node ) << 24 ) | ( quint32( index ) << 8 ) | subIndex; }
+
+private:
+    // Returns the entry with exactly the given key, or 0
+    const OdEntry* findKey( quint32 key ) const;
+    // Adds a string to the string table and returns its position
+    int addString( const QString& text );
+    // Rebuilds the PDO fields from the communication and mapping objects
+    void compilePdo();
+
+private:
+    QVector<OdEntry> mEntries;      // Entries, sorted by key
+    QVector<OdObject> mObjects;     // Object names, sorted by key
+    QVector<PdoField> mPdo;         // PDO fields, by COB-ID then bit offset
+    QStringList mStrings;           // Names and units
+    QMap<int, QString> mFiles;      // File loaded for each node
+};
+
+#endif // OBJECTDICTIONARY_H
@@ -17,6 +17,32 @@ History		12 May 18  AFB	Created
 ----------------------------------------------------------------------------*/
 
 #include "parser.h"
+#include "capturefile.h"
+#include "frameingest.h"
+#include "stageprofile.h"
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QtConcurrent>
+#include <algorithm>
+#include <limits>
+
+// Number of frames tested between checks for cancellation
+static const int FILTER_BLOCK = 1 << 20;
+
+// Delay used to coalesce bursts of filter changes (ms)
+static const int PARSE_DELAY = 50;
+
+// Fewest live frames left out of the index before it is rebuilt
+static const int REINDEX_MIN = 64 * 1024;
+
+// Frames merged from several dumps per pass of the event loop
+static const int MERGE_BLOCK = 256 * 1024;
+
+// Frames are evicted once the table is past a limit by this fraction of
+// it, so each eviction (and the index rebuild after it) covers a batch
+static const int EVICT_SLACK = 8;
 
 /*----------------------------------------------------------------------------
 
@@ -27,55 +53,461 @@ Purpose		Constructor
 History		12 May 18  AFB	Created
 ----------------------------------------------------------------------------*/
 Parser::Parser( )
-    : mMap( createRefMap() )
+    : mMatchesComplete( false ),
+      mMap( createRefMap() ),
+      mMaxFrames( 0 ),
+      mHorizon( 0 ),
+      mEvicted( 0 ),
+      mSpilling( false )
 {
+    qRegisterMetaType< QVector<FrameId> >( "QVector<FrameId>" );
+
+    mParseTimer.setSingleShot( true );
+    mParseTimer.setInterval( PARSE_DELAY );
+    connect( &mParseTimer,  SIGNAL( timeout() ),
+             this,          SLOT( parse() ) );
 
+    mMergeTimer.setInterval( 0 );
+    connect( &mMergeTimer,  SIGNAL( timeout() ),
+             this,          SLOT( mergeFrames() ) );
 }
 
 /*----------------------------------------------------------------------------
 
-Name		setText
+Name		~Parser
 
-Purpose		Set the text for the parser to parse
+Purpose		Destructor.  Stops any background parse before the frame table
+            goes away.
 
-Input       text - Text to parse
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Waits for the last spill file
+            17 Oct 26  AFB	Unmaps the dump files
+----------------------------------------------------------------------------*/
+Parser::~Parser()
+{
+    cancelParse();
 
-History		12 May 18  AFB	Created
+    if ( mSpilling )
+        mSpillFuture.waitForFinished();
+
+    unmapDumps();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		loadFile
+
+Purpose		Memory maps a dump file and tokenizes it into the frame table.
+            The file is never copied into a QString; it is split into newline
+            aligned chunks which are tokenized straight from the mapping on
+            the thread pool, and the mapping is kept so matching lines can be
+            shown without a copy of the text.
+
+Input       fileName - path of the dump to load
+
+Return      true if the file was mapped, false otherwise
+
+History		12 May 18  AFB	Created as setText
+            17 Oct 26  AFB	Maps the file instead of taking a copy of the text
+            17 Oct 26  AFB	Tokenizes chunks in parallel
+            17 Oct 26  AFB	Builds the frame index
+            17 Oct 26  AFB	Restores capture files
+            17 Oct 26  AFB	Reassembles SDO transfers
+            17 Oct 26  AFB	Maps the file through mapDump
+            17 Oct 26  AFB	Hands the text to the line search
 ----------------------------------------------------------------------------*/
-void Parser::setText(const QString& text)
+bool Parser::loadFile( const QString& fileName )
 {
-    mText = text;
+    unload();
+
+    if ( !mapDump( fileName ) )
+        return false;
+
+    const MappedDump& dump = mDumps.first();
+    if ( CaptureFile::isCapture( dump.raw, dump.size ) )
+        return loadCapture();
+
+    IngestReport report = FrameIngest::parseParallel( dump.raw, dump.raw + dump.size, mTable );
+
+    TextBlock text;
+    text.begin = dump.raw;
+    text.end = dump.raw + dump.size;
+    text.offset = dump.base;
+    mSearch.setTexts( QVector<TextBlock>() << text );
+
+    QElapsedTimer indexTimer;
+    indexTimer.start();
+    mIndex.build( mTable );
+    mAssembler.build( mTable, mIndex, mSdo );
+    qint64 indexMsecs = indexTimer.elapsed();
+
+    QStringList rates;
+    QMap<Qt::HANDLE, double>::const_iterator it;
+    for ( it = report.threadMBps.constBegin(); it != report.threadMBps.constEnd(); ++it )
+        rates << QString::number( it.value(), 'f', 0 );
+
+    emit statusChanged( tr( "Loaded %1 frames (%2 MB) in %3 ms, %4 lines skipped."
+                            "  Per-thread MB/s: %5.  Indexed in %6 ms, %7 SDO transfers." )
+                        .arg( mTable.size() )
+                        .arg( report.bytes / ( 1024 * 1024 ) )
+                        .arg( report.nsecs / 1000000 )
+                        .arg( report.skipped )
+                        .arg( rates.join( ", " ) )
+                        .arg( indexMsecs )
+                        .arg( mSdo.size() ) );
+
     parse();
+    return true;
 }
 
 /*----------------------------------------------------------------------------
 
-Name		splitOnNonAlphaNum
+Name		loadFiles
 
-Purpose		Split a string on non-alphanumeric characters
+Purpose		Memory maps several dumps, tokenizes each on the thread pool and
+            merges their frames into the table in timestamp order.  Each
+            dump's offsets are moved past those of the dumps before it, so
+            line() can tell which mapping a frame's text is in.  Capture
+            files merge too, but have no text to show.
 
-Input       str - str to split
+            The first block of the merge is indexed and parsed straight away;
+            mergeFrames takes in the rest, a block per pass of the event
+            loop, by the same path as frames read live.
 
-History		12 May 18  AFB	Created
+Input       fileNames - paths of the dumps to load
+
+Return      true if every file was mapped, false otherwise
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Hands the text of the dumps to the line search
 ----------------------------------------------------------------------------*/
-QStringList splitOnNonAlphaNum( QString str )
+bool Parser::loadFiles( const QStringList& fileNames )
 {
-    return str.split(QRegExp(QString::fromUtf8("[-`~!@#$%^&*()_—+=|:;<>«»,.?/{}\'\"\\\[\\\]\\\\]")), QString::SkipEmptyParts);
+    if ( fileNames.size() == 1 )
+        return loadFile( fileNames.first() );
+
+    unload();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for ( int i = 0; i < fileNames.size(); ++i )
+    {
+        if ( !mapDump( fileNames.at(i) ) )
+        {
+            unload();
+            return false;
+        }
+    }
+
+    int skipped = 0;
+    QVector<TextBlock> texts;
+    for ( int i = 0; i < mDumps.size(); ++i )
+    {
+        const MappedDump& dump = mDumps.at(i);
+        FrameTable table;
+
+        if ( CaptureFile::isCapture( dump.raw, dump.size ) )
+        {
+            FrameIndex index;
+            QString error;
+            if ( !CaptureFile::load( dump.raw, dump.size, table, index, error ) )
+            {
+                emit statusChanged( tr( "Unable to open capture %1: %2" )
+                                    .arg( dump.file->fileName() ).arg( error ) );
+                unload();
+                return false;
+            }
+            mMerger.addInput( table, -1 );
+        }
+        else
+        {
+            IngestReport report = FrameIngest::parseParallel( dump.raw, dump.raw + dump.size,
+                                                              table );
+            skipped += report.skipped;
+            mMerger.addInput( table, dump.base );
+
+            TextBlock text;
+            text.begin = dump.raw;
+            text.end = dump.raw + dump.size;
+            text.offset = dump.base;
+            texts.append( text );
+        }
+    }
+    mSearch.setTexts( texts );
+
+    const qint64 frames = mMerger.remaining();
+    mMerger.merge( mTable, MERGE_BLOCK );
+    mIndex.build( mTable );
+    mAssembler.build( mTable, mIndex, mSdo );
+
+    emit statusChanged( tr( "Loaded %1 frames from %2 files (%3 MB) in %4 ms, %5 lines skipped."
+                            "  Merging by timestamp..." )
+                        .arg( frames )
+                        .arg( mDumps.size() )
+                        .arg( loadedBytes() / ( 1024 * 1024 ) )
+                        .arg( timer.elapsed() )
+                        .arg( skipped ) );
+
+    parse();
+
+    if ( !mMerger.atEnd() )
+        mMergeTimer.start();
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mergeFrames
+
+Purpose		Merges the next block of frames of the loaded dumps and hands it
+            to appendFrames, which filters it (or holds it back while a parse
+            is running) as it would frames read live
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::mergeFrames()
+{
+    FrameTable block;
+    mMerger.merge( block, MERGE_BLOCK );
+    appendFrames( block );
+
+    if ( !mMerger.atEnd() )
+        return;
+
+    mMergeTimer.stop();
+    emit statusChanged( tr( "Merged %1 frames from %2 files" )
+                        .arg( mTable.size() + mPendingFrames.size() + mEvicted )
+                        .arg( mDumps.size() ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mapDump
+
+Purpose		Opens and memory maps a dump file after those already mapped.
+            Its offsets start where the last dump's end.
+
+Input       fileName - path of the dump
+
+Return      true if the file was mapped
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool Parser::mapDump( const QString& fileName )
+{
+    QFile* file = new QFile( fileName );
+    if ( !file->open( QIODevice::ReadOnly ) || file->size() == 0 )
+    {
+        delete file;
+        return false;
+    }
+
+    uchar* map = file->map( 0, file->size() );
+    if ( !map )
+    {
+        delete file;
+        return false;
+    }
+
+    MappedDump dump;
+    dump.file = file;
+    dump.raw = reinterpret_cast<const char*>( map );
+    dump.size = file->size();
+    dump.base = mDumps.isEmpty() ? 0 : mDumps.last().base + mDumps.last().size;
+    mDumps.append( dump );
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		unmapDumps
+
+Purpose		Unmaps and closes every dump file
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Clears the line search first
+----------------------------------------------------------------------------*/
+void Parser::unmapDumps()
+{
+    mSearch.clear();
+
+    for ( int i = 0; i < mDumps.size(); ++i )
+    {
+        QFile* file = mDumps.at(i).file;
+        file->unmap( reinterpret_cast<uchar*>( const_cast<char*>( mDumps.at(i).raw ) ) );
+        delete file;
+    }
+
+    mDumps.clear();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		releaseDumps
+
+Purpose		Lets go of the dumps once the followed file has been truncated.
+            Reading the mapping of a file that has shrunk raises SIGBUS, so
+            the line search is stopped, the dumps are unmapped and the frames
+            forget their offsets before anything reads the old lines again.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::releaseDumps()
+{
+    if ( mDumps.isEmpty() )
+        return;
+
+    unmapDumps();
+    mTable.clearOffsets();
+    mPendingFrames.clearOffsets();
+
+    emit matchesChanged( mMatches );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		loadedBytes
+
+Purpose		Returns the bytes of the mapped dumps
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+qint64 Parser::loadedBytes() const
+{
+    qint64 bytes = 0;
+    for ( int i = 0; i < mDumps.size(); ++i )
+        bytes += mDumps.at(i).size;
+
+    return bytes;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		loadCapture
+
+Purpose		Restores the frame table and index from the mapped capture file.
+            A capture holds no text, so the mapping is let go once the
+            columns have been filled.
+
+Return      true if the capture was restored
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Reassembles SDO transfers
+            17 Oct 26  AFB	Reads the capture from the mapped dumps
+----------------------------------------------------------------------------*/
+bool Parser::loadCapture()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    const MappedDump& dump = mDumps.first();
+    bool ok = CaptureFile::load( dump.raw, dump.size, mTable, mIndex, error );
+    unmapDumps();
+
+    if ( !ok )
+    {
+        emit statusChanged( tr( "Unable to open capture: %1" ).arg( error ) );
+        return false;
+    }
+
+    mAssembler.build( mTable, mIndex, mSdo );
+
+    emit statusChanged( tr( "Opened capture of %1 frames in %2 ms" )
+                        .arg( mTable.size() )
+                        .arg( timer.elapsed() ) );
+
+    parse();
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		saveCapture
+
+Purpose		Saves the frames and their index to a binary capture file
+
+Input       fileName - file to write
+            error    - set to the reason if the save fails
+
+Return      true if the file was written
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool Parser::saveCapture( const QString& fileName, QString& error ) const
+{
+    return CaptureFile::save( fileName, mTable, mIndex, error );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		exportLog
+
+Purpose		Writes the frames out as a candump -l log
+
+Input       fileName - file to write
+            error    - set to the reason if the export fails
+
+Return      true if the file was written
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool Parser::exportLog( const QString& fileName, QString& error ) const
+{
+    return CaptureFile::exportLog( fileName, mTable, error );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		unload
+
+Purpose		Unmaps the current dump file and clears the frame table
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Resets the evicted frame count
+            17 Oct 26  AFB	Unmaps every dump and drops any merge
+            17 Oct 26  AFB	Drops the PDO signals
+            17 Oct 26  AFB	Tells the frames have gone
+            17 Oct 26  AFB	Drops the node timeline
+----------------------------------------------------------------------------*/
+void Parser::unload()
+{
+    cancelParse();
+    mMergeTimer.stop();
+    mMerger.clear();
+
+    const FrameId removed = FrameId( mTable.size() );
+    mTable.clear();
+    mIndex.clear();
+    mAssembler.clear();
+    mSdo.clear();
+    mSignals.clear();
+    mTimeline.clear();
+    mPendingFrames.clear();
+    mMatches.clear();
+    mMatchesComplete = false;
+    mEvicted = 0;
+    emit matchesChanged( mMatches );
+    emit framesRemoved( removed );
+
+    unmapDumps();
 }
 
 /*----------------------------------------------------------------------------
 
-Name		splitOnWhiteSpace
+Name		splitOnNonAlphaNum
 
-Purpose		Split a string on white space
+Purpose		Split a string on non-alphanumeric characters
 
 Input       str - str to split
 
 History		12 May 18  AFB	Created
 ----------------------------------------------------------------------------*/
-QStringList splitOnWhiteSpace( QString str )
+QStringList splitOnNonAlphaNum( QString str )
 {
-    return str.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    return str.split(QRegExp(QString::fromUtf8("[-`~!@#$%^&*()_—+=|:;<>«»,.?/{}\'\"\\\[\\\]\\\\]")), QString::SkipEmptyParts);
 }
 
 /*----------------------------------------------------------------------------
@@ -91,7 +523,7 @@ History		12 May 18  AFB	Created
 void Parser::setPort(QString port)
 {
     mPorts = splitOnNonAlphaNum(port);
-    parse();
+    scheduleParse();
 }
 
 /*----------------------------------------------------------------------------
@@ -107,7 +539,7 @@ History		12 May 18  AFB	Created
 void Parser::setAddr(QString addr)
 {
     mAddrs = splitOnNonAlphaNum(addr);
-    parse();
+    scheduleParse();
 }
 
 /*----------------------------------------------------------------------------
@@ -119,11 +551,54 @@ Purpose		Set the object indices of SDOs to filter
 Input       objIdx - string containing all object indices to filter
 
 History		12 May 18  AFB	Created
+            17 Oct 26  AFB	Keeps the text; names are resolved by objIdxs
 ----------------------------------------------------------------------------*/
 void Parser::setObjIdx(QString objIdx)
 {
-    mObjIdxs = splitOnNonAlphaNum(objIdx);
-    parse();
+    mObjIdx = objIdx;
+    scheduleParse();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		objIdxs
+
+Purpose		Returns the object indices to filter.  Each comma separated term
+            is taken as hex indices if all its words are hex, and otherwise
+            as part of an object name, resolved once here to the indices of
+            every object in the dictionaries whose name holds it.  A name
+            found nowhere is passed on as is, so it matches nothing.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QStringList Parser::objIdxs() const
+{
+    QStringList idxs;
+    const QStringList terms = mObjIdx.split( ',', QString::SkipEmptyParts );
+    for ( int i = 0; i < terms.size(); ++i )
+    {
+        const QStringList words = splitOnNonAlphaNum( terms.at(i) );
+        bool hex = true;
+        for ( int w = 0; w < words.size() && hex; ++w )
+        {
+            bool ok;
+            hex = words.at(w).toUInt( &ok, 16 ) < 0x10000 && ok;
+        }
+
+        if ( hex )
+        {
+            idxs += words;
+            continue;
+        }
+
+        const QVector<quint16> named = mDictionary.indicesNamed( terms.at(i).trimmed() );
+        if ( named.isEmpty() )
+            idxs << terms.at(i).trimmed();
+        for ( int n = 0; n < named.size(); ++n )
+            idxs << QString::number( named.at(n), 16 );
+    }
+
+    return idxs;
 }
 
 /*----------------------------------------------------------------------------
@@ -139,7 +614,62 @@ History		12 May 18  AFB	Created
 void Parser::setSubIdx(QString subIdx)
 {
     mSubIdxs = splitOnNonAlphaNum(subIdx);
-    parse();
+    scheduleParse();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setTimeFrom
+
+Purpose		Set the start of the timestamp window
+
+Input       from - seconds, or seconds back from the latest frame if negative
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::setTimeFrom( QString from )
+{
+    mTimeFrom = from.trimmed();
+    scheduleParse();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setTimeTo
+
+Purpose		Set the end of the timestamp window
+
+Input       to - seconds, or seconds back from the latest frame if negative
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::setTimeTo( QString to )
+{
+    mTimeTo = to.trimmed();
+    scheduleParse();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setPayload
+
+Purpose		Set the payload predicates.  A term that cannot be read is
+            reported on the status bar and the payload filter is dropped.
+
+Input       payload - terms joined by commas (see FrameFilter::setPayload)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::setPayload( QString payload )
+{
+    mPayload = payload.trimmed();
+
+    FrameFilter check;
+    QString badTerm;
+    if ( !check.setPayload( mPayload, badTerm ) )
+        emit statusChanged( tr( "Payload filter ignored: unable to read \"%1\"" ).arg( badTerm ) );
+
+    scheduleParse();
 }
 
 /*----------------------------------------------------------------------------
@@ -157,7 +687,7 @@ void Parser::addType(PacketType type)
     if ( !mTypes.contains( type ) )
         mTypes.push_back( type );
 
-    parse();
+    scheduleParse();
 }
 
 /*----------------------------------------------------------------------------
@@ -175,7 +705,7 @@ void Parser::removeType(PacketType type)
     if ( mTypes.contains( type ) )
         mTypes.remove( mTypes.indexOf( type )  );
 
-    parse();
+    scheduleParse();
 }
 
 /*----------------------------------------------------------------------------
@@ -211,215 +741,697 @@ PktMap Parser::createRefMap()
 
 /*----------------------------------------------------------------------------
 
-Name		checkPort
+Name		compileFilters
 
-Purpose		Returns true if the port found in the given QStringList is within
-            the filter
+Purpose		Converts the filter strings into the compiled filter.  Negative
+            window bounds are taken back from the latest frame at the time
+            of the call, so the window does not slide as live frames arrive.
 
-Input       lst - Tokenized line of file
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Compiles the timestamp window
+            17 Oct 26  AFB	Compiles the payload predicates
+            17 Oct 26  AFB	Resolves object names through objIdxs
+----------------------------------------------------------------------------*/
+void Parser::compileFilters()
+{
+    QVector<uint> funcs;
+    for ( int i = 0; i < mTypes.size(); ++i )
+        funcs.append( mMap.value( mTypes.at(i) ) );
 
-Return      true if port is in test list or the list is empty, false
-            if not
+    mFilter.compile( mPorts, mAddrs, objIdxs(), mSubIdxs, funcs, mTable.ifaces() );
 
-History		12 May 18  AFB	Created
+    // A bad term was reported when it was entered
+    QString badTerm;
+    mFilter.setPayload( mPayload, badTerm );
+
+    bool fromOk = false;
+    bool toOk = false;
+    double from = mTimeFrom.toDouble( &fromOk );
+    double to = mTimeTo.toDouble( &toOk );
+    if ( !fromOk && !toOk )
+    {
+        mFilter.clearTimeWindow();
+        return;
+    }
+
+    qint64 latest = mIndex.latestTime();
+    for ( int i = mIndex.size(); i < mTable.size(); ++i )
+        latest = qMax( latest, mTable.time( FrameId( i ) ) );
+    latest = qMax( latest, qint64( 0 ) );
+
+    qint64 fromUs = 0;
+    qint64 toUs = std::numeric_limits<qint64>::max();
+    if ( fromOk )
+        fromUs = ( from < 0 ) ? latest + qint64( from * 1e6 ) : qint64( from * 1e6 );
+    if ( toOk )
+        toUs = ( to < 0 ) ? latest + qint64( to * 1e6 ) : qint64( to * 1e6 );
+
+    mFilter.setTimeWindow( fromUs, toUs );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		line
+
+Purpose		Returns the original text of a frame.  Frames read live have no
+            text in the mapping and are written out from the table instead.
+
+Input       frame - frame whose line is returned
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Times the materialize stage
+            17 Oct 26  AFB	Reads the line from whichever dump holds it
+            17 Oct 26  AFB	Reads the text through rawLine
 ----------------------------------------------------------------------------*/
-bool Parser::checkPort( QStringList lst )
+QString Parser::line( FrameId frame ) const
 {
-    if ( mPorts.isEmpty() )
-        return true;
-
-    int idx;
-    ( mHasTimeStamp ) ? idx = 1 : idx = 0;
+    StageTimer stage( STAGE_MATERIALIZE );
+    QString text = rawLine( mTable.offset( frame ) );
+    if ( !text.isEmpty() )
+        return text;
 
-    return mPorts.contains( lst.at(idx), Qt::CaseInsensitive );
+    return FrameIngest::formatLine( mTable, frame );
 }
 
 /*----------------------------------------------------------------------------
 
-Name		checkAddr
+Name		rawLine
 
-Purpose		Returns true if the address found in the given QStringList is within
-            the filter
+Purpose		Returns the line of whichever mapped dump holds an offset
 
-Input       lst - Tokenized line of file
+Input       offset - offset of the line's first byte (frame offsets, or a
+                     line search hit)
 
-Return      true if address is in test list or the list is empty, false
-            if not
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QString Parser::rawLine( qint64 offset ) const
+{
+    for ( int i = 0; i < mDumps.size(); ++i )
+    {
+        const MappedDump& dump = mDumps.at(i);
+        if ( offset < dump.base || offset >= dump.base + dump.size )
+            continue;
 
-History		12 May 18  AFB	Created
+        const char* begin = dump.raw + ( offset - dump.base );
+        const char* end = FrameIngest::lineEnd( begin, dump.raw + dump.size );
+
+        return QString::fromLatin1( begin, int( end - begin ) );
+    }
+
+    return QString();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		decode
+
+Purpose		Describes a frame from the object dictionaries.  Only called for
+            rows being drawn, so nothing is decoded while a dump is read.
+
+Input       frame - frame to describe
+
+History		17 Oct 26  AFB	Created
 ----------------------------------------------------------------------------*/
-bool Parser::checkAddr(QStringList lst)
+QString Parser::decode( FrameId frame ) const
 {
-    if ( mAddrs.isEmpty() )
-        return true;
+    if ( mDictionary.isEmpty() )
+        return QString();
+
+    const quint32 sdoKey = ( int( frame ) < mSdo.frameKeys().size() ) ? mSdo.frameKey( frame )
+                                                                     : NO_SDO_KEY;
+    return mDictionary.decode( mTable.cobId( frame ), mTable.dlc( frame ),
+                               mTable.data( frame ), sdoKey );
+}
 
-    int idx;
-    ( mHasTimeStamp ) ? idx = 2 : idx = 1;
+/*----------------------------------------------------------------------------
+
+Name		loadDictionary
+
+Purpose		Reads the EDS or DCF file of a node and parses again, as object
+            names in the filter may now resolve
 
-    uint cobid = lst.at(idx).toInt(0, 16);
-    uint addr = (cobid & 0x7F);
+Input       fileName - file to read
+            node     - node it describes (see ObjectDictionary::load)
+            error    - set to the reason if it cannot be read
 
-    QString straddr = QString::number( addr, 16 );
+Return      true if the file was read
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool Parser::loadDictionary( const QString& fileName, int node, QString& error )
+{
+    if ( !mDictionary.load( fileName, node, error ) )
+        return false;
 
-    return mAddrs.contains( straddr, Qt::CaseInsensitive );
+    scheduleParse();
+    return true;
 }
 
 /*----------------------------------------------------------------------------
 
-Name		checkObjIdx
+Name		extractSignals
 
-Purpose		Returns true if the object index found in the given QStringList is
-            within the filter
+Purpose		Extracts the signals of the PDOs from the frames again.  Frames
+            held back during a background parse are not included.
 
-Input       lst - Tokenized line of file
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::extractSignals()
+{
+    mSignals.build( mTable, mIndex, mSdo, mDictionary );
+}
 
-Return      true if object index is in test list or the list is empty, false
-            if not
+/*----------------------------------------------------------------------------
 
-History		12 May 18  AFB	Created
+Name		buildTimeline
+
+Purpose		Builds the NMT state and heartbeat timeline of every node again.
+            Frames held back during a background parse are not included.
+
+History		17 Oct 26  AFB	Created
 ----------------------------------------------------------------------------*/
-bool Parser::checkObjIdx( QStringList lst )
+void Parser::buildTimeline()
 {
-    if ( mObjIdxs.isEmpty() )
-        return true;
+    mTimeline.build( mTable, mIndex, mSdo, mDictionary );
+}
 
-    if ( !isSdo( lst ) )
-        return false;
+/*----------------------------------------------------------------------------
 
-    int idx;
-    ( mHasTimeStamp ) ? idx = 5 : idx = 4;
+Name		scheduleParse
 
-    QString objIdx = lst.at(idx + 1) + lst.at(idx);
+Purpose		Restarts the parse timer.  Filter changes arriving in quick
+            succession (e.g. the type check boxes) result in a single parse.
 
-    return mObjIdxs.contains( objIdx, Qt::CaseInsensitive );
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::scheduleParse()
+{
+    mParseTimer.start();
 }
 
 /*----------------------------------------------------------------------------
 
-Name		checkSubIdx
+Name		cancelParse
+
+Purpose		Supersedes any background parse and waits for it to stop.  The
+            worker checks the generation between blocks, so this returns
+            quickly.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::cancelParse()
+{
+    mGeneration.fetchAndAddOrdered( 1 );
+    mParseFuture.waitForFinished();
+}
+
+/*----------------------------------------------------------------------------
 
-Purpose		Returns true if the subindex found in the given QStringList is
-            within the filter
+Name		parse
 
-Input       lst - Tokenized line of file
+Purpose		Starts filtering the frame table on a worker thread.  Any parse
+            still in flight is cancelled.  Matches are delivered through
+            deliverMatches as they are found.
 
-Return      true if subindex is in test list or the list is empty, false
-            if not
+            If the previous parse ran to completion and the new filter only
+            narrows it, just the previous matches are tested; if it only
+            widens it, the previous matches are kept and just the frames they
+            excluded are tested.  An unchanged filter is not run at all.
 
 History		12 May 18  AFB	Created
+            17 Oct 26  AFB	Filters the frame table instead of the text
+            17 Oct 26  AFB	Emits frame ids rather than text
+            17 Oct 26  AFB	Runs in the background
+            17 Oct 26  AFB	Refines the previous matches when it can
+            17 Oct 26  AFB	Takes in live frames held back
+            17 Oct 26  AFB	Gives held back frames their SDO keys
 ----------------------------------------------------------------------------*/
-bool Parser::checkSubIdx(QStringList lst)
+void Parser::parse()
 {
-    if ( mSubIdxs.isEmpty() )
-        return true;
+    mParseTimer.stop();
+    cancelParse();
 
-    if ( !isSdo( lst ) )
-        return false;
+    // Live frames that arrived since the last parse finished (or while
+    // it ran, in which case the matches cannot be refined)
+    if ( mMatchesComplete )
+    {
+        appendPendingFrames();
+    }
+    else
+    {
+        takePendingFrames();
+    }
+
+    if ( mTable.isEmpty() )
+    {
+        mMatches.clear();
+        mMatchesComplete = false;
+        emit matchesChanged( mMatches );
+        return;
+    }
+
+    const FrameFilter previousFilter = mFilter;
+    compileFilters();
+
+    Refinement refinement = FULL_SCAN;
+    if ( mMatchesComplete )
+    {
+        bool narrows = mFilter.isSubsetOf( previousFilter );
+        bool widens = previousFilter.isSubsetOf( mFilter );
+
+        if ( narrows && widens )
+            return;
+
+        if ( narrows )
+            refinement = NARROW;
+        else if ( widens )
+            refinement = WIDEN;
+    }
 
-    int idx;
-    ( mHasTimeStamp ) ? idx = 7 : idx = 6;
+    QVector<FrameId> previous;
+    if ( refinement != FULL_SCAN )
+        previous = mMatches;
 
-    return mSubIdxs.contains( lst.at(idx), Qt::CaseInsensitive );
+    mMatches.clear();
+    mMatchesComplete = false;
+    emit matchesChanged( mMatches );
+
+    emit progressChanged( 0 );
+    mParseFuture = QtConcurrent::run( &Parser::filterFrames, this, mFilter,
+                                      int( mGeneration.load() ),
+                                      refinement, previous );
 }
 
 /*----------------------------------------------------------------------------
 
-Name		checkType
+Name		filterFrames
 
-Purpose		Returns true if the type found in the given QStringList is within
-            the filter
+Purpose		Tests frames against the filter on a worker thread.  Which frames
+            are tested depends on the refinement:
 
-Input       lst - Tokenized line of file
+                FULL_SCAN - the frames on the posting lists the filter allows
+                            when the index can narrow them down, every frame
+                            otherwise
+                NARROW    - the previous matches
+                WIDEN     - as FULL_SCAN, but frames among the previous
+                            matches are kept without being tested
 
-Return      true if type is in test list or the list is empty, false
-            if not
+            With a timestamp window set, the time index first narrows the
+            frames (or candidates) to the range the window can fall in.
 
-History		12 May 18  AFB	Created
+            Matches are queued back to the parser one block at a time; the
+            work stops as soon as a newer parse has been started.
+
+Input       parser     - parser owning the frame table
+            filter     - snapshot of the compiled filter
+            generation - generation of the parse this work belongs to
+            refinement - relation of filter to the previous parse's filter
+            previous   - matches of the previous parse (unless FULL_SCAN)
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Uses the frame index when it can
+            17 Oct 26  AFB	Refines the previous matches
+            17 Oct 26  AFB	Narrows the frames by the time window first
+            17 Oct 26  AFB	Times each block as a filter stage
 ----------------------------------------------------------------------------*/
-bool Parser::checkType( QStringList lst )
+void Parser::filterFrames( Parser* parser, FrameFilter filter, int generation,
+                           Refinement refinement, QVector<FrameId> previous )
 {
-    if ( mTypes.isEmpty() )
-        return true;
+    const FrameTable& table = parser->mTable;
+    const FrameIndex& index = parser->mIndex;
+    const SdoTable& sdo = parser->mSdo;
+
+    // Indexed frames that can fall in the time window; frames appended
+    // since the index was built are always visited
+    FrameId timeBegin = 0;
+    FrameId timeEnd = FrameId( index.size() );
+    if ( filter.hasTimeWindow() )
+        index.timeRange( filter.timeFrom(), filter.timeTo(), timeBegin, timeEnd );
+
+    // Spans of positions to visit: into candidates when indexed, frame ids
+    // otherwise
+    QVector< QPair<int, int> > spans;
+    QVector<FrameId> candidates;
+    bool indexed = false;
+    if ( refinement == NARROW )
+    {
+        candidates = previous;
+        indexed = true;
+    }
+    else if ( index.candidates( filter, candidates ) )
+    {
+        QVector<FrameId>::iterator first =
+            std::lower_bound( candidates.begin(), candidates.end(), timeBegin );
+        QVector<FrameId>::iterator last =
+            std::lower_bound( first, candidates.end(), timeEnd );
+        candidates.erase( last, candidates.end() );
+        candidates.erase( candidates.begin(), first );
+
+        for ( int i = index.size(); i < table.size(); ++i )
+            candidates.append( FrameId( i ) );
+        indexed = true;
+    }
 
-    int idx;
-    ( mHasTimeStamp ) ? idx = 2 : idx = 1;
+    if ( indexed )
+    {
+        spans.append( qMakePair( 0, candidates.size() ) );
+    }
+    else
+    {
+        spans.append( qMakePair( int( timeBegin ), int( timeEnd ) ) );
+        spans.append( qMakePair( index.size(), table.size() ) );
+    }
 
-    uint cobid = lst.at(idx).toInt(0, 16);
-    uint func = cobid & 0xF80;
+    qint64 total = 0;
+    for ( int s = 0; s < spans.size(); ++s )
+        total += spans.at(s).second - spans.at(s).first;
 
-    for ( int i = 0; i < mTypes.size(); ++i )
+    if ( total == 0 )
     {
-        if ( func == mMap.value( mTypes.at(i) ) )
-             return true;
+        QMetaObject::invokeMethod( parser, "deliverMatches", Qt::QueuedConnection,
+                                   Q_ARG( int, generation ),
+                                   Q_ARG( QVector<FrameId>, QVector<FrameId>() ),
+                                   Q_ARG( int, 100 ) );
+        return;
     }
 
-    return false;
+    const FrameId* kept = previous.constData();
+    const FrameId* keptEnd = kept + previous.size();
+    qint64 done = 0;
+
+    for ( int s = 0; s < spans.size(); ++s )
+    {
+        for ( int begin = spans.at(s).first; begin < spans.at(s).second; begin += FILTER_BLOCK )
+        {
+            if ( parser->mGeneration.load() != generation )
+                return;
+
+            const int end = qMin( begin + FILTER_BLOCK, spans.at(s).second );
+            StageTimer stage( STAGE_FILTER, end - begin );
+
+            QVector<FrameId> matches;
+            if ( refinement == WIDEN )
+            {
+                // The previous matches are a subset of the frames visited
+                // here, so walking them in step says which can be skipped
+                for ( int i = begin; i < end; ++i )
+                {
+                    FrameId frame = indexed ? candidates.at(i) : FrameId( i );
+                    if ( kept != keptEnd && *kept == frame )
+                    {
+                        matches.append( frame );
+                        ++kept;
+                    }
+                    else if ( filter.matches( table, sdo, frame ) )
+                    {
+                        matches.append( frame );
+                    }
+                }
+            }
+            else if ( indexed )
+            {
+                filter.filter( table, sdo, candidates, begin, end, matches );
+            }
+            else
+            {
+                filter.filter( table, sdo, begin, end, matches );
+            }
+
+            done += end - begin;
+            int percent = int( done * 100 / total );
+            QMetaObject::invokeMethod( parser, "deliverMatches", Qt::QueuedConnection,
+                                       Q_ARG( int, generation ),
+                                       Q_ARG( QVector<FrameId>, matches ),
+                                       Q_ARG( int, percent ) );
+        }
+    }
 }
 
 /*----------------------------------------------------------------------------
 
-Name		isSdo
+Name		deliverMatches
 
-Purpose		Returns true if the line is a type of SDO message
+Purpose		Receives a block of matches from the worker thread.  Blocks from
+            a superseded parse are dropped.  The last block marks the matches
+            complete, which lets the next parse refine them.
 
-Input       lst - Tokenized line of file
+Input       generation - generation of the parse that found the matches
+            matches    - matching frames, in file order
+            percent    - share of the table tested so far
 
-Return      true if type is in test list or the list is empty, false
-            if not
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::deliverMatches( int generation, QVector<FrameId> matches, int percent )
+{
+    if ( generation != mGeneration.load() )
+        return;
 
-History		12 May 18  AFB	Created
+    mMatches += matches;
+    if ( !matches.isEmpty() )
+        emit matchesAdded( matches );
+
+    mMatchesComplete = ( percent == 100 );
+    emit progressChanged( percent );
+
+    if ( mMatchesComplete )
+    {
+        mParseFuture.waitForFinished();
+        appendPendingFrames();
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		appendFrames
+
+Purpose		Appends frames read live to the table.  Only the new frames are
+            tested, on the calling thread; a live batch is small enough that
+            this is cheaper than handing it to a worker.  Until a background
+            parse has delivered all its matches the frames are held back and
+            taken in once it is done.
+
+Input       frames - frames read since the last call
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::appendFrames( const FrameTable& frames )
+{
+    mPendingFrames.append( frames );
+
+    // The matches must be complete for the new frames to be added to them
+    if ( ( mMatchesComplete || mTable.isEmpty() ) && !mParseTimer.isActive() )
+        appendPendingFrames();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		takePendingFrames
+
+Purpose		Appends the frames held back to the table and streams them
+            through the SDO channels, so the SDO keys cover every frame.
+            Frames past the limits are evicted, the port filter is given
+            any new interfaces and the index is rebuilt once the frames left
+            out of it make up a sizeable share of the table.
+
+Return      id of the first frame taken in (0 if the table was trimmed past
+            the frames held before)
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Evicts past the limits and updates the port filter
 ----------------------------------------------------------------------------*/
-bool Parser::isSdo(QStringList lst)
+FrameId Parser::takePendingFrames()
 {
-    int idx;
-    ( mHasTimeStamp ) ? idx = 2 : idx = 1;
+    FrameId first = FrameId( mTable.size() );
+    if ( mPendingFrames.isEmpty() )
+        return first;
 
-    uint cobid = lst.at(idx).toInt(0, 16);
-    uint func = cobid & 0xF80;
+    const int ifaceCount = mTable.ifaces().size();
 
-    return ( func == 0x600 || func == 0x580 );
+    mTable.append( mPendingFrames );
+    mPendingFrames.clear();
+    mAssembler.append( mTable, mSdo );
+
+    const FrameId evicted = evictFrames();
+    first = ( first > evicted ) ? first - evicted : 0;
+
+    // New interfaces need bits in the port filter; the frames already
+    // matched are on known interfaces so their result still holds
+    if ( mTable.ifaces().size() != ifaceCount )
+        mFilter.setIfaces( mTable.ifaces() );
+
+    if ( mTable.size() - mIndex.size() > qMax( mIndex.size() / 4, REINDEX_MIN ) )
+        mIndex.build( mTable );
+
+    return first;
 }
 
 /*----------------------------------------------------------------------------
 
-Name		parse
+Name		appendPendingFrames
 
-Purpose		Parses the text found in mText.  Emits a signal containing parsed
-            text when finished.
+Purpose		Takes in the frames held back (see takePendingFrames) and hands
+            on the ones that make it through the filter
 
-History		12 May 18  AFB	Created
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Evicts the frames past the limits
+            17 Oct 26  AFB	Times the filter stage
+            17 Oct 26  AFB	Takes the frames in through takePendingFrames
 ----------------------------------------------------------------------------*/
-void Parser::parse()
+void Parser::appendPendingFrames()
 {
-    if ( !mText.isEmpty() )
+    if ( mPendingFrames.isEmpty() )
+        return;
+
+    const FrameId first = takePendingFrames();
+
+    // Every frame left is new, so the filter runs over the whole table
+    if ( first == 0 )
+    {
+        compileFilters();
+        mMatchesComplete = true;
+    }
+
+    QVector<FrameId> matches;
     {
-        mParsed.clear();
+        StageTimer stage( STAGE_FILTER, mTable.size() - first );
+        mFilter.filter( mTable, mSdo, first, FrameId( mTable.size() ), matches );
+    }
+
+    mMatches += matches;
+    if ( !matches.isEmpty() )
+        emit matchesAdded( matches );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setLimits
 
-        QStringList txt = mText.split(QRegExp("[\r\n]"),QString::SkipEmptyParts);
+Purpose		Bounds the frames held while frames are read live.  The columns
+            are reserved up front for the frame limit, so a session that
+            runs past it keeps reusing the same memory.  The limits take
+            effect with the next frames appended.
 
-        if ( txt.at(0).contains("(") )
+Input       maxFrames - most frames held, 0 for no limit
+            horizon   - age of the oldest frame held, in microseconds back
+                        from the latest, 0 for no limit
+            spillDir  - directory evicted frames are written to, or empty to
+                        let them go
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void Parser::setLimits( int maxFrames, qint64 horizon, const QString& spillDir )
+{
+    mMaxFrames = qMax( maxFrames, 0 );
+    mHorizon = qMax( horizon, qint64( 0 ) );
+    mSpillDir = spillDir;
+
+    if ( mMaxFrames > 0 )
+        mTable.reserve( mMaxFrames + mMaxFrames / EVICT_SLACK );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		evictFrames
+
+Purpose		Removes the oldest frames once the table is past the frame limit
+            or its oldest frame is past the horizon, by more than a slack of
+            1 / EVICT_SLACK.  The table is trimmed back to the limits, the
+            SDO keys, transfers and matches are moved down with it and the
+            index is rebuilt.  Matches are handed on again from scratch.
+
+Return      number of frames evicted
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Moves the PDO signals down
+            17 Oct 26  AFB	Tells the frames have gone
+            17 Oct 26  AFB	Moves the node timeline down
+----------------------------------------------------------------------------*/
+FrameId Parser::evictFrames()
+{
+    const int size = mTable.size();
+    int count = 0;
+
+    if ( mMaxFrames > 0 && size > mMaxFrames + mMaxFrames / EVICT_SLACK )
+        count = size - mMaxFrames;
+
+    if ( mHorizon > 0 && size > 0 )
+    {
+        const qint64* times = mTable.times().constData();
+        const qint64 latest = times[ size - 1 ];
+        const qint64 cutoff = latest - mHorizon;
+
+        // Frames without a timestamp count as older than any other
+        if ( latest != NO_TIMESTAMP && times[0] < cutoff - mHorizon / EVICT_SLACK )
         {
-            mHasTimeStamp = true;
+            int old = 0;
+            while ( old < size && times[ old ] < cutoff )
+                ++old;
+            count = qMax( count, old );
         }
+    }
 
-        for ( int i = 0; i < txt.size(); ++i )
+    if ( count == 0 )
+        return 0;
+
+    if ( !mSpillDir.isEmpty() )
+    {
+        // One spill file is written at a time, which also bounds the memory
+        // held by the copies of evicted frames
+        if ( mSpilling )
         {
-            bool valid = true;
+            mSpillFuture.waitForFinished();
+            if ( !mSpillFuture.result().isEmpty() )
+                emit statusChanged( tr( "Unable to spill evicted frames: %1" )
+                                    .arg( mSpillFuture.result() ) );
+        }
 
-            QStringList line = splitOnWhiteSpace(txt.at(i).trimmed());
+        QString name = QString( "spill-%1.cdc" )
+                       .arg( QDateTime::currentDateTime().toString( "yyyyMMdd-hhmmss-zzz" ) );
+        mSpillFuture = QtConcurrent::run( &Parser::spillFrames, mTable.mid( 0, count ),
+                                          QDir( mSpillDir ).filePath( name ) );
+        mSpilling = true;
+    }
 
-            valid &= checkPort( line );
-            valid &= checkAddr( line );
+    mTable.removeFirst( count );
+    mSdo.removeFirst( FrameId( count ) );
+    mAssembler.removeFirst( FrameId( count ) );
+    mSignals.removeFirst( FrameId( count ) );
+    mTimeline.removeFirst( FrameId( count ), mTable );
+    mEvicted += count;
+    emit framesRemoved( FrameId( count ) );
 
-            valid &= checkObjIdx( line );
-            valid &= checkSubIdx( line );
+    QVector<FrameId>::iterator kept =
+        std::lower_bound( mMatches.begin(), mMatches.end(), FrameId( count ) );
+    mMatches.erase( mMatches.begin(), kept );
+    for ( int i = 0; i < mMatches.size(); ++i )
+        mMatches[i] -= FrameId( count );
+    emit matchesChanged( mMatches );
 
-            valid &= checkType( line );
+    mIndex.build( mTable );
 
-            if ( valid )
-                mParsed += txt.at(i) + "\r";
-        }
+    return FrameId( count );
+}
 
-        emit textChanged( mParsed );
-    }
+/*----------------------------------------------------------------------------
+
+Name		spillFrames
+
+Purpose		Writes evicted frames to a capture file on a worker thread
+
+Input       frames   - copy of the evicted frames
+            fileName - capture file to write
+
+Return      the reason the file could not be written, or an empty string
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QString Parser::spillFrames( FrameTable frames, QString fileName )
+{
+    FrameIndex index;
+    index.build( frames );
+
+    QString error;
+    CaptureFile::save( fileName, frames, index, error );
+
+    return error;
 }
@@ -18,11 +18,24 @@ History		12 May 18  AFB	Created
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <QAtomicInt>
+#include <QFile>
+#include <QFuture>
 #include <QMap>
 #include <QObject>
 #include <QPair>
 #include <QStringList>
+#include <QTimer>
 #include <QVector>
+#include "framefilter.h"
+#include "frameindex.h"
+#include "framemerger.h"
+#include "sdoassembler.h"
+#include "frametable.h"
+#include "linesearch.h"
+#include "nodetimeline.h"
+#include "objectdictionary.h"
+#include "signaltable.h"
 
 
 // Specifies variety of available, standard, packet types
@@ -51,71 +64,256 @@ enum PacketType
 // Convenience typedef
 typedef QMap< PacketType, int > PktMap;
 
+// Split a string on non-alphanumeric characters
+QStringList splitOnNonAlphaNum( QString str );
+
+// A dump file mapped into memory
+struct MappedDump
+{
+    QFile* file;
+    const char* raw;                // Mapped contents
+    qint64 size;                    // Size of the mapped contents
+    qint64 base;                    // Offset of its first byte in the frame offsets
+};
+
 class Parser : public QObject
 {
     Q_OBJECT
 
 public:
     explicit Parser();
-    ~Parser(){}
-
-    // Set the text of the parser (base text that will be parsed)
-    void setText( const QString& text );
+    ~Parser();
+
+    // Memory maps and tokenizes a dump file (base text that will be parsed),
+    // or restores a capture file.  Returns false if the file could not be
+    // opened or mapped.
+    bool loadFile( const QString& fileName );
+    // Memory maps and tokenizes several dumps (e.g. one per interface) and
+    // merges their frames into one table in timestamp order.  The first
+    // block is merged straight away and the rest a block at a time from
+    // the event loop, taken in like live frames, so the view fills while
+    // the merge runs.  Returns false if a file could not be opened or
+    // mapped.
+    bool loadFiles( const QStringList& fileNames );
+
+    // Saves the frames and their index to a binary capture file.  Returns
+    // false, with a reason in error, if the file could not be written.
+    bool saveCapture( const QString& fileName, QString& error ) const;
+    // Writes the frames out as a candump -l log
+    bool exportLog( const QString& fileName, QString& error ) const;
+
+    // Unmaps the current files and clears the frame table
+    void unload();
+
+    // Returns the number of bytes of the loaded files that were tokenized
+    qint64 loadedBytes() const;
+
+    // Bounds the frames held while frames are read live: at most maxFrames
+    // (0 for no limit) and none more than horizon microseconds older than
+    // the latest (0 for no limit).  The oldest frames are evicted in
+    // batches; if spillDir is set they are first written there as capture
+    // files, which can be opened and filtered like any other.
+    void setLimits( int maxFrames, qint64 horizon, const QString& spillDir );
+    int maxFrames() const { return mMaxFrames; }
+    qint64 horizon() const { return mHorizon; }
+    const QString& spillDir() const { return mSpillDir; }
+    // Returns the number of frames evicted since the last load
+    qint64 evictedFrames() const { return mEvicted; }
 
     // Set the ports that will make it through the filter
     void setPort( QString port );
     // Set the addresses that will make it through the filter
     void setAddr( QString addr );
 
-    // Sets the object indices that will make it through the filter
+    // Sets the object indices that will make it through the filter: hex
+    // indices, or names of objects in the loaded dictionaries, separated
+    // by commas
     void setObjIdx( QString objIdx );
     // Sets the subindices that will make it through the filter
     void setSubIdx( QString subIdx );
 
+    // Sets the start of the timestamp window, in seconds.  A negative value
+    // counts back from the latest frame (e.g. -10 for the last ten seconds).
+    void setTimeFrom( QString from );
+    // Sets the end of the timestamp window, in seconds
+    void setTimeTo( QString to );
+
+    // Sets the payload predicates (see FrameFilter::setPayload)
+    void setPayload( QString payload );
+
     // Add a type to the filter (these will be allowed through)
     void addType( PacketType type );
     // Remove a type from the types
     void removeType( PacketType type );
 
+    // Returns the frames loaded or read live
+    const FrameTable& table() const { return mTable; }
+    // Returns the SDO transfers reassembled from the frames
+    const SdoTable& sdoTable() const { return mSdo; }
+
+    // Reads the EDS or DCF file of a node (see ObjectDictionary::load).
+    // Returns false, with a reason in error, if it cannot be read.
+    bool loadDictionary( const QString& fileName, int node, QString& error );
+    // Returns the object dictionaries loaded
+    const ObjectDictionary& dictionary() const { return mDictionary; }
+
+    // Extracts the signals of the PDOs from the frames again, following
+    // their mappings through the dictionaries and SDO downloads
+    void extractSignals();
+    // Returns the signals extracted by the last extractSignals()
+    const SignalTable& pdoSignals() const { return mSignals; }
+    // Extracts a byte range of the frames of a COB-ID as a signal (see
+    // SignalTable::extractBytes)
+    PdoSignal extractBytes( quint32 cobId, int firstByte, int bytes, bool isSigned ) const
+        { return SignalTable::extractBytes( mTable, mIndex, cobId, firstByte, bytes, isSigned ); }
+
+    // Builds the NMT state and heartbeat timeline of every node again
+    void buildTimeline();
+    // Returns the timeline built by the last buildTimeline()
+    const NodeTimeline& nodeTimeline() const { return mTimeline; }
+
+    // Returns the original text of the given frame
+    QString line( FrameId frame ) const;
+    // Returns the frame described from the object dictionaries: its SDO
+    // object or PDO fields, or an empty string
+    QString decode( FrameId frame ) const;
+    // Returns the line of the mapped dumps starting at offset (as found by
+    // the line search), or an empty string if no dump holds it
+    QString rawLine( qint64 offset ) const;
+
+    // Returns the search over the raw lines of the loaded dumps
+    LineSearch& lineSearch() { return mSearch; }
+
+    // creates a map to reference when parsing types
+    static PktMap createRefMap();
+
+public slots:
+    // Appends frames read live to the table and filters just those.  Held
+    // back while a background parse is using the table.
+    void appendFrames( const FrameTable& frames );
+    // Unmaps the dumps once the followed file has been truncated; the
+    // lines of the frames are then written out from the frames themselves
+    void releaseDumps();
+
 signals:
-    // emitted whenever the parsing is complete
-    void textChanged( const QString& text );
+    // emitted with the frames that made it through the filter so far
+    // whenever parsing restarts
+    void matchesChanged( const QVector<FrameId>& matches );
+    // emitted with each further block of matching frames found in the
+    // background
+    void matchesAdded( const QVector<FrameId>& matches );
+    // emitted as background parsing progresses (percent of frames tested)
+    void progressChanged( int percent );
+    // emitted with a summary of the last load
+    void statusChanged( const QString& status );
+    // emitted when the first count frames have left the table (evicted, or
+    // every frame on unload), so the ids of the rest have moved down
+    void framesRemoved( FrameId count );
 
 private:
-    // creates a map to reference when parsing types
-    PktMap createRefMap();
-
-    // Checks the inputted line for a port match
-    bool checkPort( QStringList lst );
-    // Checks the inputted line for a address match
-    bool checkAddr( QStringList lst );
-    // Checks the inputted line for a object index match
-    bool checkObjIdx( QStringList lst );
-    // Checks the inputted line for a subindex match
-    bool checkSubIdx( QStringList lst );
-    // Checks the inputted line for a type match
-    bool checkType( QStringList lst );
-
-    // Checks whether the inputted line is an SDO
-    bool isSdo( QStringList lst );
-
-    // Parses a given string
+    // How a parse relates to the matches of the one before it
+    enum Refinement
+        {
+        FULL_SCAN,  // Test every frame
+        NARROW,     // Only test the previous matches
+        WIDEN       // Keep the previous matches, test the frames they excluded
+        };
+
+    // Converts the filter strings into the compiled filter
+    void compileFilters();
+    // Returns the object indices to filter, with names resolved from the
+    // object dictionaries
+    QStringList objIdxs() const;
+
+    // Runs on a worker thread: tests every frame (or the index candidates,
+    // or only those previous matches allow) against filter, handing matches
+    // back block by block until done or generation is superseded
+    static void filterFrames( Parser* parser, FrameFilter filter, int generation,
+                              Refinement refinement, QVector<FrameId> previous );
+
+    // Stops any background parse and waits for it to finish
+    void cancelParse();
+
+    // Maps a dump file after those already mapped.  Returns false if it
+    // could not be opened or mapped.
+    bool mapDump( const QString& fileName );
+    // Unmaps every dump file
+    void unmapDumps();
+
+    // Restores the table and index from the mapped capture file
+    bool loadCapture();
+
+    // Appends the frames held back to the table along with their SDO keys,
+    // evicting past the limits; returns the id of the first one taken in
+    FrameId takePendingFrames();
+    // Appends the frames held back during a background parse and filters
+    // them
+    void appendPendingFrames();
+
+    // Removes the oldest frames once the table is past the limits, and
+    // returns how many went
+    FrameId evictFrames();
+
+    // Runs on a worker thread: writes evicted frames to a capture file and
+    // returns the reason if that fails
+    static QString spillFrames( FrameTable frames, QString fileName );
+
+    // Restarts the parse timer so that bursts of filter changes result in
+    // a single parse
+    void scheduleParse();
+
+private slots:
+    // Starts parsing the frame table in the background
     void parse();
 
+    // Receives a block of matches from the worker thread
+    void deliverMatches( int generation, QVector<FrameId> matches, int percent );
+
+    // Merges the next block of frames of the loaded dumps into the table
+    void mergeFrames();
+
 private:
-    QString mText;                  // Base text to parse
-    QString mParsed;                // Parsed text
+    QVector<MappedDump> mDumps;     // Dump files mapped, in load order
+    FrameMerger mMerger;            // Frames of several dumps still to merge
+    LineSearch mSearch;             // Search over the text of mDumps
+    QTimer mMergeTimer;             // Merges a block per pass of the event loop
+    FrameTable mTable;              // Frames tokenized from the base text
+    FrameIndex mIndex;              // Posting lists over mTable
+    SdoAssembler mAssembler;        // SDO channel state, carried across appends
+    SdoTable mSdo;                  // SDO transfers and keys of mTable
+    ObjectDictionary mDictionary;   // EDS / DCF files of the nodes
+    SignalTable mSignals;           // PDO signals extracted from mTable
+    NodeTimeline mTimeline;         // NMT timeline of the nodes of mTable
+    FrameTable mPendingFrames;      // Live frames waiting for a parse to finish
+    QVector<FrameId> mMatches;      // Frames that made it through the filter
+    bool mMatchesComplete;          // True once mMatches holds every match of mFilter
 
     QStringList mPorts;             // Ports to filter against
     QStringList mAddrs;             // Addresses to filter against
 
-    QStringList mObjIdxs;           // Object indices to filter against
+    QString mObjIdx;                // Object indices or names to filter against
     QStringList mSubIdxs;           // Subindices to filter against
 
+    QString mTimeFrom;              // Start of the timestamp window, in seconds
+    QString mTimeTo;                // End of the timestamp window, in seconds
+
+    QString mPayload;               // Payload predicates
+
     QVector<PacketType> mTypes;     // Types to filter against
     const PktMap mMap;              // Map to reference for ints corresponding to packet types
 
-    bool mHasTimeStamp;             // True if the parsed text contains a timestamp
+    FrameFilter mFilter;            // Compiled form of the filter strings
+
+    int mMaxFrames;                 // Most frames held live, 0 for no limit
+    qint64 mHorizon;                // Age of the oldest frame held live (us), 0 for no limit
+    QString mSpillDir;              // Directory evicted frames are written to
+    qint64 mEvicted;                // Frames evicted since the last load
+    bool mSpilling;                 // True once mSpillFuture has been started
+    QFuture<QString> mSpillFuture;  // Spill file being written
+
+    QTimer mParseTimer;             // Coalesces filter changes
+    QAtomicInt mGeneration;         // Incremented whenever a parse starts
+    QFuture<void> mParseFuture;     // Background parse in flight
 
 };
 
@@ -0,0 +1,223 @@
+/*----------------------------------------------------------------------------
+
+Name		plotdock.cpp
+
+Purpose		Dock plotting one signal over time.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "plotdock.h"
+#include "parser.h"
+#include <QElapsedTimer>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+/*----------------------------------------------------------------------------
+
+Name		signalTitle
+
+Purpose		Returns the name a signal is listed and plotted under: its PDO,
+            node and object name (or index and subindex)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QString signalTitle( const PdoSignal& signal, const ObjectDictionary& dictionary )
+{
+    QString name;
+    if ( signal.entry >= 0 )
+        name = dictionary.string( dictionary.entry( signal.entry ).name );
+    else
+        name = QString( "%1.%2" ).arg( signal.objKey >> 8, 4, 16, QChar( '0' ) )
+                                 .arg( signal.objKey & 0xFF, 2, 16, QChar( '0' ) ).toUpper();
+
+    return QString( "%1%2 %3: %4" ).arg( signal.receive ? "RPDO" : "TPDO" )
+                                   .arg( signal.pdo )
+                                   .arg( signal.node, 2, 16, QChar( '0' ) )
+                                   .arg( name );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		PlotDock
+
+Purpose		Constructor.  Builds the source controls and the plot.
+
+Input       parser - parser the frames and signals are read from
+            parent - owning widget
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+PlotDock::PlotDock( Parser& parser, QWidget* parent )
+    : QDockWidget( tr( "Plot" ), parent ),
+      mParser( parser )
+{
+    setObjectName( "mPlotDock" );
+
+    QWidget* body = new QWidget( this );
+
+    mSourceBox = new QComboBox( body );
+    mSourceBox->addItem( tr( "COB-ID bytes" ), -1 );
+
+    mCobIdEdit = new QLineEdit( body );
+    mCobIdEdit->setPlaceholderText( tr( "COB-ID (hex)" ) );
+    mCobIdEdit->setMaximumWidth( 100 );
+
+    mFirstSpin = new QSpinBox( body );
+    mFirstSpin->setRange( 0, 7 );
+    mFirstSpin->setPrefix( tr( "byte " ) );
+
+    mBytesSpin = new QSpinBox( body );
+    mBytesSpin->setRange( 1, 8 );
+    mBytesSpin->setValue( 2 );
+    mBytesSpin->setSuffix( tr( " bytes" ) );
+
+    mSignedChk = new QCheckBox( tr( "Signed" ), body );
+    QPushButton* plotBtn = new QPushButton( tr( "Plot" ), body );
+
+    QHBoxLayout* controls = new QHBoxLayout;
+    controls->addWidget( mSourceBox, 1 );
+    controls->addWidget( mCobIdEdit );
+    controls->addWidget( mFirstSpin );
+    controls->addWidget( mBytesSpin );
+    controls->addWidget( mSignedChk );
+    controls->addWidget( plotBtn );
+
+    mStatusLbl = new QLabel( body );
+    mPlot = new PlotWidget( mParser.table(), body );
+
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->addLayout( controls );
+    layout->addWidget( mStatusLbl );
+    layout->addWidget( mPlot, 1 );
+    body->setLayout( layout );
+    setWidget( body );
+
+    connect( plotBtn,               SIGNAL( clicked() ),
+             this,                  SLOT( plot() ) );
+    connect( mCobIdEdit,            SIGNAL( returnPressed() ),
+             this,                  SLOT( plot() ) );
+    connect( mSourceBox,            SIGNAL( currentIndexChanged( int ) ),
+             this,                  SLOT( sourceChanged( int ) ) );
+    connect( mPlot,                 SIGNAL( frameClicked( FrameId ) ),
+             this,                  SIGNAL( frameClicked( FrameId ) ) );
+    connect( &mParser,              SIGNAL( framesRemoved( FrameId ) ),
+             mPlot,                 SLOT( removeFrames( FrameId ) ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		refreshSignals
+
+Purpose		Lists the signals last extracted by the parser after the COB-ID
+            bytes source, keeping the source chosen if it is still listed
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotDock::refreshSignals()
+{
+    const QString current = mSourceBox->currentText();
+    const SignalTable& table = mParser.pdoSignals();
+
+    mSourceBox->blockSignals( true );
+    while ( mSourceBox->count() > 1 )
+        mSourceBox->removeItem( 1 );
+    for ( int i = 0; i < table.size(); ++i )
+        mSourceBox->addItem( signalTitle( table.at(i), mParser.dictionary() ), i );
+
+    const int kept = mSourceBox->findText( current );
+    mSourceBox->setCurrentIndex( kept >= 0 ? kept : 0 );
+    mSourceBox->blockSignals( false );
+
+    sourceChanged( mSourceBox->currentIndex() );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		plotSignal
+
+Purpose		Chooses a signal of the parser's signal table and plots it
+
+Input       signal - position of the signal in the table
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotDock::plotSignal( int signal )
+{
+    refreshSignals();
+    const int index = mSourceBox->findData( signal );
+    if ( signal < 0 || index < 0 )
+        return;
+
+    mSourceBox->setCurrentIndex( index );
+    plot();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		plot
+
+Purpose		Plots the source chosen.  Bytes of a COB-ID are extracted from
+            the frames first; a PDO signal is already a column.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotDock::plot()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const int source = mSourceBox->currentData().toInt();
+    const SignalTable& table = mParser.pdoSignals();
+
+    PdoSignal signal;
+    QString title;
+    if ( source >= 0 && source < table.size() )
+    {
+        signal = table.at( source );
+        title = mSourceBox->currentText();
+    }
+    else
+    {
+        bool ok;
+        const quint32 cobId = mCobIdEdit->text().trimmed().toUInt( &ok, 16 );
+        if ( !ok )
+        {
+            mStatusLbl->setText( tr( "Enter the COB-ID in hex" ) );
+            return;
+        }
+
+        const int first = mFirstSpin->value();
+        const int bytes = qMin( mBytesSpin->value(), 8 - first );
+        signal = mParser.extractBytes( cobId, first, bytes, mSignedChk->isChecked() );
+        title = tr( "COB-ID %1, bytes %2-%3" ).arg( QString::number( cobId, 16 ).toUpper() )
+                                              .arg( first )
+                                              .arg( first + bytes - 1 );
+    }
+
+    mPlot->setSignal( signal, title );
+    mStatusLbl->setText( tr( "%1 samples, %2 levels built in %3 ms" )
+                         .arg( signal.values.size() )
+                         .arg( mPlot->pyramid().levels() - 1 )
+                         .arg( timer.elapsed() ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		sourceChanged
+
+Purpose		Enables the COB-ID controls when bytes are the source
+
+Input       index - source chosen
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotDock::sourceChanged( int index )
+{
+    const bool bytes = mSourceBox->itemData( index ).toInt() < 0;
+    mCobIdEdit->setEnabled( bytes );
+    mFirstSpin->setEnabled( bytes );
+    mBytesSpin->setEnabled( bytes );
+    mSignedChk->setEnabled( bytes );
+}
@@ -0,0 +1,60 @@
+/*----------------------------------------------------------------------------
+
+Name		plotdock.h
+
+Purpose		Dock plotting one signal over time: a PDO signal extracted by
+            the signal dock, or a byte range of the frames of a COB-ID.
+            Clicking a point of the plot hands on the frame it came from.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef PLOTDOCK_H
+#define PLOTDOCK_H
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDockWidget>
+#include <QLabel>
+#include <QLineEdit>
+#include <QSpinBox>
+#include "plotwidget.h"
+
+class Parser;
+
+class PlotDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PlotDock( Parser& parser, QWidget* parent = 0 );
+
+public slots:
+    // Lists the signals last extracted by the parser as sources
+    void refreshSignals();
+    // Plots a signal of the parser's signal table
+    void plotSignal( int signal );
+    // Plots the source chosen
+    void plot();
+
+signals:
+    // emitted with the frame of a point clicked on
+    void frameClicked( FrameId frame );
+
+private slots:
+    // Enables the COB-ID controls when bytes are the source
+    void sourceChanged( int index );
+
+private:
+    Parser& mParser;                // Owner of the frames and signals
+
+    PlotWidget* mPlot;              // The plot
+
+    QComboBox* mSourceBox;          // Bytes of a COB-ID, or a PDO signal
+    QLineEdit* mCobIdEdit;          // COB-ID whose bytes are plotted
+    QSpinBox* mFirstSpin;           // First byte plotted
+    QSpinBox* mBytesSpin;           // Number of bytes plotted
+    QCheckBox* mSignedChk;          // Bytes are a signed integer
+    QLabel* mStatusLbl;             // Summary of the last plot
+};
+
+#endif // PLOTDOCK_H
@@ -0,0 +1,517 @@
+/*----------------------------------------------------------------------------
+
+Name		plotwidget.cpp
+
+Purpose		Plot of one signal, drawn from its min / max pyramid.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "plotwidget.h"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QWheelEvent>
+#include <cmath>
+
+// Pixels the mouse must move with the button held before the plot pans
+static const int DRAG_START = 3;
+
+// Pixel columns either side of a click searched for a sample
+static const int PICK_REACH = 4;
+
+// Share of the plot one wheel step zooms in by
+static const double ZOOM_STEP = 0.8;
+
+/*----------------------------------------------------------------------------
+
+Name		PlotWidget
+
+Purpose		Constructor
+
+Input       table  - frames the signals shown are read from
+            parent - owning widget
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+PlotWidget::PlotWidget( const FrameTable& table, QWidget* parent )
+    : QWidget( parent ),
+      mTable( table ),
+      mHasTime( false ),
+      mFrom( 0 ),
+      mTo( 1 ),
+      mLevel( 0 ),
+      mYLow( 0.0 ),
+      mYHigh( 1.0 ),
+      mPressed( false ),
+      mDragged( false ),
+      mPressX( 0 ),
+      mPressFrom( 0 ),
+      mPressTo( 0 )
+{
+    setMinimumHeight( 120 );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setSignal
+
+Purpose		Shows a signal.  Its columns are shared, not copied; only the
+            pyramid is built.
+
+Input       signal - signal to show
+            title  - name drawn over it
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::setSignal( const PdoSignal& signal, const QString& title )
+{
+    mSignal = signal;
+    mTitle = title;
+    mHasTime = !mSignal.frames.isEmpty()
+               && mTable.time( mSignal.frames.first() ) != NO_TIMESTAMP;
+    mPyramid.build( mSignal.values );
+    fit();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Shows nothing
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::clear()
+{
+    mSignal.frames.clear();
+    mSignal.values.clear();
+    mTitle.clear();
+    mPyramid.clear();
+    update();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		fit
+
+Purpose		Shows the whole of the signal
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::fit()
+{
+    if ( !mSignal.values.isEmpty() )
+    {
+        mFrom = sampleX( 0 );
+        mTo = qMax( sampleX( mSignal.values.size() - 1 ), mFrom + 1 );
+    }
+    update();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		removeFrames
+
+Purpose		Drops the samples of frames that have left the table and builds
+            the pyramid again.  A plot against frames moves with them.
+
+Input       count - number of frames removed from the front of the table
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::removeFrames( FrameId count )
+{
+    if ( mSignal.values.isEmpty() || count == 0 )
+        return;
+
+    SignalTable::removeFirst( mSignal, count );
+    if ( !mHasTime )
+    {
+        mFrom -= count;
+        mTo -= count;
+    }
+
+    mPyramid.build( mSignal.values );
+    update();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		sampleX
+
+Purpose		Returns the position of a sample along the x axis
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+qint64 PlotWidget::sampleX( int sample ) const
+{
+    const FrameId frame = mSignal.frames.at( sample );
+    return mHasTime ? mTable.time( frame ) : qint64( frame );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		sampleAt
+
+Purpose		Returns the first sample at or after a position along the x
+            axis, by binary search (samples are in frame order, and so in
+            time order)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int PlotWidget::sampleAt( qint64 x ) const
+{
+    int lo = 0;
+    int hi = mSignal.values.size();
+    while ( lo < hi )
+    {
+        const int mid = lo + ( hi - lo ) / 2;
+        if ( sampleX( mid ) < x )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		plotArea
+
+Purpose		Returns the area the samples are drawn in, inside room for the
+            axis labels
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QRect PlotWidget::plotArea() const
+{
+    const int line = fontMetrics().height();
+    return rect().adjusted( 8 * line, line / 2, -line / 2, -2 * line );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		toColumn, fromColumn
+
+Purpose		Convert between positions along the x axis and pixel columns of
+            a plot area width pixels wide
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+double PlotWidget::toColumn( qint64 x, int width ) const
+{
+    return double( x - mFrom ) * width / double( mTo - mFrom );
+}
+
+qint64 PlotWidget::fromColumn( double column, int width ) const
+{
+    return mFrom + qint64( column * double( mTo - mFrom ) / width );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		gatherColumns
+
+Purpose		Gathers the extremes of the samples shown into pixel columns.
+            The level read gives at least one bucket a column, so between
+            width and LOD_FACTOR * width buckets are read however many
+            samples are shown; at level 0 the samples are read one by one.
+
+Input       width - width of the plot area in pixels
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::gatherColumns( int width )
+{
+    mColLow.fill( 0.0, width );
+    mColHigh.fill( 0.0, width );
+    mColLowSample.fill( -1, width );
+    mColHighSample.fill( -1, width );
+
+    const int samples = mSignal.values.size();
+    const int first = qMax( sampleAt( mFrom ) - 1, 0 );
+    const int last = qMin( sampleAt( mTo ) + 1, samples );
+    if ( first >= last )
+        return;
+
+    mLevel = mPyramid.levelFor( last - first, width );
+    const qint64 bucketSamples = SignalPyramid::bucketSamples( mLevel );
+    const int firstBucket = int( first / bucketSamples );
+    const int lastBucket = int( ( last - 1 ) / bucketSamples );
+    const double* values = mSignal.values.constData();
+
+    for ( int b = firstBucket; b <= lastBucket; ++b )
+    {
+        double low;
+        double high;
+        int lowSample;
+        int highSample;
+        if ( mLevel == 0 )
+        {
+            low = high = values[b];
+            lowSample = highSample = b;
+        }
+        else
+        {
+            const LodBucket& bucket = mPyramid.level( mLevel ).at( b );
+            low = bucket.min;
+            high = bucket.max;
+            lowSample = int( bucket.minSample );
+            highSample = int( bucket.maxSample );
+        }
+
+        const int c = int( std::floor( toColumn( sampleX( int( b * bucketSamples ) ), width ) ) );
+        if ( c < 0 || c >= width )
+            continue;
+
+        if ( mColLowSample.at( c ) < 0 || low < mColLow.at( c ) )
+        {
+            mColLow[c] = low;
+            mColLowSample[c] = lowSample;
+        }
+        if ( mColHighSample.at( c ) < 0 || high > mColHigh.at( c ) )
+        {
+            mColHigh[c] = high;
+            mColHighSample[c] = highSample;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		paintEvent
+
+Purpose		Draws the plot: the y axis fitted to the columns shown, a bar
+            from the low to the high of each column, a line joining each to
+            the one before, and the axis labels
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::paintEvent( QPaintEvent* event )
+{
+    Q_UNUSED( event );
+
+    QPainter painter( this );
+    painter.fillRect( rect(), palette().color( QPalette::Base ) );
+
+    const QRect area = plotArea();
+    painter.setPen( palette().color( QPalette::Mid ) );
+    painter.drawRect( area );
+    painter.setPen( palette().color( QPalette::Text ) );
+
+    if ( mSignal.values.isEmpty() || area.width() <= 0 || area.height() <= 0 )
+    {
+        painter.drawText( rect(), Qt::AlignCenter,
+                          tr( "Choose a signal, or a COB-ID and its bytes, and press Plot" ) );
+        return;
+    }
+
+    const int width = area.width();
+    gatherColumns( width );
+
+    // Fit the y axis to the columns shown
+    bool any = false;
+    for ( int c = 0; c < width; ++c )
+    {
+        if ( mColLowSample.at( c ) < 0 )
+            continue;
+        mYLow = any ? qMin( mYLow, mColLow.at( c ) ) : mColLow.at( c );
+        mYHigh = any ? qMax( mYHigh, mColHigh.at( c ) ) : mColHigh.at( c );
+        any = true;
+    }
+    if ( !any || mYHigh <= mYLow )
+    {
+        mYLow -= 1.0;
+        mYHigh += 1.0;
+    }
+    const double pad = ( mYHigh - mYLow ) * 0.05;
+    mYLow -= pad;
+    mYHigh += pad;
+    const double scale = area.height() / ( mYHigh - mYLow );
+
+    QVector<QLineF> lines;
+    QVector<QPointF> dots;
+    double lastX = 0;
+    double lastTop = 0;
+    double lastBottom = 0;
+    bool joined = false;
+    for ( int c = 0; c < width; ++c )
+    {
+        if ( mColLowSample.at( c ) < 0 )
+            continue;
+
+        const double x = area.left() + c + 0.5;
+        const double top = area.bottom() - ( mColHigh.at( c ) - mYLow ) * scale;
+        const double bottom = area.bottom() - ( mColLow.at( c ) - mYLow ) * scale;
+        lines << QLineF( x, top, x, bottom );
+
+        if ( joined )
+        {
+            const double from = qBound( lastTop, ( top + bottom ) / 2, lastBottom );
+            lines << QLineF( lastX, from, x, qBound( top, from, bottom ) );
+        }
+        if ( mLevel == 0 )
+            dots << QPointF( x, top );
+
+        lastX = x;
+        lastTop = top;
+        lastBottom = bottom;
+        joined = true;
+    }
+
+    painter.setPen( palette().color( QPalette::Highlight ) );
+    painter.drawLines( lines );
+    if ( dots.size() * 4 < width )
+    {
+        painter.setBrush( palette().color( QPalette::Highlight ) );
+        for ( int i = 0; i < dots.size(); ++i )
+            painter.drawEllipse( dots.at(i), 2.0, 2.0 );
+    }
+
+    // Labels
+    const int line = fontMetrics().height();
+    painter.setPen( palette().color( QPalette::Text ) );
+    painter.drawText( QRect( area.left() + 4, area.top() + 2, width - 8, line ),
+                      Qt::AlignLeft | Qt::AlignVCenter, mTitle );
+    painter.drawText( QRect( 0, area.top(), area.left() - 4, line ),
+                      Qt::AlignRight | Qt::AlignVCenter, QString::number( mYHigh, 'g', 6 ) );
+    painter.drawText( QRect( 0, area.bottom() - line, area.left() - 4, line ),
+                      Qt::AlignRight | Qt::AlignVCenter, QString::number( mYLow, 'g', 6 ) );
+
+    const QString from = mHasTime ? tr( "%1 s" ).arg( mFrom / 1e6, 0, 'f', 6 )
+                                  : tr( "frame %1" ).arg( mFrom );
+    const QString to = mHasTime ? tr( "%1 s" ).arg( mTo / 1e6, 0, 'f', 6 )
+                                : tr( "frame %1" ).arg( mTo );
+    const QRect below( area.left(), area.bottom() + 2, width, line );
+    painter.drawText( below, Qt::AlignLeft | Qt::AlignVCenter, from );
+    painter.drawText( below, Qt::AlignRight | Qt::AlignVCenter, to );
+    painter.drawText( below, Qt::AlignHCenter | Qt::AlignVCenter,
+                      tr( "%1 samples, level %2 of %3" )
+                      .arg( mSignal.values.size() )
+                      .arg( mLevel )
+                      .arg( mPyramid.levels() - 1 ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mousePressEvent
+
+Purpose		Notes where a pan or click starts
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::mousePressEvent( QMouseEvent* event )
+{
+    if ( event->button() != Qt::LeftButton )
+        return;
+
+    mPressed = true;
+    mDragged = false;
+    mPressX = event->x();
+    mPressFrom = mFrom;
+    mPressTo = mTo;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mouseMoveEvent
+
+Purpose		Pans the plot with the mouse once it has moved far enough
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::mouseMoveEvent( QMouseEvent* event )
+{
+    if ( !mPressed || plotArea().width() <= 0 )
+        return;
+
+    const int dx = event->x() - mPressX;
+    if ( qAbs( dx ) > DRAG_START )
+        mDragged = true;
+    if ( !mDragged )
+        return;
+
+    const qint64 shift = qint64( double( dx ) * ( mPressTo - mPressFrom ) / plotArea().width() );
+    mFrom = mPressFrom - shift;
+    mTo = mPressTo - shift;
+    update();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mouseReleaseEvent
+
+Purpose		Ends a pan, or picks the sample clicked on: of the extremes of
+            the nearest column drawn, the one nearest the cursor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::mouseReleaseEvent( QMouseEvent* event )
+{
+    if ( !mPressed || event->button() != Qt::LeftButton )
+        return;
+
+    mPressed = false;
+    if ( mDragged || mSignal.values.isEmpty() )
+        return;
+
+    const QRect area = plotArea();
+    const int clicked = event->x() - area.left();
+    int column = -1;
+    for ( int d = 0; d <= PICK_REACH && column < 0; ++d )
+    {
+        if ( clicked - d >= 0 && clicked - d < mColLowSample.size()
+             && mColLowSample.at( clicked - d ) >= 0 )
+            column = clicked - d;
+        else if ( clicked + d >= 0 && clicked + d < mColLowSample.size()
+                  && mColLowSample.at( clicked + d ) >= 0 )
+            column = clicked + d;
+    }
+    if ( column < 0 )
+        return;
+
+    const double value = mYLow + ( area.bottom() - event->y() ) * ( mYHigh - mYLow )
+                                 / qMax( area.height(), 1 );
+    const int sample = ( qAbs( value - mColLow.at( column ) ) < qAbs( value - mColHigh.at( column ) ) )
+                       ? mColLowSample.at( column ) : mColHighSample.at( column );
+
+    emit frameClicked( mSignal.frames.at( sample ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mouseDoubleClickEvent
+
+Purpose		Shows the whole signal
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::mouseDoubleClickEvent( QMouseEvent* event )
+{
+    Q_UNUSED( event );
+    fit();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		wheelEvent
+
+Purpose		Zooms about the cursor, ZOOM_STEP a step
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void PlotWidget::wheelEvent( QWheelEvent* event )
+{
+    const QRect area = plotArea();
+    if ( area.width() <= 0 )
+        return;
+
+    const double factor = std::pow( ZOOM_STEP, event->angleDelta().y() / 120.0 );
+    const qint64 anchor = fromColumn( event->pos().x() - area.left(), area.width() );
+    const qint64 span = qMax( qint64( ( mTo - mFrom ) * factor ), qint64( 2 ) );
+
+    mFrom = anchor - qint64( double( anchor - mFrom ) * span / ( mTo - mFrom ) );
+    mTo = mFrom + span;
+    update();
+}
@@ -0,0 +1,102 @@
+/*----------------------------------------------------------------------------
+
+Name		plotwidget.h
+
+Purpose		Plot of one signal against time (or frame number, for dumps
+            without timestamps).  Each paint reads the signal's min / max
+            pyramid at the level that gives every pixel column a bucket or
+            so, so drawing costs the same whether the view holds a hundred
+            samples or a hundred million; the columns are then drawn as
+            vertical min / max bars joined to their neighbours.  Samples are
+            drawn as dots once there is room for them.
+
+            The wheel zooms about the cursor, dragging pans and a double
+            click shows the whole signal.  A single click picks the sample
+            nearest the cursor in its column and hands on its frame.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef PLOTWIDGET_H
+#define PLOTWIDGET_H
+
+#include <QWidget>
+#include "signalpyramid.h"
+#include "signaltable.h"
+
+class PlotWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PlotWidget( const FrameTable& table, QWidget* parent = 0 );
+
+    // Shows a signal, all of it
+    void setSignal( const PdoSignal& signal, const QString& title );
+    // Shows nothing
+    void clear();
+
+    // Returns the pyramid of the signal shown
+    const SignalPyramid& pyramid() const { return mPyramid; }
+
+public slots:
+    // Shows the whole of the signal
+    void fit();
+    // Drops the samples of the first count frames after they have left
+    // the table (see Parser::framesRemoved)
+    void removeFrames( FrameId count );
+
+signals:
+    // emitted with the frame of a sample clicked on
+    void frameClicked( FrameId frame );
+
+protected:
+    void paintEvent( QPaintEvent* event );
+    void mousePressEvent( QMouseEvent* event );
+    void mouseMoveEvent( QMouseEvent* event );
+    void mouseReleaseEvent( QMouseEvent* event );
+    void mouseDoubleClickEvent( QMouseEvent* event );
+    void wheelEvent( QWheelEvent* event );
+
+private:
+    // Returns the position of a sample along the x axis: its timestamp in
+    // microseconds, or its frame
+    qint64 sampleX( int sample ) const;
+    // Returns the first sample at or after a position along the x axis
+    int sampleAt( qint64 x ) const;
+
+    // Returns the area the samples are drawn in
+    QRect plotArea() const;
+    // Converts between positions along the x axis and pixel columns of the
+    // plot area
+    double toColumn( qint64 x, int width ) const;
+    qint64 fromColumn( double column, int width ) const;
+
+    // Gathers the extremes of the samples shown into pixel columns
+    void gatherColumns( int width );
+
+private:
+    const FrameTable& mTable;       // Frames the signal was read from
+    PdoSignal mSignal;              // Signal shown
+    QString mTitle;                 // Its name
+    SignalPyramid mPyramid;         // Min / max levels over mSignal.values
+    bool mHasTime;                  // True if the x axis is time, not frames
+
+    qint64 mFrom;                   // Range of the x axis shown
+    qint64 mTo;
+
+    int mLevel;                     // Pyramid level of the last paint
+    QVector<double> mColLow;        // Extremes in each pixel column, and
+    QVector<double> mColHigh;       // the samples they were read from
+    QVector<int> mColLowSample;     // (-1 for an empty column)
+    QVector<int> mColHighSample;
+    double mYLow;                   // Range of the y axis of the last paint
+    double mYHigh;
+
+    bool mPressed;                  // Mouse button held over the plot
+    bool mDragged;                  // Mouse moved far enough to pan
+    int mPressX;                    // Column the button was pressed at
+    qint64 mPressFrom;              // Range shown when it was pressed
+    qint64 mPressTo;
+};
+
+#endif // PLOTWIDGET_H
@@ -0,0 +1,798 @@
+/*----------------------------------------------------------------------------
+
+Name		sdoassembler.cpp
+
+Purpose		SDO transfer reassembly.  Command bytes follow CiA 301:
+
+                client (0x600)          server (0x580)
+                1  initiate download    3  initiate download response
+                0  download segment     1  download segment response
+                2  initiate upload      2  initiate upload response
+                3  upload segment       0  upload segment response
+                6  block download       5  block download response
+                5  block upload         6  block upload response
+                4  abort                4  abort
+
+            (the command specifier is the top three bits of byte 0).  Inside
+            a block the segments carry a sequence number in byte 0 instead,
+            so the channel state decides how a frame is read.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "sdoassembler.h"
+#include "stageprofile.h"
+#include <QtConcurrent>
+#include <algorithm>
+
+// Steps of a transfer
+enum SdoState
+{
+    SDO_IDLE,
+    SDO_DOWNLOAD,               // Initiate download sent
+    SDO_DOWNLOAD_SEGMENTS,      // Download segments under way
+    SDO_UPLOAD,                 // Initiate upload sent
+    SDO_UPLOAD_SEGMENTS,        // Upload segments under way
+    SDO_BLOCK_DOWNLOAD,         // Initiate block download sent
+    SDO_BLOCK_DOWNLOAD_DATA,    // Client sending sub-blocks
+    SDO_BLOCK_DOWNLOAD_END,     // End block download sent
+    SDO_BLOCK_UPLOAD,           // Initiate block upload sent
+    SDO_BLOCK_UPLOAD_DATA,      // Server sending sub-blocks
+    SDO_BLOCK_UPLOAD_END        // End block upload sent
+};
+
+// Command byte of an abort, from either side
+static const quint8 SDO_ABORT = 0x80;
+
+// Channels per interface, one per node id
+static const int SDO_NODES = 128;
+
+/*----------------------------------------------------------------------------
+
+Name		keyOf
+
+Purpose		Returns the SDO key of the object addressed by a frame that
+            carries the multiplexer (index in bytes 1-2, subindex in byte 3)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline quint32 keyOf( quint64 data )
+{
+    return ( quint32( data >> 8 ) & 0xFFFF ) << 8 | ( quint32( data >> 24 ) & 0xFF );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		isSdo
+
+Purpose		Returns true if a COB-ID belongs to an SDO channel
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline bool isSdo( quint32 cobId )
+{
+    const quint32 func = cobId & ~quint32( 0x7F );
+    return func == 0x580 || func == 0x600;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		SdoChannel
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+SdoChannel::SdoChannel()
+    : state( SDO_IDLE ),
+      lastSegment( false ),
+      lastSeq( 0 ),
+      blockStart( 0 ),
+      start( NO_TIMESTAMP ),
+      transfer()
+{
+}
+
+/*----------------------------------------------------------------------------
+
+Name		touch
+
+Purpose		Extends the transfer in progress to a frame
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline void touch( SdoChannel& ch, FrameId frame, qint64 time )
+{
+    ch.transfer.last = frame;
+    ch.transfer.latency = ( ch.start >= 0 && time >= 0 ) ? time - ch.start : NO_TIMESTAMP;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		addBytes
+
+Purpose		Adds payload bytes to the transfer in progress.  Bytes past
+            SDO_MAX_PAYLOAD are counted but not kept.
+
+Input       bytes - payload bytes, first in the least significant byte
+            count - number of bytes to take
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline void addBytes( SdoChannel& ch, quint64 bytes, int count )
+{
+    if ( count <= 0 )
+        return;
+
+    const int room = qMin( count, SDO_MAX_PAYLOAD - ch.bytes.size() );
+    for ( int i = 0; i < room; ++i )
+        ch.bytes.append( char( bytes >> ( 8 * i ) ) );
+
+    ch.transfer.size += quint32( count );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		trim
+
+Purpose		Cuts the transfer in progress back to a size (segments to be
+            sent again, or padding in the last segment of a block)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline void trim( SdoChannel& ch, quint32 size )
+{
+    if ( size >= ch.transfer.size )
+        return;
+
+    ch.transfer.size = size;
+    if ( ch.bytes.size() > int( size ) )
+        ch.bytes.resize( int( size ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		acknowledge
+
+Purpose		Handles a block acknowledge.  Segments past the one acknowledged
+            are sent again, so their bytes are dropped, and the next sub-block
+            starts after it.
+
+Input       ackSeq - last segment received in sequence
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static inline void acknowledge( SdoChannel& ch, quint8 ackSeq )
+{
+    trim( ch, ch.blockStart + 7u * ackSeq );
+    ch.blockStart = ch.transfer.size;
+
+    if ( ch.lastSegment && ackSeq < ch.lastSeq )
+        ch.lastSegment = false;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		closeTransfer
+
+Purpose		Ends the transfer in progress and hands it to out
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void closeTransfer( SdoChannel& ch, SdoTransfer::Status status, SdoOutput* out )
+{
+    if ( out )
+    {
+        ch.transfer.status = quint8( status );
+        ch.transfer.payload = out->payloads.size();
+        ch.transfer.kept = ch.bytes.size();
+        out->payloads.append( ch.bytes );
+        out->transfers.append( ch.transfer );
+    }
+
+    ch.state = SDO_IDLE;
+    ch.lastSegment = false;
+    ch.bytes.resize( 0 );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		openTransfer
+
+Purpose		Starts a transfer on a channel.  A transfer still in progress
+            is closed as incomplete.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void openTransfer( SdoChannel& ch, FrameId frame, qint64 time, quint8 iface,
+                          quint32 cobId, quint64 data, SdoTransfer::Kind kind,
+                          bool upload, SdoOutput* out )
+{
+    if ( ch.state != SDO_IDLE )
+        closeTransfer( ch, SdoTransfer::INCOMPLETE, out );
+
+    SdoTransfer& t = ch.transfer;
+    t.first = frame;
+    t.last = frame;
+    t.latency = ( time >= 0 ) ? 0 : NO_TIMESTAMP;
+    t.size = 0;
+    t.abortCode = 0;
+    t.payload = 0;
+    t.kept = 0;
+    t.objIdx = quint16( data >> 8 );
+    t.subIdx = quint8( data >> 24 );
+    t.node = quint8( cobId & 0x7F );
+    t.iface = iface;
+    t.kind = quint8( kind );
+    t.status = quint8( SdoTransfer::COMPLETE );
+    t.upload = upload;
+
+    ch.start = time;
+    ch.bytes.resize( 0 );
+    ch.lastSegment = false;
+    ch.blockStart = 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		step
+
+Purpose		Runs one frame through the state machine of its channel
+
+Input       channel - channel of the frame (interface and node)
+            frame   - id of the frame, recorded in the transfers
+            time    - timestamp of the frame, or NO_TIMESTAMP
+            iface, cobId, dlc, data - the frame
+            out     - closed transfers are appended here, unless null
+
+Return      SDO key of the frame: the transfer it belongs to, or the object
+            it addresses, or NO_SDO_KEY
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+quint32 SdoAssembler::step( SdoChannel& ch, FrameId frame, qint64 time,
+                            quint8 iface, quint32 cobId, quint8 dlc, quint64 data,
+                            SdoOutput* out )
+{
+    if ( dlc == 0 )
+        return NO_SDO_KEY;
+
+    const bool client = ( cobId & ~quint32( 0x7F ) ) == 0x600;
+    const quint8 cmd = quint8( data );
+    const quint32 current = quint32( ch.transfer.objIdx ) << 8 | ch.transfer.subIdx;
+
+    // Either side can abort at any point (no segment has sequence number 0)
+    if ( cmd == SDO_ABORT )
+    {
+        if ( ch.state != SDO_IDLE )
+        {
+            touch( ch, frame, time );
+            ch.transfer.abortCode = quint32( data >> 32 );
+            closeTransfer( ch, SdoTransfer::ABORTED, out );
+        }
+        return keyOf( data );
+    }
+
+    // Sub-block segments: sequence number in byte 0, seven data bytes
+    if ( !ch.lastSegment &&
+         ( ( ch.state == SDO_BLOCK_DOWNLOAD_DATA && client ) ||
+           ( ch.state == SDO_BLOCK_UPLOAD_DATA && !client ) ) )
+    {
+        touch( ch, frame, time );
+        addBytes( ch, data >> 8, 7 );
+        if ( cmd & 0x80 )
+        {
+            ch.lastSegment = true;
+            ch.lastSeq = cmd & 0x7F;
+        }
+        return current;
+    }
+
+    if ( client )
+    {
+        switch ( cmd >> 5 )
+        {
+        case 1:     // Initiate download
+        {
+            const bool expedited = ( cmd & 0x02 ) != 0;
+            openTransfer( ch, frame, time, iface, cobId, data,
+                  expedited ? SdoTransfer::EXPEDITED : SdoTransfer::SEGMENTED, false, out );
+            if ( expedited )
+                addBytes( ch, data >> 32, 4 - ( ( cmd & 0x01 ) ? ( cmd >> 2 ) & 3 : 0 ) );
+            ch.state = SDO_DOWNLOAD;
+            return keyOf( data );
+        }
+
+        case 0:     // Download segment
+            if ( ch.state != SDO_DOWNLOAD_SEGMENTS )
+                return NO_SDO_KEY;
+            touch( ch, frame, time );
+            addBytes( ch, data >> 8, 7 - ( ( cmd >> 1 ) & 7 ) );
+            ch.lastSegment = ( cmd & 0x01 ) != 0;
+            return current;
+
+        case 2:     // Initiate upload
+            openTransfer( ch, frame, time, iface, cobId, data, SdoTransfer::SEGMENTED, true, out );
+            ch.state = SDO_UPLOAD;
+            return keyOf( data );
+
+        case 3:     // Upload segment request
+            if ( ch.state != SDO_UPLOAD_SEGMENTS )
+                return NO_SDO_KEY;
+            touch( ch, frame, time );
+            return current;
+
+        case 6:     // Block download: initiate or end
+            if ( ( cmd & 0x01 ) == 0 )
+            {
+                openTransfer( ch, frame, time, iface, cobId, data, SdoTransfer::BLOCK, false, out );
+                ch.state = SDO_BLOCK_DOWNLOAD;
+                return keyOf( data );
+            }
+            if ( ch.state != SDO_BLOCK_DOWNLOAD_DATA )
+                return NO_SDO_KEY;
+            touch( ch, frame, time );
+            trim( ch, ch.transfer.size - ( ( cmd >> 2 ) & 7 ) );
+            ch.state = SDO_BLOCK_DOWNLOAD_END;
+            return current;
+
+        case 5:     // Block upload: initiate, start, acknowledge or end
+            switch ( cmd & 0x03 )
+            {
+            case 0:
+                openTransfer( ch, frame, time, iface, cobId, data, SdoTransfer::BLOCK, true, out );
+                ch.state = SDO_BLOCK_UPLOAD;
+                return keyOf( data );
+
+            case 3:
+                if ( ch.state != SDO_BLOCK_UPLOAD )
+                    return NO_SDO_KEY;
+                touch( ch, frame, time );
+                ch.state = SDO_BLOCK_UPLOAD_DATA;
+                return current;
+
+            case 2:
+                if ( ch.state != SDO_BLOCK_UPLOAD_DATA )
+                    return NO_SDO_KEY;
+                touch( ch, frame, time );
+                acknowledge( ch, quint8( data >> 8 ) );
+                return current;
+
+            default:
+                if ( ch.state != SDO_BLOCK_UPLOAD_END )
+                    return NO_SDO_KEY;
+                touch( ch, frame, time );
+                closeTransfer( ch, SdoTransfer::COMPLETE, out );
+                return current;
+            }
+        }
+
+        return NO_SDO_KEY;
+    }
+
+    switch ( cmd >> 5 )
+    {
+    case 3:         // Initiate download response
+        if ( ch.state != SDO_DOWNLOAD )
+            return keyOf( data );
+        touch( ch, frame, time );
+        if ( ch.transfer.kind == SdoTransfer::EXPEDITED )
+            closeTransfer( ch, SdoTransfer::COMPLETE, out );
+        else
+            ch.state = SDO_DOWNLOAD_SEGMENTS;
+        return current;
+
+    case 1:         // Download segment response
+        if ( ch.state != SDO_DOWNLOAD_SEGMENTS )
+            return NO_SDO_KEY;
+        touch( ch, frame, time );
+        if ( ch.lastSegment )
+            closeTransfer( ch, SdoTransfer::COMPLETE, out );
+        return current;
+
+    case 2:         // Initiate upload response (also the answer to a block
+                    // upload the server chose to send segmented)
+        if ( ch.state != SDO_UPLOAD && ch.state != SDO_BLOCK_UPLOAD )
+            return keyOf( data );
+        touch( ch, frame, time );
+        if ( cmd & 0x02 )
+        {
+            ch.transfer.kind = quint8( SdoTransfer::EXPEDITED );
+            addBytes( ch, data >> 32, 4 - ( ( cmd & 0x01 ) ? ( cmd >> 2 ) & 3 : 0 ) );
+            closeTransfer( ch, SdoTransfer::COMPLETE, out );
+        }
+        else
+        {
+            ch.transfer.kind = quint8( SdoTransfer::SEGMENTED );
+            ch.state = SDO_UPLOAD_SEGMENTS;
+        }
+        return current;
+
+    case 0:         // Upload segment response
+        if ( ch.state != SDO_UPLOAD_SEGMENTS )
+            return NO_SDO_KEY;
+        touch( ch, frame, time );
+        addBytes( ch, data >> 8, 7 - ( ( cmd >> 1 ) & 7 ) );
+        if ( cmd & 0x01 )
+            closeTransfer( ch, SdoTransfer::COMPLETE, out );
+        return current;
+
+    case 5:         // Block download: initiate, acknowledge or end response
+        switch ( cmd & 0x03 )
+        {
+        case 0:
+            if ( ch.state != SDO_BLOCK_DOWNLOAD )
+                return keyOf( data );
+            touch( ch, frame, time );
+            ch.state = SDO_BLOCK_DOWNLOAD_DATA;
+            return current;
+
+        case 2:
+            if ( ch.state != SDO_BLOCK_DOWNLOAD_DATA )
+                return NO_SDO_KEY;
+            touch( ch, frame, time );
+            acknowledge( ch, quint8( data >> 8 ) );
+            return current;
+
+        case 1:
+            if ( ch.state != SDO_BLOCK_DOWNLOAD_END )
+                return NO_SDO_KEY;
+            touch( ch, frame, time );
+            closeTransfer( ch, SdoTransfer::COMPLETE, out );
+            return current;
+        }
+        return NO_SDO_KEY;
+
+    case 6:         // Block upload: initiate or end
+        if ( ( cmd & 0x01 ) == 0 )
+        {
+            if ( ch.state != SDO_BLOCK_UPLOAD )
+                return keyOf( data );
+            touch( ch, frame, time );
+            return current;
+        }
+        if ( ch.state != SDO_BLOCK_UPLOAD_DATA )
+            return NO_SDO_KEY;
+        touch( ch, frame, time );
+        trim( ch, ch.transfer.size - ( ( cmd >> 2 ) & 7 ) );
+        ch.state = SDO_BLOCK_UPLOAD_END;
+        return current;
+    }
+
+    return NO_SDO_KEY;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Removes all transfers and keys
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SdoTable::clear()
+{
+    mTransfers.clear();
+    mPayloads.clear();
+    mByObject.clear();
+    mFrameKeys.clear();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		payload
+
+Purpose		Returns the payload bytes kept for a transfer
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QByteArray SdoTable::payload( int i ) const
+{
+    const SdoTransfer& t = mTransfers.at( i );
+    return mPayloads.mid( t.payload, t.kept );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		removeFirst
+
+Purpose		Forgets the oldest frames.  Transfers that closed among them are
+            dropped along with their payload bytes; a transfer that opened
+            among them but closed later is kept with frame 0 as its first.
+
+Input       count - number of frames removed from the front of the table
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SdoTable::removeFirst( FrameId count )
+{
+    count = qMin( count, FrameId( mFrameKeys.size() ) );
+    if ( count == 0 )
+        return;
+
+    mFrameKeys.remove( 0, int( count ) );
+
+    QVector<SdoTransfer> transfers;
+    QByteArray payloads;
+    mByObject.clear();
+
+    for ( int i = 0; i < mTransfers.size(); ++i )
+    {
+        SdoTransfer t = mTransfers.at(i);
+        if ( t.last < count )
+            continue;
+
+        t.first = ( t.first < count ) ? 0 : t.first - count;
+        t.last -= count;
+
+        const int offset = payloads.size();
+        payloads.append( mPayloads.constData() + t.payload, t.kept );
+        t.payload = offset;
+
+        mByObject[ t.objIdx ].append( transfers.size() );
+        transfers.append( t );
+    }
+
+    mTransfers = transfers;
+    mPayloads = payloads;
+}
+
+// Reassembly of the frames of one node, run on a worker thread
+struct SdoNodeWork
+{
+    const FrameTable* table;
+    const FrameIndex* index;
+    quint32* keys;                  // SDO key column, written for this node's frames
+    quint32 node;
+    int ifaceCount;
+    QVector<SdoChannel> channels;   // Channel of each interface
+    SdoOutput out;
+};
+
+/*----------------------------------------------------------------------------
+
+Name		assembleNode
+
+Purpose		Runs the client and server frames of one node through their
+            channels, in frame order
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void assembleNode( SdoNodeWork& work )
+{
+    const QVector<FrameId> server = work.index->cobPostings( 0x580 + work.node );
+    const QVector<FrameId> client = work.index->cobPostings( 0x600 + work.node );
+    if ( server.isEmpty() && client.isEmpty() )
+        return;
+
+    QVector<const FrameId*> begins;
+    QVector<const FrameId*> ends;
+    begins << server.constData() << client.constData();
+    ends << server.constData() + server.size() << client.constData() + client.size();
+    const QVector<FrameId> frames = FrameIndex::unite( begins, ends );
+
+    const qint64* times = work.table->times().constData();
+    const quint8* ifaces = work.table->ifaceIds().constData();
+    const quint32* cobIds = work.table->cobIds().constData();
+    const quint8* dlcs = work.table->dlcs().constData();
+    const quint64* data = work.table->payloads().constData();
+
+    work.channels.resize( work.ifaceCount );
+    for ( int i = 0; i < frames.size(); ++i )
+    {
+        const FrameId f = frames.at(i);
+        work.keys[f] = SdoAssembler::step( work.channels[ ifaces[f] ], f, times[f],
+                                           ifaces[f], cobIds[f], dlcs[f], data[f],
+                                           &work.out );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		closedBefore
+
+Purpose		Orders transfers by the frame that closed them
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool closedBefore( const SdoTransfer& a, const SdoTransfer& b )
+{
+    return a.last < b.last;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Forgets every channel
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SdoAssembler::clear()
+{
+    mChannels.clear();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		removeFirst
+
+Purpose		Moves the transfers in progress down after the oldest frames of
+            the table have been removed.  A transfer that opened among them
+            keeps frame 0 as its first.
+
+Input       count - number of frames removed from the front of the table
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SdoAssembler::removeFirst( FrameId count )
+{
+    for ( int i = 0; i < mChannels.size(); ++i )
+    {
+        SdoTransfer& t = mChannels[i].transfer;
+        t.first = ( t.first < count ) ? 0 : t.first - count;
+        t.last = ( t.last < count ) ? 0 : t.last - count;
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		build
+
+Purpose		Reassembles a table from scratch.  The indexed frames are split
+            by node, and each node is run on its own worker off the posting
+            lists, so only SDO frames are read.  Frames past the index are
+            then streamed in.
+
+Input       table - frames to reassemble
+            index - posting lists over table
+            sdo   - filled with the transfers and keys
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Times the index stage
+----------------------------------------------------------------------------*/
+void SdoAssembler::build( const FrameTable& table, const FrameIndex& index,
+                          SdoTable& sdo )
+{
+    StageTimer stage( STAGE_INDEX, table.size() );
+    clear();
+    sdo.clear();
+
+    const int ifaceCount = table.ifaces().size();
+    sdo.mFrameKeys.fill( NO_SDO_KEY, index.size() );
+
+    QVector<SdoNodeWork> work( SDO_NODES );
+    for ( int n = 0; n < SDO_NODES; ++n )
+    {
+        work[n].table = &table;
+        work[n].index = &index;
+        work[n].keys = sdo.mFrameKeys.data();
+        work[n].node = quint32( n );
+        work[n].ifaceCount = ifaceCount;
+    }
+
+    QtConcurrent::blockingMap( work, assembleNode );
+
+    // Gather the channels and closed transfers of every node
+    mChannels.resize( ifaceCount * SDO_NODES );
+    SdoOutput out;
+    for ( int n = 0; n < SDO_NODES; ++n )
+    {
+        SdoNodeWork& w = work[n];
+        for ( int i = 0; i < w.channels.size(); ++i )
+            mChannels[ i * SDO_NODES + n ] = w.channels.at(i);
+
+        for ( int i = 0; i < w.out.transfers.size(); ++i )
+            w.out.transfers[i].payload += out.payloads.size();
+        out.payloads += w.out.payloads;
+        out.transfers += w.out.transfers;
+    }
+
+    std::sort( out.transfers.begin(), out.transfers.end(), closedBefore );
+    store( out, sdo );
+
+    append( table, sdo );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		append
+
+Purpose		Streams the frames appended to a table since the last build or
+            append through their channels
+
+Input       table - table the frames were appended to
+            sdo   - transfers and keys of the earlier frames
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SdoAssembler::append( const FrameTable& table, SdoTable& sdo )
+{
+    const int first = sdo.mFrameKeys.size();
+    if ( first >= table.size() )
+        return;
+
+    sdo.mFrameKeys.reserve( table.size() );
+
+    const qint64* times = table.times().constData();
+    const quint8* ifaces = table.ifaceIds().constData();
+    const quint32* cobIds = table.cobIds().constData();
+    const quint8* dlcs = table.dlcs().constData();
+    const quint64* data = table.payloads().constData();
+
+    SdoOutput out;
+    for ( int i = first; i < table.size(); ++i )
+    {
+        quint32 key = NO_SDO_KEY;
+        if ( isSdo( cobIds[i] ) )
+            key = step( channel( ifaces[i], cobIds[i] & 0x7F ), FrameId( i ), times[i],
+                        ifaces[i], cobIds[i], dlcs[i], data[i], &out );
+        sdo.mFrameKeys.append( key );
+    }
+
+    store( out, sdo );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		feed
+
+Purpose		Streams a frame that is not held in a table (e.g. in the headless
+            filter) through its channel
+
+Input       rec - tokenized frame
+
+Return      SDO key of the frame
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+quint32 SdoAssembler::feed( const FrameRecord& rec )
+{
+    if ( !isSdo( rec.cobId ) )
+        return NO_SDO_KEY;
+
+    return step( channel( rec.iface, rec.cobId & 0x7F ), 0, rec.time,
+                 rec.iface, rec.cobId, rec.dlc, rec.data, 0 );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		channel
+
+Purpose		Returns the channel of a node on an interface, adding channels
+            for the interface if it is new
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+SdoChannel& SdoAssembler::channel( quint8 iface, quint32 node )
+{
+    const int index = int( iface ) * SDO_NODES + int( node );
+    if ( index >= mChannels.size() )
+        mChannels.resize( ( int( iface ) + 1 ) * SDO_NODES );
+
+    return mChannels[ index ];
+}
+
+/*----------------------------------------------------------------------------
+
+Name		store
+
+Purpose		Adds closed transfers to a table and files them by object index
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SdoAssembler::store( SdoOutput& out, SdoTable& sdo )
+{
+    const int base = sdo.mPayloads.size();
+    sdo.mTransfers.reserve( sdo.mTransfers.size() + out.transfers.size() );
+
+    for ( int i = 0; i < out.transfers.size(); ++i )
+    {
+        SdoTransfer& t = out.transfers[i];
+        t.payload += base;
+        sdo.mByObject[ t.objIdx ].append( sdo.mTransfers.size() );
+        sdo.mTransfers.append( t );
+    }
+
+    sdo.mPayloads += out.payloads;
+}
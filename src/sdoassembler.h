@@ -0,0 +1,158 @@
+/*----------------------------------------------------------------------------
+
+Name		sdoassembler.h
+
+Purpose		Reassembles SDO transfers out of the frames of a dump.  A single
+            SDO frame only says which object it belongs to when it opens or
+            aborts a transfer; the segments that follow carry payload in the
+            bytes where the object index would be.  Every client / server
+            channel (0x600 + node / 0x580 + node on one interface) is run
+            through a small state machine that follows expedited, segmented
+            and block transfers, so that:
+
+                - every SDO frame of a transfer is tagged with the object
+                  index and subindex of that transfer (its SDO key)
+                - each finished transfer is recorded with its payload,
+                  abort code and latency
+
+            Channels are independent, so a whole table is reassembled one
+            node per worker off the posting lists of the frame index.  The
+            state held per channel is bounded: payloads are kept up to
+            SDO_MAX_PAYLOAD bytes and only counted past that.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef SDOASSEMBLER_H
+#define SDOASSEMBLER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+#include "frameindex.h"
+#include "frametable.h"
+
+// SDO key of a frame that is not part of a known transfer.  Keys of other
+// frames are object index << 8 | subindex.
+const quint32 NO_SDO_KEY = 0xFFFFFFFF;
+
+// Largest number of payload bytes kept for one transfer
+const int SDO_MAX_PAYLOAD = 4096;
+
+// A reassembled SDO transfer
+struct SdoTransfer
+{
+    enum Kind   { EXPEDITED, SEGMENTED, BLOCK };
+    enum Status { COMPLETE, ABORTED, INCOMPLETE };
+
+    FrameId first;          // Frame that opened the transfer
+    FrameId last;           // Frame that closed it
+    qint64  latency;        // Microseconds from first to last, or NO_TIMESTAMP
+    quint32 size;           // Payload bytes transferred
+    quint32 abortCode;      // SDO abort code, if aborted
+    int     payload;        // Offset of the kept bytes in the payload store
+    int     kept;           // Payload bytes kept (at most SDO_MAX_PAYLOAD)
+    quint16 objIdx;         // Object index
+    quint8  subIdx;         // Subindex
+    quint8  node;           // Server node id
+    quint8  iface;          // Interface id
+    quint8  kind;           // Kind
+    quint8  status;         // Status
+    bool    upload;         // True for uploads (server to client)
+};
+
+// Transfers and SDO keys of a frame table
+class SdoTable
+{
+public:
+    // Removes all transfers and keys
+    void clear();
+
+    // Number of transfers held
+    int size() const { return mTransfers.size(); }
+    // Returns a transfer
+    const SdoTransfer& at( int i ) const { return mTransfers.at( i ); }
+    // Returns the payload bytes kept for a transfer
+    QByteArray payload( int i ) const;
+
+    // Returns the transfers of an object index, in the order they closed
+    QVector<int> transfersOf( quint16 objIdx ) const
+        { return mByObject.value( objIdx ); }
+
+    // Returns the SDO key of a frame
+    quint32 frameKey( FrameId frame ) const { return mFrameKeys.at( frame ); }
+    // Returns the SDO keys of every frame reassembled so far
+    const QVector<quint32>& frameKeys() const { return mFrameKeys; }
+
+    // Drops the keys of the first count frames and the transfers that
+    // closed among them, and moves the rest down to match
+    // FrameTable::removeFirst
+    void removeFirst( FrameId count );
+
+private:
+    friend class SdoAssembler;
+
+    QVector<SdoTransfer> mTransfers;        // Transfers, in the order they closed
+    QByteArray mPayloads;                   // Kept bytes of every transfer
+    QHash<quint16, QVector<int> > mByObject;// Transfers by object index
+    QVector<quint32> mFrameKeys;            // SDO key of every frame
+};
+
+// State of one client / server channel
+struct SdoChannel
+{
+    SdoChannel();
+
+    quint8 state;           // Step of the transfer in progress
+    bool lastSegment;       // Block transfer: last segment seen
+    quint8 lastSeq;         // Block transfer: sequence number of that segment
+    quint32 blockStart;     // Block transfer: bytes before the sub-block
+    qint64 start;           // Timestamp of the opening frame
+    SdoTransfer transfer;   // Transfer in progress
+    QByteArray bytes;       // Payload kept so far
+};
+
+// Transfers closed by a run of the state machine
+struct SdoOutput
+{
+    QVector<SdoTransfer> transfers;
+    QByteArray payloads;
+};
+
+class SdoAssembler
+{
+public:
+    // Forgets every channel
+    void clear();
+
+    // Reassembles the indexed frames of a table from scratch, one node per
+    // worker, then streams in any frames past the index
+    void build( const FrameTable& table, const FrameIndex& index, SdoTable& sdo );
+
+    // Streams the frames appended to the table since the last call
+    void append( const FrameTable& table, SdoTable& sdo );
+
+    // Moves the transfers in progress down to match
+    // FrameTable::removeFirst
+    void removeFirst( FrameId count );
+
+    // Streams a frame not held in a table and returns its SDO key.  No
+    // transfers are recorded.
+    quint32 feed( const FrameRecord& rec );
+
+    // Runs one frame through a channel.  Closed transfers are appended to
+    // out unless it is null.  Returns the SDO key of the frame.
+    static quint32 step( SdoChannel& channel, FrameId frame, qint64 time,
+                         quint8 iface, quint32 cobId, quint8 dlc, quint64 data,
+                         SdoOutput* out );
+
+private:
+    // Returns the channel of a node on an interface
+    SdoChannel& channel( quint8 iface, quint32 node );
+    // Adds closed transfers to the table
+    static void store( SdoOutput& out, SdoTable& sdo );
+
+private:
+    QVector<SdoChannel> mChannels;  // 128 channels per interface
+};
+
+#endif // SDOASSEMBLER_H
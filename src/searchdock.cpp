@@ -0,0 +1,126 @@
+/*----------------------------------------------------------------------------
+
+Name		searchdock.cpp
+
+Purpose		Dock searching the raw lines of the loaded dumps.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "searchdock.h"
+#include "parser.h"
+#include <QFont>
+#include <QHBoxLayout>
+#include <QListView>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+/*----------------------------------------------------------------------------
+
+Name		SearchDock
+
+Purpose		Constructor.  Builds the controls and the list of lines found.
+
+Input       parser - parser whose dumps are searched
+            parent - owning widget
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+SearchDock::SearchDock( Parser& parser, QWidget* parent )
+    : QDockWidget( tr( "Search" ), parent ),
+      mParser( parser ),
+      mModel( parser )
+{
+    setObjectName( "mSearchDock" );
+
+    QWidget* body = new QWidget( this );
+
+    mPatternEdit = new QLineEdit( body );
+    mPatternEdit->setPlaceholderText( tr( "Text to find in the dump lines" ) );
+
+    mRegexChk = new QCheckBox( tr( "Regex" ), body );
+    mCaseChk = new QCheckBox( tr( "Match case" ), body );
+    QPushButton* searchBtn = new QPushButton( tr( "Search" ), body );
+
+    QHBoxLayout* controls = new QHBoxLayout;
+    controls->addWidget( mPatternEdit );
+    controls->addWidget( mRegexChk );
+    controls->addWidget( mCaseChk );
+    controls->addWidget( searchBtn );
+
+    mStatusLbl = new QLabel( body );
+
+    QFont font;
+    font.setFamily( "Courier" );
+    font.setPointSize( 11 );
+
+    QListView* view = new QListView( body );
+    view->setModel( &mModel );
+    view->setFont( font );
+    view->setUniformItemSizes( true );
+
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->addLayout( controls );
+    layout->addWidget( mStatusLbl );
+    layout->addWidget( view );
+    body->setLayout( layout );
+    setWidget( body );
+
+    LineSearch* lineSearch = &mParser.lineSearch();
+
+    connect( searchBtn,             SIGNAL( clicked() ),
+             this,                  SLOT( search() ) );
+    connect( mPatternEdit,          SIGNAL( returnPressed() ),
+             this,                  SLOT( search() ) );
+    connect( lineSearch,            SIGNAL( hitsCleared() ),
+             &mModel,               SLOT( clearHits() ) );
+    connect( lineSearch,            SIGNAL( hitsAdded( QVector<qint64> ) ),
+             &mModel,               SLOT( appendHits( QVector<qint64> ) ) );
+    connect( lineSearch,            SIGNAL( progressChanged( int ) ),
+             this,                  SLOT( showProgress( int ) ) );
+    connect( lineSearch,            SIGNAL( finished( QString ) ),
+             mStatusLbl,            SLOT( setText( QString ) ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		search
+
+Purpose		Starts searching for the pattern entered, or says why it cannot
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SearchDock::search()
+{
+    const QString pattern = mPatternEdit->text();
+    if ( pattern.isEmpty() )
+    {
+        mParser.lineSearch().cancel();
+        mModel.clearHits();
+        mStatusLbl->clear();
+        return;
+    }
+
+    QString error;
+    if ( !mParser.lineSearch().search( pattern, mRegexChk->isChecked(),
+                                       mCaseChk->isChecked(), error ) )
+    {
+        mStatusLbl->setText( tr( "Invalid expression: %1" ).arg( error ) );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		showProgress
+
+Purpose		Shows how far the search has got, until its summary arrives
+
+Input       percent - share of the candidate blocks searched
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SearchDock::showProgress( int percent )
+{
+    if ( percent < 100 )
+        mStatusLbl->setText( tr( "Searching... %1 %" ).arg( percent ) );
+}
@@ -0,0 +1,48 @@
+/*----------------------------------------------------------------------------
+
+Name		searchdock.h
+
+Purpose		Dock searching the raw lines of the loaded dumps for text or a
+            regular expression.  Matching lines stream into the list as the
+            search finds them, independently of the frame filter.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef SEARCHDOCK_H
+#define SEARCHDOCK_H
+
+#include <QCheckBox>
+#include <QDockWidget>
+#include <QLabel>
+#include <QLineEdit>
+#include "searchmodel.h"
+
+class Parser;
+
+class SearchDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SearchDock( Parser& parser, QWidget* parent = 0 );
+
+public slots:
+    // Starts searching for the pattern entered
+    void search();
+
+private slots:
+    // Shows how far the search has got
+    void showProgress( int percent );
+
+private:
+    Parser& mParser;                // Owner of the dumps and their search
+
+    SearchModel mModel;             // Lines found
+
+    QLineEdit* mPatternEdit;        // Text or expression to find
+    QCheckBox* mRegexChk;           // Pattern is a regular expression
+    QCheckBox* mCaseChk;            // Letters must match in case
+    QLabel* mStatusLbl;             // Progress, then a summary of the search
+};
+
+#endif // SEARCHDOCK_H
@@ -0,0 +1,100 @@
+/*----------------------------------------------------------------------------
+
+Name		searchmodel.cpp
+
+Purpose		List model over the lines found by a line search.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "searchmodel.h"
+#include "parser.h"
+
+/*----------------------------------------------------------------------------
+
+Name		SearchModel
+
+Purpose		Constructor
+
+Input       parser - parser the text of the lines is read from
+            parent - owning object
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+SearchModel::SearchModel( const Parser& parser, QObject* parent )
+    : QAbstractListModel( parent ),
+      mParser( parser )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		rowCount
+
+Purpose		Returns the number of lines found
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int SearchModel::rowCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() )
+        return 0;
+
+    return mOffsets.size();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		data
+
+Purpose		Returns the line in the given row.  Called by the view for
+            visible rows only.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant SearchModel::data( const QModelIndex& index, int role ) const
+{
+    if ( !index.isValid() || index.row() >= mOffsets.size() )
+        return QVariant();
+
+    if ( role == Qt::DisplayRole )
+        return mParser.rawLine( mOffsets.at( index.row() ) );
+
+    return QVariant();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clearHits
+
+Purpose		Removes every row, when a search starts or the dumps change
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SearchModel::clearHits()
+{
+    beginResetModel();
+    mOffsets.clear();
+    endResetModel();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		appendHits
+
+Purpose		Adds rows to the end of the model as the search finds more lines
+
+Input       offsets - offsets of the lines to add, in file order
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SearchModel::appendHits( const QVector<qint64>& offsets )
+{
+    if ( offsets.isEmpty() )
+        return;
+
+    beginInsertRows( QModelIndex(), mOffsets.size(), mOffsets.size() + offsets.size() - 1 );
+    mOffsets += offsets;
+    endInsertRows();
+}
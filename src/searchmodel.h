@@ -0,0 +1,41 @@
+/*----------------------------------------------------------------------------
+
+Name		searchmodel.h
+
+Purpose		List model over the lines found by a line search.  Only the
+            offsets of the lines are held; the text of a row is read back
+            from the parser's mapped dumps when the view asks for it.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef SEARCHMODEL_H
+#define SEARCHMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+
+class Parser;
+
+class SearchModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit SearchModel( const Parser& parser, QObject* parent = 0 );
+
+    // QAbstractListModel interface
+    int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+    QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+
+public slots:
+    // Removes every row
+    void clearHits();
+    // Adds rows for the given lines to the end of the model
+    void appendHits( const QVector<qint64>& offsets );
+
+private:
+    const Parser& mParser;          // Source of the row text
+    QVector<qint64> mOffsets;       // Lines shown, one per row
+};
+
+#endif // SEARCHMODEL_H
@@ -0,0 +1,118 @@
+/*----------------------------------------------------------------------------
+
+Name		signaldock.cpp
+
+Purpose		Dock listing the signals the PDOs carry.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "signaldock.h"
+#include "parser.h"
+#include <QElapsedTimer>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTableView>
+#include <QVBoxLayout>
+
+/*----------------------------------------------------------------------------
+
+Name		SignalDock
+
+Purpose		Constructor.  Builds the controls and the table.
+
+Input       parser - parser the signals are extracted by
+            parent - owning widget
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Hands on signals double clicked
+----------------------------------------------------------------------------*/
+SignalDock::SignalDock( Parser& parser, QWidget* parent )
+    : QDockWidget( tr( "Signals" ), parent ),
+      mParser( parser )
+{
+    setObjectName( "mSignalDock" );
+
+    QWidget* body = new QWidget( this );
+
+    QPushButton* refreshBtn = new QPushButton( tr( "Refresh" ), body );
+    mStatusLbl = new QLabel( body );
+
+    QHBoxLayout* controls = new QHBoxLayout;
+    controls->addWidget( mStatusLbl, 1 );
+    controls->addWidget( refreshBtn );
+
+    mProxy.setSourceModel( &mModel );
+    mProxy.setSortRole( Qt::UserRole );
+
+    QTableView* view = new QTableView( body );
+    view->setModel( &mProxy );
+    view->setSortingEnabled( true );
+    view->setSelectionBehavior( QAbstractItemView::SelectRows );
+    view->setAlternatingRowColors( true );
+    view->verticalHeader()->hide();
+    view->horizontalHeader()->setStretchLastSection( true );
+
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->addLayout( controls );
+    layout->addWidget( view );
+    body->setLayout( layout );
+    setWidget( body );
+
+    connect( refreshBtn,            SIGNAL( clicked() ),
+             this,                  SLOT( refresh() ) );
+    connect( view,                  SIGNAL( doubleClicked( QModelIndex ) ),
+             this,                  SLOT( activate( QModelIndex ) ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		refresh
+
+Purpose		Extracts the parser's signals again and shows them
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Tells when it is done
+----------------------------------------------------------------------------*/
+void SignalDock::refresh()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    mParser.extractSignals();
+    const SignalTable& table = mParser.pdoSignals();
+    mModel.setSignals( table, mParser.dictionary() );
+
+    qint64 samples = 0;
+    for ( int i = 0; i < table.size(); ++i )
+        samples += table.at(i).values.size();
+
+    if ( table.isEmpty() && mParser.dictionary().isEmpty() )
+        mStatusLbl->setText( tr( "No PDO mapping: load an object dictionary, "
+                                 "or a dump that maps PDOs by SDO" ) );
+    else
+        mStatusLbl->setText( tr( "%1 signals, %2 samples extracted in %3 ms" )
+                             .arg( table.size() )
+                             .arg( samples )
+                             .arg( timer.elapsed() ) );
+
+    emit refreshed();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		activate
+
+Purpose		Hands on the signal of a row double clicked on.  The model lists
+            the signals in table order, so its row is the signal's position.
+
+Input       index - cell double clicked, in the sort proxy
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SignalDock::activate( const QModelIndex& index )
+{
+    if ( index.isValid() )
+        emit signalActivated( mProxy.mapToSource( index ).row() );
+}
@@ -0,0 +1,53 @@
+/*----------------------------------------------------------------------------
+
+Name		signaldock.h
+
+Purpose		Dock listing the signals the PDOs carry, as mapped by the object
+            dictionaries and any SDO remapping in the dump, with the minimum,
+            maximum and mean of each.  The signals are extracted when the
+            dock is refreshed, not as frames arrive.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef SIGNALDOCK_H
+#define SIGNALDOCK_H
+
+#include <QDockWidget>
+#include <QLabel>
+#include <QSortFilterProxyModel>
+#include "signalmodel.h"
+
+class Parser;
+
+class SignalDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SignalDock( Parser& parser, QWidget* parent = 0 );
+
+public slots:
+    // Extracts the parser's signals again
+    void refresh();
+
+signals:
+    // emitted once the signals have been extracted again
+    void refreshed();
+    // emitted with the position in the parser's signal table of a signal
+    // double clicked on
+    void signalActivated( int signal );
+
+private slots:
+    // Hands on the signal of a row double clicked on
+    void activate( const QModelIndex& index );
+
+private:
+    Parser& mParser;                // Owner of the frames and their signals
+
+    SignalModel mModel;             // Rows per signal
+    QSortFilterProxyModel mProxy;
+
+    QLabel* mStatusLbl;             // Summary of the last extraction
+};
+
+#endif // SIGNALDOCK_H
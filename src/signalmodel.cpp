@@ -0,0 +1,233 @@
+/*----------------------------------------------------------------------------
+
+Name		signalmodel.cpp
+
+Purpose		Table model over the PDO signals of a SignalTable.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "signalmodel.h"
+
+// Columns of the view
+enum SignalColumn
+{
+    SIG_NAME,
+    SIG_OBJECT,
+    SIG_NODE,
+    SIG_PDO,
+    SIG_SAMPLES,
+    SIG_MIN,
+    SIG_MAX,
+    SIG_MEAN,
+    SIG_UNIT,
+    SIG_REMAPS,
+    SIG_COLUMNS
+};
+
+/*----------------------------------------------------------------------------
+
+Name		SignalModel
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+SignalModel::SignalModel( QObject* parent )
+    : QAbstractTableModel( parent )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setSignals
+
+Purpose		Replaces the rows.  Names and units are looked up once here, as
+            the entries they come from change when a dictionary is loaded.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SignalModel::setSignals( const SignalTable& table, const ObjectDictionary& dictionary )
+{
+    beginResetModel();
+    mSignals.clear();
+    mNames.clear();
+    mUnits.clear();
+
+    for ( int i = 0; i < table.size(); ++i )
+    {
+        const PdoSignal& signal = table.at(i);
+        mSignals.append( signal );
+
+        if ( signal.entry >= 0 )
+        {
+            const OdEntry& entry = dictionary.entry( signal.entry );
+            mNames << dictionary.string( entry.name );
+            mUnits << ( ( entry.unit >= 0 ) ? dictionary.string( entry.unit ) : QString() );
+        }
+        else
+        {
+            mNames << QString();
+            mUnits << QString();
+        }
+    }
+    endResetModel();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		rowCount
+
+Purpose		Returns the number of signals
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int SignalModel::rowCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() )
+        return 0;
+
+    return mSignals.size();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		columnCount
+
+Purpose		Returns the number of columns
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int SignalModel::columnCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() )
+        return 0;
+
+    return SIG_COLUMNS;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		data
+
+Purpose		Returns the text of a cell, its value for sorting, or its
+            alignment (numbers are right aligned)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant SignalModel::data( const QModelIndex& index, int role ) const
+{
+    if ( !index.isValid() || index.row() >= rowCount() )
+        return QVariant();
+
+    const int column = index.column();
+    switch ( role )
+    {
+    case Qt::DisplayRole:
+        return text( index.row(), column );
+    case Qt::UserRole:
+        return value( index.row(), column );
+    case Qt::TextAlignmentRole:
+        if ( column == SIG_NAME || column == SIG_PDO || column == SIG_UNIT )
+            return int( Qt::AlignLeft | Qt::AlignVCenter );
+        return int( Qt::AlignRight | Qt::AlignVCenter );
+    default:
+        return QVariant();
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		headerData
+
+Purpose		Returns the column titles
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant SignalModel::headerData( int section, Qt::Orientation orientation, int role ) const
+{
+    if ( orientation != Qt::Horizontal || role != Qt::DisplayRole )
+        return QVariant();
+
+    switch ( section )
+    {
+    case SIG_NAME:      return tr( "Signal" );
+    case SIG_OBJECT:    return tr( "Object" );
+    case SIG_NODE:      return tr( "Node" );
+    case SIG_PDO:       return tr( "PDO" );
+    case SIG_SAMPLES:   return tr( "Samples" );
+    case SIG_MIN:       return tr( "Min" );
+    case SIG_MAX:       return tr( "Max" );
+    case SIG_MEAN:      return tr( "Mean" );
+    case SIG_UNIT:      return tr( "Unit" );
+    case SIG_REMAPS:    return tr( "Remaps" );
+    }
+    return QVariant();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		value
+
+Purpose		Returns the value a cell sorts by.  PDOs sort TPDOs after RPDOs.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant SignalModel::value( int row, int column ) const
+{
+    const PdoSignal& s = mSignals.at( row );
+    switch ( column )
+    {
+    case SIG_NAME:      return mNames.at( row );
+    case SIG_OBJECT:    return s.objKey;
+    case SIG_NODE:      return s.node;
+    case SIG_PDO:       return ( s.receive ? 0 : 0x10000 ) + s.pdo;
+    case SIG_SAMPLES:   return s.values.size();
+    case SIG_MIN:       return s.min;
+    case SIG_MAX:       return s.max;
+    case SIG_MEAN:      return s.mean();
+    case SIG_UNIT:      return mUnits.at( row );
+    case SIG_REMAPS:    return s.remaps;
+    }
+    return QVariant();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		text
+
+Purpose		Returns the text of a cell.  Objects not in a dictionary are
+            named by their index and subindex.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QString SignalModel::text( int row, int column ) const
+{
+    const PdoSignal& s = mSignals.at( row );
+    switch ( column )
+    {
+    case SIG_NAME:
+        if ( !mNames.at( row ).isEmpty() )
+            return mNames.at( row );
+        // fall through
+    case SIG_OBJECT:
+        return QString( "%1.%2" ).arg( s.objKey >> 8, 4, 16, QChar( '0' ) )
+                                 .arg( s.objKey & 0xFF, 2, 16, QChar( '0' ) ).toUpper();
+    case SIG_NODE:
+        return QString( "%1" ).arg( s.node, 2, 16, QChar( '0' ) ).toUpper();
+    case SIG_PDO:
+        return QString( "%1%2" ).arg( s.receive ? "RPDO" : "TPDO" ).arg( s.pdo );
+    case SIG_SAMPLES:
+        return QString::number( s.values.size() );
+    case SIG_MIN:
+    case SIG_MAX:
+    case SIG_MEAN:
+        return QString::number( value( row, column ).toDouble(), 'g', 8 );
+    case SIG_UNIT:
+        return mUnits.at( row );
+    case SIG_REMAPS:
+        return QString::number( s.remaps );
+    }
+    return QString();
+}
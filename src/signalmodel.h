@@ -0,0 +1,52 @@
+/*----------------------------------------------------------------------------
+
+Name		signalmodel.h
+
+Purpose		Table model over the PDO signals of a SignalTable, one row per
+            signal with its place, sample count and minimum, maximum and
+            mean.  Every cell also carries its raw number under Qt::UserRole
+            so a sort proxy orders rows by value rather than by text.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef SIGNALMODEL_H
+#define SIGNALMODEL_H
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include "signaltable.h"
+
+class SignalModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit SignalModel( QObject* parent = 0 );
+
+    // Replaces the rows with the signals of a table, named from the
+    // dictionaries they were extracted with
+    void setSignals( const SignalTable& table, const ObjectDictionary& dictionary );
+
+    // Returns the signal shown in a row
+    const PdoSignal& signalAt( int row ) const { return mSignals.at( row ); }
+
+    // QAbstractTableModel interface
+    int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+    int columnCount( const QModelIndex& parent = QModelIndex() ) const;
+    QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+    QVariant headerData( int section, Qt::Orientation orientation,
+                         int role = Qt::DisplayRole ) const;
+
+private:
+    // Returns the value of a cell (Qt::UserRole)
+    QVariant value( int row, int column ) const;
+    // Returns the text of a cell
+    QString text( int row, int column ) const;
+
+private:
+    QVector<PdoSignal> mSignals;    // Rows (the columns are shared, not copied)
+    QStringList mNames;             // Name of each row's object
+    QStringList mUnits;             // Unit of each row's object
+};
+
+#endif // SIGNALMODEL_H
@@ -0,0 +1,194 @@
+/*----------------------------------------------------------------------------
+
+Name		signalpyramid.cpp
+
+Purpose		Min / max decimation pyramid over the values of a signal.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "signalpyramid.h"
+#include <QtConcurrent>
+
+// Buckets of level 1 built by one worker
+static const int LOD_CHUNK = 64 * 1024;
+
+// Buckets of level 1 to build, run on a worker thread
+struct LodChunk
+{
+    const double* values;
+    int samples;                // Samples of the signal
+    int begin;                  // Buckets built
+    int end;
+    LodBucket* out;
+};
+
+/*----------------------------------------------------------------------------
+
+Name		buildChunk
+
+Purpose		Builds buckets of level 1 straight from the samples
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Keeps the extremes as doubles
+----------------------------------------------------------------------------*/
+static void buildChunk( LodChunk& chunk )
+{
+    for ( int b = chunk.begin; b < chunk.end; ++b )
+    {
+        const int first = b * LOD_BASE;
+        const int last = qMin( first + LOD_BASE, chunk.samples );
+
+        int lo = first;
+        int hi = first;
+        for ( int i = first + 1; i < last; ++i )
+        {
+            lo = ( chunk.values[i] < chunk.values[ lo ] ) ? i : lo;
+            hi = ( chunk.values[i] > chunk.values[ hi ] ) ? i : hi;
+        }
+
+        LodBucket& bucket = chunk.out[b];
+        bucket.min = chunk.values[ lo ];
+        bucket.max = chunk.values[ hi ];
+        bucket.minSample = quint32( lo );
+        bucket.maxSample = quint32( hi );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		SignalPyramid
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+SignalPyramid::SignalPyramid()
+    : mSamples( 0 )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Removes every level
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SignalPyramid::clear()
+{
+    mSamples = 0;
+    mLevels.clear();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		build
+
+Purpose		Builds the levels.  Level 1 reads every sample, so it is built
+            in chunks across the thread pool; each level after it reads only
+            the level before, a quarter of its size.
+
+Input       values - values of the signal, in sample order
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SignalPyramid::build( const QVector<double>& values )
+{
+    clear();
+    mSamples = values.size();
+    if ( mSamples <= LOD_BASE )
+        return;
+
+    QVector<LodBucket> level( ( mSamples + LOD_BASE - 1 ) / LOD_BASE );
+
+    QVector<LodChunk> chunks;
+    for ( int begin = 0; begin < level.size(); begin += LOD_CHUNK )
+    {
+        LodChunk chunk;
+        chunk.values = values.constData();
+        chunk.samples = mSamples;
+        chunk.begin = begin;
+        chunk.end = qMin( begin + LOD_CHUNK, level.size() );
+        chunk.out = level.data();
+        chunks.append( chunk );
+    }
+    QtConcurrent::blockingMap( chunks, buildChunk );
+    mLevels.append( level );
+
+    while ( mLevels.last().size() > 1 )
+    {
+        const QVector<LodBucket>& below = mLevels.last();
+        QVector<LodBucket> above( ( below.size() + LOD_FACTOR - 1 ) / LOD_FACTOR );
+
+        for ( int b = 0; b < above.size(); ++b )
+        {
+            const int first = b * LOD_FACTOR;
+            const int last = qMin( first + LOD_FACTOR, below.size() );
+
+            LodBucket bucket = below.at( first );
+            for ( int i = first + 1; i < last; ++i )
+            {
+                const LodBucket& next = below.at(i);
+                if ( next.min < bucket.min )
+                {
+                    bucket.min = next.min;
+                    bucket.minSample = next.minSample;
+                }
+                if ( next.max > bucket.max )
+                {
+                    bucket.max = next.max;
+                    bucket.maxSample = next.maxSample;
+                }
+            }
+            above[b] = bucket;
+        }
+
+        mLevels.append( above );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		bucketSamples
+
+Purpose		Returns the samples a bucket of a level covers
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+qint64 SignalPyramid::bucketSamples( int level )
+{
+    qint64 samples = 1;
+    if ( level > 0 )
+        samples = LOD_BASE;
+    for ( int n = 1; n < level; ++n )
+        samples *= LOD_FACTOR;
+
+    return samples;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		levelFor
+
+Purpose		Returns the level to draw samples across pixels from: the
+            coarsest whose buckets still give every pixel at least one
+
+Input       samples - samples to draw
+            pixels  - pixels they are drawn across
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int SignalPyramid::levelFor( qint64 samples, int pixels ) const
+{
+    if ( pixels <= 0 )
+        return 0;
+
+    int level = 0;
+    while ( level + 1 < levels() && bucketSamples( level + 1 ) * pixels <= samples )
+        ++level;
+
+    return level;
+}
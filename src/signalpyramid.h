@@ -0,0 +1,72 @@
+/*----------------------------------------------------------------------------
+
+Name		signalpyramid.h
+
+Purpose		Min / max decimation pyramid over the values of a signal, the
+            way a mipmap is over an image.  Level 1 holds the smallest and
+            largest value of every LOD_BASE samples, and each level after
+            it of every LOD_FACTOR buckets of the one before, down to a
+            single bucket; level 0 is the samples themselves.  Each bucket
+            also records which samples its extremes came from, so a point
+            picked off a zoomed out plot still leads to a frame.
+
+            To draw n samples across w pixels, the coarsest level with no
+            more than n / w samples a bucket is read: between w and
+            LOD_FACTOR * w buckets, whatever n is.  The levels take about
+            1 / ( LOD_BASE - LOD_BASE / LOD_FACTOR ) of a bucket per sample.
+            The extremes are kept as doubles, like the samples, so 32 bit
+            counts plot the same at every level.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Keeps the extremes as doubles
+----------------------------------------------------------------------------*/
+#ifndef SIGNALPYRAMID_H
+#define SIGNALPYRAMID_H
+
+#include <QVector>
+#include <QtGlobal>
+
+// Samples per bucket of level 1
+const int LOD_BASE = 16;
+
+// Buckets of a level per bucket of the next
+const int LOD_FACTOR = 4;
+
+// Extremes of a run of samples
+struct LodBucket
+{
+    double  min;            // Smallest value
+    double  max;            // Largest value
+    quint32 minSample;      // Sample the smallest value is from
+    quint32 maxSample;      // Sample the largest value is from
+};
+
+class SignalPyramid
+{
+public:
+    SignalPyramid();
+
+    // Removes every level
+    void clear();
+    // Builds the levels over a signal's values
+    void build( const QVector<double>& values );
+
+    // Number of samples the pyramid was built over
+    int samples() const { return mSamples; }
+    // Number of levels, counting the samples as level 0
+    int levels() const { return mLevels.size() + 1; }
+    // Returns the buckets of a level (1 on)
+    const QVector<LodBucket>& level( int n ) const { return mLevels.at( n - 1 ); }
+    // Returns the samples a bucket of a level covers (1 for level 0)
+    static qint64 bucketSamples( int level );
+
+    // Returns the coarsest level whose buckets hold no more than
+    // samples / pixels samples
+    int levelFor( qint64 samples, int pixels ) const;
+
+private:
+    int mSamples;                           // Samples the levels cover
+    QVector< QVector<LodBucket> > mLevels;  // Levels 1 on
+};
+
+#endif // SIGNALPYRAMID_H
@@ -0,0 +1,737 @@
+/*----------------------------------------------------------------------------
+
+Name		signaltable.cpp
+
+Purpose		Signals carried by PDOs, extracted into columns.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "signaltable.h"
+#include "stageprofile.h"
+#include <QMap>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// Communication objects of the first RPDO and TPDO; the mapping objects
+// follow PDO_COUNT objects on, and both run on for PDO_COUNT objects
+static const quint16 RPDO_COMM = 0x1400;
+static const quint16 TPDO_COMM = 0x1800;
+static const quint16 PDO_OBJECTS_END = 0x1C00;
+static const int PDO_COUNT = 512;
+
+// Most objects one PDO maps
+static const int PDO_MAX_MAPPED = 0x40;
+
+// COB-ID bit marking a PDO as not valid
+static const quint32 PDO_INVALID = 0x80000000;
+
+// Objects below this index only pad a mapping (dummy entries)
+static const quint16 FIRST_MAPPED_OBJECT = 0x1000;
+
+// Mapping of one PDO from a frame on
+struct PdoEpoch
+{
+    FrameId from;                       // First frame the mapping applies to
+    QVector<PdoField> fields;           // Fields mapped; none while not valid
+};
+
+// Mapping of one PDO, as followed through the SDO downloads
+struct PdoState
+{
+    quint8 node;
+    bool receive;
+    quint16 number;                     // PDO number, from 0
+    bool cobKnown;                      // False if no COB-ID is known
+    quint32 cobId;                      // Subindex 1 of the communication object
+    quint32 count;                      // Subindex 0 of the mapping object
+    quint32 mapping[ PDO_MAX_MAPPED ];  // Subindices 1 on of the mapping object
+    int changes;                        // Mapping changes made by SDO
+    QVector<PdoEpoch> epochs;           // Mappings, in frame order
+};
+
+// Frames over which a signal sat at one place in a PDO
+struct SignalSpan
+{
+    quint32 cobId;
+    FrameId from;
+    FrameId to;
+    quint8 bitOffset;
+    quint8 bits;
+};
+
+// Extraction of one signal, run on a worker thread
+struct SignalWork
+{
+    const FrameTable* table;
+    const QMap< quint32, QVector<FrameId> >* frames;    // Frames of each COB-ID
+    QVector<SignalSpan> spans;          // Where to read the signal, in frame order
+    quint16 type;                       // Data type of the object
+    double factor;                      // Scaling of the object
+    double offset;
+    PdoSignal signal;                   // Extracted columns
+};
+
+/*----------------------------------------------------------------------------
+
+Name		stateKey
+
+Purpose		Returns the key a PDO's state is kept under: node, then RPDOs
+            before TPDOs, then PDO number
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static quint32 stateKey( quint8 node, bool receive, quint16 number )
+{
+    return ( quint32( node ) << 16 ) | quint32( ( receive ? RPDO_COMM : TPDO_COMM ) + number );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		initState
+
+Purpose		Sets up the mapping of a PDO from the object dictionary.  A PDO
+            without a COB-ID in the dictionary takes the one of the
+            predefined connection set, if it is among the first four.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void initState( PdoState& state, const ObjectDictionary& dictionary,
+                       quint8 node, bool receive, quint16 number )
+{
+    const quint16 comm = quint16( ( receive ? RPDO_COMM : TPDO_COMM ) + number );
+    const quint16 map = quint16( comm + PDO_COUNT );
+
+    state.node = node;
+    state.receive = receive;
+    state.number = number;
+    state.changes = 0;
+
+    const OdEntry* cobId = dictionary.find( node, comm, 1 );
+    state.cobKnown = ( cobId && cobId->hasValue ) || number < 4;
+    if ( cobId && cobId->hasValue )
+        state.cobId = quint32( cobId->value );
+    else
+        state.cobId = ( receive ? 0x200 : 0x180 ) + 0x100 * number + node;
+
+    const OdEntry* count = dictionary.find( node, map, 0 );
+    state.count = ( count && count->hasValue ) ? quint32( count->value ) : 0;
+
+    for ( int s = 0; s < PDO_MAX_MAPPED; ++s )
+    {
+        const OdEntry* mapping = dictionary.find( node, map, quint8( s + 1 ) );
+        state.mapping[s] = ( mapping && mapping->hasValue ) ? quint32( mapping->value ) : 0;
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mappedFields
+
+Purpose		Returns the fields a PDO maps in its present state, in bit order,
+            or none if its COB-ID is not known or not valid
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QVector<PdoField> mappedFields( const PdoState& state,
+                                       const ObjectDictionary& dictionary )
+{
+    QVector<PdoField> fields;
+    if ( !state.cobKnown || ( state.cobId & PDO_INVALID ) )
+        return fields;
+
+    int bit = 0;
+    for ( quint32 s = 0; s < state.count && s < quint32( PDO_MAX_MAPPED ); ++s )
+    {
+        const quint32 value = state.mapping[s];
+        const int bits = value & 0xFF;
+        if ( bits == 0 || bit + bits > 64 )
+            break;
+
+        PdoField field;
+        field.cobId = state.cobId & 0x1FFFFFFF;
+        field.node = state.node;
+        field.bitOffset = quint8( bit );
+        field.bits = quint8( bits );
+        field.receive = state.receive;
+        field.objKey = value >> 8;
+        field.entry = dictionary.entryIndex(
+            dictionary.find( state.node, quint16( value >> 16 ), quint8( value >> 8 ) ) );
+
+        fields.append( field );
+        bit += bits;
+    }
+
+    return fields;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		sameFields
+
+Purpose		Returns true if two mappings put the same objects in the same
+            places of the same COB-ID
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool sameFields( const QVector<PdoField>& a, const QVector<PdoField>& b )
+{
+    if ( a.size() != b.size() )
+        return false;
+
+    for ( int i = 0; i < a.size(); ++i )
+    {
+        if ( a.at(i).cobId != b.at(i).cobId || a.at(i).bitOffset != b.at(i).bitOffset
+             || a.at(i).bits != b.at(i).bits || a.at(i).objKey != b.at(i).objKey )
+            return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		followMappings
+
+Purpose		Follows the mapping of every PDO through the dump.  PDOs the
+            node dictionaries map start from them; every completed SDO
+            download to a PDO communication or mapping object then updates
+            its PDO, and a new mapping starts with the frame after the
+            download if the fields changed.  The usual remapping (subindex 0
+            to 0, the mappings, subindex 0 to the count) so leaves the PDO
+            unmapped while it is rewritten.
+
+Input       sdo        - SDO transfers, in the order they closed
+            dictionary - object dictionaries of the nodes
+            states     - set to the mapping of every PDO, by stateKey
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void followMappings( const SdoTable& sdo, const ObjectDictionary& dictionary,
+                            QMap<quint32, PdoState>& states )
+{
+    // PDOs the dictionaries of the nodes map
+    QMap<int, QString>::const_iterator file;
+    for ( file = dictionary.files().constBegin(); file != dictionary.files().constEnd(); ++file )
+    {
+        const int node = file.key();
+        if ( node == 0 )
+            continue;
+
+        for ( int n = 0; n < 2 * PDO_COUNT; ++n )
+        {
+            const bool receive = n < PDO_COUNT;
+            const quint16 number = quint16( n % PDO_COUNT );
+            const quint16 map = quint16( ( receive ? RPDO_COMM : TPDO_COMM ) + PDO_COUNT + number );
+            const OdEntry* count = dictionary.find( node, map, 0 );
+            if ( !count || !count->hasValue || count->value == 0 )
+                continue;
+
+            PdoState& state = states[ stateKey( quint8( node ), receive, number ) ];
+            initState( state, dictionary, quint8( node ), receive, number );
+        }
+    }
+
+    QMap<quint32, PdoState>::iterator it;
+    for ( it = states.begin(); it != states.end(); ++it )
+    {
+        PdoEpoch epoch;
+        epoch.from = 0;
+        epoch.fields = mappedFields( it.value(), dictionary );
+        it.value().epochs.append( epoch );
+    }
+
+    // Downloads that completed, in the order they closed
+    for ( int i = 0; i < sdo.size(); ++i )
+    {
+        const SdoTransfer& t = sdo.at(i);
+        if ( t.upload || t.status != SdoTransfer::COMPLETE || t.kept == 0
+             || t.objIdx < RPDO_COMM || t.objIdx >= PDO_OBJECTS_END )
+            continue;
+
+        const int within = ( t.objIdx - RPDO_COMM ) % ( 2 * PDO_COUNT );
+        const bool receive = t.objIdx < TPDO_COMM;
+        const bool mapObject = within >= PDO_COUNT;
+        const quint16 number = quint16( within % PDO_COUNT );
+        if ( !mapObject && t.subIdx != 1 )
+            continue;
+        if ( mapObject && t.subIdx > PDO_MAX_MAPPED )
+            continue;
+
+        const QByteArray bytes = sdo.payload( i );
+        quint32 value = 0;
+        for ( int b = 0; b < bytes.size() && b < 4; ++b )
+            value |= quint32( quint8( bytes.at( b ) ) ) << ( 8 * b );
+
+        const quint32 key = stateKey( t.node, receive, number );
+        if ( !states.contains( key ) )
+        {
+            PdoState& state = states[ key ];
+            initState( state, dictionary, t.node, receive, number );
+
+            PdoEpoch epoch;
+            epoch.from = 0;
+            epoch.fields = mappedFields( state, dictionary );
+            state.epochs.append( epoch );
+        }
+
+        PdoState& state = states[ key ];
+        if ( !mapObject )
+        {
+            state.cobId = value;
+            state.cobKnown = true;
+        }
+        else if ( t.subIdx == 0 )
+            state.count = value;
+        else
+            state.mapping[ t.subIdx - 1 ] = value;
+
+        PdoEpoch epoch;
+        epoch.from = t.last + 1;
+        epoch.fields = mappedFields( state, dictionary );
+        if ( sameFields( epoch.fields, state.epochs.last().fields ) )
+            continue;
+
+        if ( state.epochs.last().from == epoch.from )
+            state.epochs.last() = epoch;
+        else
+            state.epochs.append( epoch );
+        ++state.changes;
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		readValues
+
+Purpose		Reads raw fields by a data type.  Each type is one loop over the
+            contiguous fields, with no test per value.
+
+Input       type - data type of the object (OdType), 0 if not known
+            bits - length of the fields
+            raw  - fields, each in the low bits
+            out  - set to the values
+            n    - number of fields
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static void readValues( quint16 type, int bits, const quint64* raw, double* out, int n )
+{
+    switch ( type )
+    {
+    case OD_INTEGER8:
+    case OD_INTEGER16:
+    case OD_INTEGER24:
+    case OD_INTEGER32:
+    case OD_INTEGER40:
+    case OD_INTEGER48:
+    case OD_INTEGER56:
+    case OD_INTEGER64:
+    {
+        // Sign extend by moving the top bit of the field to bit 63
+        const int shift = 64 - bits;
+        for ( int i = 0; i < n; ++i )
+            out[i] = double( qint64( raw[i] << shift ) >> shift );
+        break;
+    }
+
+    case OD_REAL32:
+        for ( int i = 0; i < n; ++i )
+        {
+            const quint32 word = quint32( raw[i] );
+            float value;
+            memcpy( &value, &word, sizeof( value ) );
+            out[i] = value;
+        }
+        break;
+
+    case OD_REAL64:
+        for ( int i = 0; i < n; ++i )
+        {
+            double value;
+            memcpy( &value, &raw[i], sizeof( value ) );
+            out[i] = value;
+        }
+        break;
+
+    case OD_BOOLEAN:
+        for ( int i = 0; i < n; ++i )
+            out[i] = raw[i] ? 1.0 : 0.0;
+        break;
+
+    default:
+        for ( int i = 0; i < n; ++i )
+            out[i] = double( raw[i] );
+        break;
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		summarize
+
+Purpose		Works out the minimum, maximum and sum of a signal's values
+            again, once some have been dropped
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Only used once values are dropped
+----------------------------------------------------------------------------*/
+static void summarize( PdoSignal& signal )
+{
+    const double* values = signal.values.constData();
+    const int n = signal.values.size();
+
+    double lo = n ? values[0] : 0.0;
+    double hi = lo;
+    double sum = 0.0;
+    for ( int i = 0; i < n; ++i )
+    {
+        lo = qMin( lo, values[i] );
+        hi = qMax( hi, values[i] );
+        sum += values[i];
+    }
+
+    signal.min = lo;
+    signal.max = hi;
+    signal.sum = sum;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		extractSignal
+
+Purpose		Extracts one signal.  For each span the frames of its COB-ID are
+            found by binary search of their posting list; the field is cut
+            out of every payload with one shift and mask into a contiguous
+            array (frames too short to hold it are dropped without a
+            branch), then read by the data type, scaled and summed into
+            the minimum, maximum and sum.
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Summarizes in the scaling loop
+----------------------------------------------------------------------------*/
+static void extractSignal( SignalWork& work )
+{
+    const quint8* dlcs = work.table->dlcs().constData();
+    const quint64* data = work.table->payloads().constData();
+    PdoSignal& signal = work.signal;
+
+    QVector<quint64> raw;
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -lo;
+    double sum = 0.0;
+    for ( int s = 0; s < work.spans.size(); ++s )
+    {
+        const SignalSpan& span = work.spans.at(s);
+        const QVector<FrameId>& list = work.frames->constFind( span.cobId ).value();
+        const FrameId* begin = std::lower_bound( list.constData(),
+                                                 list.constData() + list.size(), span.from );
+        const FrameId* end = std::lower_bound( begin, list.constData() + list.size(), span.to );
+
+        const int shift = span.bitOffset;
+        const quint64 mask = ( span.bits < 64 ) ? ( quint64( 1 ) << span.bits ) - 1
+                                                : ~quint64( 0 );
+        const quint8 needed = quint8( ( span.bitOffset + span.bits + 7 ) / 8 );
+
+        // Gather
+        const int first = signal.frames.size();
+        signal.frames.resize( first + int( end - begin ) );
+        raw.resize( int( end - begin ) );
+        FrameId* frames = signal.frames.data() + first;
+        quint64* fields = raw.data();
+
+        int n = 0;
+        for ( const FrameId* f = begin; f != end; ++f )
+        {
+            frames[n] = *f;
+            fields[n] = ( data[*f] >> shift ) & mask;
+            n += ( dlcs[*f] >= needed ) ? 1 : 0;
+        }
+        signal.frames.resize( first + n );
+
+        // Read and scale
+        signal.values.resize( first + n );
+        double* values = signal.values.data() + first;
+        readValues( work.type, span.bits, fields, values, n );
+
+        // Summarize while the span's values are still in cache
+        const bool scaled = ( work.factor != 1.0 || work.offset != 0.0 );
+        for ( int i = 0; i < n; ++i )
+        {
+            if ( scaled )
+                values[i] = values[i] * work.factor + work.offset;
+            lo = qMin( lo, values[i] );
+            hi = qMax( hi, values[i] );
+            sum += values[i];
+        }
+    }
+
+    const bool empty = signal.values.isEmpty();
+    signal.min = empty ? 0.0 : lo;
+    signal.max = empty ? 0.0 : hi;
+    signal.sum = sum;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		cobFrames
+
+Purpose		Returns the indexed frames of a COB-ID.  Wide identifiers share
+            one posting list, so theirs is narrowed to the one asked for.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QVector<FrameId> cobFrames( const FrameTable& table, const FrameIndex& index,
+                                   quint32 cobId )
+{
+    QVector<FrameId> list = index.cobPostings( cobId );
+    if ( cobId < WIDE_COB_BUCKET )
+        return list;
+
+    const quint32* cobIds = table.cobIds().constData();
+    int kept = 0;
+    for ( int i = 0; i < list.size(); ++i )
+    {
+        list[ kept ] = list.at(i);
+        kept += ( cobIds[ list.at(i) ] == cobId ) ? 1 : 0;
+    }
+    list.resize( kept );
+    return list;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Removes all signals
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SignalTable::clear()
+{
+    mSignals.clear();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		build
+
+Purpose		Extracts every signal of the table.  The PDO mappings are
+            followed through the SDO transfers, and each mapping that held
+            for some frames is turned into spans of its signals.  Objects
+            that are not numbers, and RPDO fields on a COB-ID that a known
+            TPDO sends (the sender's mapping is the one read), are left out.
+            The frames of every COB-ID used are taken from the index once,
+            with any frames past the index added by a scan, and the signals
+            then extracted one per worker.  Signals that no frame carried
+            are dropped.
+
+Input       table      - frames to extract from
+            index      - posting lists over table
+            sdo        - SDO transfers of table
+            dictionary - object dictionaries of the nodes
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SignalTable::build( const FrameTable& table, const FrameIndex& index,
+                         const SdoTable& sdo, const ObjectDictionary& dictionary )
+{
+    StageTimer stage( STAGE_INDEX, table.size() );
+    clear();
+
+    QMap<quint32, PdoState> states;
+    followMappings( sdo, dictionary, states );
+
+    // COB-IDs some TPDO sends
+    QMap<quint32, bool> transmitted;
+    QMap<quint32, PdoState>::const_iterator it;
+    for ( it = states.constBegin(); it != states.constEnd(); ++it )
+    {
+        for ( int e = 0; e < it.value().epochs.size() && !it.value().receive; ++e )
+        {
+            const QVector<PdoField>& fields = it.value().epochs.at( e ).fields;
+            if ( !fields.isEmpty() )
+                transmitted.insert( fields.first().cobId, true );
+        }
+    }
+
+    // Spans of every signal, and the frames of the COB-IDs they read
+    QVector<SignalWork> work;
+    QMap<quint64, int> workOf;
+    QMap< quint32, QVector<FrameId> > frames;
+    for ( it = states.constBegin(); it != states.constEnd(); ++it )
+    {
+        const PdoState& state = it.value();
+        for ( int e = 0; e < state.epochs.size(); ++e )
+        {
+            const FrameId from = state.epochs.at( e ).from;
+            const FrameId to = ( e + 1 < state.epochs.size() ) ? state.epochs.at( e + 1 ).from
+                                                               : FrameId( table.size() );
+            const QVector<PdoField>& fields = state.epochs.at( e ).fields;
+            if ( from >= to || fields.isEmpty()
+                 || ( state.receive && transmitted.contains( fields.first().cobId ) ) )
+                continue;
+
+            for ( int f = 0; f < fields.size(); ++f )
+            {
+                const PdoField& field = fields.at( f );
+                const OdEntry* entry = ( field.entry >= 0 ) ? &dictionary.entry( field.entry ) : 0;
+                const quint16 type = entry ? entry->type : 0;
+                if ( ( field.objKey >> 8 ) < FIRST_MAPPED_OBJECT
+                     || type == OD_VISIBLE_STRING || type == OD_OCTET_STRING
+                     || type == OD_UNICODE_STRING || type == OD_DOMAIN )
+                    continue;
+
+                const quint64 key = ( quint64( it.key() ) << 32 ) | field.objKey;
+                if ( !workOf.contains( key ) )
+                {
+                    SignalWork w;
+                    w.table = &table;
+                    w.frames = &frames;
+                    w.type = type;
+                    w.factor = entry ? entry->factor : 1.0;
+                    w.offset = entry ? entry->offset : 0.0;
+                    w.signal.node = state.node;
+                    w.signal.receive = state.receive;
+                    w.signal.pdo = quint16( state.number + 1 );
+                    w.signal.objKey = field.objKey;
+                    w.signal.entry = field.entry;
+                    w.signal.remaps = state.changes;
+                    workOf.insert( key, work.size() );
+                    work.append( w );
+                }
+
+                SignalSpan span;
+                span.cobId = field.cobId;
+                span.from = from;
+                span.to = to;
+                span.bitOffset = field.bitOffset;
+                span.bits = field.bits;
+                work[ workOf.value( key ) ].spans.append( span );
+
+                if ( !frames.contains( field.cobId ) )
+                    frames.insert( field.cobId, cobFrames( table, index, field.cobId ) );
+            }
+        }
+    }
+
+    if ( work.isEmpty() )
+        return;
+
+    // Frames appended since the index was built
+    const quint32* cobIds = table.cobIds().constData();
+    for ( int f = index.size(); f < table.size(); ++f )
+    {
+        QMap< quint32, QVector<FrameId> >::iterator list = frames.find( cobIds[f] );
+        if ( list != frames.end() )
+            list.value().append( FrameId( f ) );
+    }
+
+    QtConcurrent::blockingMap( work, extractSignal );
+
+    for ( int i = 0; i < work.size(); ++i )
+    {
+        if ( !work.at(i).signal.values.isEmpty() )
+            mSignals.append( work.at(i).signal );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		removeFirst
+
+Purpose		Drops the values read from the oldest frames once they have been
+            removed from the table, and moves the frames of the rest down
+
+Input       count - number of frames removed from the front of the table
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Trims each signal with removeFirst( PdoSignal& )
+----------------------------------------------------------------------------*/
+void SignalTable::removeFirst( FrameId count )
+{
+    for ( int i = 0; i < mSignals.size(); ++i )
+        removeFirst( mSignals[i], count );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		removeFirst
+
+Purpose		Drops the values a signal read from the oldest frames once they
+            have been removed from the table, and moves its frames down
+
+Input       signal - signal to trim
+            count  - number of frames removed from the front of the table
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void SignalTable::removeFirst( PdoSignal& signal, FrameId count )
+{
+    const FrameId* begin = signal.frames.constData();
+    const int gone = int( std::lower_bound( begin, begin + signal.frames.size(), count )
+                          - begin );
+
+    signal.frames.remove( 0, gone );
+    signal.values.remove( 0, gone );
+    for ( int f = 0; f < signal.frames.size(); ++f )
+        signal.frames[f] -= count;
+
+    summarize( signal );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		extractBytes
+
+Purpose		Extracts a byte range of a COB-ID's frames as a signal, the way
+            a mapped object is extracted, over every frame of the table
+
+Input       table     - frames to extract from
+            index     - posting lists over table
+            cobId     - COB-ID of the frames
+            firstByte - first payload byte of the value
+            bytes     - number of bytes, at most 8 - firstByte
+            isSigned  - true to read the bytes as a signed integer
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+PdoSignal SignalTable::extractBytes( const FrameTable& table, const FrameIndex& index,
+                                     quint32 cobId, int firstByte, int bytes, bool isSigned )
+{
+    QMap< quint32, QVector<FrameId> > frames;
+    QVector<FrameId> list = cobFrames( table, index, cobId );
+    const quint32* cobIds = table.cobIds().constData();
+    for ( int f = index.size(); f < table.size(); ++f )
+    {
+        if ( cobIds[f] == cobId )
+            list.append( FrameId( f ) );
+    }
+    frames.insert( cobId, list );
+
+    SignalWork work;
+    work.table = &table;
+    work.frames = &frames;
+    work.type = quint16( isSigned ? OD_INTEGER64 : OD_UNSIGNED64 );
+    work.factor = 1.0;
+    work.offset = 0.0;
+    work.signal.node = quint8( cobId & 0x7F );
+    work.signal.receive = false;
+    work.signal.pdo = 0;
+    work.signal.objKey = 0;
+    work.signal.entry = -1;
+    work.signal.remaps = 0;
+
+    SignalSpan span;
+    span.cobId = cobId;
+    span.from = 0;
+    span.to = FrameId( table.size() );
+    span.bitOffset = quint8( firstByte * 8 );
+    span.bits = quint8( bytes * 8 );
+    work.spans.append( span );
+
+    extractSignal( work );
+    return work.signal;
+}
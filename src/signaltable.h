@@ -0,0 +1,93 @@
+/*----------------------------------------------------------------------------
+
+Name		signaltable.h
+
+Purpose		Signals carried by PDOs, each pulled out of the frames into a
+            column of its own.  The mapping of every PDO is followed through
+            the dump:
+
+                - it starts from the object dictionaries (the DCF values,
+                  or the EDS defaults) of the node
+                - every SDO download to a communication (0x1400 / 0x1800)
+                  or mapping (0x1600 / 0x1A00) object that completed
+                  changes it from the next frame on, so a node remapped
+                  while the dump runs is read by the mapping in force
+
+            Each mapped object of a PDO is one signal.  Its frames are taken
+            from the posting lists of the frame index, their payloads
+            gathered into a contiguous array, and the field cut out of all
+            of them with the same shift and mask before being read by the
+            entry's data type and scaled.  The minimum, maximum and sum are
+            taken in the scaling loop, while each span's values are still
+            in cache, so they need no second pass.  Signals are extracted
+            one per worker.
+
+            Values are held as doubles; 64 bit integers past 2^53 lose
+            their lowest bits.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef SIGNALTABLE_H
+#define SIGNALTABLE_H
+
+#include <QVector>
+#include "frameindex.h"
+#include "frametable.h"
+#include "objectdictionary.h"
+#include "sdoassembler.h"
+
+// One object mapped into a PDO, as a column of values
+struct PdoSignal
+{
+    quint8  node;           // Node whose PDO carries the signal
+    bool    receive;        // True for an RPDO of the node, false for a TPDO
+    quint16 pdo;            // PDO number, from 1
+    quint32 objKey;         // Object mapped: index << 8 | subindex
+    int     entry;          // Entry of the object, or -1 if not in the dictionary
+    int     remaps;         // Times the PDO was remapped by SDO while the dump ran
+
+    QVector<FrameId> frames;// Frames the signal was read from, in order
+    QVector<double> values; // Value read from each frame, scaled
+
+    double  min;            // Smallest value, or 0 if there are none
+    double  max;            // Largest value, or 0 if there are none
+    double  sum;            // Sum of the values
+
+    // Mean value, or 0 if there are none
+    double mean() const { return values.isEmpty() ? 0.0 : sum / values.size(); }
+};
+
+class SignalTable
+{
+public:
+    // Removes all signals
+    void clear();
+
+    // Number of signals held
+    int size() const { return mSignals.size(); }
+    bool isEmpty() const { return mSignals.isEmpty(); }
+    // Returns a signal
+    const PdoSignal& at( int i ) const { return mSignals.at( i ); }
+
+    // Follows the PDO mappings through the SDO transfers and extracts every
+    // mapped signal of the table, replacing those held
+    void build( const FrameTable& table, const FrameIndex& index, const SdoTable& sdo,
+                const ObjectDictionary& dictionary );
+
+    // Drops the values of the first count frames and moves the rest down
+    // to match FrameTable::removeFirst
+    void removeFirst( FrameId count );
+    // Does the same for one signal
+    static void removeFirst( PdoSignal& signal, FrameId count );
+
+    // Extracts bytes of the frames of a COB-ID as a signal of its own: the
+    // little endian integer in bytes [firstByte, firstByte + bytes) of
+    // every frame long enough to hold them
+    static PdoSignal extractBytes( const FrameTable& table, const FrameIndex& index,
+                                   quint32 cobId, int firstByte, int bytes, bool isSigned );
+
+private:
+    QVector<PdoSignal> mSignals;    // Signals, by node, PDO and object
+};
+
+#endif // SIGNALTABLE_H
@@ -0,0 +1,328 @@
+/*----------------------------------------------------------------------------
+
+Name		stageprofile.cpp
+
+Purpose		Lock free stage totals and trace recording.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "stageprofile.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSaveFile>
+#include <QThread>
+#include <cstdio>
+
+// Running totals of one stage
+struct StageCounters
+{
+    QAtomicInteger<quint64> calls;
+    QAtomicInteger<quint64> nsecs;
+    QAtomicInteger<quint64> frames;
+};
+
+// One recorded stage.  stage is written last (stage + 1, 0 while the slot
+// is being filled) so a slot still being written is skipped when saved.
+struct TraceEvent
+{
+    qint64 start;
+    qint64 nsecs;
+    Qt::HANDLE thread;
+    QAtomicInt stage;
+};
+
+// Clock every stage is timed on, started before first use from any thread
+struct StageClock
+{
+    StageClock() { timer.start(); }
+
+    QElapsedTimer timer;
+};
+
+QAtomicInt StageProfile::sFlags;
+
+static StageCounters sTotals[ STAGE_COUNT ];
+
+// Trace buffer, allocated by the first trace and kept for the life of the
+// program so a worker finishing a stage never writes to freed memory
+static TraceEvent* sEvents = 0;
+static QAtomicInt sTraceNext;              // Next free slot (may pass the end when full)
+static Qt::HANDLE sTraceThread = 0;        // Thread that started the trace
+
+/*----------------------------------------------------------------------------
+
+Name		profileClock
+
+Purpose		Returns the profile clock
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static const QElapsedTimer& profileClock()
+{
+    static const StageClock stageClock;
+    return stageClock.timer;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setEnabled
+
+Purpose		Turns stage timing on (clearing the totals) or off.  Turning it
+            off also stops any trace.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void StageProfile::setEnabled( bool enabled )
+{
+    if ( !enabled )
+    {
+        sFlags.store( 0 );
+        return;
+    }
+
+    if ( isEnabled() )
+        return;
+
+    reset();
+    profileClock();
+    sFlags.fetchAndOrOrdered( PROFILE_TIMING );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		reset
+
+Purpose		Clears the totals of every stage
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void StageProfile::reset()
+{
+    for ( int s = 0; s < STAGE_COUNT; ++s )
+    {
+        sTotals[s].calls.store( 0 );
+        sTotals[s].nsecs.store( 0 );
+        sTotals[s].frames.store( 0 );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		startTrace
+
+Purpose		Empties the trace buffer and starts recording into it
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void StageProfile::startTrace()
+{
+    stopTrace();
+    setEnabled( true );
+
+    if ( !sEvents )
+        sEvents = new TraceEvent[ TRACE_MAX_EVENTS ];
+
+    for ( int i = 0; i < TRACE_MAX_EVENTS; ++i )
+        sEvents[i].stage.store( 0 );
+
+    sTraceThread = QThread::currentThreadId();
+    sTraceNext.store( 0 );
+    sFlags.fetchAndOrOrdered( PROFILE_TRACE );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		stopTrace
+
+Purpose		Stops recording a trace, leaving timing on
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void StageProfile::stopTrace()
+{
+    sFlags.fetchAndAndOrdered( ~int( PROFILE_TRACE ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		tracedEvents
+
+Purpose		Returns the number of events the buffer holds
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int StageProfile::tracedEvents()
+{
+    return sEvents ? qMin( sTraceNext.load(), TRACE_MAX_EVENTS ) : 0;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		writeTrace
+
+Purpose		Writes the recorded events as Chrome trace-event JSON: one
+            complete ("X") event per stage, in microseconds, and a name for
+            every thread seen.  The thread that started the trace is "main".
+
+Input       fileName - file to write
+            error    - set to the reason when the file cannot be written
+
+Return      true if the trace was written
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+bool StageProfile::writeTrace( const QString& fileName, QString& error )
+{
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    // Chrome wants small thread ids; number them by first appearance
+    QHash<Qt::HANDLE, int> threads;
+    threads.insert( sTraceThread, 1 );
+
+    QByteArray out( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+    char line[ 160 ];
+    const int count = tracedEvents();
+    for ( int i = 0; i < count; ++i )
+    {
+        const TraceEvent& event = sEvents[i];
+        const int stage = event.stage.loadAcquire() - 1;
+        if ( stage < 0 || stage >= STAGE_COUNT )
+            continue;
+
+        if ( !threads.contains( event.thread ) )
+            threads.insert( event.thread, threads.size() + 1 );
+
+        int len = snprintf( line, sizeof( line ),
+                            "{\"name\":\"%s\",\"cat\":\"stage\",\"ph\":\"X\",\"pid\":1,"
+                            "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+                            name( Stage( stage ) ), threads.value( event.thread ),
+                            event.start / 1000.0, event.nsecs / 1000.0 );
+        out.append( line, qBound( 0, len, int( sizeof( line ) ) - 1 ) );
+    }
+
+    QHash<Qt::HANDLE, int>::const_iterator it;
+    for ( it = threads.constBegin(); it != threads.constEnd(); ++it )
+    {
+        QByteArray thread = ( it.value() == 1 ) ? QByteArray( "main" )
+                                                : "worker " + QByteArray::number( it.value() - 1 );
+        int len = snprintf( line, sizeof( line ),
+                            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                            "\"args\":{\"name\":\"%s\"}},\n",
+                            it.value(), thread.constData() );
+        out.append( line, qBound( 0, len, int( sizeof( line ) ) - 1 ) );
+    }
+
+    // Every event line ends in a comma; close with the process name
+    out.append( "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"args\":{\"name\":\"canDumpDisplay\"}}\n]}\n" );
+    file.write( out );
+
+    if ( !file.commit() )
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		totals
+
+Purpose		Returns the totals of a stage since timing was turned on
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+StageTotals StageProfile::totals( Stage stage )
+{
+    StageTotals totals;
+    totals.calls = sTotals[ stage ].calls.load();
+    totals.nsecs = sTotals[ stage ].nsecs.load();
+    totals.frames = sTotals[ stage ].frames.load();
+
+    return totals;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		name
+
+Purpose		Returns the name of a stage
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+const char* StageProfile::name( Stage stage )
+{
+    switch ( stage )
+    {
+    case STAGE_INGEST:      return "ingest";
+    case STAGE_TOKENIZE:    return "tokenize";
+    case STAGE_INDEX:       return "index";
+    case STAGE_FILTER:      return "filter";
+    case STAGE_MATERIALIZE: return "materialize";
+    case STAGE_RENDER:      return "render";
+    default:                return "";
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		now
+
+Purpose		Returns nanoseconds since the profile clock started
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+qint64 StageProfile::now()
+{
+    return profileClock().nsecsElapsed();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		record
+
+Purpose		Adds a finished stage to its totals and, while tracing, takes the
+            next slot of the trace buffer for it.  Only relaxed atomic adds
+            are used, so any thread may call this at any time.
+
+Input       stage  - stage that finished
+            start  - clock reading when it started
+            frames - frames it handled
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void StageProfile::record( Stage stage, qint64 start, qint64 frames )
+{
+    const qint64 nsecs = now() - start;
+
+    StageCounters& counters = sTotals[ stage ];
+    counters.calls.fetchAndAddRelaxed( 1 );
+    counters.nsecs.fetchAndAddRelaxed( quint64( nsecs ) );
+    counters.frames.fetchAndAddRelaxed( quint64( frames ) );
+
+    // Acquire pairs with startTrace, so the buffer is seen once allocated
+    if ( ( sFlags.loadAcquire() & PROFILE_TRACE ) == 0 )
+        return;
+
+    const int slot = sTraceNext.fetchAndAddRelaxed( 1 );
+    if ( slot >= TRACE_MAX_EVENTS )
+    {
+        // Full; stop before the cursor can run on and wrap
+        stopTrace();
+        return;
+    }
+
+    TraceEvent& event = sEvents[ slot ];
+    event.start = start;
+    event.nsecs = nsecs;
+    event.thread = QThread::currentThreadId();
+    event.stage.storeRelease( int( stage ) + 1 );
+}
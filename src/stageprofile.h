@@ -0,0 +1,122 @@
+/*----------------------------------------------------------------------------
+
+Name		stageprofile.h
+
+Purpose		Timings of the stages a dump goes through on its way to the
+            screen:
+
+                ingest      - the whole of a load: splitting the text into
+                              chunks, tokenizing them and merging the tables
+                tokenize    - one chunk, on a worker thread
+                index       - building the frame index and SDO transfers
+                filter      - one block of frames tested by a parse
+                materialize - building the text of one row
+                render      - drawing one row
+
+            Code marks a stage by putting a StageTimer on the stack.  Calls,
+            nanoseconds and frames are added to per-stage totals with
+            relaxed atomic adds, so worker threads never wait on each other.
+            While a trace is recorded each stage is also written, through an
+            atomic cursor, into a fixed buffer that is saved as a Chrome
+            trace-event file (chrome://tracing, Perfetto).
+
+            With timings off a StageTimer costs one relaxed load.  Stages
+            nest (a render includes the materialize of its row), so totals
+            are inclusive.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef STAGEPROFILE_H
+#define STAGEPROFILE_H
+
+#include <QAtomicInteger>
+#include <QString>
+
+// Stages timed
+enum Stage
+{
+    STAGE_INGEST,
+    STAGE_TOKENIZE,
+    STAGE_INDEX,
+    STAGE_FILTER,
+    STAGE_MATERIALIZE,
+    STAGE_RENDER,
+    STAGE_COUNT
+};
+
+// Most events one trace holds
+const int TRACE_MAX_EVENTS = 256 * 1024;
+
+// Totals of one stage
+struct StageTotals
+{
+    quint64 calls;
+    quint64 nsecs;
+    quint64 frames;
+};
+
+class StageProfile
+{
+public:
+    // Turns timing on or off.  Turning it on clears the totals.
+    static void setEnabled( bool enabled );
+    static bool isEnabled()
+        { return ( sFlags.load() & PROFILE_TIMING ) != 0; }
+    // Clears the totals
+    static void reset();
+
+    // Starts recording a trace (turning timing on) from an empty buffer
+    static void startTrace();
+    // Stops recording; the events so far are kept until the next start
+    static void stopTrace();
+    static bool isTracing()
+        { return ( sFlags.load() & PROFILE_TRACE ) != 0; }
+    // Writes the recorded events as a Chrome trace-event JSON file.
+    // Returns false, with a reason in error, if it cannot be written.
+    static bool writeTrace( const QString& fileName, QString& error );
+    // Returns the number of events recorded.  Recording stops by itself
+    // once TRACE_MAX_EVENTS have been.
+    static int tracedEvents();
+
+    // Returns the totals of a stage
+    static StageTotals totals( Stage stage );
+    // Returns the name of a stage
+    static const char* name( Stage stage );
+
+    // Returns nanoseconds on the profile's clock
+    static qint64 now();
+    // Adds a finished stage to the totals (and the trace)
+    static void record( Stage stage, qint64 start, qint64 frames );
+
+private:
+    enum Flag
+    {
+        PROFILE_TIMING = 1,
+        PROFILE_TRACE  = 2
+    };
+
+    static QAtomicInt sFlags;
+};
+
+// Times a stage from construction to destruction
+class StageTimer
+{
+public:
+    explicit StageTimer( Stage stage, qint64 frames = 1 )
+        : mStage( stage ),
+          mFrames( frames ),
+          mStart( StageProfile::isEnabled() ? StageProfile::now() : -1 )
+        {}
+    ~StageTimer()
+        { if ( mStart >= 0 ) StageProfile::record( mStage, mStart, mFrames ); }
+
+    // Sets the frames the stage handled, when only known at its end
+    void setFrames( qint64 frames ) { mFrames = frames; }
+
+private:
+    Stage mStage;
+    qint64 mFrames;
+    qint64 mStart;                  // -1 when timing was off at the start
+};
+
+#endif // STAGEPROFILE_H
@@ -0,0 +1,143 @@
+/*----------------------------------------------------------------------------
+
+Name		statsdock.cpp
+
+Purpose		Dock showing the traffic statistics of the loaded frames.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "statsdock.h"
+#include "parser.h"
+#include <QElapsedTimer>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QTableView>
+#include <QVBoxLayout>
+
+/*----------------------------------------------------------------------------
+
+Name		makeTable
+
+Purpose		Returns a sortable table view over a proxy of a model
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QTableView* makeTable( StatsModel& model, QSortFilterProxyModel& proxy,
+                              QWidget* parent )
+{
+    proxy.setSourceModel( &model );
+    proxy.setSortRole( Qt::UserRole );
+
+    QTableView* view = new QTableView( parent );
+    view->setModel( &proxy );
+    view->setSortingEnabled( true );
+    view->setSelectionBehavior( QAbstractItemView::SelectRows );
+    view->setAlternatingRowColors( true );
+    view->verticalHeader()->hide();
+    view->horizontalHeader()->setStretchLastSection( true );
+
+    return view;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		StatsDock
+
+Purpose		Constructor.  Builds the controls and the two tables.
+
+Input       parser - parser the frames are read from
+            parent - owning widget
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+StatsDock::StatsDock( const Parser& parser, QWidget* parent )
+    : QDockWidget( tr( "Statistics" ), parent ),
+      mParser( parser ),
+      mCobModel( StatsModel::COB_IDS ),
+      mNodeModel( StatsModel::NODES )
+{
+    setObjectName( "mStatsDock" );
+
+    QWidget* body = new QWidget( this );
+
+    mBitrateBox = new QComboBox( body );
+    mBitrateBox->addItem( tr( "125 kbit/s" ), 125000 );
+    mBitrateBox->addItem( tr( "250 kbit/s" ), 250000 );
+    mBitrateBox->addItem( tr( "500 kbit/s" ), 500000 );
+    mBitrateBox->addItem( tr( "1 Mbit/s" ), 1000000 );
+    mBitrateBox->setCurrentIndex( 2 );
+
+    mWindowSpin = new QSpinBox( body );
+    mWindowSpin->setRange( 10, 60000 );
+    mWindowSpin->setValue( 1000 );
+    mWindowSpin->setSuffix( tr( " ms" ) );
+    mWindowSpin->setToolTip( tr( "Window the peak bus load is measured over" ) );
+
+    QPushButton* refreshBtn = new QPushButton( tr( "Refresh" ), body );
+
+    QHBoxLayout* controls = new QHBoxLayout;
+    controls->addWidget( mBitrateBox );
+    controls->addWidget( mWindowSpin );
+    controls->addStretch();
+    controls->addWidget( refreshBtn );
+
+    mLoadLbl = new QLabel( body );
+
+    QTabWidget* tabs = new QTabWidget( body );
+    tabs->addTab( makeTable( mCobModel, mCobProxy, tabs ), tr( "COB-IDs" ) );
+    tabs->addTab( makeTable( mNodeModel, mNodeProxy, tabs ), tr( "Nodes" ) );
+
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->addLayout( controls );
+    layout->addWidget( mLoadLbl );
+    layout->addWidget( tabs );
+    body->setLayout( layout );
+    setWidget( body );
+
+    connect( refreshBtn,            SIGNAL( clicked() ),
+             this,                  SLOT( refresh() ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		refresh
+
+Purpose		Gathers the statistics of the parser's frames again and shows
+            them
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void StatsDock::refresh()
+{
+    const FrameTable& table = mParser.table();
+    const int bitrate = mBitrateBox->currentData().toInt();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    FrameStats stats;
+    stats.compute( table, bitrate, qint64( mWindowSpin->value() ) * 1000 );
+
+    mCobModel.setStats( stats, table.ifaces() );
+    mNodeModel.setStats( stats, table.ifaces() );
+
+    QStringList lines;
+    for ( int i = 0; i < stats.loads().size(); ++i )
+    {
+        const BusLoad& load = stats.loads().at(i);
+        lines << tr( "%1: mean load %2 %, peak %3 % at %4 s" )
+                 .arg( table.ifaces().value( load.iface ) )
+                 .arg( load.mean, 0, 'f', 1 )
+                 .arg( load.peak, 0, 'f', 1 )
+                 .arg( load.peakTime / 1e6, 0, 'f', 3 );
+    }
+    lines << tr( "%1 frames counted in %2 ms (%3 ms window)" )
+             .arg( table.size() )
+             .arg( timer.elapsed() )
+             .arg( stats.window() / 1000 );
+
+    mLoadLbl->setText( lines.join( "\n" ) );
+}
@@ -0,0 +1,48 @@
+/*----------------------------------------------------------------------------
+
+Name		statsdock.h
+
+Purpose		Dock showing the traffic statistics of the loaded frames: bus
+            load per interface, and sortable tables of per-COB-ID and
+            per-node rates, periods and jitter.  The statistics are gathered
+            when the dock is refreshed, not as frames arrive.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef STATSDOCK_H
+#define STATSDOCK_H
+
+#include <QComboBox>
+#include <QDockWidget>
+#include <QLabel>
+#include <QSortFilterProxyModel>
+#include <QSpinBox>
+#include "statsmodel.h"
+
+class Parser;
+
+class StatsDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit StatsDock( const Parser& parser, QWidget* parent = 0 );
+
+public slots:
+    // Gathers the statistics of the parser's frames again
+    void refresh();
+
+private:
+    const Parser& mParser;          // Source of the frames
+
+    StatsModel mCobModel;           // Rows per COB-ID
+    StatsModel mNodeModel;          // Rows per node
+    QSortFilterProxyModel mCobProxy;
+    QSortFilterProxyModel mNodeProxy;
+
+    QComboBox* mBitrateBox;         // Bus speed
+    QSpinBox* mWindowSpin;          // Bus load window, ms
+    QLabel* mLoadLbl;               // Bus load of each interface
+};
+
+#endif // STATSDOCK_H
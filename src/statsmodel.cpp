@@ -0,0 +1,316 @@
+/*----------------------------------------------------------------------------
+
+Name		statsmodel.cpp
+
+Purpose		Table model over the results of FrameStats.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "statsmodel.h"
+
+// Columns of the COB-ID view
+enum CobColumn
+{
+    COB_IFACE,
+    COB_ID,
+    COB_FRAMES,
+    COB_RATE,
+    COB_MEAN,
+    COB_MAX,
+    COB_JITTER,
+    COB_DLCS,
+    COB_LOAD,
+    COB_COLUMNS
+};
+
+// Columns of the node view
+enum NodeColumn
+{
+    NODE_ID,
+    NODE_COB_IDS,
+    NODE_FRAMES,
+    NODE_RATE,
+    NODE_LOAD,
+    NODE_COLUMNS
+};
+
+/*----------------------------------------------------------------------------
+
+Name		StatsModel
+
+Purpose		Constructor
+
+Input       view   - rows to show
+            parent - owning object
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+StatsModel::StatsModel( View view, QObject* parent )
+    : QAbstractTableModel( parent ),
+      mView( view ),
+      mSpan( 0 ),
+      mBitrate( 0 )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setStats
+
+Purpose		Replaces the rows with new results
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void StatsModel::setStats( const FrameStats& stats, const QStringList& ifaces )
+{
+    beginResetModel();
+    mCobs = stats.cobs();
+    mNodes = stats.nodes();
+    mIfaces = ifaces;
+    mSpan = stats.span();
+    mBitrate = stats.bitrate();
+    endResetModel();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		rowCount
+
+Purpose		Returns the number of COB-IDs or nodes
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int StatsModel::rowCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() )
+        return 0;
+
+    return ( mView == COB_IDS ) ? mCobs.size() : mNodes.size();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		columnCount
+
+Purpose		Returns the number of columns of the view
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int StatsModel::columnCount( const QModelIndex& parent ) const
+{
+    if ( parent.isValid() )
+        return 0;
+
+    return ( mView == COB_IDS ) ? int( COB_COLUMNS ) : int( NODE_COLUMNS );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		data
+
+Purpose		Returns the text of a cell, its value for sorting, or its
+            alignment (numbers are right aligned)
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant StatsModel::data( const QModelIndex& index, int role ) const
+{
+    if ( !index.isValid() || index.row() >= rowCount() )
+        return QVariant();
+
+    const int column = index.column();
+    switch ( role )
+    {
+    case Qt::DisplayRole:
+        return ( mView == COB_IDS ) ? cobText( mCobs.at( index.row() ), column )
+                                    : nodeText( mNodes.at( index.row() ), column );
+    case Qt::UserRole:
+        return ( mView == COB_IDS ) ? cobValue( mCobs.at( index.row() ), column )
+                                    : nodeValue( mNodes.at( index.row() ), column );
+    case Qt::TextAlignmentRole:
+        if ( ( mView == COB_IDS && column == COB_IFACE ) ||
+             ( mView == COB_IDS && column == COB_DLCS ) )
+            return int( Qt::AlignLeft | Qt::AlignVCenter );
+        return int( Qt::AlignRight | Qt::AlignVCenter );
+    default:
+        return QVariant();
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		headerData
+
+Purpose		Returns the column titles
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant StatsModel::headerData( int section, Qt::Orientation orientation, int role ) const
+{
+    if ( orientation != Qt::Horizontal || role != Qt::DisplayRole )
+        return QVariant();
+
+    if ( mView == COB_IDS )
+    {
+        switch ( section )
+        {
+        case COB_IFACE:     return tr( "Interface" );
+        case COB_ID:        return tr( "COB-ID" );
+        case COB_FRAMES:    return tr( "Frames" );
+        case COB_RATE:      return tr( "Rate (Hz)" );
+        case COB_MEAN:      return tr( "Mean period (ms)" );
+        case COB_MAX:       return tr( "Max period (ms)" );
+        case COB_JITTER:    return tr( "Jitter (ms)" );
+        case COB_DLCS:      return tr( "DLCs" );
+        case COB_LOAD:      return tr( "Load (%)" );
+        }
+        return QVariant();
+    }
+
+    switch ( section )
+    {
+    case NODE_ID:       return tr( "Node" );
+    case NODE_COB_IDS:  return tr( "COB-IDs" );
+    case NODE_FRAMES:   return tr( "Frames" );
+    case NODE_RATE:     return tr( "Rate (Hz)" );
+    case NODE_LOAD:     return tr( "Load (%)" );
+    }
+    return QVariant();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		cobValue
+
+Purpose		Returns the value a COB-ID cell sorts by
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant StatsModel::cobValue( const CobStats& s, int column ) const
+{
+    switch ( column )
+    {
+    case COB_IFACE:     return mIfaces.value( s.iface );
+    case COB_ID:        return s.cobId;
+    case COB_FRAMES:    return quint64( s.count );
+    case COB_RATE:      return s.gaps ? 1e6 / s.meanGap() : 0.0;
+    case COB_MEAN:      return s.meanGap() / 1000.0;
+    case COB_MAX:       return s.gapMax / 1000.0;
+    case COB_JITTER:    return s.jitter() / 1000.0;
+    case COB_DLCS:      return cobText( s, column );
+    case COB_LOAD:      return load( s.bits );
+    }
+    return QVariant();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		cobText
+
+Purpose		Returns the text of a COB-ID cell
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QString StatsModel::cobText( const CobStats& s, int column ) const
+{
+    switch ( column )
+    {
+    case COB_IFACE:
+        return mIfaces.value( s.iface );
+    case COB_ID:
+        return ( s.cobId > 0x7FF ) ? tr( "extended" )
+                                   : QString( "%1" ).arg( s.cobId, 3, 16, QChar( '0' ) ).toUpper();
+    case COB_FRAMES:
+        return QString::number( s.count );
+    case COB_DLCS:
+    {
+        // Lengths seen, with a count where more than one was
+        QStringList dlcs;
+        int seen = 0;
+        for ( int d = 0; d < 9; ++d )
+            seen += ( s.dlcs[d] != 0 );
+        for ( int d = 0; d < 9; ++d )
+        {
+            if ( s.dlcs[d] == 0 )
+                continue;
+            dlcs << ( seen > 1 ? QString( "%1:%2" ).arg( d ).arg( s.dlcs[d] )
+                               : QString::number( d ) );
+        }
+        return dlcs.join( " " );
+    }
+    case COB_LOAD:
+        return QString::number( load( s.bits ), 'f', 2 );
+    default:
+        if ( s.gaps == 0 )
+            return QString();
+        return QString::number( cobValue( s, column ).toDouble(), 'f', 3 );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		nodeValue
+
+Purpose		Returns the value a node cell sorts by
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVariant StatsModel::nodeValue( const NodeStats& s, int column ) const
+{
+    switch ( column )
+    {
+    case NODE_ID:       return s.node;
+    case NODE_COB_IDS:  return s.cobIds;
+    case NODE_FRAMES:   return quint64( s.count );
+    case NODE_RATE:     return mSpan > 0 ? s.count * 1e6 / mSpan : 0.0;
+    case NODE_LOAD:     return load( s.bits );
+    }
+    return QVariant();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		nodeText
+
+Purpose		Returns the text of a node cell.  Node 0 collects the broadcast
+            objects (NMT, SYNC, TIME).
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QString StatsModel::nodeText( const NodeStats& s, int column ) const
+{
+    switch ( column )
+    {
+    case NODE_ID:
+        return s.node ? QString( "%1" ).arg( s.node, 2, 16, QChar( '0' ) ).toUpper()
+                      : tr( "broadcast" );
+    case NODE_COB_IDS:
+        return QString::number( s.cobIds );
+    case NODE_FRAMES:
+        return QString::number( s.count );
+    case NODE_RATE:
+        return QString::number( nodeValue( s, column ).toDouble(), 'f', 1 );
+    case NODE_LOAD:
+        return QString::number( load( s.bits ), 'f', 2 );
+    }
+    return QString();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		load
+
+Purpose		Returns the share of the bus, in percent, a number of bits took
+            over the whole dump
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+double StatsModel::load( quint64 bits ) const
+{
+    if ( mSpan <= 0 || mBitrate <= 0 )
+        return 0.0;
+
+    return 100.0 * bits / ( double( mBitrate ) * mSpan / 1e6 );
+}
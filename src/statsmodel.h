@@ -0,0 +1,64 @@
+/*----------------------------------------------------------------------------
+
+Name		statsmodel.h
+
+Purpose		Table model over the results of FrameStats, either one row per
+            COB-ID or one row per node.  Every cell also carries its raw
+            number under Qt::UserRole so a sort proxy orders rows by value
+            rather than by the formatted text.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef STATSMODEL_H
+#define STATSMODEL_H
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include "framestats.h"
+
+class StatsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    // Rows the model shows
+    enum View
+    {
+        COB_IDS,
+        NODES
+    };
+
+    explicit StatsModel( View view, QObject* parent = 0 );
+
+    // Replaces the rows with new results.  ifaces are the interface names
+    // of the table the statistics were gathered from.
+    void setStats( const FrameStats& stats, const QStringList& ifaces );
+
+    // QAbstractTableModel interface
+    int rowCount( const QModelIndex& parent = QModelIndex() ) const;
+    int columnCount( const QModelIndex& parent = QModelIndex() ) const;
+    QVariant data( const QModelIndex& index, int role = Qt::DisplayRole ) const;
+    QVariant headerData( int section, Qt::Orientation orientation,
+                         int role = Qt::DisplayRole ) const;
+
+private:
+    // Returns the value of a cell (Qt::UserRole)
+    QVariant cobValue( const CobStats& s, int column ) const;
+    QVariant nodeValue( const NodeStats& s, int column ) const;
+    // Returns the text of a cell
+    QString cobText( const CobStats& s, int column ) const;
+    QString nodeText( const NodeStats& s, int column ) const;
+
+    // Returns the share of the bus a number of bits took over the dump
+    double load( quint64 bits ) const;
+
+private:
+    const View mView;               // Rows shown
+    QVector<CobStats> mCobs;        // Rows when showing COB-IDs
+    QVector<NodeStats> mNodes;      // Rows when showing nodes
+    QStringList mIfaces;            // Interface names, indexed by id
+    qint64 mSpan;                   // Time covered by the dump (microseconds)
+    int mBitrate;                   // Bus speed the load is worked out for
+};
+
+#endif // STATSMODEL_H
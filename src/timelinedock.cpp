@@ -0,0 +1,158 @@
+/*----------------------------------------------------------------------------
+
+Name		timelinedock.cpp
+
+Purpose		Dock showing the NMT states and anomalies of every node.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "timelinedock.h"
+#include "parser.h"
+#include <QElapsedTimer>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QScrollArea>
+#include <QSplitter>
+#include <QTableView>
+#include <QVBoxLayout>
+
+/*----------------------------------------------------------------------------
+
+Name		TimelineDock
+
+Purpose		Constructor.  Builds the controls, the lanes and the anomaly
+            table, one above the other.
+
+Input       parser - parser the timeline is built by
+            parent - owning widget
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+TimelineDock::TimelineDock( Parser& parser, QWidget* parent )
+    : QDockWidget( tr( "Node Timeline" ), parent ),
+      mParser( parser )
+{
+    setObjectName( "mTimelineDock" );
+
+    QWidget* body = new QWidget( this );
+
+    QPushButton* refreshBtn = new QPushButton( tr( "Refresh" ), body );
+    mStatusLbl = new QLabel( body );
+
+    QHBoxLayout* controls = new QHBoxLayout;
+    controls->addWidget( mStatusLbl, 1 );
+    controls->addWidget( refreshBtn );
+
+    QSplitter* splitter = new QSplitter( Qt::Vertical, body );
+
+    QScrollArea* scroll = new QScrollArea( splitter );
+    scroll->setWidgetResizable( true );
+    mLanes = new TimelineWidget( scroll );
+    scroll->setWidget( mLanes );
+
+    mProxy.setSourceModel( &mModel );
+    mProxy.setSortRole( Qt::UserRole );
+
+    QTableView* view = new QTableView( splitter );
+    view->setModel( &mProxy );
+    view->setSortingEnabled( true );
+    view->sortByColumn( 0, Qt::AscendingOrder );
+    view->setSelectionBehavior( QAbstractItemView::SelectRows );
+    view->setAlternatingRowColors( true );
+    view->verticalHeader()->hide();
+    view->horizontalHeader()->setStretchLastSection( true );
+
+    splitter->addWidget( scroll );
+    splitter->addWidget( view );
+
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->addLayout( controls );
+    layout->addWidget( splitter, 1 );
+    body->setLayout( layout );
+    setWidget( body );
+
+    connect( refreshBtn,            SIGNAL( clicked() ),
+             this,                  SLOT( refresh() ) );
+    connect( view,                  SIGNAL( doubleClicked( QModelIndex ) ),
+             this,                  SLOT( showAnomaly( QModelIndex ) ) );
+    connect( mLanes,                SIGNAL( frameClicked( FrameId ) ),
+             this,                  SIGNAL( frameClicked( FrameId ) ) );
+    connect( &mParser,              SIGNAL( framesRemoved( FrameId ) ),
+             this,                  SLOT( framesRemoved( FrameId ) ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		refresh
+
+Purpose		Builds the parser's node timeline again and shows all of it
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineDock::refresh()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    mParser.buildTimeline();
+    const NodeTimeline& timeline = mParser.nodeTimeline();
+    const QStringList& ifaces = mParser.table().ifaces();
+    mLanes->setTimeline( timeline, ifaces );
+    mLanes->fit();
+    mModel.setTimeline( timeline, ifaces );
+
+    int anomalies = 0;
+    for ( int i = 0; i < timeline.size(); ++i )
+        anomalies += timeline.at(i).anomalies;
+
+    if ( timeline.isEmpty() )
+        mStatusLbl->setText( tr( "No heartbeat, node guarding, emergency or NMT frames" ) );
+    else
+        mStatusLbl->setText( tr( "%1 nodes, %2 anomalies, laid out in %3 ms" )
+                             .arg( timeline.size() )
+                             .arg( anomalies )
+                             .arg( timer.elapsed() ) );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		showAnomaly
+
+Purpose		Shows an anomaly double clicked on in the lanes, and hands on
+            its frame
+
+Input       index - cell double clicked, in the sort proxy
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineDock::showAnomaly( const QModelIndex& index )
+{
+    if ( !index.isValid() )
+        return;
+
+    const NodeEvent& event = mModel.eventAt( mProxy.mapToSource( index ).row() );
+    mLanes->showSpan( event.begin, event.end );
+    emit frameClicked( event.frame );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		framesRemoved
+
+Purpose		Shows the parser's timeline again once frames have been evicted
+            (the parser trims it with the table), keeping the range shown
+
+Input       count - number of frames removed from the front of the table
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineDock::framesRemoved( FrameId count )
+{
+    Q_UNUSED( count );
+
+    const QStringList& ifaces = mParser.table().ifaces();
+    mLanes->setTimeline( mParser.nodeTimeline(), ifaces );
+    mModel.setTimeline( mParser.nodeTimeline(), ifaces );
+}
@@ -0,0 +1,57 @@
+/*----------------------------------------------------------------------------
+
+Name		timelinedock.h
+
+Purpose		Dock showing the NMT states of every node as swimlanes over
+            time, with the anomalies found (heartbeat and guard timeouts,
+            EMCY bursts, flapping, unexpected boot-ups) listed under them.
+            Double clicking an anomaly shows it in the lanes; clicking in
+            the lanes or on an anomaly hands on the frame it came from.
+            The timeline is built when the dock is refreshed, not as frames
+            arrive.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef TIMELINEDOCK_H
+#define TIMELINEDOCK_H
+
+#include <QDockWidget>
+#include <QLabel>
+#include <QSortFilterProxyModel>
+#include "anomalymodel.h"
+#include "timelinewidget.h"
+
+class Parser;
+
+class TimelineDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TimelineDock( Parser& parser, QWidget* parent = 0 );
+
+public slots:
+    // Builds the parser's node timeline again
+    void refresh();
+
+signals:
+    // emitted with the frame of an event, interval or anomaly clicked on
+    void frameClicked( FrameId frame );
+
+private slots:
+    // Shows an anomaly double clicked on in the lanes, and hands on its frame
+    void showAnomaly( const QModelIndex& index );
+    // Shows the parser's timeline again once frames have been evicted
+    void framesRemoved( FrameId count );
+
+private:
+    Parser& mParser;                // Owner of the frames and the timeline
+
+    AnomalyModel mModel;            // Rows per anomaly
+    QSortFilterProxyModel mProxy;
+
+    TimelineWidget* mLanes;         // Swimlanes
+    QLabel* mStatusLbl;             // Summary of the last build
+};
+
+#endif // TIMELINEDOCK_H
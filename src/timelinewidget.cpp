@@ -0,0 +1,562 @@
+/*----------------------------------------------------------------------------
+
+Name		timelinewidget.cpp
+
+Purpose		Swimlane view of the NMT states and events of every node.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "timelinewidget.h"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+
+// Pixels the mouse must move with the button held before the view pans
+static const int DRAG_START = 3;
+
+// Pixel columns either side of a click searched for an event
+static const int PICK_REACH = 4;
+
+// Share of the view one wheel step zooms in by
+static const double ZOOM_STEP = 0.8;
+
+// Height of the anomaly strip at the foot of each lane, in pixels
+static const int ANOMALY_STRIP = 4;
+
+// Colour of each NodeState
+static const QColor STATE_COLORS[ NODE_STATE_COUNT ] =
+{
+    QColor( 240, 200, 60 ),     // Boot-up
+    QColor( 200, 70, 60 ),      // Stopped
+    QColor( 80, 170, 80 ),      // Operational
+    QColor( 90, 140, 210 ),     // Pre-operational
+    QColor( 160, 160, 160 ),    // Unknown
+    QColor( 225, 225, 225 )     // Silent
+};
+
+// Colour of emergencies and anomalies
+static const QColor ALARM_COLOR( 220, 30, 30 );
+
+/*----------------------------------------------------------------------------
+
+Name		stateName
+
+Purpose		Returns the name of a NodeState, for the legend
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static QString stateName( int state )
+{
+    switch ( state )
+    {
+    case NODE_BOOTUP:           return TimelineWidget::tr( "Boot-up" );
+    case NODE_STOPPED:          return TimelineWidget::tr( "Stopped" );
+    case NODE_OPERATIONAL:      return TimelineWidget::tr( "Operational" );
+    case NODE_PRE_OPERATIONAL:  return TimelineWidget::tr( "Pre-operational" );
+    case NODE_SILENT:           return TimelineWidget::tr( "Silent" );
+    default:                    return TimelineWidget::tr( "Unknown" );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		endsAfter, beginsBefore
+
+Purpose		Compare a position with the end of an interval, or the start of
+            an event, for binary searches
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static bool endsAfter( qint64 x, const NodeInterval& interval )
+{
+    return x < interval.end;
+}
+
+static bool beginsBefore( const NodeEvent& event, qint64 x )
+{
+    return event.begin < x;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		firstInterval
+
+Purpose		Returns the first interval ending after a position
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static int firstInterval( const QVector<NodeInterval>& intervals, qint64 x )
+{
+    const NodeInterval* begin = intervals.constData();
+    return int( std::upper_bound( begin, begin + intervals.size(), x, endsAfter ) - begin );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		firstEvent
+
+Purpose		Returns the first event starting at or after a position
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static int firstEvent( const QVector<NodeEvent>& events, qint64 x )
+{
+    const NodeEvent* begin = events.constData();
+    return int( std::lower_bound( begin, begin + events.size(), x, beginsBefore ) - begin );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		TimelineWidget
+
+Purpose		Constructor
+
+Input       parent - owning widget
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+TimelineWidget::TimelineWidget( QWidget* parent )
+    : QWidget( parent ),
+      mFrom( 0 ),
+      mTo( 1 ),
+      mPressed( false ),
+      mDragged( false ),
+      mPressX( 0 ),
+      mPressFrom( 0 ),
+      mPressTo( 0 )
+{
+    setMinimumHeight( 120 );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		setTimeline
+
+Purpose		Shows a timeline.  Its arrays are shared, not copied.  The range
+            shown is kept, so a timeline trimmed as frames are evicted does
+            not jump; fit() shows all of a new one.
+
+Input       timeline - timeline to show
+            ifaces   - names of the interfaces of its lanes
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineWidget::setTimeline( const NodeTimeline& timeline, const QStringList& ifaces )
+{
+    mTimeline = timeline;
+    mIfaces = ifaces;
+
+    mMaxSpan.fill( 0, mTimeline.size() );
+    for ( int l = 0; l < mTimeline.size(); ++l )
+    {
+        const QVector<NodeEvent>& events = mTimeline.at( l ).events;
+        for ( int e = 0; e < events.size(); ++e )
+            mMaxSpan[l] = qMax( mMaxSpan.at( l ), events.at( e ).end - events.at( e ).begin );
+    }
+
+    setMinimumHeight( sizeHint().height() );
+    update();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		sizeHint
+
+Purpose		Returns room for every lane and the axis labels
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QSize TimelineWidget::sizeHint() const
+{
+    const int line = fontMetrics().height();
+    return QSize( 60 * line, qMax( mTimeline.size(), 4 ) * laneHeight() + 3 * line );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		fit
+
+Purpose		Shows the whole of the timeline
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineWidget::fit()
+{
+    mFrom = mTimeline.begin();
+    mTo = qMax( mTimeline.end(), mFrom + 1 );
+    update();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		showSpan
+
+Purpose		Shows a span with as much again either side of it.  A point is
+            shown with a hundredth of the dump either side.
+
+Input       begin, end - span to show
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineWidget::showSpan( qint64 begin, qint64 end )
+{
+    const qint64 pad = qMax( qMax( end - begin, ( mTimeline.end() - mTimeline.begin() ) / 100 ),
+                             qint64( 1 ) );
+    mFrom = begin - pad;
+    mTo = end + pad;
+    update();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		laneHeight
+
+Purpose		Returns the height of a lane in pixels
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+int TimelineWidget::laneHeight() const
+{
+    return fontMetrics().height() + ANOMALY_STRIP + 4;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		laneArea
+
+Purpose		Returns the area the lanes are drawn in, inside room for the
+            lane names and the axis labels
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QRect TimelineWidget::laneArea() const
+{
+    const int line = fontMetrics().height();
+    return rect().adjusted( 8 * line, line / 2, -line / 2, -2 * line );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		toColumn, fromColumn
+
+Purpose		Convert between positions along the x axis and pixel columns of
+            a lane area width pixels wide
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+double TimelineWidget::toColumn( qint64 x, int width ) const
+{
+    return double( x - mFrom ) * width / double( mTo - mFrom );
+}
+
+qint64 TimelineWidget::fromColumn( double column, int width ) const
+{
+    return mFrom + qint64( column * double( mTo - mFrom ) / width );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		paintLane
+
+Purpose		Draws one lane: a bar coloured by state, ticks for the NMT
+            commands (top half, in the text colour) and emergencies (bottom
+            half, in red), and a red strip at its foot under each anomaly.
+            Intervals that end within a column already drawn are skipped by
+            a binary search rather than one by one, as are events that
+            would land on a column already ticked.
+
+Input       painter - painter of the widget
+            lane    - lane to draw
+            maxSpan - longest event of the lane
+            row     - area of the lane
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineWidget::paintLane( QPainter& painter, const NodeLane& lane, qint64 maxSpan,
+                                const QRect& row ) const
+{
+    const int width = row.width();
+    const QRect bar = row.adjusted( 0, 0, 0, -ANOMALY_STRIP );
+
+    // States
+    const QVector<NodeInterval>& intervals = lane.intervals;
+    int drawn = 0;
+    int i = firstInterval( intervals, mFrom );
+    while ( i < intervals.size() && intervals.at(i).begin < mTo && drawn < width )
+    {
+        const NodeInterval& interval = intervals.at(i);
+        const int x0 = qMax( int( std::floor( toColumn( interval.begin, width ) ) ), drawn );
+        int x1 = qMin( int( std::ceil( toColumn( interval.end, width ) ) ), width );
+        if ( x1 <= x0 )
+            x1 = qMin( x0 + 1, width );
+
+        if ( x0 < x1 )
+            painter.fillRect( QRect( row.left() + x0, bar.top(), x1 - x0, bar.height() ),
+                              STATE_COLORS[ qMin<int>( interval.state, NODE_STATE_COUNT - 1 ) ] );
+        drawn = qMax( drawn, x1 );
+        i = qMax( i + 1, firstInterval( intervals, fromColumn( drawn, width ) ) );
+    }
+
+    // Events
+    QVector<QLineF> commands;
+    QVector<QLineF> emcys;
+    QVector<QRect> anomalies;
+    int lastCommand = -1;
+    int lastEmcy = -1;
+    int lastAnomaly = -1;
+    const double middle = bar.center().y();
+
+    const QVector<NodeEvent>& events = lane.events;
+    for ( int e = firstEvent( events, mFrom - maxSpan );
+          e < events.size() && events.at( e ).begin <= mTo; ++e )
+    {
+        const NodeEvent& event = events.at( e );
+        const int x0 = int( std::floor( toColumn( event.begin, width ) ) );
+        const int x1 = int( std::ceil( toColumn( event.end, width ) ) );
+        if ( x1 < 0 || x0 >= width )
+            continue;
+
+        const double x = row.left() + qMax( x0, 0 ) + 0.5;
+        if ( event.kind == EVENT_NMT_COMMAND )
+        {
+            if ( x0 != lastCommand )
+                commands << QLineF( x, bar.top(), x, middle );
+            lastCommand = x0;
+        }
+        else if ( event.kind == EVENT_EMCY )
+        {
+            if ( x0 != lastEmcy )
+                emcys << QLineF( x, middle, x, bar.bottom() );
+            lastEmcy = x0;
+        }
+        else if ( x1 > lastAnomaly )
+        {
+            const int from = qMax( qMax( x0, lastAnomaly ), 0 );
+            const int to = qMin( qMax( x1, from + 3 ), width );
+            anomalies << QRect( row.left() + from, bar.bottom() + 1, to - from, ANOMALY_STRIP );
+            lastAnomaly = to;
+        }
+    }
+
+    painter.setPen( palette().color( QPalette::Text ) );
+    painter.drawLines( commands );
+    painter.setPen( ALARM_COLOR );
+    painter.drawLines( emcys );
+    for ( int a = 0; a < anomalies.size(); ++a )
+        painter.fillRect( anomalies.at( a ), ALARM_COLOR );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		paintEvent
+
+Purpose		Draws the lanes with their names, then the axis labels and a
+            legend of the state colours
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineWidget::paintEvent( QPaintEvent* event )
+{
+    Q_UNUSED( event );
+
+    QPainter painter( this );
+    painter.fillRect( rect(), palette().color( QPalette::Base ) );
+
+    const QRect area = laneArea();
+    painter.setPen( palette().color( QPalette::Mid ) );
+    painter.drawRect( area );
+    painter.setPen( palette().color( QPalette::Text ) );
+
+    if ( mTimeline.isEmpty() || area.width() <= 0 || area.height() <= 0 )
+    {
+        painter.drawText( rect(), Qt::AlignCenter,
+                          tr( "No node has sent a heartbeat or emergency, or been sent "
+                              "an NMT command of its own" ) );
+        return;
+    }
+
+    const int height = laneHeight();
+    const int line = fontMetrics().height();
+    for ( int l = 0; l < mTimeline.size(); ++l )
+    {
+        const NodeLane& lane = mTimeline.at( l );
+        const QRect row( area.left(), area.top() + l * height + 1, area.width(), height - 2 );
+        if ( row.top() > area.bottom() )
+            break;
+
+        const QString node = QString( "%1" ).arg( lane.node, 2, 16, QChar( '0' ) ).toUpper();
+        const QString name = ( mIfaces.size() > 1 )
+                             ? tr( "%1 node %2" ).arg( mIfaces.value( lane.iface ) ).arg( node )
+                             : tr( "Node %1" ).arg( node );
+        painter.setPen( palette().color( QPalette::Text ) );
+        painter.drawText( QRect( 0, row.top(), area.left() - 4, row.height() ),
+                          Qt::AlignRight | Qt::AlignVCenter, name );
+
+        paintLane( painter, lane, mMaxSpan.at( l ), row );
+    }
+
+    // Labels and legend
+    painter.setPen( palette().color( QPalette::Text ) );
+    const bool timed = mTimeline.isTimed();
+    const QString from = timed ? tr( "%1 s" ).arg( mFrom / 1e6, 0, 'f', 6 )
+                               : tr( "frame %1" ).arg( mFrom );
+    const QString to = timed ? tr( "%1 s" ).arg( mTo / 1e6, 0, 'f', 6 )
+                             : tr( "frame %1" ).arg( mTo );
+    const QRect below( area.left(), area.bottom() + 2, area.width(), line );
+    painter.drawText( below, Qt::AlignLeft | Qt::AlignVCenter, from );
+    painter.drawText( below, Qt::AlignRight | Qt::AlignVCenter, to );
+
+    const int cell = area.width() / ( NODE_STATE_COUNT + 4 );
+    for ( int s = 0; s < NODE_STATE_COUNT; ++s )
+    {
+        const int x = area.left() + ( s + 2 ) * cell;
+        painter.fillRect( QRect( x, below.top() + 2, line - 4, line - 4 ), STATE_COLORS[s] );
+        painter.drawText( QRect( x + line, below.top(), cell - line, line ),
+                          Qt::AlignLeft | Qt::AlignVCenter, stateName( s ) );
+    }
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mousePressEvent
+
+Purpose		Notes where a pan or click starts
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineWidget::mousePressEvent( QMouseEvent* event )
+{
+    if ( event->button() != Qt::LeftButton )
+        return;
+
+    mPressed = true;
+    mDragged = false;
+    mPressX = event->x();
+    mPressFrom = mFrom;
+    mPressTo = mTo;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mouseMoveEvent
+
+Purpose		Pans the lanes with the mouse once it has moved far enough
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineWidget::mouseMoveEvent( QMouseEvent* event )
+{
+    if ( !mPressed || laneArea().width() <= 0 )
+        return;
+
+    const int dx = event->x() - mPressX;
+    if ( qAbs( dx ) > DRAG_START )
+        mDragged = true;
+    if ( !mDragged )
+        return;
+
+    const qint64 shift = qint64( double( dx ) * ( mPressTo - mPressFrom ) / laneArea().width() );
+    mFrom = mPressFrom - shift;
+    mTo = mPressTo - shift;
+    update();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mouseReleaseEvent
+
+Purpose		Ends a pan, or picks what was clicked on: the event of the lane
+            nearest the cursor within PICK_REACH columns (anomalies first on
+            a tie), or else the interval under it
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineWidget::mouseReleaseEvent( QMouseEvent* event )
+{
+    if ( !mPressed || event->button() != Qt::LeftButton )
+        return;
+
+    mPressed = false;
+    const QRect area = laneArea();
+    if ( mDragged || mTimeline.isEmpty() || area.width() <= 0 )
+        return;
+
+    const int l = ( event->y() - area.top() ) / laneHeight();
+    const int column = event->x() - area.left();
+    if ( event->y() < area.top() || l >= mTimeline.size() || column < 0 || column >= area.width() )
+        return;
+
+    const NodeLane& lane = mTimeline.at( l );
+    const int width = area.width();
+
+    int best = -1;
+    double bestDistance = PICK_REACH + 1;
+    const QVector<NodeEvent>& events = lane.events;
+    const qint64 last = fromColumn( column + PICK_REACH + 1, width );
+    for ( int e = firstEvent( events, fromColumn( column - PICK_REACH, width ) - mMaxSpan.at( l ) );
+          e < events.size() && events.at( e ).begin <= last; ++e )
+    {
+        const double x0 = toColumn( events.at( e ).begin, width );
+        const double x1 = toColumn( events.at( e ).end, width );
+        const double distance = ( column >= x0 && column <= x1 )
+                                ? 0.0 : qMin( qAbs( column - x0 ), qAbs( column - x1 ) );
+        const bool anomaly = NodeTimeline::isAnomaly( events.at( e ).kind );
+        if ( distance < bestDistance
+             || ( distance == bestDistance && anomaly && best >= 0
+                  && !NodeTimeline::isAnomaly( events.at( best ).kind ) ) )
+        {
+            best = e;
+            bestDistance = distance;
+        }
+    }
+    if ( best >= 0 && bestDistance <= PICK_REACH )
+    {
+        emit frameClicked( events.at( best ).frame );
+        return;
+    }
+
+    const qint64 x = fromColumn( column, width );
+    const int i = firstInterval( lane.intervals, x );
+    if ( i < lane.intervals.size() && lane.intervals.at(i).begin <= x )
+        emit frameClicked( lane.intervals.at(i).frame );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		mouseDoubleClickEvent
+
+Purpose		Shows the whole timeline
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineWidget::mouseDoubleClickEvent( QMouseEvent* event )
+{
+    Q_UNUSED( event );
+    fit();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		wheelEvent
+
+Purpose		Zooms about the cursor, ZOOM_STEP a step
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TimelineWidget::wheelEvent( QWheelEvent* event )
+{
+    const QRect area = laneArea();
+    if ( area.width() <= 0 )
+        return;
+
+    const double factor = std::pow( ZOOM_STEP, event->angleDelta().y() / 120.0 );
+    const qint64 anchor = fromColumn( event->pos().x() - area.left(), area.width() );
+    const qint64 span = qMax( qint64( ( mTo - mFrom ) * factor ), qint64( 2 ) );
+
+    mFrom = anchor - qint64( double( anchor - mFrom ) * span / ( mTo - mFrom ) );
+    mTo = mFrom + span;
+    update();
+}
@@ -0,0 +1,92 @@
+/*----------------------------------------------------------------------------
+
+Name		timelinewidget.h
+
+Purpose		Swimlane view of a NodeTimeline: one lane per node, coloured by
+            the NMT state it was in, with ticks for the NMT commands sent
+            to it and its emergencies, and a red strip under each anomaly.
+            The lanes share a time axis (or frame axis, for dumps without
+            timestamps).
+
+            Each paint finds the first interval and event in view by binary
+            search, and skips the intervals that fall wholly within a pixel
+            already drawn, so it costs about the same however long the dump
+            is or however often a node flapped.
+
+            The wheel zooms about the cursor, dragging pans and a double
+            click shows the whole dump.  A single click picks the event
+            nearest the cursor in its lane, or else the interval under it,
+            and hands on its frame.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef TIMELINEWIDGET_H
+#define TIMELINEWIDGET_H
+
+#include <QStringList>
+#include <QWidget>
+#include "nodetimeline.h"
+
+class TimelineWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TimelineWidget( QWidget* parent = 0 );
+
+    // Shows a timeline, keeping the range shown; ifaces names the
+    // interfaces of its lanes
+    void setTimeline( const NodeTimeline& timeline, const QStringList& ifaces );
+
+    // Shows a span, with as much again either side of it
+    void showSpan( qint64 begin, qint64 end );
+
+    // QWidget interface
+    QSize sizeHint() const;
+
+public slots:
+    // Shows the whole of the timeline
+    void fit();
+
+signals:
+    // emitted with the frame of an event or interval clicked on
+    void frameClicked( FrameId frame );
+
+protected:
+    void paintEvent( QPaintEvent* event );
+    void mousePressEvent( QMouseEvent* event );
+    void mouseMoveEvent( QMouseEvent* event );
+    void mouseReleaseEvent( QMouseEvent* event );
+    void mouseDoubleClickEvent( QMouseEvent* event );
+    void wheelEvent( QWheelEvent* event );
+
+private:
+    // Returns the height of a lane in pixels
+    int laneHeight() const;
+    // Returns the area the lanes are drawn in
+    QRect laneArea() const;
+    // Converts between positions along the x axis and pixel columns of the
+    // lane area
+    double toColumn( qint64 x, int width ) const;
+    qint64 fromColumn( double column, int width ) const;
+
+    // Draws the intervals and events of one lane within a row
+    void paintLane( QPainter& painter, const NodeLane& lane, qint64 maxSpan,
+                    const QRect& row ) const;
+
+private:
+    NodeTimeline mTimeline;         // Timeline shown (its arrays are shared)
+    QStringList mIfaces;            // Interface names
+    QVector<qint64> mMaxSpan;       // Longest event of each lane
+
+    qint64 mFrom;                   // Range of the x axis shown
+    qint64 mTo;
+
+    bool mPressed;                  // Mouse button held over the lanes
+    bool mDragged;                  // Mouse moved far enough to pan
+    int mPressX;                    // Column the button was pressed at
+    qint64 mPressFrom;              // Range shown when it was pressed
+    qint64 mPressTo;
+};
+
+#endif // TIMELINEWIDGET_H
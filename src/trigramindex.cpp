@@ -0,0 +1,555 @@
+/*----------------------------------------------------------------------------
+
+Name		trigramindex.cpp
+
+Purpose		Trigram index over the raw text of the mapped dumps.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+
+#include "trigramindex.h"
+#include "frameindex.h"
+#include "stageprofile.h"
+#include <QtConcurrent>
+#include <cstring>
+
+// Blocks sampled to find the common trigrams
+static const int TRIGRAM_SAMPLE = 64;
+
+// Blocks listed by one task of the build
+static const int TRIGRAM_GROUP = 64;
+
+// Most rare trigrams listed for one block; past this it is always searched
+static const int TRIGRAM_MAX_LISTED = 4096;
+
+// Blocks a group of the build lists, and where to look for a cancel
+struct TrigramGroup
+{
+    const TrigramIndex* index;
+    int first;
+    int last;
+    const QAtomicInt* generation;
+    int current;
+};
+
+/*----------------------------------------------------------------------------
+
+Name		ByteClasses
+
+Purpose		Table folding every byte to its 6 bit class.  Class 0 is unused,
+            digits and letters (either case) have one each, the punctuation
+            candump and its annotations use have one each, and every other
+            byte shares one of the last few.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+struct ByteClasses
+{
+    ByteClasses()
+    {
+        static const char punctuation[] = " #.()[]-_:/,=\t\n\r<>";
+        const int shared = 37 + int( sizeof( punctuation ) ) - 1;
+
+        for ( int b = 0; b < 256; ++b )
+        {
+            if ( b >= '0' && b <= '9' )
+                table[b] = quint8( 1 + b - '0' );
+            else if ( b >= 'a' && b <= 'z' )
+                table[b] = quint8( 11 + b - 'a' );
+            else if ( b >= 'A' && b <= 'Z' )
+                table[b] = quint8( 11 + b - 'A' );
+            else
+            {
+                const char* p = b ? strchr( punctuation, b ) : 0;
+                table[b] = p ? quint8( 37 + ( p - punctuation ) )
+                             : quint8( shared + b % ( 64 - shared ) );
+            }
+        }
+    }
+
+    quint8 table[ 256 ];
+};
+
+/*----------------------------------------------------------------------------
+
+Name		byteClasses
+
+Purpose		Returns the class of every byte, built before first use from
+            any thread
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static const quint8* byteClasses()
+{
+    static const ByteClasses classes;
+    return classes.table;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		TrigramIndex
+
+Purpose		Constructor
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+TrigramIndex::TrigramIndex()
+    : mBuilt( false )
+{
+
+}
+
+/*----------------------------------------------------------------------------
+
+Name		clear
+
+Purpose		Drops the blocks and lists
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+void TrigramIndex::clear()
+{
+    mBuilt = false;
+    mBlocks.clear();
+    mCommon.clear();
+    mStart.clear();
+    mPostings.clear();
+}
+
+/*----------------------------------------------------------------------------
+
+Name		code
+
+Purpose		Returns the 18 bit code of the trigram starting at p
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+quint32 TrigramIndex::code( const char* p )
+{
+    const quint8* classes = byteClasses();
+    return ( quint32( classes[ uchar( p[0] ) ] ) << 12 )
+         | ( quint32( classes[ uchar( p[1] ) ] ) << 6 )
+         | classes[ uchar( p[2] ) ];
+}
+
+/*----------------------------------------------------------------------------
+
+Name		build
+
+Purpose		Cuts the texts into newline aligned blocks and builds the lists:
+
+            1. trigrams found in half or more of up to TRIGRAM_SAMPLE evenly
+               spaced blocks are marked common;
+            2. groups of blocks are listed in parallel, each giving a
+               (code, block) pair for every distinct rare trigram of its
+               blocks (or a pair under the open list for a block with too
+               many);
+            3. one counting sort of the pairs by code gives the lists, each
+               in block order.
+
+Input       texts      - texts to index, in offset order
+            generation - bumped to cancel the build
+            current    - value of generation this build belongs to
+
+Return      false if cancelled
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Lists blocks as BlockId
+----------------------------------------------------------------------------*/
+bool TrigramIndex::build( const QVector<TextBlock>& texts, const QAtomicInt& generation,
+                          int current )
+{
+    StageTimer stage( STAGE_INDEX, 0 );
+    clear();
+
+    for ( int t = 0; t < texts.size(); ++t )
+    {
+        const TextBlock& text = texts.at( t );
+        const char* p = text.begin;
+        while ( p < text.end )
+        {
+            const char* end = p + qMin( qint64( TRIGRAM_BLOCK ), qint64( text.end - p ) );
+            if ( end < text.end )
+            {
+                const char* nl = static_cast<const char*>( memchr( end, '\n', text.end - end ) );
+                end = nl ? nl + 1 : text.end;
+            }
+
+            TextBlock block;
+            block.begin = p;
+            block.end = end;
+            block.offset = text.offset + ( p - text.begin );
+            mBlocks.append( block );
+
+            p = end;
+        }
+    }
+
+    const int blocks = mBlocks.size();
+    stage.setFrames( blocks );
+
+    // 1. Sample
+    const int samples = qMin( TRIGRAM_SAMPLE, blocks );
+    QVector<int> seenIn( TRIGRAM_CODES, -1 );
+    QVector<quint8> counts( TRIGRAM_CODES, 0 );
+    for ( int s = 0; s < samples; ++s )
+    {
+        const TextBlock& block = mBlocks.at( int( qint64( s ) * blocks / samples ) );
+        for ( const char* p = block.begin; p + 3 <= block.end; ++p )
+        {
+            const quint32 c = code( p );
+            if ( seenIn.at( c ) != s )
+            {
+                seenIn[c] = s;
+                ++counts[c];
+            }
+        }
+    }
+
+    mCommon.fill( 0, TRIGRAM_CODES / 64 );
+    for ( int c = 0; c < TRIGRAM_CODES; ++c )
+    {
+        if ( samples > 0 && counts.at( c ) * 2 >= samples )
+            mCommon[ c >> 6 ] |= quint64( 1 ) << ( c & 63 );
+    }
+
+    if ( generation.load() != current )
+    {
+        clear();
+        return false;
+    }
+
+    // 2. List
+    QVector<TrigramGroup> groups;
+    for ( int first = 0; first < blocks; first += TRIGRAM_GROUP )
+    {
+        TrigramGroup group;
+        group.index = this;
+        group.first = first;
+        group.last = qMin( first + TRIGRAM_GROUP, blocks );
+        group.generation = &generation;
+        group.current = current;
+        groups.append( group );
+    }
+
+    QVector< QVector<quint64> > pairs =
+        QtConcurrent::blockingMapped< QVector< QVector<quint64> > >( groups, listGroup );
+
+    if ( generation.load() != current )
+    {
+        clear();
+        return false;
+    }
+
+    // 3. Sort by code, the open blocks under the extra last code
+    mStart.fill( 0, TRIGRAM_CODES + 2 );
+    for ( int g = 0; g < pairs.size(); ++g )
+    {
+        const QVector<quint64>& list = pairs.at( g );
+        for ( int i = 0; i < list.size(); ++i )
+            ++mStart[ int( list.at(i) >> 32 ) + 1 ];
+    }
+    for ( int c = 0; c <= TRIGRAM_CODES; ++c )
+        mStart[ c + 1 ] += mStart.at( c );
+
+    QVector<int> fill = mStart;
+    mPostings.resize( mStart.last() );
+    BlockId* out = mPostings.data();
+    for ( int g = 0; g < pairs.size(); ++g )
+    {
+        const QVector<quint64>& list = pairs.at( g );
+        for ( int i = 0; i < list.size(); ++i )
+            out[ fill[ int( list.at(i) >> 32 ) ]++ ] = BlockId( list.at(i) );
+    }
+
+    mBuilt = true;
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		listGroup
+
+Purpose		Lists the distinct rare trigrams of a group of blocks, as
+            (code << 32 | block) pairs in block order.  A block with more
+            than TRIGRAM_MAX_LISTED is given one pair under the open list
+            instead.
+
+Input       group - blocks to list
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+QVector<quint64> TrigramIndex::listGroup( const TrigramGroup& group )
+{
+    const TrigramIndex& index = *group.index;
+    QVector<quint64> pairs;
+    QVector<int> seenIn( TRIGRAM_CODES, -1 );
+    QVector<quint32> codes;
+    codes.reserve( TRIGRAM_MAX_LISTED );
+
+    for ( int b = group.first; b < group.last; ++b )
+    {
+        if ( group.generation->load() != group.current )
+            return QVector<quint64>();
+
+        const TextBlock& block = index.mBlocks.at( b );
+        bool open = false;
+        codes.clear();
+        for ( const char* p = block.begin; p + 3 <= block.end; ++p )
+        {
+            const quint32 c = code( p );
+            if ( seenIn.at( c ) == b || index.isCommon( c ) )
+                continue;
+
+            seenIn[c] = b;
+            if ( codes.size() == TRIGRAM_MAX_LISTED )
+            {
+                open = true;
+                break;
+            }
+            codes.append( c );
+        }
+
+        if ( open )
+            pairs.append( ( quint64( TRIGRAM_CODES ) << 32 ) | quint32( b ) );
+        else
+        {
+            for ( int i = 0; i < codes.size(); ++i )
+                pairs.append( ( quint64( codes.at(i) ) << 32 ) | quint32( b ) );
+        }
+    }
+
+    return pairs;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		candidates
+
+Purpose		Returns the blocks that can hold every one of the literals: the
+            intersection of the lists of their rare trigrams, plus the open
+            blocks.  A literal with no rare trigram cannot narrow anything.
+
+Input       literals - strings a match must contain
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Lists blocks as BlockId
+----------------------------------------------------------------------------*/
+QVector<BlockId> TrigramIndex::candidates( const QList<QByteArray>& literals ) const
+{
+    QVector<BlockId> found;
+    bool narrowed = false;
+
+    for ( int l = 0; mBuilt && l < literals.size(); ++l )
+    {
+        const QByteArray& literal = literals.at( l );
+        for ( int i = 0; i + 3 <= literal.size(); ++i )
+        {
+            const quint32 c = code( literal.constData() + i );
+            if ( isCommon( c ) )
+                continue;
+
+            QVector<BlockId> list( mStart.at( c + 1 ) - mStart.at( c ) );
+            std::copy( mPostings.constBegin() + mStart.at( c ),
+                       mPostings.constBegin() + mStart.at( c + 1 ), list.begin() );
+
+            found = narrowed ? FrameIndex::intersect( found, list ) : list;
+            narrowed = true;
+            if ( found.isEmpty() )
+                break;
+        }
+    }
+
+    if ( !narrowed )
+    {
+        found.resize( mBlocks.size() );
+        for ( int b = 0; b < found.size(); ++b )
+            found[b] = BlockId( b );
+        return found;
+    }
+
+    // Open blocks list nothing, so never overlap the lists
+    QVector<const BlockId*> begins, ends;
+    begins << found.constData() << mPostings.constData() + mStart.at( TRIGRAM_CODES );
+    ends << found.constData() + found.size()
+         << mPostings.constData() + mStart.at( TRIGRAM_CODES + 1 );
+
+    return FrameIndex::unite( begins, ends );
+}
+
+/*----------------------------------------------------------------------------
+
+Name		classEnd
+
+Purpose		Returns the position just past the ']' that closes a character
+            class.  A ']' first in the class (after any '^') is one of its
+            members, as are escaped characters and the ']' of a POSIX class
+            such as [:digit:].
+
+Input       pattern - regular expression
+            i       - position of the '[' opening the class
+
+Return      position after the class, or the end of an unclosed one
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+static int classEnd( const QString& pattern, int i )
+{
+    const int n = pattern.size();
+
+    ++i;
+    if ( i < n && pattern.at( i ) == '^' )
+        ++i;
+    if ( i < n && pattern.at( i ) == ']' )
+        ++i;
+
+    for ( ; i < n; ++i )
+    {
+        const QChar c = pattern.at( i );
+        if ( c == ']' )
+            return i + 1;
+
+        if ( c == '\\' )
+            ++i;
+        else if ( c == '[' && i + 1 < n && pattern.at( i + 1 ) == ':' )
+        {
+            const int close = pattern.indexOf( QString( ":]" ), i + 2 );
+            if ( close >= 0 )
+                i = close + 1;
+        }
+    }
+
+    return n;
+}
+
+/*----------------------------------------------------------------------------
+
+Name		literals
+
+Purpose		Returns strings every match of the pattern must contain.  For a
+            regular expression the pattern is read left to right, keeping
+            runs of plain characters and escaped punctuation; a run ends at
+            any group, class, anchor, wildcard or escape such as \d (with
+            the letters and digits after it, so \x41 gives nothing), and a
+            quantifier that allows none takes the character before it off
+            the run.  This only ever drops literals, which costs speed but
+            never a hit.
+
+Input       pattern - text or regular expression searched for
+            regex   - true if pattern is a regular expression
+
+History		17 Oct 26  AFB	Created
+            17 Oct 26  AFB	Reads a ']' first in a class as a member
+----------------------------------------------------------------------------*/
+QList<QByteArray> TrigramIndex::literals( const QString& pattern, bool regex )
+{
+    QList<QString> runs;
+    if ( !regex )
+        runs << pattern;
+    else
+    {
+        const int n = pattern.size();
+
+        // A top level alternation means no one literal is needed
+        int depth = 0;
+        for ( int i = 0; i < n; ++i )
+        {
+            const QChar c = pattern.at( i );
+            if ( c == '\\' )
+                ++i;
+            else if ( c == '[' )
+                i = classEnd( pattern, i ) - 1;
+            else if ( c == '(' )
+                ++depth;
+            else if ( c == ')' )
+                --depth;
+            else if ( c == '|' && depth <= 0 )
+                return QList<QByteArray>();
+        }
+
+        QString run;
+        int i = 0;
+        while ( i < n )
+        {
+            const QChar c = pattern.at( i );
+            if ( c == '\\' && i + 1 < n )
+            {
+                const QChar e = pattern.at( i + 1 );
+                i += 2;
+                if ( !e.isLetterOrNumber() )
+                {
+                    run += e;
+                    continue;
+                }
+
+                runs << run;
+                run.clear();
+                while ( i < n && ( pattern.at( i ).isLetterOrNumber()
+                                   || pattern.at( i ) == '{' || pattern.at( i ) == '}' ) )
+                    ++i;
+            }
+            else if ( c == '[' )
+            {
+                runs << run;
+                run.clear();
+                i = classEnd( pattern, i );
+            }
+            else if ( c == '(' )
+            {
+                runs << run;
+                run.clear();
+                int open = 1;
+                for ( ++i; i < n && open > 0; ++i )
+                {
+                    const QChar g = pattern.at( i );
+                    if ( g == '\\' )
+                        ++i;
+                    else if ( g == '[' )
+                        i = classEnd( pattern, i ) - 1;
+                    else if ( g == '(' )
+                        ++open;
+                    else if ( g == ')' )
+                        --open;
+                }
+            }
+            else if ( c == '?' || c == '*' || c == '{' )
+            {
+                run.chop( 1 );
+                runs << run;
+                run.clear();
+                if ( c == '{' )
+                    while ( i < n && pattern.at( i ) != '}' )
+                        ++i;
+                ++i;
+            }
+            else if ( c == '+' || c == '.' || c == '^' || c == '$' || c == '\\' )
+            {
+                runs << run;
+                run.clear();
+                ++i;
+            }
+            else
+            {
+                run += c;
+                ++i;
+            }
+        }
+        runs << run;
+    }
+
+    QList<QByteArray> found;
+    for ( int r = 0; r < runs.size(); ++r )
+    {
+        const QString& run = runs.at( r );
+        if ( run.size() < 3 )
+            continue;
+
+        bool latin1 = true;
+        for ( int i = 0; i < run.size() && latin1; ++i )
+            latin1 = run.at( i ).unicode() < 0x100;
+        if ( latin1 )
+            found << run.toLatin1();
+    }
+
+    return found;
+}
@@ -0,0 +1,106 @@
+/*----------------------------------------------------------------------------
+
+Name		trigramindex.h
+
+Purpose		Trigram index over the raw text of the mapped dumps, used to
+            narrow a free text search to the blocks that can hold a match.
+            The text is cut into newline aligned blocks of about
+            TRIGRAM_BLOCK bytes, and for every trigram the index lists the
+            blocks it occurs in.
+
+            Bytes are folded into 64 classes (digits, letters without case,
+            the punctuation candump writes, and a few shared classes for
+            everything else), so a trigram is an 18 bit code and letters
+            match in either case.  Folding only adds candidates; the search
+            itself confirms every hit.
+
+            Most trigrams of a candump (hex pairs, interface names, spaces)
+            occur in every block and narrow nothing, so trigrams found in
+            half or more of a sample of blocks are treated as common and not
+            listed.  What is listed is the rare text: error frames, flags,
+            annotations.  A block holding too many rare trigrams to list is
+            always a candidate.
+
+History		17 Oct 26  AFB	Created
+----------------------------------------------------------------------------*/
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+// Bytes of text per block of the index (blocks end on a newline)
+const int TRIGRAM_BLOCK = 64 * 1024;
+
+// Number of trigram codes: three 6 bit byte classes
+const int TRIGRAM_CODES = 1 << 18;
+
+// Index of a block of the index.  Lists of blocks are sorted like lists of
+// frames, so FrameIndex::unite and intersect serve for both.
+typedef quint32 BlockId;
+
+// A run of text: a whole dump, or one block of the index
+struct TextBlock
+{
+    const char* begin;
+    const char* end;
+    qint64 offset;          // Offset of begin in the frame offsets
+};
+
+struct TrigramGroup;
+
+class TrigramIndex
+{
+public:
+    TrigramIndex();
+
+    // Drops the blocks and lists
+    void clear();
+    // Returns true once build has completed
+    bool isBuilt() const { return mBuilt; }
+
+    // Cuts the texts into blocks and lists the trigrams of each, on the
+    // thread pool.  Stops early, returning false and leaving the index
+    // empty, once generation no longer equals current.
+    bool build( const QVector<TextBlock>& texts, const QAtomicInt& generation, int current );
+
+    int blockCount() const { return mBlocks.size(); }
+    const TextBlock& block( int i ) const { return mBlocks.at( i ); }
+
+    // Returns the blocks that can hold every one of the literals, in
+    // order; every block when the literals have no listed trigram
+    QVector<BlockId> candidates( const QList<QByteArray>& literals ) const;
+
+    // Returns strings every match of the pattern must contain.  A plain
+    // pattern is itself the literal; for a regular expression, the runs of
+    // plain characters outside groups, classes and optional parts (none
+    // when there is a top level alternation).  Only runs of three or more
+    // bytes are returned.
+    static QList<QByteArray> literals( const QString& pattern, bool regex );
+
+private:
+    // Lists the trigrams of a group of blocks, on a worker thread
+    static QVector<quint64> listGroup( const TrigramGroup& group );
+
+    // Returns the 18 bit code of the trigram starting at p
+    static quint32 code( const char* p );
+
+    // Returns true if a trigram code was found common when sampling
+    bool isCommon( quint32 code ) const
+        { return ( mCommon.at( code >> 6 ) >> ( code & 63 ) ) & 1; }
+
+private:
+    QVector<TextBlock> mBlocks;     // Blocks of the texts, in offset order
+    QVector<quint64> mCommon;       // Bit per trigram code: not listed
+    QVector<int> mStart;            // Start of each code's list in mPostings; the
+                                    // list after the last code holds the blocks
+                                    // with too many trigrams to list
+    QVector<BlockId> mPostings;     // Blocks grouped by trigram code
+    bool mBuilt;
+};
+
+#endif // TRIGRAMINDEX_H